@@ -95,7 +95,10 @@ class BlockDesc {
 
   void RemoveOpInternal(const OpDesc *op_desc);
 
-  void RemoveVar(const std::string &name) { vars_.erase(name); }
+  void RemoveVar(const std::string &name) {
+    vars_.erase(name);
+    need_update_ = true;
+  }
 
   std::vector<OpDesc *> AllOps() const;
 
@@ -0,0 +1,180 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/common_subexpression_elimination_pass.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+namespace {
+
+// The attributes which only tell where the op comes from
+bool IsDebugAttr(const std::string& name) {
+  return name == OpProtoAndCheckerMaker::OpNamescopeAttrName() ||
+         name == OpProtoAndCheckerMaker::OpCreationCallstackAttrName() ||
+         name == OpProtoAndCheckerMaker::OpRoleVarAttrName();
+}
+
+bool HasSameAttrs(const OpDesc& a, const OpDesc& b) {
+  const auto& a_attrs = a.GetAttrMap();
+  const auto& b_attrs = b.GetAttrMap();
+  for (auto& attr : a_attrs) {
+    if (IsDebugAttr(attr.first)) continue;
+    auto it = b_attrs.find(attr.first);
+    if (it == b_attrs.end() || !(it->second == attr.second)) return false;
+  }
+  for (auto& attr : b_attrs) {
+    if (!IsDebugAttr(attr.first) && !a_attrs.count(attr.first)) return false;
+  }
+  return true;
+}
+
+bool HasSameOutputSlots(const OpDesc& a, const OpDesc& b) {
+  const auto& a_outputs = a.Outputs();
+  const auto& b_outputs = b.Outputs();
+  if (a_outputs.size() != b_outputs.size()) return false;
+  for (auto& output : a_outputs) {
+    auto it = b_outputs.find(output.first);
+    if (it == b_outputs.end() || it->second.size() != output.second.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Node* FindVarNode(const std::vector<Node*>& nodes, const std::string& name) {
+  for (auto* node : nodes) {
+    if (node->IsVar() && node->Var() && node->Name() == name) return node;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+void CommonSubexpressionEliminationPass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init("common_subexpression_elimination", graph);
+
+  // A var written more than once has several nodes of the same name, and
+  // its readers may not read the value of another var instead
+  std::unordered_map<std::string, int> num_var_nodes;
+  for (auto* node : graph->Nodes()) {
+    if (node->IsVar() && node->Var()) ++num_var_nodes[node->Name()];
+  }
+
+  // The key of an op is its type and the ids of the var nodes it reads, i.e.
+  // the versions of its inputs. It is empty if the op can not be merged.
+  auto op_key = [&](Node* op_node) -> std::string {
+    auto* op = op_node->Op();
+    if (op == nullptr || !IsPureOp(*op) || op->Outputs().empty()) return "";
+    for (auto* out : op_node->outputs) {
+      if (!out->IsVar() || out->Var() == nullptr ||
+          out->Var()->Persistable() || num_var_nodes[out->Name()] != 1) {
+        return "";
+      }
+    }
+    std::ostringstream key;
+    key << op->Type();
+    for (auto& input : op->Inputs()) {
+      key << ";" << input.first << ":";
+      for (auto& arg : input.second) {
+        auto* var = FindVarNode(op_node->inputs, arg);
+        if (var == nullptr) return "";
+        key << var->id() << ",";
+      }
+    }
+    return key.str();
+  };
+  // The readers of the fetched vars and of the vars read in sub-blocks refer
+  // to them by name
+  auto can_rename_outputs = [](Node* op_node) {
+    for (auto* out : op_node->outputs) {
+      for (auto* reader : out->outputs) {
+        if (reader->Op() == nullptr || reader->Op()->Type() == "fetch" ||
+            HasSubBlock(*reader->Op())) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  std::unordered_map<std::string, std::vector<Node*>> ops_by_key;
+  int found_count = 0;
+  for (auto* op_node : TopologySortOperations(*graph)) {
+    const std::string key = op_key(op_node);
+    if (key.empty()) continue;
+    auto& same_key_ops = ops_by_key[key];
+    auto* op = op_node->Op();
+    auto it = std::find_if(
+        same_key_ops.begin(), same_key_ops.end(), [&](Node* first) {
+          return HasSameAttrs(*first->Op(), *op) &&
+                 HasSameOutputSlots(*first->Op(), *op);
+        });
+    if (it == same_key_ops.end() || !can_rename_outputs(op_node)) {
+      same_key_ops.push_back(op_node);
+      continue;
+    }
+
+    // The readers of the outputs of the op read the outputs of the first
+    // op instead
+    Node* first = *it;
+    std::unordered_set<const Node*> nodes_to_remove{op_node};
+    for (auto& output : op->Outputs()) {
+      const auto& first_args = first->Op()->Output(output.first);
+      for (size_t i = 0; i < output.second.size(); ++i) {
+        Node* var = FindVarNode(op_node->outputs, output.second[i]);
+        Node* first_var = FindVarNode(first->outputs, first_args[i]);
+        PADDLE_ENFORCE_NOT_NULL(
+            first_var, platform::errors::NotFound(
+                           "Can not find the output %s of the op %s.",
+                           first_args[i], first->Op()->Type()));
+        for (auto* reader : var->outputs) {
+          reader->Op()->RenameInput(var->Name(), first_var->Name());
+          reader->Op()->Flush();
+          if (std::find(reader->inputs.begin(), reader->inputs.end(),
+                        first_var) == reader->inputs.end()) {
+            IR_NODE_LINK_TO(first_var, reader);
+          }
+        }
+        nodes_to_remove.insert(var);
+      }
+    }
+    VLOG(4) << "merge the op " << op->Type() << " into the same op writing "
+            << first->outputs[0]->Name();
+    GraphSafeRemoveNodes(graph, nodes_to_remove);
+    ++found_count;
+  }
+
+  AddStatis(found_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(common_subexpression_elimination_pass,
+              paddle::framework::ir::CommonSubexpressionEliminationPass);
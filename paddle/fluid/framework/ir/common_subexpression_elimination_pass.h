@@ -0,0 +1,41 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/*
+ * Merges the pure ops of the same type and attributes which read the same
+ * versions of the same vars, such as the duplicated shape, slice, cast and
+ * reshape chains of the programs converted from dygraph. The readers of the
+ * outputs of a duplicate read the outputs of the first op instead, and the
+ * duplicate is removed. The outputs which are fetched are kept, since their
+ * names are the names of the outputs of the predictor.
+ */
+class CommonSubexpressionEliminationPass : public FusePassBase {
+ public:
+  virtual ~CommonSubexpressionEliminationPass() {}
+
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
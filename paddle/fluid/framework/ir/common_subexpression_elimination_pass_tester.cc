@@ -0,0 +1,81 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "paddle/fluid/framework/ir/common_subexpression_elimination_pass.h"
+
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+TEST(CommonSubexpressionEliminationPass, basic) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (x)                        scale            -> scale_out_0
+  // (x)                        scale            -> scale_out_1
+  // (x)                        scale            -> scale_out_2
+  // (scale_out_0)              relu             -> relu_out_0
+  // (scale_out_1)              relu             -> relu_out_1
+  // (relu_out_0, relu_out_1)   elementwise_add  -> add_out_0
+  // (add_out_0, scale_out_2)   elementwise_add  -> add_out_1
+  // (x)                        sigmoid          -> sigmoid_out_0
+  // (x)                        sigmoid          -> sigmoid_out_1
+  // (add_out_1)                fetch
+  // (sigmoid_out_0)            fetch
+  // (sigmoid_out_1)            fetch
+  Layers layers;
+  auto* x = layers.data("x", {4, 8});
+  auto* scale_out_0 = layers.scale(x, 2.0f, 0.0f, true);
+  auto* scale_out_1 = layers.scale(x, 2.0f, 0.0f, true);
+  auto* scale_out_2 = layers.scale(x, 3.0f, 0.0f, true);
+  auto* relu_out_0 = layers.relu(scale_out_0);
+  auto* relu_out_1 = layers.relu(scale_out_1);
+  auto* add_out_0 = layers.elementwise_add(relu_out_0, relu_out_1);
+  auto* add_out_1 = layers.elementwise_add(add_out_0, scale_out_2);
+  auto* sigmoid_out_0 = layers.sigmoid(x);
+  auto* sigmoid_out_1 = layers.sigmoid(x);
+  layers.fetch(add_out_1, 0);
+  layers.fetch(sigmoid_out_0, 1);
+  layers.fetch(sigmoid_out_1, 2);
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(layers.main_program()));
+  auto pass =
+      PassRegistry::Instance().Get("common_subexpression_elimination_pass");
+  VLOG(3) << DebugString(graph);
+
+  graph.reset(pass->Apply(graph.release()));
+  VLOG(3) << DebugString(graph);
+
+  // The scale by 3 differs in its attributes, and the sigmoids are fetched
+  EXPECT_EQ(GetNumOpNodes(graph, "scale"), 2);
+  EXPECT_EQ(GetNumOpNodes(graph, "relu"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "elementwise_add"), 2);
+  EXPECT_EQ(GetNumOpNodes(graph, "sigmoid"), 2);
+  for (auto* node : GetOpNodes(graph, "elementwise_add")) {
+    auto* op = node->Op();
+    if (op->Output("Out")[0] == add_out_0->Name()) {
+      EXPECT_EQ(op->Input("X")[0], relu_out_0->Name());
+      EXPECT_EQ(op->Input("Y")[0], relu_out_0->Name());
+    } else {
+      EXPECT_EQ(op->Input("Y")[0], scale_out_2->Name());
+    }
+  }
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(common_subexpression_elimination_pass);
@@ -0,0 +1,167 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/constant_folding_pass.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+namespace {
+
+bool IsInitializedTensor(const Scope& scope, const std::string& name) {
+  auto* var = scope.FindVar(name);
+  return var != nullptr && var->IsType<LoDTensor>() &&
+         var->Get<LoDTensor>().IsInitialized();
+}
+
+bool IsLoDTensorVar(Node* node) {
+  return node->IsVar() && node->Var() != nullptr &&
+         node->Var()->GetType() == proto::VarType::LOD_TENSOR;
+}
+
+}  // namespace
+
+void ConstantFoldingPass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init("constant_folding", graph);
+  auto* scope = param_scope();
+
+  // A var written more than once has several nodes of the same name, and is
+  // not a constant
+  std::unordered_map<std::string, int> num_var_nodes;
+  bool has_sub_blocks = false;
+  for (auto* node : graph->Nodes()) {
+    if (node->IsVar() && node->Var()) {
+      ++num_var_nodes[node->Name()];
+    } else if (node->IsOp() && node->Op() && HasSubBlock(*node->Op())) {
+      has_sub_blocks = true;
+    }
+  }
+
+  // The var nodes whose values are in the param scope
+  std::unordered_set<Node*> constant_vars;
+  auto is_constant = [&](Node* var) {
+    if (constant_vars.count(var)) return true;
+    return IsLoDTensorVar(var) && var->Var()->Persistable() &&
+           num_var_nodes[var->Name()] == 1 &&
+           IsInitializedTensor(*scope, var->Name());
+  };
+  auto is_foldable = [&](Node* op_node) {
+    auto* op = op_node->Op();
+    if (op == nullptr || !IsPureOp(*op) || op_node->outputs.empty()) {
+      return false;
+    }
+    for (auto* in : op_node->inputs) {
+      if (!is_constant(in)) return false;
+    }
+    for (auto* out : op_node->outputs) {
+      if (!IsLoDTensorVar(out) || out->Var()->Persistable() ||
+          num_var_nodes[out->Name()] != 1 ||
+          scope->FindVar(out->Name()) != nullptr) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  std::vector<Node*> folded_ops;
+  for (auto* op_node : TopologySortOperations(*graph)) {
+    if (!is_foldable(op_node)) continue;
+    std::vector<std::string> out_names;
+    for (auto* out : op_node->outputs) {
+      scope->Var(out->Name());
+      out_names.push_back(out->Name());
+    }
+    bool success = true;
+    try {
+      OpRegistry::CreateOp(*op_node->Op())->Run(*scope, platform::CPUPlace());
+    } catch (const std::exception& e) {
+      VLOG(3) << "Can not fold the op " << op_node->Op()->Type() << ": "
+              << e.what();
+      success = false;
+    }
+    for (auto* out : op_node->outputs) {
+      // The unused outputs, like the XShape of transpose2, may stay empty
+      if (success && !out->outputs.empty() &&
+          !IsInitializedTensor(*scope, out->Name())) {
+        success = false;
+      }
+    }
+    if (!success) {
+      scope->EraseVars(out_names);
+      continue;
+    }
+    VLOG(4) << "fold the op " << op_node->Op()->Type() << " into "
+            << string::join_strings(out_names, ',');
+    folded_ops.push_back(op_node);
+    constant_vars.insert(op_node->outputs.begin(), op_node->outputs.end());
+  }
+
+  std::unordered_set<const Node*> folded_set(folded_ops.begin(),
+                                             folded_ops.end());
+  std::unordered_set<const Node*> nodes_to_remove(folded_ops.begin(),
+                                                  folded_ops.end());
+  std::vector<std::string> dead_vars;
+  auto remove_or_keep = [&](Node* var) {
+    if (nodes_to_remove.count(var)) return;
+    bool is_dead = true;
+    for (auto* consumer : var->outputs) {
+      if (!folded_set.count(consumer)) is_dead = false;
+    }
+    const bool is_folded_output =
+        !var->inputs.empty() && folded_set.count(var->inputs[0]);
+    if (!is_dead) {
+      // The rest of the graph reads the value from the param scope
+      if (is_folded_output) {
+        auto& tensor = scope->FindVar(var->Name())->Get<LoDTensor>();
+        var->Var()->SetPersistable(true);
+        var->Var()->SetShape(framework::vectorize(tensor.dims()));
+      }
+      return;
+    }
+    nodes_to_remove.insert(var);
+    // The ops of the sub-blocks are not in the graph, and may still read
+    // the parameters
+    if (is_folded_output || !has_sub_blocks) {
+      dead_vars.push_back(var->Name());
+    }
+  };
+  for (auto* op_node : folded_ops) {
+    for (auto* in : op_node->inputs) remove_or_keep(in);
+    for (auto* out : op_node->outputs) remove_or_keep(out);
+  }
+  GraphSafeRemoveNodes(graph, nodes_to_remove);
+  scope->EraseVars(dead_vars);
+
+  AddStatis(folded_ops.size());
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(constant_folding_pass,
+              paddle::framework::ir::ConstantFoldingPass);
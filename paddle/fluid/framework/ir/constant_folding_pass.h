@@ -0,0 +1,41 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/*
+ * Evaluates the ops whose inputs are all constant, i.e. the parameters in
+ * the param scope or the outputs of other folded ops, once at analysis time
+ * with their CPU kernels. The outputs still read by the rest of the graph
+ * become persistable vars in the param scope, and the folded ops and the
+ * vars only they read are removed. This folds, e.g., the reshapes,
+ * transposes and scales of weights and the fill_constant ops.
+ */
+class ConstantFoldingPass : public FusePassBase {
+ public:
+  virtual ~ConstantFoldingPass() {}
+
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,88 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/constant_folding_pass.h"
+
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/framework/op_registry.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+TEST(ConstantFoldingPass, basic) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (weights)                  transpose2       -> transpose_out
+  // (transpose_out)            scale            -> scale_out_0
+  // (x)                        scale            -> scale_out_1
+  // (scale_out_1, scale_out_0) matmul           -> matmul_out
+  Layers layers;
+  auto* x = layers.data("x", {2, 3});
+  auto* weights = layers.data("weights", {4, 3}, true);
+  auto* transpose_out = layers.transpose2(weights, {1, 0}, true);
+  auto* scale_out_0 = layers.scale(transpose_out, 2.0f, 1.0f, true);
+  auto* scale_out_1 = layers.scale(x, 0.5f, 0.0f, true);
+  layers.matmul(scale_out_1, scale_out_0);
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(layers.main_program()));
+  std::unique_ptr<Scope> param_scope(new Scope());
+  auto* w_tensor = param_scope->Var("weights")->GetMutable<LoDTensor>();
+  w_tensor->Resize({4, 3});
+  auto* w_data = w_tensor->mutable_data<float>(platform::CPUPlace());
+  for (int i = 0; i < 12; ++i) {
+    w_data[i] = static_cast<float>(i);
+  }
+  graph->Set("__param_scope__", param_scope.get());
+  auto pass = PassRegistry::Instance().Get("constant_folding_pass");
+  VLOG(3) << DebugString(graph);
+
+  graph.reset(pass->Apply(graph.release()));
+  VLOG(3) << DebugString(graph);
+
+  // Only the scale of the activation x stays
+  EXPECT_EQ(GetNumOpNodes(graph, "transpose2"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "scale"), 1);
+  EXPECT_EQ(param_scope->FindVar("weights"), nullptr);
+
+  auto matmuls = GetOpNodes(graph, "matmul");
+  ASSERT_EQ(matmuls.size(), 1UL);
+  const std::string y_name = matmuls[0]->Op()->Input("Y")[0];
+  ASSERT_EQ(y_name, scale_out_0->Name());
+  for (auto* in : matmuls[0]->inputs) {
+    if (in->Name() == y_name) {
+      EXPECT_TRUE(in->Var()->Persistable());
+    }
+  }
+  auto* y_var = param_scope->FindVar(y_name);
+  ASSERT_NE(y_var, nullptr);
+  const auto& y_tensor = y_var->Get<LoDTensor>();
+  ASSERT_EQ(y_tensor.dims(), make_ddim({3, 4}));
+  const float* y_data = y_tensor.data<float>();
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      // The transposed weights are j * 3 + i
+      EXPECT_FLOAT_EQ(y_data[i * 4 + j], 2.0f * (j * 3 + i) + 1.0f);
+    }
+  }
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(constant_folding_pass);
+USE_OP(transpose2);
+USE_OP(scale);
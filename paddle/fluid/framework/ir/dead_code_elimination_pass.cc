@@ -0,0 +1,101 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/dead_code_elimination_pass.h"
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+void DeadCodeEliminationPass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init("dead_code_elimination", graph);
+
+  // The ops with side effects and the ops writing the parameters are live,
+  // and so are the ops writing the vars read by live ops
+  std::unordered_set<Node*> live_ops;
+  std::vector<Node*> live_ops_to_visit;
+  bool has_fetch = false;
+  for (auto* node : graph->Nodes()) {
+    if (!node->IsOp()) continue;
+    bool is_live = node->Op() == nullptr || !IsPureOp(*node->Op());
+    for (auto* out : node->outputs) {
+      if (out->Var() && out->Var()->Persistable()) is_live = true;
+    }
+    if (is_live) {
+      live_ops.insert(node);
+      live_ops_to_visit.push_back(node);
+    }
+    if (node->Op() && node->Op()->Type() == "fetch") has_fetch = true;
+  }
+  if (!has_fetch) {
+    VLOG(3) << "The graph has no fetch ops, dead_code_elimination_pass "
+               "does not know its outputs.";
+    AddStatis(0);
+    return;
+  }
+  while (!live_ops_to_visit.empty()) {
+    auto* op_node = live_ops_to_visit.back();
+    live_ops_to_visit.pop_back();
+    for (auto* in : op_node->inputs) {
+      for (auto* writer : in->inputs) {
+        if (live_ops.insert(writer).second) {
+          live_ops_to_visit.push_back(writer);
+        }
+      }
+    }
+  }
+
+  // The vars are removed with the dead ops if no live op reads or writes
+  // them
+  std::unordered_set<const Node*> nodes_to_remove;
+  auto is_used_by_live_ops = [&](Node* var) {
+    for (auto* op_node : var->inputs) {
+      if (live_ops.count(op_node)) return true;
+    }
+    for (auto* op_node : var->outputs) {
+      if (live_ops.count(op_node)) return true;
+    }
+    return false;
+  };
+  int found_count = 0;
+  for (auto* node : graph->Nodes()) {
+    if (!node->IsOp() || live_ops.count(node)) continue;
+    VLOG(4) << "remove the dead op " << node->Op()->Type();
+    nodes_to_remove.insert(node);
+    for (auto* in : node->inputs) {
+      if (!is_used_by_live_ops(in)) nodes_to_remove.insert(in);
+    }
+    for (auto* out : node->outputs) {
+      if (!is_used_by_live_ops(out)) nodes_to_remove.insert(out);
+    }
+    ++found_count;
+  }
+  GraphSafeRemoveNodes(graph, nodes_to_remove);
+
+  AddStatis(found_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(dead_code_elimination_pass,
+              paddle::framework::ir::DeadCodeEliminationPass);
@@ -0,0 +1,119 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "paddle/fluid/framework/ir/dead_code_elimination_pass.h"
+
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+static std::unique_ptr<ir::Graph> ApplyPass(const ProgramDesc& program) {
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(program));
+  auto pass = PassRegistry::Instance().Get("dead_code_elimination_pass");
+  VLOG(3) << DebugString(graph);
+  graph.reset(pass->Apply(graph.release()));
+  VLOG(3) << DebugString(graph);
+  return graph;
+}
+
+static bool HasVarNode(const std::unique_ptr<ir::Graph>& graph,
+                       const std::string& name) {
+  for (auto* node : graph->Nodes()) {
+    if (node->IsVar() && node->Name() == name) return true;
+  }
+  return false;
+}
+
+TEST(DeadCodeEliminationPass, basic) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (x)                        relu             -> relu_out
+  // (x)                        sigmoid          -> sigmoid_out
+  // (sigmoid_out)              tanh             -> tanh_out
+  // (tanh_out, weights)        mul              -> mul_out
+  // (relu_out)                 fetch
+  Layers layers;
+  auto* x = layers.data("x", {4, 8});
+  auto* weights = layers.data("weights", {8, 8}, true);
+  auto* relu_out = layers.relu(x);
+  auto* sigmoid_out = layers.sigmoid(x);
+  auto* tanh_out = layers.tanh(sigmoid_out);
+  layers.mul(tanh_out, weights);
+  layers.fetch(relu_out);
+
+  auto graph = ApplyPass(layers.main_program());
+  EXPECT_EQ(GetNumOpNodes(graph, "relu"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "fetch"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "sigmoid"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "tanh"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "mul"), 0);
+  EXPECT_TRUE(HasVarNode(graph, x->Name()));
+  EXPECT_FALSE(HasVarNode(graph, weights->Name()));
+  EXPECT_FALSE(HasVarNode(graph, tanh_out->Name()));
+}
+
+TEST(DeadCodeEliminationPass, side_effects) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (x)                        relu             -> relu_out
+  // (x)                        sigmoid          -> sigmoid_out
+  // (sigmoid_out)              c_allreduce_sum  -> allreduce_out
+  //                            recv_v2          -> recv_out
+  // (relu_out)                 fetch
+  //
+  // The communication ops are kept though their outputs are unused
+  Layers layers;
+  auto* x = layers.data("x", {4, 8});
+  auto* relu_out = layers.relu(x);
+  auto* sigmoid_out = layers.sigmoid(x);
+  layers.fetch(relu_out);
+
+  ProgramDesc program(layers.main_program());
+  auto* block = program.MutableBlock(0);
+  block->Var("allreduce_out");
+  block->Var("recv_out");
+  auto* allreduce = block->AppendOp();
+  allreduce->SetType("c_allreduce_sum");
+  allreduce->SetInput("X", {sigmoid_out->Name()});
+  allreduce->SetOutput("Out", {"allreduce_out"});
+  auto* recv = block->AppendOp();
+  recv->SetType("recv_v2");
+  recv->SetOutput("Out", {"recv_out"});
+
+  auto graph = ApplyPass(program);
+  EXPECT_EQ(GetNumOpNodes(graph, "relu"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "sigmoid"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "c_allreduce_sum"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "recv_v2"), 1);
+  EXPECT_TRUE(HasVarNode(graph, "allreduce_out"));
+}
+
+TEST(DeadCodeEliminationPass, no_fetch) {
+  // Without fetch ops, the outputs of the graph are unknown
+  Layers layers;
+  auto* x = layers.data("x", {4, 8});
+  layers.sigmoid(layers.relu(x));
+
+  auto graph = ApplyPass(layers.main_program());
+  EXPECT_EQ(GetNumOpNodes(graph, "relu"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "sigmoid"), 1);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(dead_code_elimination_pass);
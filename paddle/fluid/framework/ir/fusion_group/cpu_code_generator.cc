@@ -0,0 +1,194 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/ir/fusion_group/cpu_code_generator.h"
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include "paddle/fluid/framework/ir/fusion_group/operation.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+// The operations of the CPU code by the op types
+static const std::unordered_map<std::string, std::string>& CPUOperations() {
+  static const std::unordered_map<std::string, std::string> operations{
+      {"elementwise_add", "add"}, {"elementwise_sub", "sub"},
+      {"elementwise_mul", "mul"}, {"elementwise_div", "div"},
+      {"elementwise_min", "min"}, {"elementwise_max", "max"},
+      {"relu", "relu"},           {"sigmoid", "sigmoid"},
+      {"tanh", "tanh"},           {"sqrt", "sqrt"},
+      {"square", "square"},       {"assign", "copy"},
+      {"cast", "copy"},           {"scale", "scale"},
+      {"sum", "add"}};
+  return operations;
+}
+
+static Node* FindVar(const std::vector<Node*>& nodes, const std::string& name) {
+  for (auto* n : nodes) {
+    if (n->IsVar() && n->Var() && n->Name() == name) {
+      return n;
+    }
+  }
+  return nullptr;
+}
+
+std::string CPUCodeGenerator::Generate(SubGraph* subgraph,
+                                       const std::vector<Node*>& input_vars,
+                                       const std::vector<Node*>& output_vars) {
+  std::unordered_map<Node*, std::string> regs;
+  for (size_t i = 0; i < input_vars.size(); ++i) {
+    regs[input_vars[i]] = "x" + std::to_string(i);
+  }
+  std::unordered_map<Node*, std::string> output_regs;
+  for (size_t j = 0; j < output_vars.size(); ++j) {
+    if (regs.count(output_vars[j])) return "";
+    output_regs[output_vars[j]] = "y" + std::to_string(j);
+  }
+
+  // The kernel runs all the inputs and outputs in one data type, so the
+  // casts of the subgraph can only be copies
+  std::vector<Node*> var_nodes(input_vars);
+  var_nodes.insert(var_nodes.end(), output_vars.begin(), output_vars.end());
+  std::vector<Node*> op_nodes;
+  for (auto* n : subgraph->SortedNodes()) {
+    if (n && n->IsOp() && n->Op()) {
+      op_nodes.push_back(n);
+    } else if (n && n->IsVar() && n->Var()) {
+      var_nodes.push_back(n);
+    }
+  }
+  if (var_nodes.empty()) return "";
+  const auto dtype = var_nodes[0]->Var()->GetDataType();
+  if (dtype != proto::VarType::FP32 && dtype != proto::VarType::FP64) {
+    VLOG(3) << "Data type " << dtype << " of " << var_nodes[0]->Name()
+            << " is not supported on CPU.";
+    return "";
+  }
+  for (auto* n : var_nodes) {
+    if (n->Var()->GetDataType() != dtype) {
+      VLOG(3) << "Data type " << n->Var()->GetDataType() << " of "
+              << n->Name() << " differs from " << dtype
+              << " of the subgraph, which is not supported on CPU.";
+      return "";
+    }
+  }
+  // The temporaries are reused after the last op reading them
+  std::unordered_map<Node*, size_t> last_reads;
+  for (size_t i = 0; i < op_nodes.size(); ++i) {
+    for (auto* in : op_nodes[i]->inputs) {
+      last_reads[in] = i;
+    }
+  }
+  std::vector<std::string> free_temps;
+  int num_temps = 0;
+
+  std::ostringstream code;
+  code.precision(17);
+  code << "// " << subgraph->GetFuncName() << "\n";
+  for (size_t i = 0; i < op_nodes.size(); ++i) {
+    auto* node = op_nodes[i];
+    auto* op = node->Op();
+    auto iter = CPUOperations().find(op->Type());
+    if (iter == CPUOperations().end()) {
+      VLOG(3) << "Operation " << op->Type() << " is not supported on CPU.";
+      return "";
+    }
+    if (op->Type() == "scale" && op->Inputs().count("ScaleTensor") &&
+        !op->Input("ScaleTensor").empty()) {
+      return "";
+    }
+
+    std::vector<std::string> srcs;
+    for (auto& name : OperationMap::Instance().Get(op->Type()).input_names) {
+      if (!op->Inputs().count(name)) return "";
+      for (auto& arg : op->Input(name)) {
+        auto reg = regs.find(FindVar(node->inputs, arg));
+        if (reg == regs.end()) return "";
+        srcs.push_back(reg->second);
+      }
+    }
+    Node* out = op->Outputs().count("Out") && op->Output("Out").size() == 1
+                    ? FindVar(node->outputs, op->Output("Out")[0])
+                    : nullptr;
+    if (srcs.empty() || out == nullptr || regs.count(out)) return "";
+
+    // A sum writes its output before reading all the inputs, so it can not
+    // run in place
+    const bool in_place = op->Type() != "sum";
+    auto free_read_temps = [&] {
+      std::unordered_set<std::string> freed;
+      for (auto* in : node->inputs) {
+        auto reg = regs.find(in);
+        if (reg != regs.end() && reg->second[0] == 't' &&
+            last_reads[in] == i && freed.insert(reg->second).second) {
+          free_temps.push_back(reg->second);
+        }
+      }
+    };
+    if (in_place) free_read_temps();
+    std::string dst;
+    if (output_regs.count(out)) {
+      dst = output_regs[out];
+    } else if (!free_temps.empty()) {
+      dst = free_temps.back();
+      free_temps.pop_back();
+    } else {
+      dst = "t" + std::to_string(num_temps++);
+    }
+    if (!in_place) free_read_temps();
+    regs[out] = dst;
+
+    if (op->Type() == "sum") {
+      if (srcs.size() == 1) {
+        code << dst << " = copy " << srcs[0] << "\n";
+      } else {
+        code << dst << " = add " << srcs[0] << " " << srcs[1] << "\n";
+        for (size_t k = 2; k < srcs.size(); ++k) {
+          code << dst << " = add " << dst << " " << srcs[k] << "\n";
+        }
+      }
+    } else if (op->Type() == "scale") {
+      // out = scale * x + bias, or scale * (x + bias)
+      double scale = op->HasAttr("scale")
+                         ? BOOST_GET_CONST(float, op->GetAttr("scale"))
+                         : 1.0;
+      double bias = op->GetAttrIfExists<float>("bias");
+      if (op->HasAttr("bias_after_scale") &&
+          !BOOST_GET_CONST(bool, op->GetAttr("bias_after_scale"))) {
+        bias *= scale;
+      }
+      code << dst << " = scale " << srcs[0] << " " << scale << " " << bias
+           << "\n";
+    } else {
+      code << dst << " = " << iter->second;
+      for (auto& src : srcs) {
+        code << " " << src;
+      }
+      code << "\n";
+    }
+  }
+
+  for (auto* out : output_vars) {
+    if (!regs.count(out)) return "";
+  }
+  return code.str();
+}
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,40 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/ir/fusion_group/subgraph.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+// Generates the code of an elementwise subgraph for the CPU kernel of the
+// fusion_group op, see operators/fused/fusion_group_cpu.h.
+class CPUCodeGenerator {
+ public:
+  // Returns the code computing the output_vars of the subgraph from its
+  // input_vars, in the order of the inputs and outputs of the fusion_group
+  // op, or an empty string if some operation can not run on CPU.
+  std::string Generate(SubGraph* subgraph, const std::vector<Node*>& input_vars,
+                       const std::vector<Node*>& output_vars);
+};
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
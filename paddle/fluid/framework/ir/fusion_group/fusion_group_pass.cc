@@ -17,6 +17,7 @@ limitations under the License. */
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_code_generator.h"
 #include "paddle/fluid/framework/ir/fusion_group/elementwise_group_detector.h"
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
@@ -29,27 +30,46 @@ namespace ir {
 
 void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
   FusePassBase::Init("fusion_group_pass", graph);
-  if (Get<bool>("use_gpu")) {
-    // TODO(liuyiqun): open this check.
-    // if (!platform::CUDADeviceCode::IsAvailable()) {
-    //   LOG(WARNING)
-    //       << "Disable fusion_group because CUDA Driver or NVRTC is not
-    //       avaiable.";
-    //   return 0;
-    // }
-
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+  // TODO(liuyiqun): open this check on GPU.
+  // if (!platform::CUDADeviceCode::IsAvailable()) {
+  //   LOG(WARNING)
+  //       << "Disable fusion_group because CUDA Driver or NVRTC is not
+  //       avaiable.";
+  //   return 0;
+  // }
+
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups.";
+}
+
+// The input and output var nodes of the fusion_group op of the subgraph
+static void GetFusionGroupVars(fusion_group::SubGraph* subgraph,
+                               std::vector<Node*>* input_vars,
+                               std::vector<Node*>* output_vars) {
+  *output_vars = subgraph->GetOutputVarNodes(subgraph->SaveIntermediateOut());
+  std::unordered_set<Node*> output_vars_set(output_vars->begin(),
+                                            output_vars->end());
+  for (auto* n : subgraph->GetInputVarNodes()) {
+    // It is not an output var node.
+    if (output_vars_set.find(n) == output_vars_set.end()) {
+      input_vars->push_back(n);
+    }
   }
 }
 
 int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  int index = platform::DeviceCodePool::Init({place}).size(place);
+  const bool use_gpu = Get<bool>("use_gpu");
+  int index = 0;
+#ifdef PADDLE_WITH_CUDA
+  if (use_gpu) {
+    // TODO(liuyiqun): supported different places
+    platform::CUDAPlace place = platform::CUDAPlace(0);
+    index = platform::DeviceCodePool::Init({place}).size(place);
+  }
+#endif
 
   std::vector<std::vector<Node*>> subgraphs =
       fusion_group::ElementwiseGroupDetector()(graph);
@@ -65,8 +85,11 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 
     if (subgraph.IsValid(min_subgraph_size)) {
       subgraph.SetFuncName("fused_elementwise_" + std::to_string(index++));
-      if (GenerateCode(&subgraph)) {
-        InsertFusionGroupOp(graph, &subgraph);
+      // The CPU kernel runs the code carried by the op
+      std::string code;
+      if (use_gpu ? GenerateCode(&subgraph)
+                  : GenerateCPUCode(&subgraph, &code)) {
+        InsertFusionGroupOp(graph, &subgraph, code);
         num_subgraphs++;
       }
     }
@@ -75,6 +98,7 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 }
 
 bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
+#ifdef PADDLE_WITH_CUDA
   fusion_group::CodeGenerator code_generator;
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(4) << code_str;
@@ -89,6 +113,22 @@ bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
     pool.Set(std::move(device_code));
   }
   return is_compiled;
+#else
+  LOG(WARNING) << "fusion_group_pass generates the GPU code only when "
+                  "compiled with CUDA.";
+  return false;
+#endif
+}
+
+bool FusionGroupPass::GenerateCPUCode(fusion_group::SubGraph* subgraph,
+                                      std::string* code) const {
+  std::vector<Node*> input_vars;
+  std::vector<Node*> output_vars;
+  GetFusionGroupVars(subgraph, &input_vars, &output_vars);
+  *code = fusion_group::CPUCodeGenerator().Generate(subgraph, input_vars,
+                                                     output_vars);
+  VLOG(4) << *code;
+  return !code->empty();
 }
 
 static int ExtractOpRole(fusion_group::SubGraph* subgraph) {
@@ -108,25 +148,21 @@ static int ExtractOpRole(fusion_group::SubGraph* subgraph) {
   }
 }
 
-void FusionGroupPass::InsertFusionGroupOp(
-    Graph* graph, fusion_group::SubGraph* subgraph) const {
-  const std::vector<Node*>& input_vars = subgraph->GetInputVarNodes();
-  const std::vector<Node*>& output_vars =
-      subgraph->GetOutputVarNodes(subgraph->SaveIntermediateOut());
+void FusionGroupPass::InsertFusionGroupOp(Graph* graph,
+                                          fusion_group::SubGraph* subgraph,
+                                          const std::string& code) const {
+  std::vector<Node*> input_vars;
+  std::vector<Node*> output_vars;
+  GetFusionGroupVars(subgraph, &input_vars, &output_vars);
   std::unordered_set<Node*> external_nodes;
 
   // Prepare inputs.
   std::vector<std::string> input_names;
   std::vector<int> input_dtypes;
-  std::unordered_set<Node*> output_vars_set(output_vars.begin(),
-                                            output_vars.end());
   for (auto* n : input_vars) {
-    // It is not an output var node.
-    if (output_vars_set.find(n) == output_vars_set.end()) {
-      input_names.push_back(n->Name());
-      input_dtypes.push_back(n->Var()->GetDataType());
-      external_nodes.insert(n);
-    }
+    input_names.push_back(n->Name());
+    input_dtypes.push_back(n->Var()->GetDataType());
+    external_nodes.insert(n);
   }
 
   // Prepare outputs.
@@ -146,14 +182,13 @@ void FusionGroupPass::InsertFusionGroupOp(
   op_desc.SetAttr("outs_dtype", output_dtypes);
   op_desc.SetAttr("type", subgraph->GetType());
   op_desc.SetAttr("func_name", subgraph->GetFuncName());
+  op_desc.SetAttr("code", code);
   op_desc.SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
                   ExtractOpRole(subgraph));
 
   Node* fusion_group_node = graph->CreateOpNode(&op_desc);
   for (auto* in : input_vars) {
-    if (output_vars_set.find(in) == output_vars_set.end()) {
-      IR_NODE_LINK_TO(in, fusion_group_node);
-    }
+    IR_NODE_LINK_TO(in, fusion_group_node);
   }
   for (auto* out : output_vars) {
     IR_NODE_LINK_TO(fusion_group_node, out);
@@ -30,8 +30,10 @@ class FusionGroupPass : public FusePassBase {
  private:
   int DetectFusionGroup(Graph* graph, int type = 0) const;
   bool GenerateCode(fusion_group::SubGraph* subgraph) const;
-  void InsertFusionGroupOp(Graph* graph,
-                           fusion_group::SubGraph* subgraph) const;
+  bool GenerateCPUCode(fusion_group::SubGraph* subgraph,
+                       std::string* code) const;
+  void InsertFusionGroupOp(Graph* graph, fusion_group::SubGraph* subgraph,
+                           const std::string& code) const;
 
   const std::string name_scope_{"fusion_group"};
 };
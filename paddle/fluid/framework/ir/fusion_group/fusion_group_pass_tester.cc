@@ -133,20 +133,68 @@ std::unique_ptr<Graph> BuildElementwiseTreeGraph(bool backward = false) {
 #endif
 }
 
-int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
+std::unique_ptr<Graph> BuildCastGraph(proto::VarType::Type out_dtype) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // x                          relu             -> tmp_0
+  // tmp_0                      cast             -> tmp_1
+  // (tmp_1, y)                 elementwise_add  -> tmp_2
+  // tmp_2                      sigmoid          -> tmp_3
+  //
+  // Expression: tmp_3 = sigmoid(cast(relu(x)) + y), where x and tmp_0 are
+  // FP32, and the others are out_dtype
+  Layers layers;
+  std::vector<int64_t> shape = {16, 32};
+  auto* x = layers.data("x", shape);
+  auto* tmp_0 = layers.relu(x);
+  auto* tmp_1 = layers.cast(tmp_0, proto::VarType::FP32, out_dtype);
+  auto* y = layers.data("y", shape);
+  auto* tmp_2 = layers.elementwise_add(tmp_1, y);
+  auto* tmp_3 = layers.sigmoid(tmp_2);
+  for (auto* var : {tmp_0, tmp_1, tmp_2, tmp_3}) {
+    var->SetShape(shape);
+  }
+
+  std::unique_ptr<Graph> graph(new Graph(layers.main_program()));
+  for (auto* n : graph->Nodes()) {
+    if (n && n->IsVar() && n->Var()) {
+      auto name = n->Name();
+      n->Var()->SetDataType(name == x->Name() || name == tmp_0->Name()
+                                ? proto::VarType::FP32
+                                : out_dtype);
+    }
+  }
+#ifdef __clang__
+  return graph;
+#else
+  return std::move(graph);
+#endif
+}
+
+int TestMain(std::unique_ptr<Graph> graph, std::string prefix,
+             bool use_gpu = true) {
   // VisualizeGraph(&graph, prefix + ".dot");
   auto pass = PassRegistry::Instance().Get("fusion_group_pass");
-  pass->Set("use_gpu", new bool(true));
+  pass->Set("use_gpu", new bool(use_gpu));
   VLOG(3) << DebugString(graph);
 
   graph.reset(pass->Apply(graph.release()));
   // VisualizeGraph(&graph, prefix + ".fusion_group.dot");
   int num_fusion_group_ops = GetNumOpNodes(graph, "fusion_group");
   VLOG(3) << DebugString(graph);
+  for (auto* n : graph->Nodes()) {
+    if (n->IsOp() && n->Op()->Type() == "fusion_group") {
+      // Only the ops generated for CPU carry their code
+      auto code = BOOST_GET_CONST(std::string, n->Op()->GetAttr("code"));
+      VLOG(3) << code;
+      EXPECT_EQ(code.empty(), use_gpu);
+    }
+  }
 
   return num_fusion_group_ops;
 }
 
+#ifdef PADDLE_WITH_CUDA
 TEST(FusionGroupPass, elementwise_list) {
   std::unique_ptr<Graph> graph = BuildElementwiseListGraph(true);
   int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_list");
@@ -158,6 +206,33 @@ TEST(FusionGroupPass, elementwise_tree) {
   int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_tree");
   EXPECT_EQ(num_fusion_group_ops, 4);
 }
+#endif
+
+TEST(FusionGroupPass, elementwise_list_cpu) {
+  // The backward ops are not supported on CPU
+  std::unique_ptr<Graph> graph = BuildElementwiseListGraph();
+  int num_fusion_group_ops =
+      TestMain(std::move(graph), "elementwise_list_cpu", false);
+  EXPECT_EQ(num_fusion_group_ops, 1);
+}
+
+TEST(FusionGroupPass, elementwise_tree_cpu) {
+  std::unique_ptr<Graph> graph = BuildElementwiseTreeGraph();
+  int num_fusion_group_ops =
+      TestMain(std::move(graph), "elementwise_tree_cpu", false);
+  EXPECT_EQ(num_fusion_group_ops, 2);
+}
+
+TEST(FusionGroupPass, cast_cpu) {
+  // The CPU kernel runs in one data type, so only the casts to the same type
+  // are fused
+  int num_fusion_group_ops = TestMain(
+      BuildCastGraph(proto::VarType::FP32), "cast_fp32_cpu", false);
+  EXPECT_EQ(num_fusion_group_ops, 1);
+  num_fusion_group_ops = TestMain(BuildCastGraph(proto::VarType::FP64),
+                                  "cast_fp64_cpu", false);
+  EXPECT_EQ(num_fusion_group_ops, 0);
+}
 
 }  // namespace ir
 }  // namespace framework
@@ -0,0 +1,211 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/gemm_weight_pack_pass.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+#ifdef PADDLE_WITH_MKLML
+namespace {
+
+// The K x N weight of a GEMM op, which the op reads with the leading
+// dimension ld
+struct GemmWeight {
+  std::string input;
+  std::string packed_input;
+  int K;
+  int N;
+  int ld;
+};
+
+// Returns false if the op can not run on a packed weight, which are only
+// the 2-D weights of the ops without transposes and scaling
+bool GetGemmWeight(OpDesc* op, const Scope& scope, GemmWeight* weight) {
+  if (op->GetAttrIfExists<bool>("use_mkldnn") || op->HasAttr("enable_int8")) {
+    return false;
+  }
+  bool padding_weights = false;
+  if (op->Type() == "fc") {
+    weight->input = "W";
+    weight->packed_input = "PackedW";
+    padding_weights = op->GetAttrIfExists<bool>("padding_weights");
+  } else if (op->Type() == "mul") {
+    weight->input = "Y";
+    weight->packed_input = "PackedY";
+    if (op->HasAttr("y_num_col_dims") &&
+        BOOST_GET_CONST(int, op->GetAttr("y_num_col_dims")) != 1) {
+      return false;
+    }
+  } else if (op->Type() == "matmul") {
+    weight->input = "Y";
+    weight->packed_input = "PackedY";
+    if (op->GetAttrIfExists<bool>("transpose_X") ||
+        op->GetAttrIfExists<bool>("transpose_Y") ||
+        op->GetAttrIfExists<int>("head_number") > 1 ||
+        (op->HasAttr("alpha") &&
+         BOOST_GET_CONST(float, op->GetAttr("alpha")) != 1.0f)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  const auto& inputs = op->Inputs();
+  if (inputs.count(weight->packed_input) || !inputs.count(weight->input) ||
+      op->Input(weight->input).size() != 1) {
+    return false;
+  }
+
+  auto* var = scope.FindVar(op->Input(weight->input)[0]);
+  if (var == nullptr || !var->IsType<LoDTensor>()) return false;
+  const auto& tensor = var->Get<LoDTensor>();
+  if (!tensor.IsInitialized() || tensor.type() != proto::VarType::FP32 ||
+      tensor.dims().size() != 2) {
+    return false;
+  }
+  const int pad = padding_weights ? 4 : 0;
+  weight->K = tensor.dims()[0] - pad;
+  weight->N = tensor.dims()[1] - pad;
+  weight->ld = tensor.dims()[1];
+  return weight->K > 0 && weight->N > 0;
+}
+
+// Packs the weight into a new var of the scope, and returns its name
+std::string PackWeight(const GemmWeight& weight, const std::string& w_name,
+                       Scope* scope) {
+  const auto& w_tensor = scope->FindVar(w_name)->Get<LoDTensor>();
+  // The packed format does not depend on the rows of X, which are only
+  // known at run time
+  const size_t bytes = operators::math::CBlas<float>::GEMM_PACK_GET_SIZE(
+      CblasBMatrix, 1, weight.N, weight.K);
+  const std::string packed_name = patterns::UniqueKey(w_name + "@packed");
+  auto* packed_tensor = scope->Var(packed_name)->GetMutable<LoDTensor>();
+  packed_tensor->Resize(
+      {static_cast<int64_t>((bytes + sizeof(float) - 1) / sizeof(float))});
+  auto* packed_data = packed_tensor->mutable_data<float>(platform::CPUPlace());
+  operators::math::CBlas<float>::GEMM_PACK(
+      CblasRowMajor, CblasBMatrix, CblasNoTrans, 1, weight.N, weight.K, 1.0f,
+      w_tensor.data<float>(), weight.ld, packed_data);
+  VLOG(4) << "pack the weight " << w_name << " of " << weight.K << " x "
+          << weight.N << " into " << packed_name;
+  return packed_name;
+}
+
+void DescribePackedWeight(const Scope& scope, VarDesc* desc) {
+  const auto& tensor = scope.FindVar(desc->Name())->Get<LoDTensor>();
+  desc->SetPersistable(true);
+  desc->SetShape(framework::vectorize(tensor.dims()));
+  desc->SetDataType(proto::VarType::FP32);
+}
+
+}  // namespace
+#endif
+
+int PackGemmWeights(BlockDesc* block, Scope* scope) {
+  int count = 0;
+#ifdef PADDLE_WITH_MKLML
+  std::unordered_map<std::string, std::string> packed_names;
+  for (auto* op : block->AllOps()) {
+    GemmWeight weight;
+    if (!GetGemmWeight(op, *scope, &weight)) continue;
+    const std::string& w_name = op->Input(weight.input)[0];
+    auto* w_var = block->FindVar(w_name);
+    if (w_var == nullptr || !w_var->Persistable()) continue;
+    auto it = packed_names.find(w_name);
+    if (it == packed_names.end()) {
+      it = packed_names.emplace(w_name, PackWeight(weight, w_name, scope))
+               .first;
+      DescribePackedWeight(*scope, block->Var(it->second));
+    }
+    op->SetInput(weight.packed_input, {it->second});
+    ++count;
+  }
+#endif
+  return count;
+}
+
+std::unordered_set<std::string> RemovePackedGemmWeights(BlockDesc* block) {
+  std::unordered_set<std::string> names;
+  for (auto* op : block->AllOps()) {
+    for (auto* input : {"PackedW", "PackedY"}) {
+      if (!op->Inputs().count(input)) continue;
+      for (auto& name : op->Input(input)) names.insert(name);
+      op->RemoveInput(input);
+    }
+  }
+  for (auto& name : names) block->RemoveVar(name);
+  return names;
+}
+
+void GemmWeightPackPass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init("gemm_weight_pack", graph);
+
+  int found_count = 0;
+#ifdef PADDLE_WITH_MKLML
+  auto* scope = param_scope();
+  // The packed weights by the name of the weight, shared by all its ops
+  std::unordered_map<std::string, Node*> packed_nodes;
+  for (auto* op_node : TopologySortOperations(*graph)) {
+    auto* op = op_node->Op();
+    GemmWeight weight;
+    if (!GetGemmWeight(op, *scope, &weight)) continue;
+    const std::string& w_name = op->Input(weight.input)[0];
+    Node* w_node = nullptr;
+    for (auto* in : op_node->inputs) {
+      if (in->IsVar() && in->Name() == w_name) w_node = in;
+    }
+    // Only the parameters stay constant across the runs
+    if (w_node == nullptr || w_node->Var() == nullptr ||
+        !w_node->Var()->Persistable()) {
+      continue;
+    }
+
+    auto it = packed_nodes.find(w_name);
+    if (it == packed_nodes.end()) {
+      VarDesc packed_desc(PackWeight(weight, w_name, scope));
+      DescribePackedWeight(*scope, &packed_desc);
+      it = packed_nodes.emplace(w_name, graph->CreateVarNode(&packed_desc))
+               .first;
+    }
+
+    op->SetInput(weight.packed_input, {it->second->Name()});
+    op->Flush();
+    IR_NODE_LINK_TO(it->second, op_node);
+    ++found_count;
+  }
+#else
+  VLOG(3) << "gemm_weight_pack_pass only packs the weights for MKL.";
+#endif
+
+  AddStatis(found_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(gemm_weight_pack_pass,
+              paddle::framework::ir::GemmWeightPackPass);
@@ -0,0 +1,52 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/graph.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/*
+ * Pack the constant weights of the fc, mul and matmul ops into the MKL packed
+ * GEMM format once at load time, instead of MKL packing them in every run.
+ * The packed weights are new persistable vars of the param scope, fed to the
+ * ops by their PackedW or PackedY inputs.
+ */
+class GemmWeightPackPass : public FusePassBase {
+ public:
+  virtual ~GemmWeightPackPass() {}
+
+ protected:
+  void ApplyImpl(Graph* graph) const override;
+};
+
+// Packs the weights of the GEMM ops of a block like GemmWeightPackPass, and
+// returns the number of ops packed. The programs saved without their packed
+// weights are packed again by this at load time.
+int PackGemmWeights(BlockDesc* block, Scope* scope);
+
+// Removes the packed weights from the ops and the vars of a block, and
+// returns their names. The packed format depends on the MKL build and the
+// CPU, so the programs are saved without them.
+std::unordered_set<std::string> RemovePackedGemmWeights(BlockDesc* block);
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,175 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/gemm_weight_pack_pass.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+void AddVarToScope(Scope* param_scope, const std::string& name,
+                   const DDim& dims) {
+  auto* tensor = param_scope->Var(name)->GetMutable<LoDTensor>();
+  tensor->Resize(dims);
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = static_cast<float>(i % 7);
+  }
+}
+
+Scope* CreateParamScope() {
+  auto param_scope = new Scope();
+  AddVarToScope(param_scope, "weights_0", {64, 32});
+  AddVarToScope(param_scope, "bias_0", {32});
+  AddVarToScope(param_scope, "weights_1", {32, 16});
+  AddVarToScope(param_scope, "weights_2", {16, 16});
+  return param_scope;
+}
+
+TEST(GemmWeightPackPass, basic) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (a, weights_0, bias_0)     fc               -> fc_out
+  // (fc_out, weights_1)        mul              -> mul_out
+  // (mul_out, weights_2)       matmul           -> matmul_out_0
+  // (matmul_out_0, weights_2)  matmul           -> matmul_out_1
+  // (matmul_out_1, b)          matmul           -> matmul_out_2
+  Layers layers;
+  auto* a = layers.data("a", {4, 64});
+  auto* b = layers.data("b", {16, 8});
+  auto* weights_0 = layers.data("weights_0", {64, 32}, true);
+  auto* bias_0 = layers.data("bias_0", {32}, true);
+  auto* fc_out = layers.fc(a, weights_0, bias_0);
+  auto* weights_1 = layers.data("weights_1", {32, 16}, true);
+  auto* mul_out = layers.mul(fc_out, weights_1);
+  auto* weights_2 = layers.data("weights_2", {16, 16}, true);
+  auto* matmul_out_0 = layers.matmul(mul_out, weights_2);
+  auto* matmul_out_1 = layers.matmul(matmul_out_0, weights_2);
+  layers.matmul(matmul_out_1, b);
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(layers.main_program()));
+  auto* param_scope = CreateParamScope();
+  graph->Set("__param_scope__", param_scope);
+  auto pass = PassRegistry::Instance().Get("gemm_weight_pack_pass");
+  int num_nodes_before = graph->Nodes().size();
+  VLOG(3) << DebugString(graph);
+
+  graph.reset(pass->Apply(graph.release()));
+  int num_nodes_after = graph->Nodes().size();
+  VLOG(3) << DebugString(graph);
+
+  int num_packed_ops = 0;
+  for (auto* node : graph->Nodes()) {
+    if (!node->IsOp()) continue;
+    auto* op = node->Op();
+    const bool is_fc = op->Type() == "fc";
+    const std::string packed_input = is_fc ? "PackedW" : "PackedY";
+    if (op->Inputs().count(packed_input)) {
+      ++num_packed_ops;
+      // The activation b of the last matmul stays unpacked
+      ASSERT_NE(op->Input(is_fc ? "W" : "Y")[0], "b");
+      auto* packed = param_scope->FindVar(op->Input(packed_input)[0]);
+      ASSERT_NE(packed, nullptr);
+      ASSERT_GT(packed->Get<LoDTensor>().numel(), 0);
+    }
+  }
+
+#ifdef PADDLE_WITH_MKLML
+  // The fc, the mul and both matmuls on weights_2, which share a packed var
+  EXPECT_EQ(num_packed_ops, 4);
+  EXPECT_EQ(num_nodes_before + 3, num_nodes_after);
+#else
+  EXPECT_EQ(num_packed_ops, 0);
+  EXPECT_EQ(num_nodes_before, num_nodes_after);
+#endif
+}
+
+TEST(GemmWeightPackPass, remove_packed_weights) {
+  // The packed weights are removed from a program before it is saved
+  Layers layers;
+  auto* a = layers.data("a", {4, 64});
+  auto* weights_0 = layers.data("weights_0", {64, 32}, true);
+  auto* bias_0 = layers.data("bias_0", {32}, true);
+  auto* fc_out = layers.fc(a, weights_0, bias_0);
+  auto* weights_1 = layers.data("weights_1", {32, 16}, true);
+  layers.mul(fc_out, weights_1);
+
+  ProgramDesc program(layers.main_program());
+  auto* block = program.MutableBlock(0);
+  const size_t num_vars = block->AllVars().size();
+  for (auto* op : block->AllOps()) {
+    const bool is_fc = op->Type() == "fc";
+    const std::string w_name = op->Input(is_fc ? "W" : "Y")[0];
+    block->Var(w_name + "@packed")->SetPersistable(true);
+    op->SetInput(is_fc ? "PackedW" : "PackedY", {w_name + "@packed"});
+  }
+  ASSERT_EQ(block->AllVars().size(), num_vars + 2);
+
+  EXPECT_EQ(RemovePackedGemmWeights(block).size(), 2UL);
+  EXPECT_EQ(block->AllVars().size(), num_vars);
+  // The saved proto has neither the inputs nor the vars
+  ProgramDesc saved(*program.Proto());
+  EXPECT_EQ(saved.Block(0).AllVars().size(), num_vars);
+  for (auto* op : saved.Block(0).AllOps()) {
+    EXPECT_EQ(op->Inputs().count("PackedW"), 0UL);
+    EXPECT_EQ(op->Inputs().count("PackedY"), 0UL);
+  }
+}
+
+TEST(GemmWeightPackPass, remove_and_pack_block) {
+  // The weights of a saved program are removed and packed again at load time
+  Layers layers;
+  auto* a = layers.data("a", {4, 64});
+  auto* weights_0 = layers.data("weights_0", {64, 32}, true);
+  auto* bias_0 = layers.data("bias_0", {32}, true);
+  auto* fc_out = layers.fc(a, weights_0, bias_0);
+  auto* weights_1 = layers.data("weights_1", {32, 16}, true);
+  layers.mul(fc_out, weights_1);
+
+  ProgramDesc program(layers.main_program());
+  auto* block = program.MutableBlock(0);
+  std::unique_ptr<Scope> param_scope(CreateParamScope());
+  const size_t num_vars = block->AllVars().size();
+  auto count_packed_ops = [block] {
+    int count = 0;
+    for (auto* op : block->AllOps()) {
+      count += op->Inputs().count("PackedW") + op->Inputs().count("PackedY");
+    }
+    return count;
+  };
+
+#ifdef PADDLE_WITH_MKLML
+  EXPECT_EQ(PackGemmWeights(block, param_scope.get()), 2);
+  EXPECT_EQ(count_packed_ops(), 2);
+  EXPECT_EQ(block->AllVars().size(), num_vars + 2);
+  EXPECT_EQ(RemovePackedGemmWeights(block).size(), 2UL);
+  EXPECT_EQ(count_packed_ops(), 0);
+  EXPECT_EQ(block->AllVars().size(), num_vars);
+  EXPECT_EQ(PackGemmWeights(block, param_scope.get()), 2);
+#else
+  EXPECT_EQ(PackGemmWeights(block, param_scope.get()), 0);
+  EXPECT_EQ(count_packed_ops(), 0);
+  EXPECT_EQ(block->AllVars().size(), num_vars);
+#endif
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(gemm_weight_pack_pass);
@@ -22,6 +22,8 @@ limitations under the License. */
 #include <unordered_map>
 #include <unordered_set>
 #include "paddle/fluid/framework/ir/graph_traits.h"
+#include "paddle/fluid/framework/op_info.h"
+#include "paddle/fluid/framework/operator.h"
 
 DEFINE_string(print_sub_graph_dir, "",
               "FLAGS_print_sub_graph_dir is used "
@@ -393,6 +395,72 @@ void CleanIndividualNodes(Graph *graph) {
   }
 }
 
+bool HasSubBlock(const OpDesc &op) {
+  for (auto &name : op.AttrNames()) {
+    auto attr_type = op.GetAttrType(name);
+    if (attr_type == proto::AttrType::BLOCK ||
+        attr_type == proto::AttrType::BLOCKS) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsPureOp(const OpDesc &op) {
+  static const std::unordered_set<std::string> impure_types{
+      "feed",
+      "fetch",
+      "read",
+      "save",
+      "save_combine",
+      "load",
+      "load_combine",
+      "print",
+      "assert",
+      "py_func",
+      "uniform_random",
+      "uniform_random_batch_size_like",
+      "gaussian_random",
+      "gaussian_random_batch_size_like",
+      "truncated_gaussian_random",
+      "randint",
+      "randperm",
+      "sampling_id",
+      "random_crop",
+      "bernoulli",
+      "multinomial",
+      "seed",
+      "barrier",
+      "fetch_barrier",
+      "listen_and_serv",
+      "prefetch",
+      "checkpoint_notify",
+      "distributed_lookup_table",
+      "distributed_push_sparse",
+      "gen_nccl_id",
+      "allreduce",
+      "broadcast",
+      "ncclInit",
+      "ncclAllReduce",
+      "ncclReduce",
+      "ncclBcast"};
+  // The communication ops, like c_allreduce_sum, send_v2 and recv_v2
+  static const std::vector<std::string> impure_prefixes{"create_", "c_",
+                                                        "send", "recv"};
+  const auto &type = op.Type();
+  if (impure_types.count(type) || HasSubBlock(op) ||
+      (type == "dropout" && !op.GetAttrIfExists<bool>("is_test"))) {
+    return false;
+  }
+  for (auto &prefix : impure_prefixes) {
+    if (type.compare(0, prefix.size(), prefix) == 0) return false;
+  }
+  // The registered ops without kernels, like the control flow and the RPC
+  // ops, run on the scope as they like
+  return !OpInfoMap::Instance().Has(type) ||
+         OperatorWithKernel::AllOpKernels().count(type) > 0;
+}
+
 std::vector<Node *> TopologyVarientSort(const Graph &graph,
                                         SortKind sort_kind) {
   switch (sort_kind) {
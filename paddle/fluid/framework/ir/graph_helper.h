@@ -72,6 +72,16 @@ std::vector<Node *> TopologyVarientSort(const Graph &graph, SortKind sort_kind);
 // Clean the nodes that doesn't connect to others.
 void CleanIndividualNodes(Graph *graph);
 
+// Test if the op has a block or blocks attribute, i.e. runs sub-blocks
+// whose ops are not part of the graph.
+bool HasSubBlock(const OpDesc &op);
+
+// Test if the op computes its outputs only from its inputs and attributes,
+// i.e. it has no side effects like communication, draws no random numbers,
+// has no sub-blocks and, if registered, runs a kernel. The pure ops may be
+// evaluated ahead of time, merged or removed when their outputs are unused.
+bool IsPureOp(const OpDesc &op);
+
 // Build an adjacency list of operations for the `graph`.
 std::map<ir::Node *, std::set<ir::Node *, ir::NodeComp>, ir::NodeComp>
 BuildOperationAdjList(const Graph &graph);
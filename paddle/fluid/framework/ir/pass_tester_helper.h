@@ -310,6 +310,19 @@ struct Layers {
     return out;
   }
 
+  VarDesc* cast(VarDesc* x, int in_dtype, int out_dtype) {
+    VarDesc* out = lod_tensor(unique_name());
+    OpDesc* op = program_.MutableBlock(0)->AppendOp();
+    op->SetType("cast");
+    op->SetInput("X", {x->Name()});
+    op->SetAttr("in_dtype", in_dtype);
+    op->SetAttr("out_dtype", out_dtype);
+    op->SetOutput("Out", {out->Name()});
+    op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+                static_cast<int>(OpRole::kForward));
+    return out;
+  }
+
   std::vector<VarDesc*> batch_norm(VarDesc* x, VarDesc* scale, VarDesc* bias,
                                    VarDesc* mean, VarDesc* variance) {
     VarDesc* y = lod_tensor(unique_name());
@@ -347,6 +360,17 @@ struct Layers {
     return out;
   }
 
+  void fetch(VarDesc* x, int col = 0) {
+    auto* fetch_var = program_.MutableBlock(0)->Var("fetch");
+    fetch_var->SetType(proto::VarType::FETCH_LIST);
+    fetch_var->SetPersistable(true);
+    OpDesc* op = program_.MutableBlock(0)->AppendOp();
+    op->SetType("fetch");
+    op->SetInput("X", {x->Name()});
+    op->SetOutput("Out", {"fetch"});
+    op->SetAttr("col", col);
+  }
+
   void backward(std::vector<VarDesc*> targets) {
     // This function is designed to simulate the structure of training program,
     //  but is constructed differently as the actual program.
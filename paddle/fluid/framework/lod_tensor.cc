@@ -244,7 +244,8 @@ void AppendLoD(LoD *lod, const LoD &lod_length) {
 }
 
 void SerializeToStream(std::ostream &os, const LoDTensor &tensor,
-                       const platform::DeviceContext &dev_ctx) {
+                       const platform::DeviceContext &dev_ctx,
+                       size_t data_alignment) {
   {  // the 1st field, uint32_t version for LoDTensor
     os.write(reinterpret_cast<const char *>(&kCurTensorVersion),
              sizeof(kCurTensorVersion));
@@ -267,7 +268,7 @@ void SerializeToStream(std::ostream &os, const LoDTensor &tensor,
     }
   }
   // the 3st field, Tensor
-  TensorToStream(os, static_cast<Tensor>(tensor), dev_ctx);
+  TensorToStream(os, static_cast<Tensor>(tensor), dev_ctx, data_alignment);
 }
 
 void DeserializeFromStream(std::istream &is, LoDTensor *tensor,
@@ -298,6 +299,100 @@ void DeserializeFromStream(std::istream &is, LoDTensor *tensor,
   TensorFromStream(is, static_cast<Tensor *>(tensor), dev_ctx, seek, shape);
 }
 
+#ifndef _WIN32
+void DeserializeFromMemoryMap(
+    const std::shared_ptr<memory::allocation::MemoryMapFileAllocation> &file,
+    size_t *offset, LoDTensor *tensor, const platform::DeviceContext &dev_ctx) {
+  const char *base = static_cast<const char *>(file->ptr());
+  auto read = [&](void *dst, size_t size) {
+    PADDLE_ENFORCE_LE(
+        *offset + size, file->size(),
+        platform::errors::Unavailable(
+            "Read out of the range of memory mapped file %s, please check "
+            "whether the file is complete or damaged.",
+            file->file_name()));
+    memcpy(dst, base + *offset, size);
+    *offset += size;
+  };
+
+  {
+    // the 1st field, unit32_t version for LoDTensor
+    uint32_t version;
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(
+        version, 0U,
+        platform::errors::InvalidArgument(
+            "Tensor version %u is not supported, only version 0 is supported.",
+            version));
+  }
+  {
+    // the 2st field, LoD information
+    uint64_t lod_level;
+    read(&lod_level, sizeof(lod_level));
+    auto &lod = *tensor->mutable_lod();
+    lod.resize(lod_level);
+    for (uint64_t i = 0; i < lod_level; ++i) {
+      uint64_t size;
+      read(&size, sizeof(size));
+      std::vector<size_t> tmp(size / sizeof(size_t));
+      read(tmp.data(), size);
+      lod[i] = tmp;
+    }
+  }
+  // the 3st filed, Tensor
+  uint32_t tensor_version;
+  read(&tensor_version, sizeof(tensor_version));
+  CheckTensorVersion(tensor_version);
+  proto::VarType::TensorDesc desc;
+  {
+    int32_t size;
+    read(&size, sizeof(size));
+    std::unique_ptr<char[]> buf(new char[size]);
+    read(buf.get(), size);
+    PADDLE_ENFORCE_EQ(
+        desc.ParseFromArray(buf.get(), size), true,
+        platform::errors::InvalidArgument("Cannot parse tensor desc"));
+  }
+  if (tensor_version == kAlignedTensorDataVersion) {
+    uint32_t padding;
+    read(&padding, sizeof(padding));
+    *offset += padding;
+  }
+
+  std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+  auto type = desc.data_type();
+  size_t type_size = SizeOfType(type);
+  tensor->Resize(make_ddim(dims));
+  size_t size = tensor->numel() * type_size;
+  PADDLE_ENFORCE_LE(*offset + size, file->size(),
+                    platform::errors::Unavailable(
+                        "Read out of the range of memory mapped file %s, "
+                        "please check whether the file is complete or damaged.",
+                        file->file_name()));
+
+  const char *data = base + *offset;
+  if (platform::is_cpu_place(dev_ctx.GetPlace()) &&
+      reinterpret_cast<uintptr_t>(data) % type_size == 0) {
+    tensor->clear();
+    tensor->ResetHolderWithType(
+        std::make_shared<memory::allocation::MemoryMapFileSliceAllocation>(
+            file, *offset, size),
+        type);
+  } else {
+    Tensor cpu_tensor;
+    cpu_tensor.Resize(make_ddim(dims));
+    void *buf = cpu_tensor.mutable_data(platform::CPUPlace(), type);
+    memcpy(buf, data, size);
+    if (platform::is_cpu_place(dev_ctx.GetPlace())) {
+      tensor->ShareDataWith(cpu_tensor);
+    } else {
+      TensorCopy(cpu_tensor, dev_ctx.GetPlace(), dev_ctx, tensor);
+    }
+  }
+  *offset += size;
+}
+#endif
+
 void DeserializeFromStream(std::istream &is, LoDTensor *tensor,
                            const platform::DeviceContext &dev_ctx) {
   {
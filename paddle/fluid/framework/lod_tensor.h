@@ -28,6 +28,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/mixed_vector.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/tensor_util.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -226,9 +229,12 @@ void AppendLoD(LoD* lod, const LoD& lod_length);
  * Serialize/Desiralize LoDTensor to std::ostream
  * You can pass ofstream or ostringstream to serilize to file
  * or to a in memory string. GPU tensor will be copied to CPU.
+ * A data_alignment other than 0 pads the tensor data to start at a multiple
+ * of it in the stream, see TensorToStream.
  */
 void SerializeToStream(std::ostream& os, const LoDTensor& tensor,
-                       const platform::DeviceContext& dev_ctx);
+                       const platform::DeviceContext& dev_ctx,
+                       size_t data_alignment = 0);
 void DeserializeFromStream(std::istream& is, LoDTensor* tensor,
                            const platform::DeviceContext& dev_ctx);
 void DeserializeFromStream(std::istream& is, LoDTensor* tensor,
@@ -236,6 +242,19 @@ void DeserializeFromStream(std::istream& is, LoDTensor* tensor,
                            const size_t& seek,
                            const std::vector<int64_t>& shape);
 
+#ifndef _WIN32
+/*
+ * Desiralize the LoDTensor serialized by SerializeToStream at `*offset` of a
+ * memory mapped file, and move `*offset` behind it. A CPU tensor adopts its
+ * data from the mapping without copying if the data is naturally aligned in
+ * the file, otherwise the data is copied. The data serialized with a
+ * data_alignment is always aligned.
+ */
+void DeserializeFromMemoryMap(
+    const std::shared_ptr<memory::allocation::MemoryMapFileAllocation>& file,
+    size_t* offset, LoDTensor* tensor, const platform::DeviceContext& dev_ctx);
+#endif
+
 /*
  * Convert between length-based LoD and offset-based LoD.
  * The implementation of LoDTensor class use offset-based LoD.
@@ -428,6 +428,11 @@ void OpDesc::SetInput(const std::string &param_name,
   inputs_[param_name] = args;
 }
 
+void OpDesc::RemoveInput(const std::string &param_name) {
+  inputs_.erase(param_name);
+  need_update_ = true;
+}
+
 const std::vector<std::string> &OpDesc::Output(const std::string &name) const {
   auto it = outputs_.find(name);
   PADDLE_ENFORCE_NE(
@@ -55,6 +55,8 @@ class OpDesc {
   void SetInput(const std::string &param_name,
                 const std::vector<std::string> &args);
 
+  void RemoveInput(const std::string &param_name);
+
   const std::vector<std::string> &Output(const std::string &name) const;
 
   bool HasOutput(const std::string &name) const;
@@ -15,18 +15,80 @@
 #include "paddle/fluid/framework/save_load_util.h"
 
 #include <algorithm>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <utility>
+#if defined(__SSE4_2__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
 
+#include "gflags/gflags.h"
 #include "paddle/fluid/imperative/layer.h"
 
+DEFINE_int32(save_load_file_num, 1,
+             "The number of data files that save_static_dict and "
+             "save_dygraph_dict shard tensors into, each file is written by "
+             "its own thread. 1 keeps the single file format.");
+DEFINE_bool(save_load_verify_checksum, true,
+            "Whether to verify the CRC32C of every tensor when loading a "
+            "sharded checkpoint.");
+
 namespace paddle {
 namespace framework {
 
 const int model_file_reserve_size = 256;
-const std::string tensor_number_mark = "TNUM";  // NOLINT
-const std::string tensor_name_mark = "NAME";    // NOLINT
+const std::string tensor_number_mark = "TNUM";   // NOLINT
+const std::string tensor_name_mark = "NAME";     // NOLINT
+const std::string tensor_index_mark = "TIDX";    // NOLINT
+const std::string tensor_part_suffix = ".part";  // NOLINT
+const size_t file_stream_buffer_size = 8 << 20;
+
+struct TensorIndexEntry {
+  std::string name;
+  uint32_t file_id;
+  uint64_t offset;
+  uint64_t length;
+  uint32_t crc;
+};
+
+static const uint32_t* Crc32cTable() {
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (c >> 1) ^ 0x82F63B78U : (c >> 1);
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+  return table.data();
+}
+
+uint32_t Crc32c(uint32_t crc, const char* data, size_t length) {
+  crc = ~crc;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+  uint64_t crc64 = crc;
+  for (; length >= sizeof(uint64_t); length -= sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += sizeof(word);
+  }
+  crc = static_cast<uint32_t>(crc64);
+#endif
+  const uint32_t* table = Crc32cTable();
+  for (; length > 0; --length) {
+    crc = table[(crc ^ static_cast<uint8_t>(*data++)) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
 
 void CheckInStreamState(std::istream& istre, size_t length) {
   if (!istre) {
@@ -102,12 +164,155 @@ std::string ReadTensorName(std::istream& istre) {
   return str_tensor_name;
 }
 
-void ReadReserveBuffer(std::istream& istre) {
-  char* reserve_buffer = new char[model_file_reserve_size];
-  istre.read(reserve_buffer, sizeof(char) * model_file_reserve_size);
+// Returns whether the file is the index of a sharded checkpoint
+bool ReadReserveBuffer(std::istream& istre) {
+  std::vector<char> reserve_buffer(model_file_reserve_size);
+  istre.read(reserve_buffer.data(), sizeof(char) * model_file_reserve_size);
   CheckInStreamState(istre, model_file_reserve_size);
 
-  delete[] reserve_buffer;
+  return std::equal(tensor_index_mark.begin(), tensor_index_mark.end(),
+                    reserve_buffer.begin());
+}
+
+// Write the version, the desc and the data of one tensor, which is the
+// layout shared by the single file and the data files of a sharded
+// checkpoint. Returns the bytes written, and extends crc over them if it is
+// not null.
+uint64_t WriteTensorRecord(std::ostream& ostre, const Tensor& tensor,
+                           uint32_t* crc) {
+  uint64_t length = 0;
+  auto write = [&](const void* data, size_t size) {
+    ostre.write(static_cast<const char*>(data),
+                static_cast<std::streamsize>(size));
+    if (crc != nullptr) {
+      *crc = Crc32c(*crc, static_cast<const char*>(data), size);
+    }
+    length += size;
+  };
+
+  // write tensor version
+  constexpr uint32_t version = 0;
+  write(&version, sizeof(version));
+
+  // the 2nd field, tensor description
+  // int32_t  size
+  // void*    protobuf message
+  proto::VarType::TensorDesc desc;
+  desc.set_data_type(tensor.type());
+  auto dims = framework::vectorize(tensor.dims());
+  auto* pb_dims = desc.mutable_dims();
+  pb_dims->Resize(static_cast<int>(dims.size()), 0);
+  std::copy(dims.begin(), dims.end(), pb_dims->begin());
+  int32_t size = desc.ByteSize();
+  write(&size, sizeof(size));
+  auto out = desc.SerializeAsString();
+  write(out.data(), size);
+
+  // save tensor
+  uint64_t data_size = tensor.numel() * framework::SizeOfType(tensor.type());
+  const void* data_ptr = tensor.data<void>();
+  framework::Tensor temp;
+  if (platform::is_gpu_place(tensor.place())) {
+#ifdef PADDLE_WITH_CUDA
+    TensorCopySync(tensor, platform::CPUPlace(), &temp);
+    data_ptr = temp.data<void>();
+#else
+    PADDLE_THROW(
+        "Tensor is in CUDA device, but paddle not compile with CUDA, this "
+        "should not happen");
+#endif
+  }
+  write(data_ptr, data_size);
+
+  return length;
+}
+
+// Read one tensor written by WriteTensorRecord, the data is skipped when
+// tensor is null. Returns the bytes consumed, and extends crc over them if
+// it is not null.
+uint64_t ReadTensorRecord(std::istream& istre, Tensor* tensor,
+                          uint32_t* crc) {
+  uint64_t length = 0;
+  auto read = [&](void* data, size_t size) {
+    istre.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    CheckInStreamState(istre, size);
+    if (crc != nullptr) {
+      *crc = Crc32c(*crc, static_cast<const char*>(data), size);
+    }
+    length += size;
+  };
+
+  uint32_t version;
+  read(&version, sizeof(version));
+  PADDLE_ENFORCE_EQ(version, 0U, "Only version 0 is supported");
+
+  proto::VarType::TensorDesc desc;
+  {
+    // int32_t size
+    // proto buffer
+    int32_t size;
+    read(&size, sizeof(size));
+    std::unique_ptr<char[]> buf(new char[size]);
+    read(buf.get(), size);
+    PADDLE_ENFORCE_EQ(
+        desc.ParseFromArray(buf.get(), size), true,
+        platform::errors::InvalidArgument("Cannot parse tensor desc"));
+  }
+
+  std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+  auto new_dim = framework::make_ddim(dims);
+  size_t size =
+      framework::product(new_dim) * framework::SizeOfType(desc.data_type());
+  if (tensor == nullptr) {
+    istre.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+    CheckInStreamState(istre, size);
+    return length + size;
+  }
+
+  tensor->Resize(new_dim);
+  void* buf;
+  framework::VisitDataType(
+      desc.data_type(),
+      DeserializedDataFunctor(&buf, tensor, platform::CPUPlace()));
+  read(buf, size);
+
+  return length;
+}
+
+template <typename T>
+static void WritePod(std::ostream& ostre, const T& value) {
+  ostre.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static void ReadPod(std::istream& istre, T* value) {
+  istre.read(reinterpret_cast<char*>(value), sizeof(*value));
+  CheckInStreamState(istre, sizeof(*value));
+}
+
+// Run func(i) for i in [0, num) on num threads and rethrow the first error.
+template <typename Func>
+static void RunOnThreads(size_t num, Func func) {
+  std::vector<std::exception_ptr> errors(num);
+  std::vector<std::thread> threads;
+  threads.reserve(num);
+  for (size_t i = 0; i < num; ++i) {
+    threads.emplace_back([&errors, &func, i] {
+      try {
+        func(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
 
 bool SaveStaticNameListToDisk(
@@ -131,6 +336,10 @@ bool SaveStaticNameListToDisk(
     map_tensor[vec_tensor_name_list[i]] = tensor;
   }
 
+  if (FLAGS_save_load_file_num > 1) {
+    return SaveTensorToDiskParallel(file_name, map_tensor,
+                                    FLAGS_save_load_file_num);
+  }
   return SaveTensorToDisk(file_name, map_tensor);
 }
 
@@ -152,6 +361,10 @@ bool SaveDygraphVarBaseListToDisk(
     map_tensor[vec_var_base_list[i]->Name()] = tensor;
   }
 
+  if (FLAGS_save_load_file_num > 1) {
+    return SaveTensorToDiskParallel(file_name, map_tensor,
+                                    FLAGS_save_load_file_num);
+  }
   return SaveTensorToDisk(file_name, map_tensor);
 }
 
@@ -181,7 +394,7 @@ bool LoadStaticNameListFromDisk(
     const std::string& file_name,
     const std::vector<std::string>& vec_tensor_name_list, const Scope& scope) {
   std::map<std::string, std::shared_ptr<Tensor>> map_load_tensor;
-  LoadTensorFromDisk(file_name, &map_load_tensor);
+  LoadTensorFromDisk(file_name, vec_tensor_name_list, &map_load_tensor);
 
   for (size_t i = 0; i < vec_tensor_name_list.size(); ++i) {
     auto it = map_load_tensor.find(vec_tensor_name_list[i]);
@@ -244,9 +457,8 @@ bool SaveTensorToDisk(const std::string& file_name,
   }
 
   // first 256 byte for reserve for fulture upgrade
-  char* kReserveBuffer = new char[model_file_reserve_size];
-  fout.write(kReserveBuffer, sizeof(char) * model_file_reserve_size);
-  delete[] kReserveBuffer;
+  std::vector<char> reserve_buffer(model_file_reserve_size, 0);
+  fout.write(reserve_buffer.data(), sizeof(char) * model_file_reserve_size);
 
   fout.write(tensor_number_mark.c_str(),
              sizeof(char) * tensor_number_mark.size());
@@ -262,43 +474,107 @@ bool SaveTensorToDisk(const std::string& file_name,
     fout.write(reinterpret_cast<const char*>(&name_length),
                sizeof(name_length));
     fout.write(itera.first.c_str(), sizeof(char) * name_length);
-    // write tensor version
-    constexpr uint32_t version = 0;
-    fout.write(reinterpret_cast<const char*>(&version), sizeof(version));
-
-    // the 2nd field, tensor description
-    // int32_t  size
-    // void*    protobuf message
-    auto tensor = itera.second;
-
-    proto::VarType::TensorDesc desc;
-    desc.set_data_type(tensor->type());
-    auto dims = framework::vectorize(tensor->dims());
-    auto* pb_dims = desc.mutable_dims();
-    pb_dims->Resize(static_cast<int>(dims.size()), 0);
-    std::copy(dims.begin(), dims.end(), pb_dims->begin());
-    int32_t size = desc.ByteSize();
-    fout.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    auto out = desc.SerializeAsString();
-    fout.write(out.data(), size);
-
-    // save tensor
-    uint64_t data_size =
-        tensor->numel() * framework::SizeOfType(tensor->type());
-    auto* data_ptr = tensor->data<void>();
-    if (platform::is_gpu_place(tensor->place())) {
-#ifdef PADDLE_WITH_CUDA
-      framework::Tensor temp;
-      TensorCopySync(*tensor, platform::CPUPlace(), &temp);
-      data_ptr = temp.data<void>();
-#else
-      PADDLE_THROW(
-          "Tensor is in CUDA device, but paddle not compile with CUDA, this "
-          "should not happen");
-#endif
+
+    WriteTensorRecord(fout, *itera.second, nullptr);
+  }
+
+  if (!fout) {
+    PADDLE_THROW("Model save failed, data write to model file [%s] error",
+                 file_name);
+  }
+
+  fout.close();
+
+  return true;
+}
+
+bool SaveTensorToDiskParallel(const std::string& file_name,
+                              const std::map<std::string, Tensor*>& map_tensor,
+                              int file_num) {
+  PADDLE_ENFORCE_GT(file_num, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of checkpoint files should be greater "
+                        "than 0, but received %d.",
+                        file_num));
+  MkDirRecursively(DirName(file_name).c_str());
+
+  // Place the larger tensors first, each on the file with the fewest bytes
+  std::vector<std::pair<std::string, Tensor*>> tensors(map_tensor.begin(),
+                                                       map_tensor.end());
+  auto tensor_bytes = [](const Tensor* tensor) {
+    return static_cast<uint64_t>(tensor->numel()) *
+           framework::SizeOfType(tensor->type());
+  };
+  std::stable_sort(tensors.begin(), tensors.end(),
+                   [&](const std::pair<std::string, Tensor*>& a,
+                       const std::pair<std::string, Tensor*>& b) {
+                     return tensor_bytes(a.second) > tensor_bytes(b.second);
+                   });
+  size_t real_file_num = std::max<size_t>(
+      1, std::min<size_t>(static_cast<size_t>(file_num), tensors.size()));
+  std::vector<std::vector<size_t>> file_tensors(real_file_num);
+  std::vector<uint64_t> file_bytes(real_file_num, 0);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    size_t file_id = std::min_element(file_bytes.begin(), file_bytes.end()) -
+                     file_bytes.begin();
+    file_tensors[file_id].push_back(i);
+    file_bytes[file_id] += tensor_bytes(tensors[i].second);
+  }
+
+  std::vector<TensorIndexEntry> entries(tensors.size());
+  RunOnThreads(real_file_num, [&](size_t file_id) {
+    auto part_name = file_name + tensor_part_suffix + std::to_string(file_id);
+    std::vector<char> stream_buffer(file_stream_buffer_size);
+    std::ofstream fout;
+    fout.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+    fout.open(part_name, std::ios::binary);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Cannot open %s to save tensors.", part_name));
+
+    uint64_t offset = 0;
+    for (auto i : file_tensors[file_id]) {
+      auto& entry = entries[i];
+      entry.name = tensors[i].first;
+      entry.file_id = static_cast<uint32_t>(file_id);
+      entry.offset = offset;
+      entry.crc = 0;
+      entry.length = WriteTensorRecord(fout, *tensors[i].second, &entry.crc);
+      offset += entry.length;
     }
-    fout.write(static_cast<const char*>(data_ptr),
-               static_cast<std::streamsize>(data_size));
+
+    fout.close();
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Failed to write tensors to %s.", part_name));
+  });
+
+  // The index keeps the layout of the single file, with the index mark at
+  // the head of the reserved bytes
+  std::ofstream fout(file_name, std::ios::binary);
+  if (!fout) {
+    PADDLE_THROW("File open error. Can not open file [%s]", file_name);
+  }
+
+  std::vector<char> reserve_buffer(model_file_reserve_size, 0);
+  std::copy(tensor_index_mark.begin(), tensor_index_mark.end(),
+            reserve_buffer.begin());
+  fout.write(reserve_buffer.data(), sizeof(char) * model_file_reserve_size);
+
+  fout.write(tensor_number_mark.c_str(),
+             sizeof(char) * tensor_number_mark.size());
+  WritePod(fout, entries.size());
+  WritePod(fout, static_cast<uint32_t>(real_file_num));
+
+  for (auto& entry : entries) {
+    fout.write(tensor_name_mark.c_str(),
+               sizeof(char) * tensor_name_mark.size());
+    WritePod(fout, entry.name.size());
+    fout.write(entry.name.c_str(), sizeof(char) * entry.name.size());
+    WritePod(fout, entry.file_id);
+    WritePod(fout, entry.offset);
+    WritePod(fout, entry.length);
+    WritePod(fout, entry.crc);
   }
 
   if (!fout) {
@@ -311,8 +587,83 @@ bool SaveTensorToDisk(const std::string& file_name,
   return true;
 }
 
-bool LoadTensorFromDisk(
+static bool LoadTensorFromIndex(
+    std::istream& istre, const std::string& file_name, size_t tensor_number,
+    const std::unordered_set<std::string>* name_set,
+    std::map<std::string, std::shared_ptr<Tensor>>* map_tensor) {
+  uint32_t file_num;
+  ReadPod(istre, &file_num);
+
+  std::vector<std::vector<TensorIndexEntry>> file_entries(file_num);
+  for (size_t i = 0; i < tensor_number; ++i) {
+    TensorIndexEntry entry;
+    entry.name = ReadTensorName(istre);
+    ReadPod(istre, &entry.file_id);
+    ReadPod(istre, &entry.offset);
+    ReadPod(istre, &entry.length);
+    ReadPod(istre, &entry.crc);
+    PADDLE_ENFORCE_LT(entry.file_id, file_num,
+                      platform::errors::InvalidArgument(
+                          "Tensor %s is in data file %d, but the index [%s] "
+                          "only has %d data files.",
+                          entry.name, entry.file_id, file_name, file_num));
+    if (name_set == nullptr || name_set->count(entry.name)) {
+      file_entries[entry.file_id].emplace_back(std::move(entry));
+    }
+  }
+
+  // Create the tensors here so the reading threads do not touch map_tensor
+  std::vector<std::vector<Tensor*>> file_tensors(file_num);
+  for (uint32_t file_id = 0; file_id < file_num; ++file_id) {
+    for (auto& entry : file_entries[file_id]) {
+      std::shared_ptr<Tensor> tensor(new Tensor());
+      file_tensors[file_id].push_back(tensor.get());
+      (*map_tensor)[entry.name] = tensor;
+    }
+  }
+
+  bool verify = FLAGS_save_load_verify_checksum;
+  RunOnThreads(file_num, [&](size_t file_id) {
+    auto& entries = file_entries[file_id];
+    if (entries.empty()) return;
+
+    auto part_name = file_name + tensor_part_suffix + std::to_string(file_id);
+    std::vector<char> stream_buffer(file_stream_buffer_size);
+    std::ifstream fin;
+    fin.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+    fin.open(part_name, std::ios::binary);
+    if (!fin) {
+      PADDLE_THROW("File open error. Can not open model file [%s]",
+                   part_name);
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto& entry = entries[i];
+      fin.seekg(static_cast<std::streamoff>(entry.offset), std::ios::beg);
+      uint32_t crc = 0;
+      auto length = ReadTensorRecord(fin, file_tensors[file_id][i],
+                                     verify ? &crc : nullptr);
+      PADDLE_ENFORCE_EQ(length, entry.length,
+                        platform::errors::InvalidArgument(
+                            "Tensor %s in [%s] has %d bytes, but the index "
+                            "records %d bytes.",
+                            entry.name, part_name, length, entry.length));
+      if (verify) {
+        PADDLE_ENFORCE_EQ(crc, entry.crc,
+                          platform::errors::InvalidArgument(
+                              "The checksum of tensor %s in [%s] does not "
+                              "match the index, the file may be corrupted.",
+                              entry.name, part_name));
+      }
+    }
+  });
+
+  return true;
+}
+
+static bool LoadTensorFromDiskImpl(
     const std::string& file_name,
+    const std::unordered_set<std::string>* name_set,
     std::map<std::string, std::shared_ptr<Tensor>>* map_tensor) {
   std::ifstream fin(file_name, std::ios::binary);
 
@@ -320,50 +671,25 @@ bool LoadTensorFromDisk(
     PADDLE_THROW("File open error. Can not open model file [%s]", file_name);
   }
 
-  ReadReserveBuffer(fin);
+  bool is_index = ReadReserveBuffer(fin);
 
   size_t tensor_number = ReadTensorNumber(fin);
 
+  if (is_index) {
+    return LoadTensorFromIndex(fin, file_name, tensor_number, name_set,
+                               map_tensor);
+  }
+
   for (size_t i = 0; i < tensor_number; ++i) {
     std::string str_tensor_name = ReadTensorName(fin);
 
-    std::shared_ptr<Tensor> tensor_temp(new Tensor());
-    uint32_t version;
-    fin.read(reinterpret_cast<char*>(&version), sizeof(version));
-    CheckInStreamState(fin, sizeof(version));
-    PADDLE_ENFORCE_EQ(version, 0U, "Only version 0 is supported");
-    proto::VarType::TensorDesc desc;
-    {
-      // int32_t size
-      // proto buffer
-      int32_t size;
-      fin.read(reinterpret_cast<char*>(&size), sizeof(size));
-      CheckInStreamState(fin, sizeof(size));
-      std::unique_ptr<char[]> buf(new char[size]);
-      fin.read(reinterpret_cast<char*>(buf.get()), size);
-      CheckInStreamState(fin, sizeof(size));
-      PADDLE_ENFORCE_EQ(
-          desc.ParseFromArray(buf.get(), size), true,
-          platform::errors::InvalidArgument("Cannot parse tensor desc"));
+    if (name_set != nullptr && name_set->count(str_tensor_name) == 0) {
+      ReadTensorRecord(fin, nullptr, nullptr);
+      continue;
     }
 
-    {  // read tensor
-      std::vector<int64_t> dims;
-      dims.reserve(static_cast<size_t>(desc.dims().size()));
-      std::copy(desc.dims().begin(), desc.dims().end(),
-                std::back_inserter(dims));
-      auto new_dim = framework::make_ddim(dims);
-      tensor_temp->Resize(new_dim);
-      void* buf;
-      framework::VisitDataType(desc.data_type(),
-                               DeserializedDataFunctor(&buf, tensor_temp.get(),
-                                                       platform::CPUPlace()));
-      size_t size =
-          tensor_temp->numel() * framework::SizeOfType(desc.data_type());
-
-      fin.read(reinterpret_cast<char*>(buf), size);
-      CheckInStreamState(fin, size);
-    }
+    std::shared_ptr<Tensor> tensor_temp(new Tensor());
+    ReadTensorRecord(fin, tensor_temp.get(), nullptr);
 
     (*map_tensor)[str_tensor_name] = tensor_temp;
   }
@@ -371,5 +697,20 @@ bool LoadTensorFromDisk(
   return true;
 }
 
+bool LoadTensorFromDisk(
+    const std::string& file_name,
+    std::map<std::string, std::shared_ptr<Tensor>>* map_tensor) {
+  return LoadTensorFromDiskImpl(file_name, nullptr, map_tensor);
+}
+
+bool LoadTensorFromDisk(
+    const std::string& file_name,
+    const std::vector<std::string>& vec_tensor_name_list,
+    std::map<std::string, std::shared_ptr<Tensor>>* map_tensor) {
+  std::unordered_set<std::string> name_set(vec_tensor_name_list.begin(),
+                                           vec_tensor_name_list.end());
+  return LoadTensorFromDiskImpl(file_name, &name_set, map_tensor);
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -50,5 +50,23 @@ bool LoadTensorFromDisk(
     const std::string& file_name,
     std::map<std::string, std::shared_ptr<Tensor>>* map_tensor);
 
+// Only load the tensors in vec_tensor_name_list, the others in the file are
+// skipped without being read.
+bool LoadTensorFromDisk(
+    const std::string& file_name,
+    const std::vector<std::string>& vec_tensor_name_list,
+    std::map<std::string, std::shared_ptr<Tensor>>* map_tensor);
+
+// Shard the tensors into file_num data files [file_name].part[i], each one
+// written by its own thread, and write an index to file_name that records
+// the file, offset, length and CRC32C of every tensor. LoadTensorFromDisk
+// recognizes the index and reads the data files in parallel.
+bool SaveTensorToDiskParallel(const std::string& file_name,
+                              const std::map<std::string, Tensor*>& map_tensor,
+                              int file_num);
+
+// CRC32C (Castagnoli) of data[0, length), continuing from crc.
+uint32_t Crc32c(uint32_t crc, const char* data, size_t length);
+
 }  // namespace framework
 }  // namespace paddle
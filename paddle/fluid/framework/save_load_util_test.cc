@@ -13,8 +13,11 @@
 // limitations under the License.
 #include <stdlib.h>
 #include <time.h>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/save_load_util.h"
@@ -74,5 +77,59 @@ TEST(test_save_load_util, test_save_load) {
     ASSERT_EQ(ptr_2[i], ptr_2_new[i]);
   }
 }
+
+TEST(test_save_load_util, test_crc32c) {
+  ASSERT_EQ(Crc32c(0, "123456789", 9), 0xE3069283U);
+  ASSERT_EQ(Crc32c(Crc32c(0, "1234", 4), "56789", 5), 0xE3069283U);
+}
+
+TEST(test_save_load_util, test_save_load_parallel) {
+  auto cpu_place = platform::CPUPlace();
+  std::vector<Tensor> tensors(5);
+  std::map<std::string, Tensor*> map_tensor;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    tensors[i].Resize({static_cast<int64_t>(i + 1) * 100, 10});
+    auto data = tensors[i].mutable_data<float>(cpu_place);
+    for (int64_t j = 0; j < tensors[i].numel(); ++j) {
+      data[j] = static_cast<float>(i * 10000 + j);
+    }
+    map_tensor["t" + std::to_string(i)] = &tensors[i];
+  }
+
+  SaveTensorToDiskParallel("test_parallel", map_tensor, 3);
+
+  std::map<std::string, std::shared_ptr<Tensor>> load_map_tensor;
+  LoadTensorFromDisk("test_parallel", &load_map_tensor);
+  ASSERT_EQ(load_map_tensor.size(), tensors.size());
+  for (auto& item : map_tensor) {
+    auto it = load_map_tensor.find(item.first);
+    ASSERT_TRUE(it != load_map_tensor.end());
+    ASSERT_EQ(it->second->dims(), item.second->dims());
+    float* ptr = item.second->data<float>();
+    float* ptr_new = it->second->data<float>();
+    for (int64_t i = 0; i < item.second->numel(); ++i) {
+      ASSERT_EQ(ptr[i], ptr_new[i]);
+    }
+  }
+
+  // only the requested tensors are read
+  std::map<std::string, std::shared_ptr<Tensor>> part_map_tensor;
+  LoadTensorFromDisk("test_parallel", {"t1", "t4"}, &part_map_tensor);
+  ASSERT_EQ(part_map_tensor.size(), 2UL);
+  ASSERT_EQ(part_map_tensor["t4"]->data<float>()[7], 40007.0f);
+
+  // the largest tensor t4 is alone in the first data file, flip one of its
+  // bytes and the checksum should catch it
+  {
+    std::fstream fout("test_parallel.part0",
+                      std::ios::binary | std::ios::in | std::ios::out);
+    fout.seekp(-1, std::ios::end);
+    char c = 0x7f;
+    fout.write(&c, 1);
+  }
+  std::map<std::string, std::shared_ptr<Tensor>> broken_map_tensor;
+  ASSERT_THROW(LoadTensorFromDisk("test_parallel", &broken_map_tensor),
+               platform::EnforceNotMet);
+}
 }  // namespace framework
 }  // namespace paddle
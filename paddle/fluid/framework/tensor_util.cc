@@ -618,9 +618,10 @@ void TensorIsfiniteV2(const framework::Tensor& tensor, framework::Tensor* out) {
 }
 
 void TensorToStream(std::ostream& os, const Tensor& tensor,
-                    const platform::DeviceContext& dev_ctx) {
+                    const platform::DeviceContext& dev_ctx,
+                    size_t data_alignment) {
+  const uint32_t version = data_alignment > 0 ? kAlignedTensorDataVersion : 0;
   {  // the 1st field, uint32_t version
-    constexpr uint32_t version = 0;
     os.write(reinterpret_cast<const char*>(&version), sizeof(version));
   }
   {  // the 2nd field, tensor description
@@ -637,6 +638,20 @@ void TensorToStream(std::ostream& os, const Tensor& tensor,
     auto out = desc.SerializeAsString();
     os.write(out.data(), size);
   }
+  if (version == kAlignedTensorDataVersion) {
+    // uint32_t size of the padding, and the zeros that align the data. The
+    // data is left unaligned if the position of the stream is unknown.
+    uint32_t padding = 0;
+    auto pos = static_cast<int64_t>(os.tellp());
+    if (pos >= 0) {
+      pos += sizeof(padding);
+      padding = static_cast<uint32_t>(
+          (data_alignment - pos % data_alignment) % data_alignment);
+    }
+    os.write(reinterpret_cast<const char*>(&padding), sizeof(padding));
+    std::string zeros(padding, '\0');
+    os.write(zeros.data(), padding);
+  }
   {  // the 3rd field, tensor data
     uint64_t size = tensor.numel() * framework::SizeOfType(tensor.type());
 
@@ -711,17 +726,28 @@ struct DeserializedDataFunctor {
   platform::Place place_;
 };
 
+void CheckTensorVersion(uint32_t version) {
+  PADDLE_ENFORCE_EQ(
+      version == 0U || version == kAlignedTensorDataVersion, true,
+      platform::errors::InvalidArgument(
+          "tensor version %u is not supported, only version 0 and %u are "
+          "supported",
+          version, kAlignedTensorDataVersion));
+}
+
+static void SkipTensorDataPadding(std::istream& is, uint32_t version) {
+  if (version != kAlignedTensorDataVersion) return;
+  uint32_t padding;
+  is.read(reinterpret_cast<char*>(&padding), sizeof(padding));
+  is.seekg(padding, is.cur);
+}
+
 void TensorFromStream(std::istream& is, Tensor* tensor,
                       const platform::DeviceContext& dev_ctx,
                       const size_t& seek, const std::vector<int64_t>& shape) {
   uint32_t version;
   is.read(reinterpret_cast<char*>(&version), sizeof(version));
-
-  PADDLE_ENFORCE_EQ(
-      version, 0U,
-      platform::errors::InvalidArgument(
-          "tensor version %u is not supported, Only version 0 is supported",
-          version));
+  CheckTensorVersion(version);
 
   proto::VarType::TensorDesc desc;
   {  // int32_t size
@@ -734,6 +760,7 @@ void TensorFromStream(std::istream& is, Tensor* tensor,
         desc.ParseFromArray(buf.get(), size), true,
         platform::errors::InvalidArgument("Cannot parse tensor desc"));
   }
+  SkipTensorDataPadding(is, version);
   {  // read tensor
     tensor->Resize(framework::make_ddim(shape));
     size_t seekg = seek * framework::SizeOfType(desc.data_type());
@@ -775,11 +802,7 @@ void TensorFromStream(std::istream& is, Tensor* tensor,
                       const platform::DeviceContext& dev_ctx) {
   uint32_t version;
   is.read(reinterpret_cast<char*>(&version), sizeof(version));
-  PADDLE_ENFORCE_EQ(
-      version, 0U,
-      platform::errors::InvalidArgument(
-          "tensor version %u is not supported, Only version 0 is supported",
-          version));
+  CheckTensorVersion(version);
   proto::VarType::TensorDesc desc;
   {  // int32_t size
      // proto buffer
@@ -791,6 +814,7 @@ void TensorFromStream(std::istream& is, Tensor* tensor,
         desc.ParseFromArray(buf.get(), size), true,
         platform::errors::InvalidArgument("Cannot parse tensor desc"));
   }
+  SkipTensorDataPadding(is, version);
   {  // read tensor
     std::vector<int64_t> dims;
     dims.reserve(static_cast<size_t>(desc.dims().size()));
@@ -68,8 +68,18 @@ void TensorContainsNAN(const framework::Tensor& tensor, framework::Tensor* out);
 void TensorContainsInf(const framework::Tensor& tensor, framework::Tensor* out);
 void TensorIsfinite(const framework::Tensor& tensor, framework::Tensor* out);
 
+// The version of the serialized tensor whose data is padded to start at a
+// multiple of an alignment in the stream, so that the data of a memory
+// mapped file can be used in place. The other tensors are of version 0.
+constexpr uint32_t kAlignedTensorDataVersion = 1;
+
+// Writes the tensor of version kAlignedTensorDataVersion if data_alignment is
+// not 0, which only the readers of the version can load.
 void TensorToStream(std::ostream& os, const Tensor& tensor,
-                    const platform::DeviceContext& dev_ctx);
+                    const platform::DeviceContext& dev_ctx,
+                    size_t data_alignment = 0);
+// Throws if the serialized tensor of the version can not be read
+void CheckTensorVersion(uint32_t version);
 void TensorFromStream(std::istream& is, Tensor* tensor,
                       const platform::DeviceContext& dev_ctx);
 void TensorFromStream(std::istream& is, Tensor* tensor,
@@ -151,6 +151,9 @@ void IRPassManager::CreatePasses(Argument *argument,
       pass->Set("xpu_l3_workspace_size",
                 new int(argument->xpu_l3_workspace_size()));
     }
+    if (pass_name == "fusion_group_pass") {
+      pass->Set("use_gpu", new bool(argument->use_gpu()));
+    }
     disable_logs_ = argument->disable_logs();
     if (pass_name == "fc_fuse_pass") {
       pass->Set("use_gpu", new bool(argument->use_gpu()));
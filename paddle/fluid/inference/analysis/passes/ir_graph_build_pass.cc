@@ -48,7 +48,8 @@ void IrGraphBuildPass::RunImpl(Argument *argument) {
     auto program = LoadModel(
         argument->model_program_path(), argument->model_params_path(),
         argument->scope_ptr(), place,
-        argument->model_from_memory_valid() && argument->model_from_memory());
+        argument->model_from_memory_valid() && argument->model_from_memory(),
+        argument->memory_map_params_valid() && argument->memory_map_params());
     argument->SetMainProgram(program.release());
   } else {
     PADDLE_THROW(
@@ -72,10 +73,10 @@ std::unique_ptr<framework::ProgramDesc> IrGraphBuildPass::LoadModel(
 std::unique_ptr<framework::ProgramDesc> IrGraphBuildPass::LoadModel(
     const std::string &program_path, const std::string &params_path,
     framework::Scope *scope, const platform::Place &place,
-    bool model_from_memory) {
+    bool model_from_memory, bool memory_map_params) {
   framework::Executor exe(place);
   if (!model_from_memory) {
-    return Load(&exe, scope, program_path, params_path);
+    return Load(&exe, scope, program_path, params_path, memory_map_params);
   } else {
     return LoadFromMemory(&exe, scope, program_path, params_path);
   }
@@ -39,7 +39,7 @@ class IrGraphBuildPass : public AnalysisPass {
   std::unique_ptr<framework::ProgramDesc> LoadModel(
       const std::string &program_path, const std::string &params_path,
       framework::Scope *scope, const platform::Place &place,
-      bool model_from_memory);
+      bool model_from_memory, bool memory_map_params);
 
   std::string model_binary_str_;
 };
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
@@ -100,8 +101,10 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(model_dir_);
   CP_MEMBER(model_from_memory_);  // the memory model reuses prog_file_ and
                                   // params_file_ fields.
+  CP_MEMBER(memory_map_params_);
 
   CP_MEMBER(opt_cache_dir_);
+  CP_MEMBER(optimized_program_cache_dir_);
   CP_MEMBER(prog_file_);
   CP_MEMBER(params_file_);
 
@@ -155,6 +158,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(shape_buckets_);
+  CP_MEMBER(shape_bucket_seq_axis_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -417,6 +422,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << use_mkldnn_quantizer_;
   ss << use_mkldnn_bfloat16_;
   ss << model_from_memory_;
+  ss << memory_map_params_;
 
   ss << with_profile_;
 
@@ -428,6 +434,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  for (int length : shape_buckets_) ss << length << ",";
+  ss << shape_bucket_seq_axis_;
 
   ss << use_lite_;
   ss << use_xpu_;
@@ -445,6 +453,28 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::EnableShapeBucketing(const std::vector<int> &lengths,
+                                          int seq_axis) {
+  PADDLE_ENFORCE_GE(seq_axis, 0,
+                    platform::errors::InvalidArgument(
+                        "The seq_axis of the shape bucketing should be "
+                        "non-negative, but it is %d.",
+                        seq_axis));
+  for (int length : lengths) {
+    PADDLE_ENFORCE_GT(length, 0,
+                      platform::errors::InvalidArgument(
+                          "The bucket lengths should be positive, but one of "
+                          "them is %d.",
+                          length));
+  }
+  shape_buckets_ = lengths;
+  std::sort(shape_buckets_.begin(), shape_buckets_.end());
+  shape_buckets_.erase(
+      std::unique(shape_buckets_.begin(), shape_buckets_.end()),
+      shape_buckets_.end());
+  shape_bucket_seq_axis_ = seq_axis;
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #ifdef PADDLE_WITH_CUDA
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -470,6 +500,11 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableMemoryMapParams(bool x) {
+  memory_map_params_ = x;
+  Update();
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
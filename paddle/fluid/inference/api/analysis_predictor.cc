@@ -14,19 +14,33 @@
 
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <iomanip>
+#include <iterator>
 #include <memory>
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/gemm_weight_pack_pass.h"
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/var_type_traits.h"
 #include "paddle/fluid/framework/version.h"
 #include "paddle/fluid/inference/analysis/helper.h"
@@ -34,8 +48,10 @@
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/utils/singleton.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/gpu_info.h"
 #include "paddle/fluid/platform/place.h"
@@ -73,6 +89,38 @@ bool IsPersistable(const framework::VarDesc *var) {
   }
   return false;
 }
+
+// Whether the shape is of the given length along the axis of the shape
+// bucketing, so padded up to the bucket or cut back from it
+bool IsBucketedShape(const std::vector<int64_t> &shape, int axis,
+                     int64_t length) {
+  return static_cast<int>(shape.size()) > axis && shape[axis] == length;
+}
+
+// The size and the modification time of a file, which change whenever the
+// file is rewritten
+std::string FileStamp(const std::string &path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) return "none";
+  return std::to_string(info.st_size) + "@" + std::to_string(info.st_mtime);
+}
+
+bool ReadFile(const std::string &path, std::string *content) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  if (!fin.is_open()) return false;
+  content->assign(std::istreambuf_iterator<char>(fin),
+                  std::istreambuf_iterator<char>());
+  return true;
+}
+
+// The directory of the entry of the key in the optimized program cache
+std::string OptimizedProgramCacheEntry(const std::string &cache_dir,
+                                       const std::string &key) {
+  std::stringstream ss;
+  ss << cache_dir << "/" << std::hex << std::setw(16) << std::setfill('0')
+     << std::hash<std::string>()(key);
+  return ss.str();
+}
 }  // namespace
 
 bool PaddleTensorToLoDTensor(const PaddleTensor &pt, framework::LoDTensor *t,
@@ -161,6 +209,15 @@ bool AnalysisPredictor::Init(
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
 
+  if (config_.shape_bucketing_enabled()) {
+    if (platform::is_cpu_place(place_)) {
+      shape_buckets_.resize(config_.shape_buckets().size());
+    } else {
+      LOG(WARNING) << "The shape bucketing is only supported on CPU, and "
+                      "disabled.";
+    }
+  }
+
   return true;
 }
 
@@ -196,12 +253,23 @@ bool AnalysisPredictor::PrepareProgram(
                       "Please use the corresponding version of the model and "
                       "prediction library, and do not use the develop branch.";
     }
-    executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+    std::string cache_key;
+    if (config_.optimized_program_cache_enabled() && config_.ir_optim() &&
+        !config_.mkldnn_quantizer_enabled()) {
+      cache_key = OptimizedProgramCacheKey();
+    }
+    if (!cache_key.empty() && LoadOptimizedProgramCache(cache_key)) {
+      optimized_program_cache_hit_ = true;
+      config_.PartiallyRelease();
+    } else {
+      executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
 
-    // if enable_ir_optim_ is false,
-    // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc) will
-    // not be executed.
-    OptimizeInferenceProgram();
+      // if enable_ir_optim_ is false,
+      // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc)
+      // will not be executed.
+      OptimizeInferenceProgram();
+      if (!cache_key.empty()) SaveOptimizedProgramCache(cache_key);
+    }
   } else {
     // If the program is passed from external, no need to optimize it, this
     // logic is used in the clone scenario.
@@ -289,29 +357,46 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
                             std::vector<PaddleTensor> *output_data,
                             int batch_size) {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  framework::Scope *scope = sub_scope_ ? sub_scope_ : scope_.get();
+  PADDLE_ENFORCE_NOT_NULL(scope, "The scope should not be nullptr.");
+  NaiveExecutor *executor = executor_.get();
+  auto *cleaner = &tensor_array_batch_cleaner_;
+  const std::vector<PaddleTensor> *feeds = &inputs;
+  int64_t length = -1;
+  ShapeBucket *bucket = nullptr;
+  if (!shape_buckets_.empty()) {
+    bucket = PadShapeBucketInputs(inputs, &length);
+  }
+  if (bucket != nullptr) {
+    scope = bucket->scope;
+    executor = bucket->executor.get();
+    cleaner = &bucket->tensor_array_batch_cleaner;
+    feeds = &bucket->inputs;
+  }
 #ifdef PADDLE_WITH_MKLDNN
-  if (config_.use_mkldnn_) MkldnnPreSet(inputs);
+  if (config_.use_mkldnn_) MkldnnPreSet(*feeds);
 #endif
   VLOG(3) << "Predictor::predict";
   inference::Timer timer;
   timer.tic();
   // set feed variable
-  framework::Scope *scope = sub_scope_ ? sub_scope_ : scope_.get();
-  PADDLE_ENFORCE_NOT_NULL(scope, "The scope should not be nullptr.");
-  if (!SetFeed(inputs, scope)) {
+  if (!SetFeed(*feeds, scope)) {
     LOG(ERROR) << "fail to set feed";
     return false;
   }
 
   // Run the inference program
   // if share variables, we need not create variables
-  executor_->Run();
+  executor->Run();
 
   // get fetch variable
   if (!GetFetch(output_data, scope)) {
     LOG(ERROR) << "fail to get fetches";
     return false;
   }
+  if (bucket != nullptr) {
+    CutShapeBucketOutputs(*bucket, length, output_data);
+  }
 
   VLOG(3) << "predict cost: " << timer.toc() << "ms";
 
@@ -321,9 +406,9 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   // bool; the next time, the operator will call MutableData and construct a new
   // container again, so that the container will be empty for each batch.
   if (sub_scope_) {
-    tensor_array_batch_cleaner_.CollectNoTensorVars(sub_scope_);
+    cleaner->CollectNoTensorVars(scope);
   }
-  tensor_array_batch_cleaner_.ResetNoTensorVars();
+  cleaner->ResetNoTensorVars();
 
   // recover the cpu_math_library_num_threads to 1, in order to avoid thread
   // conflict when integrating it into deployment service.
@@ -429,6 +514,7 @@ void AnalysisPredictor::PrepareArgument() {
   argument_.SetEnableAnalysisOptim(config_.enable_ir_optim_);
   argument_.SetEnableMemoryOptim(config_.enable_memory_optim());
   argument_.SetModelFromMemory(config_.model_from_memory_);
+  argument_.SetMemoryMapParams(config_.memory_map_params_);
   // Analyze inference_program
   argument_.SetPredictorID(predictor_id_);
   argument_.SetOptimCacheDir(config_.opt_cache_dir_);
@@ -714,10 +800,22 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetOutputTensor(
 
 bool AnalysisPredictor::ZeroCopyRun() {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
-  executor_->Run();
-  // Fix TensorArray reuse not cleaned bug.
-  tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
-  tensor_array_batch_cleaner_.ResetTensorArray();
+  int64_t length = -1;
+  ShapeBucket *bucket = nullptr;
+  if (!shape_buckets_.empty()) {
+    bucket = PadShapeBucketInputs(&length);
+  }
+  if (bucket != nullptr) {
+    bucket->executor->Run();
+    CutShapeBucketOutputs(*bucket, length);
+    bucket->tensor_array_batch_cleaner.CollectTensorArrays(bucket->scope);
+    bucket->tensor_array_batch_cleaner.ResetTensorArray();
+  } else {
+    executor_->Run();
+    // Fix TensorArray reuse not cleaned bug.
+    tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
+    tensor_array_batch_cleaner_.ResetTensorArray();
+  }
 
   // recover the cpu_math_library_num_threads to 1, in order to avoid thread
   // conflict when integrating it into deployment service.
@@ -731,6 +829,189 @@ bool AnalysisPredictor::ZeroCopyRun() {
   return true;
 }
 
+AnalysisPredictor::ShapeBucket *AnalysisPredictor::FindShapeBucket(
+    const std::vector<std::vector<int64_t>> &shapes, bool paddable,
+    int64_t *length) {
+  const int axis = config_.shape_bucket_seq_axis();
+  *length = -1;
+  for (auto &shape : shapes) {
+    if (static_cast<int>(shape.size()) > axis) {
+      *length = std::max(*length, shape[axis]);
+    }
+  }
+  const auto &lengths = config_.shape_buckets();
+  auto it = std::lower_bound(lengths.begin(), lengths.end(), *length);
+  if (!paddable || *length < 0 || it == lengths.end()) {
+    ++shape_bucket_misses_;
+    return nullptr;
+  }
+
+  auto &bucket = shape_buckets_[it - lengths.begin()];
+  if (bucket == nullptr) {
+    VLOG(3) << "Create the shape bucket of length " << *it;
+    bucket.reset(new ShapeBucket);
+    bucket->length = *it;
+    bucket->scope = &scope_->NewScope();
+    bucket->executor.reset(new NaiveExecutor(place_));
+    bucket->executor->CreateVariables(*inference_program_, 0, false,
+                                      bucket->scope);
+    CreateFeedFetchVar(bucket->scope);
+    bucket->executor->Prepare(bucket->scope, *inference_program_, 0,
+                              config_.use_feed_fetch_ops_);
+  }
+  std::vector<int64_t> padded_shapes;
+  for (auto &shape : shapes) {
+    padded_shapes.insert(padded_shapes.end(), shape.begin(), shape.end());
+    if (IsBucketedShape(shape, axis, *length)) {
+      padded_shapes[padded_shapes.size() - shape.size() + axis] =
+          bucket->length;
+    }
+    padded_shapes.push_back(-1);
+  }
+  ++bucket->runs;
+  if (bucket->shapes.insert(padded_shapes).second) ++bucket->cold_runs;
+  return bucket.get();
+}
+
+AnalysisPredictor::ShapeBucket *AnalysisPredictor::PadShapeBucketInputs(
+    const std::vector<PaddleTensor> &inputs, int64_t *length) {
+  std::vector<std::vector<int64_t>> shapes;
+  bool paddable = true;
+  for (auto &input : inputs) {
+    shapes.emplace_back(input.shape.begin(), input.shape.end());
+    paddable = paddable && input.lod.empty();
+  }
+  auto *bucket = FindShapeBucket(shapes, paddable, length);
+  if (bucket == nullptr) return nullptr;
+
+  const int axis = config_.shape_bucket_seq_axis();
+  bucket->inputs.resize(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto &padded = bucket->inputs[i];
+    padded.name = inputs[i].name;
+    padded.dtype = inputs[i].dtype;
+    padded.shape = inputs[i].shape;
+    const bool pad = IsBucketedShape(shapes[i], axis, *length);
+    if (pad) padded.shape[axis] = bucket->length;
+    // The feed copies the whole buffer, which must be of the padded size
+    const size_t element_size =
+        paddle_infer::GetNumBytesOfDataType(inputs[i].dtype);
+    const size_t bytes = inference::VecReduceToInt(padded.shape) * element_size;
+    if (padded.data.length() != bytes) padded.data = PaddleBuf(bytes);
+    if (pad) {
+      inference::ResizeAxis(inputs[i].data.data(), shapes[i], axis,
+                            bucket->length, element_size, padded.data.data());
+    } else {
+      std::memcpy(padded.data.data(), inputs[i].data.data(), bytes);
+    }
+  }
+  return bucket;
+}
+
+AnalysisPredictor::ShapeBucket *AnalysisPredictor::PadShapeBucketInputs(
+    int64_t *length) {
+  std::vector<const framework::LoDTensor *> inputs;
+  std::vector<std::vector<int64_t>> shapes;
+  bool paddable = true;
+  for (auto &item : idx2feeds_) {
+    auto *var = sub_scope_->FindVar(item.second);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound("The input %s is not found.",
+                                        item.second));
+    auto &input = var->Get<framework::LoDTensor>();
+    inputs.push_back(&input);
+    shapes.push_back(framework::vectorize(input.dims()));
+    paddable = paddable && input.IsInitialized() && input.lod().empty();
+  }
+  auto *bucket = FindShapeBucket(shapes, paddable, length);
+  if (bucket == nullptr) return nullptr;
+
+  const int axis = config_.shape_bucket_seq_axis();
+  size_t i = 0;
+  for (auto &item : idx2feeds_) {
+    auto *padded =
+        bucket->scope->Var(item.second)->GetMutable<framework::LoDTensor>();
+    if (IsBucketedShape(shapes[i], axis, *length)) {
+      auto padded_shape = shapes[i];
+      padded_shape[axis] = bucket->length;
+      padded->Resize(framework::make_ddim(padded_shape));
+      void *data = padded->mutable_data(place_, inputs[i]->type());
+      inference::ResizeAxis(inputs[i]->data<void>(), shapes[i], axis,
+                            bucket->length,
+                            framework::SizeOfType(inputs[i]->type()), data);
+    } else {
+      framework::TensorCopySync(*inputs[i], place_, padded);
+    }
+    ++i;
+  }
+  return bucket;
+}
+
+void AnalysisPredictor::CutShapeBucketOutputs(
+    const ShapeBucket &bucket, int64_t length,
+    std::vector<PaddleTensor> *outputs) {
+  if (length == bucket.length) return;
+  const int axis = config_.shape_bucket_seq_axis();
+  for (auto &output : *outputs) {
+    std::vector<int64_t> shape(output.shape.begin(), output.shape.end());
+    if (!output.lod.empty() || !IsBucketedShape(shape, axis, bucket.length)) {
+      continue;
+    }
+    // The cut data is copied to a buffer of its size, as the users take the
+    // length of the buffer for the size of the output
+    output.shape[axis] = length;
+    const size_t type_size = paddle_infer::GetNumBytesOfDataType(output.dtype);
+    PaddleBuf cut(inference::VecReduceToInt(output.shape) * type_size);
+    inference::ResizeAxis(output.data.data(), shape, axis, length, type_size,
+                          cut.data());
+    output.data = std::move(cut);
+  }
+}
+
+void AnalysisPredictor::CutShapeBucketOutputs(const ShapeBucket &bucket,
+                                              int64_t length) {
+  const int axis = config_.shape_bucket_seq_axis();
+  for (auto &item : idx2fetches_) {
+    auto *var = bucket.scope->FindVar(item.second);
+    if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+    auto &output = var->Get<framework::LoDTensor>();
+    auto *cut =
+        sub_scope_->Var(item.second)->GetMutable<framework::LoDTensor>();
+    auto shape = framework::vectorize(output.dims());
+    if (length != bucket.length && output.lod().empty() &&
+        IsBucketedShape(shape, axis, bucket.length)) {
+      auto cut_shape = shape;
+      cut_shape[axis] = length;
+      cut->Resize(framework::make_ddim(cut_shape));
+      void *data = cut->mutable_data(place_, output.type());
+      inference::ResizeAxis(output.data<void>(), shape, axis, length,
+                            framework::SizeOfType(output.type()), data);
+    } else {
+      // The output handles read the scope of the predictor
+      cut->ShareDataWith(output);
+    }
+    cut->set_lod(output.lod());
+  }
+}
+
+std::vector<paddle_infer::ShapeBucketStats>
+AnalysisPredictor::GetShapeBucketStats() const {
+  std::vector<paddle_infer::ShapeBucketStats> stats;
+  for (size_t i = 0; i < shape_buckets_.size(); ++i) {
+    paddle_infer::ShapeBucketStats bucket_stats;
+    bucket_stats.length = config_.shape_buckets()[i];
+    if (shape_buckets_[i] != nullptr) {
+      bucket_stats.runs = shape_buckets_[i]->runs;
+      bucket_stats.cold_runs = shape_buckets_[i]->cold_runs;
+    }
+    stats.push_back(bucket_stats);
+  }
+  paddle_infer::ShapeBucketStats misses;
+  misses.runs = shape_bucket_misses_;
+  stats.push_back(misses);
+  return stats;
+}
+
 bool AnalysisPredictor::LoadProgramDesc() {
   // Initialize the inference program
   std::string filename;
@@ -820,6 +1101,7 @@ bool AnalysisPredictor::LoadParameters() {
     op->SetType("load_combine");
     op->SetOutput("Out", params);
     op->SetAttr("file_path", {config_.params_file()});
+    op->SetAttr("use_mmap", config_.memory_map_params_);
     op->CheckAttrs();
   }
 
@@ -837,20 +1119,53 @@ void AnalysisPredictor::ClearIntermediateTensor() {
                           platform::errors::PreconditionNotMet(
                               "The inference program should be loaded first."));
   const auto &global_block = inference_program_->MutableBlock(0);
-  for (auto *var : global_block->AllVars()) {
-    if (!IsPersistable(var)) {
-      const std::string name = var->Name();
-      auto *variable = executor_->scope()->FindVar(name);
-      if (variable != nullptr && variable->IsType<framework::LoDTensor>() &&
-          name != "feed" && name != "fetch") {
-        VLOG(3) << "Clear Intermediate Tensor: " << name;
-        auto *t = variable->GetMutable<framework::LoDTensor>();
-        t->clear();
+  for (auto *scope : IntermediateScopes()) {
+    for (auto *var : global_block->AllVars()) {
+      if (!IsPersistable(var)) {
+        const std::string name = var->Name();
+        auto *variable = scope->FindVar(name);
+        if (variable != nullptr && variable->IsType<framework::LoDTensor>() &&
+            name != "feed" && name != "fetch") {
+          VLOG(3) << "Clear Intermediate Tensor: " << name;
+          auto *t = variable->GetMutable<framework::LoDTensor>();
+          t->clear();
+        }
       }
     }
   }
 }
 
+size_t AnalysisPredictor::IntermediateTensorBytes() {
+  PADDLE_ENFORCE_NOT_NULL(inference_program_.get(),
+                          platform::errors::PreconditionNotMet(
+                              "The inference program should be loaded first."));
+  std::set<const memory::Allocation *> buffers;
+  size_t bytes = 0;
+  for (auto *scope : IntermediateScopes()) {
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var)) continue;
+      auto *variable = scope->FindVar(var->Name());
+      if (variable == nullptr || !variable->IsType<framework::LoDTensor>()) {
+        continue;
+      }
+      auto &tensor = variable->Get<framework::LoDTensor>();
+      auto *buffer = tensor.Holder().get();
+      if (buffer != nullptr && buffers.insert(buffer).second) {
+        bytes += buffer->size();
+      }
+    }
+  }
+  return bytes;
+}
+
+std::vector<framework::Scope *> AnalysisPredictor::IntermediateScopes() {
+  std::vector<framework::Scope *> scopes{executor_->scope()};
+  for (auto &bucket : shape_buckets_) {
+    if (bucket) scopes.push_back(bucket->scope);
+  }
+  return scopes;
+}
+
 #if PADDLE_WITH_TENSORRT
 bool AnalysisPredictor::SaveTrtCalibToDisk() {
   PADDLE_ENFORCE(config_.tensorrt_engine_enabled(),
@@ -916,6 +1231,9 @@ AnalysisPredictor::~AnalysisPredictor() {
     platform::DisableProfiler(platform::EventSortingKey::kTotal,
                               "./profile.log");
   }
+  for (auto &bucket : shape_buckets_) {
+    if (bucket) scope_->DeleteScope(bucket->scope);
+  }
   if (sub_scope_) {
     scope_->DeleteScope(sub_scope_);
   }
@@ -979,13 +1297,15 @@ void AnalysisPredictor::SaveOptimModel(const std::string &dir) {
   std::string model_name = dir + "/model";
   std::ofstream outfile;
   outfile.open(model_name, std::ios::out | std::ios::binary);
-  std::string inference_prog_desc = GetSerializedProgram();
-  outfile << inference_prog_desc;
+  // The packed GEMM weights depend on the MKL build and the CPU, and are
+  // not saved
+  framework::ProgramDesc main_program(*inference_program_->Proto());
+  framework::ir::RemovePackedGemmWeights(main_program.MutableBlock(0));
+  outfile << main_program.Proto()->SerializeAsString();
   // save params
   framework::ProgramDesc save_program;
   auto *save_block = save_program.MutableBlock(0);
 
-  const framework::ProgramDesc &main_program = program();
   const framework::BlockDesc &global_block = main_program.Block(0);
   std::vector<std::string> save_var_list;
   for (framework::VarDesc *var : global_block.AllVars()) {
@@ -1005,6 +1325,8 @@ void AnalysisPredictor::SaveOptimModel(const std::string &dir) {
   op->SetType("save_combine");
   op->SetInput("X", save_var_list);
   op->SetAttr("file_path", dir + "/params");
+  // Pad the data for the memory mapped loads, see EnableMemoryMapParams()
+  op->SetAttr("align_data", true);
   op->CheckAttrs();
 
   platform::CPUPlace place;
@@ -1012,6 +1334,175 @@ void AnalysisPredictor::SaveOptimModel(const std::string &dir) {
   exe.Run(save_program, scope(), 0, true, true);
 }
 
+std::string AnalysisPredictor::OptimizedProgramCacheKey() {
+  std::hash<std::string> hash;
+  std::stringstream key;
+  key << get_version();
+  key << "program: " << hash(inference_program_->Proto()->SerializeAsString())
+      << "\n";
+  // The config holds the program and the parameters of the models loaded
+  // from memory
+  key << "config: " << hash(config_.SerializeInfoCache()) << "\n";
+  key << "passes:";
+  for (auto &pass : config_.pass_builder()->AllPasses()) key << " " << pass;
+  key << "\nanalysis passes:";
+  for (auto &pass : config_.pass_builder()->AnalysisPasses()) {
+    key << " " << pass;
+  }
+  key << "\nparams:";
+  if (config_.model_from_memory()) {
+    key << " memory";
+  } else if (!config_.params_file().empty()) {
+    key << " " << FileStamp(config_.params_file());
+  } else {
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var)) {
+        key << " " << var->Name() << "="
+            << FileStamp(config_.model_dir() + "/" + var->Name());
+      }
+    }
+  }
+  // The kernels picked by the passes, like the JIT ones, depend on the
+  // instruction set of the CPU
+  key << "\ncpu:";
+  for (auto isa : {platform::sse42, platform::avx, platform::avx2,
+                   platform::avx512f, platform::avx512_core,
+                   platform::avx512_core_vnni}) {
+    key << " " << platform::MayIUse(isa);
+  }
+  key << "\n";
+  return key.str();
+}
+
+bool AnalysisPredictor::LoadOptimizedProgramCache(const std::string &key) {
+  const std::string dir = OptimizedProgramCacheEntry(
+      config_.optimized_program_cache_dir(), key);
+  std::string cached_key;
+  if (!ReadFile(dir + "/key", &cached_key)) return false;
+  if (cached_key != key) {
+    LOG(WARNING) << "The optimized program cache " << dir
+                 << " is of another model or config, and not used.";
+    return false;
+  }
+
+  std::string program_content;
+  framework::proto::ProgramDesc proto;
+  if (!ReadFile(dir + "/model", &program_content) ||
+      !proto.ParseFromString(program_content)) {
+    LOG(WARNING) << "Can not read the program of the optimized program cache "
+                 << dir;
+    return false;
+  }
+  auto program = std::make_shared<framework::ProgramDesc>(proto);
+
+  // The parameters are saved by SaveOptimModel() in the order of their names
+  framework::ProgramDesc load_program;
+  framework::BlockDesc *load_block = load_program.MutableBlock(0);
+  std::vector<std::string> params;
+  for (auto *var : program->Block(0).AllVars()) {
+    if (IsPersistable(var)) {
+      framework::VarDesc *new_var = load_block->Var(var->Name());
+      new_var->SetShape(var->GetShape());
+      new_var->SetDataType(var->GetDataType());
+      new_var->SetType(var->GetType());
+      new_var->SetLoDLevel(var->GetLoDLevel());
+      new_var->SetPersistable(true);
+      params.push_back(var->Name());
+    }
+  }
+  std::sort(params.begin(), params.end());
+  framework::OpDesc *op = load_block->AppendOp();
+  op->SetType("load_combine");
+  op->SetOutput("Out", params);
+  op->SetAttr("file_path", {dir + "/params"});
+  op->SetAttr("use_mmap", config_.memory_map_params_);
+  op->CheckAttrs();
+
+  // The persistable vars are created in the root scope. Those of the cache
+  // are erased if it fails to load, since the analysis then runs on the
+  // scope, where constant_folding_pass does not fold into the existing vars.
+  framework::Scope *root = scope_.get();
+  while (root->parent()) root = root->parent();
+  std::vector<std::string> created_vars;
+  for (auto *var : program->Block(0).AllVars()) {
+    if (var->Persistable() && root->FindVar(var->Name()) == nullptr) {
+      created_vars.push_back(var->Name());
+    }
+  }
+  try {
+    executor_->CreateVariables(*program, 0, true, sub_scope_);
+    framework::NaiveExecutor e(place_);
+    e.Prepare(scope_.get(), load_program, 0, false);
+    e.Run();
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Can not load the parameters of the optimized program "
+                    "cache "
+                 << dir << ": " << e.what();
+    root->EraseVars(created_vars);
+    return false;
+  }
+  // The packed GEMM weights are not saved, see SaveOptimModel()
+  auto &passes = config_.pass_builder()->AllPasses();
+  if (std::find(passes.begin(), passes.end(), "gemm_weight_pack_pass") !=
+      passes.end()) {
+    framework::ir::PackGemmWeights(program->MutableBlock(0), scope_.get());
+  }
+  inference_program_ = program;
+  LOG(INFO) << "Load the optimized program from the cache " << dir;
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimizedProgramCache(const std::string &key) {
+  // The engines and the device code are built by the analysis, and are not
+  // part of the program
+  for (size_t i = 0; i < inference_program_->Size(); ++i) {
+    for (auto *op : inference_program_->Block(i).AllOps()) {
+      if (op->Type() == "tensorrt_engine" || op->Type() == "lite_engine" ||
+          (op->Type() == "fusion_group" &&
+           op->GetAttrIfExists<std::string>("code").empty())) {
+        LOG(INFO) << "The optimized program has a " << op->Type()
+                  << " op, and is not cached.";
+        return;
+      }
+    }
+  }
+
+  const std::string &cache_dir = config_.optimized_program_cache_dir();
+  const std::string dir = OptimizedProgramCacheEntry(cache_dir, key);
+  if (!inference::analysis::PathExists(cache_dir)) {
+    MKDIR(cache_dir.c_str());
+  }
+  // Write to a directory of its own, and move it to the entry at the end, so
+  // that the processes starting together never read a partial entry
+  const std::string tmp_dir =
+      dir + ".tmp" + std::to_string(std::random_device()());
+  if (MKDIR(tmp_dir.c_str()) != 0) {
+    LOG(WARNING) << "Can not create the directory " << tmp_dir
+                 << " of the optimized program cache.";
+    return;
+  }
+  bool success = true;
+  try {
+    SaveOptimModel(tmp_dir);
+    std::ofstream fout(tmp_dir + "/key", std::ios::out | std::ios::binary);
+    fout << key;
+    fout.close();
+    success = static_cast<bool>(fout);
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Can not save the optimized program cache: " << e.what();
+    success = false;
+  }
+  // The rename fails if another predictor saved the entry first
+  if (success && std::rename(tmp_dir.c_str(), dir.c_str()) == 0) {
+    LOG(INFO) << "Save the optimized program to the cache " << dir;
+    return;
+  }
+  for (auto *name : {"/model", "/params", "/key"}) {
+    std::remove((tmp_dir + name).c_str());
+  }
+  RMDIR(tmp_dir.c_str());
+}
+
 template <>
 std::unique_ptr<PaddlePredictor> CreatePaddlePredictor<AnalysisConfig>(
     const AnalysisConfig &config) {
@@ -1116,6 +1607,12 @@ void Predictor::ClearIntermediateTensor() {
   predictor_->ClearIntermediateTensor();
 }
 
+std::vector<ShapeBucketStats> Predictor::GetShapeBucketStats() {
+  auto *analysis_pred =
+      static_cast<paddle::AnalysisPredictor *>(predictor_.get());
+  return analysis_pred->GetShapeBucketStats();
+}
+
 int GetNumBytesOfDataType(DataType dtype) {
   switch (dtype) {
     case DataType::FLOAT32:
@@ -1147,22 +1644,242 @@ std::shared_ptr<Predictor> CreatePredictor(const Config &config) {  // NOLINT
 }
 
 namespace services {
-PredictorPool::PredictorPool(const Config &config, size_t size) {
+namespace {
+
+PredictorPoolConfig MakePoolConfig(size_t size) {
+  PredictorPoolConfig pool;
+  pool.size = size;
+  return pool;
+}
+
+#ifdef __linux__
+void SetThreadCores(const cpu_set_t &mask) {
+  if (0 != pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask)) {
+    VLOG(1) << "Failed to set the thread affinity.";
+  }
+}
+
+// Sets the cores of the calling thread and of the OpenMP workers its MKL
+// calls run on. The workers of other threads, like the MKL threads of
+// a build without OpenMP, keep their cores.
+void SetCallerCores(const cpu_set_t &mask, int omp_threads) {
+  SetThreadCores(mask);
+#ifdef PADDLE_WITH_MKLML
+  if (omp_threads > 1) {
+#pragma omp parallel num_threads(omp_threads)
+    SetThreadCores(mask);
+  }
+#endif
+}
+
+cpu_set_t CoreMask(const std::vector<int> &cores) {
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int core : cores) CPU_SET(core, &mask);
+  return mask;
+}
+#endif
+
+// The pages of a parameter of its own on a NUMA node
+class NumaAllocation : public paddle::memory::Allocation {
+ public:
+  NumaAllocation(void *ptr, size_t size)
+      : Allocation(ptr, size, paddle::platform::CPUPlace()) {}
+  ~NumaAllocation() { paddle::platform::FreeNumaMemory(ptr(), size()); }
+};
+
+#ifdef __linux__
+// How the calling thread was placed before Pin(), restored by Unpin() once
+// it holds no predictor of a pool
+struct ThreadPlacement {
+  int pinned{0};
+  cpu_set_t cores;
+  bool cores_saved{false};
+  // The OpenMP workers pinned with the thread
+  int omp_threads{0};
+  paddle::platform::NumaMemoryPolicy numa_policy;
+};
+
+ThreadPlacement &CallerPlacement() {
+  thread_local ThreadPlacement placement;
+  return placement;
+}
+#endif
+
+// Moves the parameters of the predictor to pages of their own on the NUMA
+// node, so that binding them moves no other memory, and returns their bytes
+size_t BindParameters(paddle::AnalysisPredictor *pred, int node) {
+  auto *scope = pred->scope();
+  size_t bytes = 0;
+  for (auto &name : scope->LocalVarNames()) {
+    auto *var = scope->FindLocalVar(name);
+    if (var == nullptr || !var->IsType<paddle::framework::LoDTensor>()) {
+      continue;
+    }
+    auto *tensor = var->GetMutable<paddle::framework::LoDTensor>();
+    if (!tensor->IsInitialized() ||
+        !paddle::platform::is_cpu_place(tensor->place()) ||
+        tensor->offset() != 0) {
+      continue;
+    }
+    const size_t size =
+        tensor->numel() * paddle::framework::SizeOfType(tensor->type());
+    void *ptr = paddle::platform::AllocateNumaMemory(size, node);
+    if (ptr == nullptr) continue;
+    std::memcpy(ptr, tensor->data<void>(), size);
+    tensor->ResetHolder(std::make_shared<NumaAllocation>(ptr, size));
+    bytes += size;
+  }
+  return bytes;
+}
+
+}  // namespace
+
+PredictorPool::PredictorPool(const Config &config, size_t size)
+    : PredictorPool(config, MakePoolConfig(size)) {}
+
+PredictorPool::PredictorPool(const Config &config,
+                             const PredictorPoolConfig &pool)
+    : pool_(pool) {
+  const size_t size = pool.size;
   PADDLE_ENFORCE_GE(
       size, 1UL,
       paddle::platform::errors::InvalidArgument(
           "The predictor pool size should be greater than 1, but it's (%d)",
           size));
   Config copy_config(config);
-  main_pred_.reset(new Predictor(config));
-  for (size_t i = 0; i < size - 1; i++) {
-    if (config.tensorrt_engine_enabled()) {
-      Config config_tmp(copy_config);
-      preds_.push_back(
-          std::move(std::unique_ptr<Predictor>(new Predictor(config_tmp))));
+  // The nodes with cores the pool may run on
+  std::vector<int> numa_nodes;
+
+#ifdef __linux__
+  if (pool_.pin_cpu_cores || pool_.numa_aware) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    sched_getaffinity(0, sizeof(mask), &mask);
+    for (int core = 0; core < CPU_SETSIZE; ++core) {
+      if (CPU_ISSET(core, &mask)) all_cores_.push_back(core);
+    }
+  }
+  std::vector<std::vector<int>> numa_node_cores;
+  if (pool_.numa_aware) {
+    auto node_cores = paddle::platform::NumaNodeCores();
+    for (size_t node = 0; node < node_cores.size(); ++node) {
+      std::vector<int> cores;
+      for (int core : node_cores[node]) {
+        if (std::binary_search(all_cores_.begin(), all_cores_.end(), core)) {
+          cores.push_back(core);
+        }
+      }
+      if (!cores.empty()) {
+        numa_nodes.push_back(node);
+        numa_node_cores.push_back(std::move(cores));
+      }
+    }
+    if (numa_nodes.size() < 2 || config.use_gpu()) {
+      LOG(INFO) << "The predictor pool runs on " << numa_nodes.size()
+                << " NUMA node(s), and is not NUMA aware.";
+      pool_.numa_aware = false;
+      numa_nodes.clear();
     } else {
-      preds_.push_back(std::move(main_pred_->Clone()));
+      pool_.pin_cpu_cores = true;
+    }
+  }
+  if (all_cores_.empty()) {
+    pool_.pin_cpu_cores = false;
+    pool_.numa_aware = false;
+  }
+  if (pool_.pin_cpu_cores) {
+    const size_t threads = std::max(config.cpu_math_library_num_threads(), 1);
+    cores_.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      // The predictors of a node take the cores of the node in turn
+      const auto &cores = pool_.numa_aware
+                              ? numa_node_cores[i % numa_nodes.size()]
+                              : all_cores_;
+      const size_t first =
+          pool_.numa_aware ? i / numa_nodes.size() * threads : i * threads;
+      for (size_t j = 0; j < threads; ++j) {
+        cores_[i].push_back(cores[(first + j) % cores.size()]);
+      }
+    }
+  }
+  if (pool_.numa_aware) {
+    for (size_t i = 0; i < size; ++i) {
+      nodes_.push_back(numa_nodes[i % numa_nodes.size()]);
+    }
+  }
+#else
+  pool_.pin_cpu_cores = false;
+  pool_.numa_aware = false;
+#endif
+
+  // With NUMA, the first predictor of each node loads the parameters, and
+  // each predictor is made on the cores and the memory of its node
+  const size_t num_nodes = pool_.numa_aware ? numa_nodes.size() : 1;
+  for (size_t i = 0; i < size; ++i) {
+    auto create = [&, i] {
+      const bool load = i == 0 || config.tensorrt_engine_enabled() ||
+                        (pool_.numa_aware && i < num_nodes);
+      if (load) {
+        Config config_tmp(copy_config);
+        std::unique_ptr<Predictor> pred(new Predictor(config_tmp));
+        if (i == 0) {
+          main_pred_ = std::move(pred);
+        } else {
+          preds_.push_back(std::move(pred));
+        }
+      } else {
+        preds_.push_back(
+            Retrive(pool_.numa_aware ? i % num_nodes : 0)->Clone());
+      }
+      if (pool_.numa_aware && i < num_nodes) {
+        auto *analysis_pred = static_cast<paddle::AnalysisPredictor *>(
+            Retrive(i)->predictor_.get());
+        node_param_bytes_[nodes_[i]] = BindParameters(analysis_pred, nodes_[i]);
+      }
+    };
+    if (pool_.numa_aware) {
+      // An error of the thread is raised to the caller, as without NUMA
+      std::exception_ptr error;
+      std::thread thread([&, i] {
+        try {
+          Pin(i);
+          create();
+        } catch (...) {
+          error = std::current_exception();
+        }
+      });
+      thread.join();
+      if (error) std::rethrow_exception(error);
+    } else {
+      create();
+    }
+  }
+  for (size_t i = 0; i < size && pool_.pin_cpu_cores; ++i) {
+    LOG(INFO) << "Predictor " << i << " of the pool runs on the NUMA node "
+              << (pool_.numa_aware ? nodes_[i] : -1) << " and the cores "
+              << paddle::inference::to_string(cores_[i]);
+  }
+
+  // All the predictors start free, the first one on the top
+  next_.reset(new std::atomic<uint32_t>[size]);
+  checked_out_.reset(new std::atomic<bool>[size]);
+  for (size_t i = 0; i < size; ++i) {
+    index_[Retrive(i)] = i;
+    next_[i].store(i + 1 < size ? i + 2 : 0);
+    checked_out_[i].store(false);
+  }
+  head_.store(1);
+
+  if (pool.warmup) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < size; ++i) {
+      threads.emplace_back([this, i] {
+        Pin(i);
+        pool_.warmup(Retrive(i));
+      });
     }
+    for (auto &thread : threads) thread.join();
   }
 }
 
@@ -1177,5 +1894,109 @@ Predictor *PredictorPool::Retrive(size_t idx) {
   }
   return preds_[idx - 1].get();
 }
+
+Predictor *PredictorPool::TryCheckout() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  while (true) {
+    const uint32_t top = static_cast<uint32_t>(head);
+    if (top == 0) return nullptr;
+    const uint32_t next = next_[top - 1].load(std::memory_order_relaxed);
+    const uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+    if (head_.compare_exchange_weak(head, new_head, std::memory_order_acquire,
+                                    std::memory_order_acquire)) {
+      checked_out_[top - 1].store(true, std::memory_order_relaxed);
+      Pin(top - 1);
+      return Retrive(top - 1);
+    }
+  }
+}
+
+Predictor *PredictorPool::Checkout() {
+  while (true) {
+    auto *pred = TryCheckout();
+    if (pred != nullptr) return pred;
+    std::this_thread::yield();
+  }
+}
+
+void PredictorPool::Return(Predictor *pred) {
+  auto it = index_.find(pred);
+  PADDLE_ENFORCE_EQ(it != index_.end(), true,
+                    paddle::platform::errors::InvalidArgument(
+                        "The predictor returned is not from the pool."));
+  const size_t idx = it->second;
+  // A predictor pushed twice would be on the free stack twice
+  PADDLE_ENFORCE_EQ(
+      checked_out_[idx].exchange(false, std::memory_order_relaxed), true,
+      paddle::platform::errors::PreconditionNotMet(
+          "The predictor (%d) returned is not checked out.", idx));
+  if (pool_.max_intermediate_bytes > 0) {
+    auto *analysis_pred =
+        static_cast<paddle::AnalysisPredictor *>(pred->predictor_.get());
+    if (analysis_pred->IntermediateTensorBytes() >
+        pool_.max_intermediate_bytes) {
+      analysis_pred->ClearIntermediateTensor();
+    }
+  }
+  Unpin();
+
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  uint64_t new_head;
+  do {
+    next_[idx].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    new_head = (((head >> 32) + 1) << 32) | (idx + 1);
+  } while (!head_.compare_exchange_weak(head, new_head,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+std::vector<PredictorPlacement> PredictorPool::GetPlacements() const {
+  std::vector<PredictorPlacement> placements(size());
+  for (size_t i = 0; i < placements.size(); ++i) {
+    if (pool_.pin_cpu_cores) placements[i].cores = cores_[i];
+    if (pool_.numa_aware) {
+      placements[i].numa_node = nodes_[i];
+      placements[i].numa_param_bytes = node_param_bytes_.at(nodes_[i]);
+    }
+  }
+  return placements;
+}
+
+void PredictorPool::Pin(size_t idx) {
+#ifdef __linux__
+  auto &placement = CallerPlacement();
+  if (placement.pinned++ == 0) {
+    placement.cores_saved =
+        pool_.pin_cpu_cores &&
+        0 == pthread_getaffinity_np(pthread_self(), sizeof(placement.cores),
+                                    &placement.cores);
+    placement.omp_threads = 0;
+    if (pool_.numa_aware) {
+      paddle::platform::GetThreadNumaPolicy(&placement.numa_policy);
+    }
+  }
+  if (pool_.pin_cpu_cores) {
+    placement.omp_threads = std::max(placement.omp_threads,
+                                     static_cast<int>(cores_[idx].size()));
+    SetCallerCores(CoreMask(cores_[idx]), placement.omp_threads);
+  }
+  if (pool_.numa_aware) paddle::platform::SetThreadNumaNode(nodes_[idx]);
+#endif
+}
+
+void PredictorPool::Unpin() {
+#ifdef __linux__
+  // The thread is placed as its last predictor until it returns all of them
+  auto &placement = CallerPlacement();
+  if (placement.pinned == 0 || --placement.pinned > 0) return;
+  if (placement.cores_saved) {
+    SetCallerCores(placement.cores, placement.omp_threads);
+  }
+  if (pool_.numa_aware &&
+      !paddle::platform::SetThreadNumaPolicy(placement.numa_policy)) {
+    paddle::platform::SetThreadNumaNode(-1);
+  }
+#endif
+}
 }  // namespace services
 }  // namespace paddle_infer
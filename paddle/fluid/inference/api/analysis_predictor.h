@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/naive_executor.h"
@@ -193,6 +194,22 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   void ClearIntermediateTensor();
 
+  ///
+  /// \brief Get the memory held by the intermediate tensors of the predictor
+  ///
+  /// \return The memory in bytes, counting shared buffers once
+  ///
+  size_t IntermediateTensorBytes();
+
+  ///
+  /// \brief Get the runs of each bucket of the shape bucketing, see
+  /// AnalysisConfig::EnableShapeBucketing
+  ///
+  /// \return The stats of the buckets in ascending length, then of the runs
+  /// which fit in no bucket
+  ///
+  std::vector<paddle_infer::ShapeBucketStats> GetShapeBucketStats() const;
+
   ///
   /// \brief Get the argument used by predictor
   ///
@@ -280,6 +297,29 @@ class AnalysisPredictor : public PaddlePredictor {
   /// \return Whether the function executed successfully
   ///
   bool LoadParameters();
+  ///
+  /// \brief The key of the loaded program and the config in the optimized
+  /// program cache.
+  ///
+  /// \return The key, or an empty string if the program can not be cached
+  ///
+  std::string OptimizedProgramCacheKey();
+  ///
+  /// \brief Load the optimized program and its parameters from the optimized
+  /// program cache.
+  ///
+  /// \param[in] key the key of the program in the cache
+  /// \return Whether the cache has the program
+  ///
+  bool LoadOptimizedProgramCache(const std::string &key);
+  ///
+  /// \brief Save the optimized program and its parameters to the optimized
+  /// program cache, unless the program keeps state out of the program and
+  /// the scope, like the TensorRT engines.
+  ///
+  /// \param[in] key the key of the program in the cache
+  ///
+  void SaveOptimizedProgramCache(const std::string &key);
 
   ///
   /// \brief Prepare input data, only used in Run()
@@ -324,6 +364,70 @@ class AnalysisPredictor : public PaddlePredictor {
   /// AnalysisPredictor::ZeroCopyRun() now.
   ///
   void MkldnnPostReset();
+  ///
+  /// \brief The scope and executor of a bucket of the shape bucketing, which
+  /// keep the intermediate tensors and kernel caches of its shapes
+  ///
+  struct ShapeBucket {
+    int length;
+    framework::Scope *scope{nullptr};
+    std::unique_ptr<NaiveExecutor> executor;
+    details::TensorArrayBatchCleaner tensor_array_batch_cleaner;
+    // Memory buffer for the padded inputs of Run()
+    std::vector<PaddleTensor> inputs;
+    // The padded input shapes the bucket has run
+    std::set<std::vector<int64_t>> shapes;
+    uint64_t runs{0};
+    uint64_t cold_runs{0};
+  };
+  ///
+  /// \brief Find the bucket to run the inputs in, and count the run. The
+  /// scope and executor of a bucket are created at its first run.
+  ///
+  /// \param[in] shapes the shapes of the inputs
+  /// \param[in] paddable whether the inputs can be padded, which they can not
+  /// with LoD
+  /// \param[out] length the run length, which is the longest input along the
+  /// axis of the bucketing
+  /// \return The bucket, or nullptr if the inputs are not padded
+  ///
+  ShapeBucket *FindShapeBucket(const std::vector<std::vector<int64_t>> &shapes,
+                               bool paddable, int64_t *length);
+  ///
+  /// \brief The scopes of the intermediate tensors, which are the scope of
+  /// the predictor and those of the shape buckets
+  ///
+  std::vector<framework::Scope *> IntermediateScopes();
+  ///
+  /// \brief Pad the inputs of Run() up to their bucket
+  ///
+  /// \param[in] inputs the inputs of Run()
+  /// \param[out] length the run length
+  /// \return The bucket, with the padded inputs in its inputs, or nullptr if
+  /// the inputs are not padded
+  ///
+  ShapeBucket *PadShapeBucketInputs(const std::vector<PaddleTensor> &inputs,
+                                    int64_t *length);
+  ///
+  /// \brief Pad the inputs of ZeroCopyRun() up to their bucket, into the
+  /// scope of the bucket
+  ///
+  /// \param[out] length the run length
+  /// \return The bucket, or nullptr if the inputs are not padded
+  ///
+  ShapeBucket *PadShapeBucketInputs(int64_t *length);
+  ///
+  /// \brief Cut the outputs of Run() from the bucket length back to the run
+  /// length
+  ///
+  void CutShapeBucketOutputs(const ShapeBucket &bucket, int64_t length,
+                             std::vector<PaddleTensor> *outputs);
+  ///
+  /// \brief Cut the outputs of ZeroCopyRun() from the bucket length back to
+  /// the run length, into the scope of the predictor
+  ///
+  void CutShapeBucketOutputs(const ShapeBucket &bucket, int64_t length);
+
   ///
   /// \brief Compute compatibility based on model version information and
   /// operator version information
@@ -356,6 +460,7 @@ class AnalysisPredictor : public PaddlePredictor {
   FRIEND_TEST(AnalysisPredictor, analysis_off);
   FRIEND_TEST(AnalysisPredictor, analysis_on);
   FRIEND_TEST(AnalysisPredictor, with_gpu);
+  FRIEND_TEST(AnalysisPredictor, optimized_program_cache);
 #endif
 
  private:
@@ -373,6 +478,8 @@ class AnalysisPredictor : public PaddlePredictor {
   std::map<size_t, std::string> idx2feeds_;
   std::vector<framework::OpDesc *> fetches_;
   std::map<size_t, std::string> idx2fetches_;
+  // Whether the program is loaded from the optimized program cache.
+  bool optimized_program_cache_hit_{false};
 
 #if PADDLE_WITH_MKLDNN
   // Helper class to perform quantization
@@ -397,6 +504,11 @@ class AnalysisPredictor : public PaddlePredictor {
   std::vector<std::map<std::string, std::vector<int>>> batch_var_shapes_;
   int predictor_id_;
 
+  // For the shape bucketing, indexed as AnalysisConfig::shape_buckets(), and
+  // empty if it is disabled.
+  std::vector<std::unique_ptr<ShapeBucket>> shape_buckets_;
+  uint64_t shape_bucket_misses_{0};
+
  private:
   // Some status here that help to determine the status inside the predictor.
   bool status_is_cloned_{false};
@@ -15,12 +15,26 @@
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <dirent.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <set>
 #include <thread>  // NOLINT
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/inference/analysis/helper.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/tests/api/tester_helper.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/inference/api/mkldnn_quantizer.h"
 #endif
@@ -193,6 +207,165 @@ TEST(AnalysisPredictor, Clone) {
   }
 }
 
+TEST(AnalysisPredictor, resize_axis) {
+  // A 2 x 3 x 2 tensor, padded to 2 x 4 x 2 and cut back in place
+  std::vector<float> src(12);
+  for (size_t i = 0; i < src.size(); ++i) src[i] = i + 1;
+  std::vector<float> padded(16);
+  inference::ResizeAxis(src.data(), {2, 3, 2}, 1, 4, sizeof(float),
+                        padded.data());
+  std::vector<float> expected{1, 2, 3, 4,  5,  6,  0, 0,
+                              7, 8, 9, 10, 11, 12, 0, 0};
+  ASSERT_EQ(padded, expected);
+
+  inference::ResizeAxis(padded.data(), {2, 4, 2}, 1, 3, sizeof(float),
+                        padded.data());
+  padded.resize(12);
+  ASSERT_EQ(padded, src);
+}
+
+TEST(AnalysisPredictor, shape_bucketing) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  auto ref_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+
+  // Buckets over the batch, the only variable axis of word2vec
+  config.EnableShapeBucketing({8, 4}, 0);
+  ASSERT_TRUE(config.shape_bucketing_enabled());
+  ASSERT_EQ(config.shape_buckets(), std::vector<int>({4, 8}));
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  config.SwitchUseFeedFetchOps(false);
+  auto zero_copy_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+
+  for (int batch : {3, 4, 1, 3, 7, 10}) {
+    std::vector<int64_t> data(batch);
+    for (int i = 0; i < batch; ++i) data[i] = (i * 37 + batch) % 2000;
+    PaddleTensor tensor;
+    tensor.shape = std::vector<int>({batch, 1});
+    tensor.data.Reset(data.data(), batch * sizeof(int64_t));
+    tensor.dtype = PaddleDType::INT64;
+    std::vector<PaddleTensor> inputs(4, tensor);
+
+    std::vector<PaddleTensor> outputs, refs;
+    ASSERT_TRUE(ref_predictor->Run(inputs, &refs));
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    ASSERT_EQ(outputs.size(), 1UL);
+    ASSERT_EQ(outputs.front().shape[0], batch);
+    ASSERT_EQ(outputs.front().data.length(), refs.front().data.length());
+    EXPECT_TRUE(inference::CompareTensor(outputs.front(), refs.front()));
+
+    for (auto& name : zero_copy_predictor->GetInputNames()) {
+      auto input = zero_copy_predictor->GetInputTensor(name);
+      input->Reshape({batch, 1});
+      input->copy_from_cpu(data.data());
+    }
+    ASSERT_TRUE(zero_copy_predictor->ZeroCopyRun());
+    auto output = zero_copy_predictor->GetOutputTensor(
+        zero_copy_predictor->GetOutputNames()[0]);
+    ASSERT_EQ(output->shape(), refs.front().shape);
+    std::vector<float> out_data(refs.front().data.length() / sizeof(float));
+    output->copy_to_cpu(out_data.data());
+    const float* ref_data = static_cast<float*>(refs.front().data.data());
+    for (size_t i = 0; i < out_data.size(); ++i) {
+      EXPECT_NEAR(out_data[i], ref_data[i], 1e-5);
+    }
+  }
+
+  // The batches of 3, 4, 1 and 3 all run padded to 4, the one of 7 to 8, and
+  // the one of 10 on the default scope
+  for (auto* p : {predictor.get(), zero_copy_predictor.get()}) {
+    auto stats = static_cast<AnalysisPredictor*>(p)->GetShapeBucketStats();
+    ASSERT_EQ(stats.size(), 3UL);
+    EXPECT_EQ(stats[0].length, 4);
+    EXPECT_EQ(stats[0].runs, 4UL);
+    EXPECT_EQ(stats[0].cold_runs, 1UL);
+    EXPECT_EQ(stats[1].length, 8);
+    EXPECT_EQ(stats[1].runs, 1UL);
+    EXPECT_EQ(stats[1].cold_runs, 1UL);
+    EXPECT_EQ(stats[2].length, -1);
+    EXPECT_EQ(stats[2].runs, 1UL);
+  }
+}
+
+// Removes a directory of the optimized program cache and its entries, also
+// when the test fails halfway.
+class OptimizedProgramCacheCleaner {
+ public:
+  explicit OptimizedProgramCacheCleaner(const std::string& dir) : dir_(dir) {}
+  ~OptimizedProgramCacheCleaner() {
+    for (auto& entry : Entries()) {
+      for (const char* file : {"/key", "/model", "/params"}) {
+        std::remove((entry + file).c_str());
+      }
+      RMDIR(entry.c_str());
+    }
+    RMDIR(dir_.c_str());
+  }
+
+  std::vector<std::string> Entries() const {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(dir_.c_str());
+    if (dir == nullptr) return entries;
+    while (struct dirent* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name != "." && name != "..") entries.push_back(dir_ + "/" + name);
+    }
+    closedir(dir);
+    return entries;
+  }
+
+ private:
+  std::string dir_;
+};
+
+TEST(AnalysisPredictor, optimized_program_cache) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  auto ref_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+
+  // The first predictor saves the optimized program, and the second one
+  // loads it. The cache lives in a fresh directory, so that the runs never
+  // share the entries, or leave them in the model directory.
+  const std::string cache_dir = "/tmp/_optim_program_cache" +
+                                std::to_string(std::random_device()());
+  OptimizedProgramCacheCleaner cleaner(cache_dir);
+  config.EnableOptimizedProgramCache(cache_dir);
+  ASSERT_TRUE(config.optimized_program_cache_enabled());
+  auto saving_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  ASSERT_FALSE(static_cast<AnalysisPredictor*>(saving_predictor.get())
+                   ->optimized_program_cache_hit_);
+  auto entries = cleaner.Entries();
+  ASSERT_EQ(entries.size(), 1UL);
+  for (const char* file : {"/key", "/model", "/params"}) {
+    struct stat info;
+    EXPECT_EQ(stat((entries.front() + file).c_str(), &info), 0) << file;
+  }
+
+  auto loading_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  ASSERT_TRUE(static_cast<AnalysisPredictor*>(loading_predictor.get())
+                  ->optimized_program_cache_hit_);
+  ASSERT_EQ(loading_predictor->GetSerializedProgram(),
+            saving_predictor->GetSerializedProgram());
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  std::vector<PaddleTensor> refs;
+  ASSERT_TRUE(ref_predictor->Run(inputs, &refs));
+  for (auto* predictor : {saving_predictor.get(), loading_predictor.get()}) {
+    std::vector<PaddleTensor> outputs;
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    ASSERT_EQ(outputs.size(), 1UL);
+    EXPECT_TRUE(inference::CompareTensor(outputs.front(), refs.front()));
+  }
+}
+
 // This function is not released yet, will fail on some machine.
 // TODO(Superjomn) Turn on it latter.
 /*
@@ -507,3 +680,151 @@ TEST(AnalysisPredictor, bf16_pass_strategy) {
 }
 
 }  // namespace paddle
+
+namespace paddle_infer {
+namespace services {
+
+TEST(PredictorPool, checkout) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  PredictorPoolConfig pool_config;
+  pool_config.size = 3;
+  pool_config.pin_cpu_cores = true;
+  pool_config.max_intermediate_bytes = 1;
+  std::atomic<int> warmed{0};
+  pool_config.warmup = [&warmed](Predictor* pred) {
+    for (auto& name : pred->GetInputNames()) {
+      auto input = pred->GetInputHandle(name);
+      input->Reshape({4, 1});
+      std::vector<int64_t> data(4, 1);
+      input->CopyFromCpu(data.data());
+    }
+    ASSERT_TRUE(pred->Run());
+    ++warmed;
+  };
+  PredictorPool pool(config, pool_config);
+  ASSERT_EQ(warmed.load(), 3);
+
+  std::vector<Predictor*> preds;
+  for (size_t i = 0; i < pool.size(); ++i) {
+    preds.push_back(pool.TryCheckout());
+    ASSERT_NE(preds.back(), nullptr);
+  }
+  ASSERT_EQ(pool.TryCheckout(), nullptr);
+  std::sort(preds.begin(), preds.end());
+  ASSERT_EQ(std::unique(preds.begin(), preds.end()), preds.end());
+  for (auto* pred : preds) pool.Return(pred);
+  // A predictor can't be returned twice
+  EXPECT_ANY_THROW(pool.Return(preds[0]));
+
+#ifdef __linux__
+  // The caller gets its own cores back
+  std::thread([&pool] {
+    cpu_set_t mask, before, after;
+    ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask), 0);
+    CPU_ZERO(&before);
+    for (int core = 0; core < CPU_SETSIZE; ++core) {
+      if (CPU_ISSET(core, &mask)) {
+        CPU_SET(core, &before);
+        break;
+      }
+    }
+    ASSERT_EQ(pthread_setaffinity_np(pthread_self(), sizeof(before), &before),
+              0);
+    pool.Return(pool.Checkout());
+    ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(after), &after),
+              0);
+    EXPECT_TRUE(CPU_EQUAL(&before, &after));
+  }).join();
+#endif
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 6; ++tid) {
+    threads.emplace_back([&pool] {
+      for (int i = 0; i < 10; ++i) {
+        auto* pred = pool.Checkout();
+        for (auto& name : pred->GetInputNames()) {
+          auto input = pred->GetInputHandle(name);
+          input->Reshape({2, 1});
+          std::vector<int64_t> data(2, i);
+          input->CopyFromCpu(data.data());
+        }
+        ASSERT_TRUE(pred->Run());
+        pool.Return(pred);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+TEST(PredictorPool, numa_load_error) {
+  // A predictor that fails to load raises the error, NUMA aware or not
+  Config config;
+  config.SetModel(FLAGS_dirname + "/_not_a_model");
+  config.DisableGpu();
+  PredictorPoolConfig pool_config;
+  pool_config.size = 2;
+  pool_config.numa_aware = true;
+  EXPECT_ANY_THROW(PredictorPool pool(config, pool_config));
+}
+
+TEST(PredictorPool, numa_placement) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  PredictorPoolConfig pool_config;
+  pool_config.size = 4;
+  pool_config.numa_aware = true;
+  PredictorPool pool(config, pool_config);
+
+  auto placements = pool.GetPlacements();
+  ASSERT_EQ(placements.size(), 4UL);
+  std::set<int> nodes;
+  for (auto& placement : placements) nodes.insert(placement.numa_node);
+#ifdef __linux__
+  if (paddle::platform::NumaNodeCores().size() > 1) {
+    // The predictors alternate over the nodes, each with a parameter copy
+    ASSERT_GT(nodes.size(), 1UL);
+    for (size_t i = 0; i < placements.size(); ++i) {
+      EXPECT_NE(placements[i].numa_node, -1);
+      EXPECT_FALSE(placements[i].cores.empty());
+      EXPECT_GT(placements[i].numa_param_bytes, 0UL);
+      if (i > 0) {
+        EXPECT_NE(placements[i].numa_node, placements[i - 1].numa_node);
+      }
+    }
+  }
+#endif
+  if (nodes.count(-1)) {
+    ASSERT_EQ(nodes.size(), 1UL);
+  }
+
+  // All the predictors compute the same outputs
+  std::vector<Predictor*> preds;
+  for (size_t i = 0; i < pool.size(); ++i) preds.push_back(pool.Checkout());
+  std::vector<float> ref;
+  for (auto* pred : preds) {
+    for (auto& name : pred->GetInputNames()) {
+      auto input = pred->GetInputHandle(name);
+      input->Reshape({4, 1});
+      std::vector<int64_t> data({1, 2, 3, 4});
+      input->CopyFromCpu(data.data());
+    }
+    ASSERT_TRUE(pred->Run());
+    auto output = pred->GetOutputHandle(pred->GetOutputNames()[0]);
+    auto shape = output->shape();
+    std::vector<float> out(std::accumulate(shape.begin(), shape.end(), 1,
+                                           std::multiplies<int>()));
+    output->CopyToCpu(out.data());
+    if (ref.empty()) {
+      ref = out;
+    } else {
+      ASSERT_EQ(out.size(), ref.size());
+      for (size_t j = 0; j < out.size(); ++j) EXPECT_NEAR(out[j], ref[j], 1e-5);
+    }
+  }
+  for (auto* pred : preds) pool.Return(pred);
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -73,7 +73,9 @@ PaddleBuf &PaddleBuf::operator=(const PaddleBuf &other) {
 }
 
 PaddleBuf &PaddleBuf::operator=(PaddleBuf &&other) {
-  // only the buffer with external memory can be copied
+  if (this == &other) return *this;
+  // release the owned memory, which is replaced by that of other
+  Free();
   data_ = other.data_;
   length_ = other.length_;
   memory_owned_ = other.memory_owned_;
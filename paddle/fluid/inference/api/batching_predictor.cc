@@ -0,0 +1,577 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/inference/api/helper.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle_infer {
+namespace services {
+
+using paddle::PaddleTensor;
+using paddle::ZeroCopyTensor;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// The latest latencies that the percentiles of BatchingStats are taken over
+constexpr size_t kLatencyWindow = 1 << 16;
+
+struct BatchRequest {
+  // The inputs in the order of the model inputs
+  std::vector<const PaddleTensor *> inputs;
+  std::vector<PaddleTensor> *outputs;
+  size_t samples;
+  // Whether the request may share a batch with others
+  bool batchable;
+  Clock::time_point arrival;
+  std::promise<bool> done;
+};
+
+size_t NumSamples(const PaddleTensor &tensor) {
+  return tensor.lod.empty() ? tensor.shape[0] : tensor.lod[0].size() - 1;
+}
+
+size_t NumElements(const std::vector<int> &shape, size_t begin) {
+  size_t numel = 1;
+  for (size_t i = begin; i < shape.size(); ++i) numel *= shape[i];
+  return numel;
+}
+
+char *MutableData(ZeroCopyTensor *tensor, DataType dtype) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return reinterpret_cast<char *>(
+          tensor->mutable_data<float>(PlaceType::kCPU));
+    case DataType::INT64:
+      return reinterpret_cast<char *>(
+          tensor->mutable_data<int64_t>(PlaceType::kCPU));
+    case DataType::INT32:
+      return reinterpret_cast<char *>(
+          tensor->mutable_data<int32_t>(PlaceType::kCPU));
+    case DataType::UINT8:
+      return reinterpret_cast<char *>(
+          tensor->mutable_data<uint8_t>(PlaceType::kCPU));
+  }
+  PADDLE_THROW(paddle::platform::errors::Unimplemented(
+      "Unsupported data type %d.", static_cast<int>(dtype)));
+}
+
+void CopyFromCpu(ZeroCopyTensor *tensor, DataType dtype, const char *data) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return tensor->copy_from_cpu(reinterpret_cast<const float *>(data));
+    case DataType::INT64:
+      return tensor->copy_from_cpu(reinterpret_cast<const int64_t *>(data));
+    case DataType::INT32:
+      return tensor->copy_from_cpu(reinterpret_cast<const int32_t *>(data));
+    case DataType::UINT8:
+      return tensor->copy_from_cpu(reinterpret_cast<const uint8_t *>(data));
+  }
+  PADDLE_THROW(paddle::platform::errors::Unimplemented(
+      "Unsupported data type %d.", static_cast<int>(dtype)));
+}
+
+const char *CpuData(ZeroCopyTensor *tensor, DataType dtype) {
+  PlaceType place;
+  int size;
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return reinterpret_cast<const char *>(tensor->data<float>(&place, &size));
+    case DataType::INT64:
+      return reinterpret_cast<const char *>(
+          tensor->data<int64_t>(&place, &size));
+    case DataType::INT32:
+      return reinterpret_cast<const char *>(
+          tensor->data<int32_t>(&place, &size));
+    case DataType::UINT8:
+      return reinterpret_cast<const char *>(
+          tensor->data<uint8_t>(&place, &size));
+  }
+  PADDLE_THROW(paddle::platform::errors::Unimplemented(
+      "Unsupported data type %d.", static_cast<int>(dtype)));
+}
+
+void CopyToCpu(ZeroCopyTensor *tensor, DataType dtype, char *data) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return tensor->copy_to_cpu(reinterpret_cast<float *>(data));
+    case DataType::INT64:
+      return tensor->copy_to_cpu(reinterpret_cast<int64_t *>(data));
+    case DataType::INT32:
+      return tensor->copy_to_cpu(reinterpret_cast<int32_t *>(data));
+    case DataType::UINT8:
+      return tensor->copy_to_cpu(reinterpret_cast<uint8_t *>(data));
+  }
+  PADDLE_THROW(paddle::platform::errors::Unimplemented(
+      "Unsupported data type %d.", static_cast<int>(dtype)));
+}
+
+}  // namespace
+
+class BatchingPredictor::Impl {
+ public:
+  Impl(const Config &config, const BatchingConfig &batching);
+  ~Impl();
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *outputs);
+
+  BatchingStats GetStats() const;
+  void ResetStats();
+
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+
+ private:
+  // A predictor with the handles of its inputs and outputs, run by one thread
+  struct Worker {
+    std::unique_ptr<paddle::PaddlePredictor> predictor;
+    std::vector<std::unique_ptr<ZeroCopyTensor>> inputs;
+    std::vector<std::unique_ptr<ZeroCopyTensor>> outputs;
+    // Host copies of the inputs and outputs of GPU predictors
+    std::vector<char> staging;
+  };
+
+  void Work(Worker *worker);
+  void Gather(std::vector<BatchRequest *> *batch);
+  bool Compatible(const BatchRequest &a, const BatchRequest &b) const;
+  void RunBatch(Worker *worker, const std::vector<BatchRequest *> &batch);
+  void Feed(Worker *worker, const std::vector<BatchRequest *> &batch);
+  bool Fetch(Worker *worker, const std::vector<BatchRequest *> &batch);
+  void Record(const std::vector<BatchRequest *> &batch,
+              Clock::time_point start);
+
+  BatchingConfig batching_;
+  bool use_gpu_;
+  std::vector<Worker> workers_;
+  std::vector<std::thread> threads_;
+
+  std::deque<BatchRequest *> queue_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  bool stop_{false};
+  // Only one worker at a time waits for a batch to fill up, the others wait
+  // for it to leave with the batch.
+  std::mutex gather_mutex_;
+  // Cleared once the outputs turn out to have no batch dimension
+  std::atomic<bool> splittable_{true};
+
+  mutable std::mutex stats_mutex_;
+  Clock::time_point stats_since_;
+  uint64_t requests_{0};
+  uint64_t batches_{0};
+  uint64_t samples_{0};
+  double queue_us_{0};
+  std::vector<double> latencies_;
+  size_t next_latency_{0};
+};
+
+BatchingPredictor::Impl::Impl(const Config &config,
+                              const BatchingConfig &batching)
+    : batching_(batching), use_gpu_(config.use_gpu()) {
+  PADDLE_ENFORCE_GE(batching.max_batch_size, 1UL,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max batch size should be at least 1, but it's "
+                        "(%d).",
+                        batching.max_batch_size));
+  PADDLE_ENFORCE_GE(batching.max_queue_delay_us, 0,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max queue delay should not be negative, but "
+                        "it's (%d).",
+                        batching.max_queue_delay_us));
+  PADDLE_ENFORCE_GE(batching.num_predictors, 1UL,
+                    paddle::platform::errors::InvalidArgument(
+                        "The number of predictors should be at least 1, but "
+                        "it's (%d).",
+                        batching.num_predictors));
+  Config copy_config(config);
+  copy_config.SwitchUseFeedFetchOps(false);
+  workers_.resize(batching.num_predictors);
+  workers_[0].predictor = paddle::CreatePaddlePredictor<
+      Config, paddle::PaddleEngineKind::kAnalysis>(copy_config);
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    if (config.tensorrt_engine_enabled()) {
+      workers_[i].predictor = paddle::CreatePaddlePredictor<
+          Config, paddle::PaddleEngineKind::kAnalysis>(copy_config);
+    } else {
+      workers_[i].predictor = workers_[0].predictor->Clone();
+    }
+  }
+  input_names_ = workers_[0].predictor->GetInputNames();
+  output_names_ = workers_[0].predictor->GetOutputNames();
+  for (auto &worker : workers_) {
+    for (auto &name : input_names_) {
+      worker.inputs.push_back(worker.predictor->GetInputTensor(name));
+    }
+    for (auto &name : output_names_) {
+      worker.outputs.push_back(worker.predictor->GetOutputTensor(name));
+    }
+  }
+  ResetStats();
+  for (auto &worker : workers_) {
+    threads_.emplace_back(&Impl::Work, this, &worker);
+  }
+}
+
+BatchingPredictor::Impl::~Impl() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &thread : threads_) thread.join();
+}
+
+bool BatchingPredictor::Impl::Run(const std::vector<PaddleTensor> &inputs,
+                                  std::vector<PaddleTensor> *outputs) {
+  PADDLE_ENFORCE_EQ(inputs.size(), input_names_.size(),
+                    paddle::platform::errors::InvalidArgument(
+                        "The model has %d inputs, but the request has %d.",
+                        input_names_.size(), inputs.size()));
+  BatchRequest request;
+  request.inputs.assign(inputs.size(), nullptr);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    size_t idx = i;
+    if (!inputs[i].name.empty()) {
+      idx = std::find(input_names_.begin(), input_names_.end(),
+                      inputs[i].name) -
+            input_names_.begin();
+      PADDLE_ENFORCE_LT(idx, input_names_.size(),
+                        paddle::platform::errors::NotFound(
+                            "The model has no input called %s.",
+                            inputs[i].name));
+    }
+    PADDLE_ENFORCE_EQ(request.inputs[idx] == nullptr, true,
+                      paddle::platform::errors::InvalidArgument(
+                          "The input %s is given twice.", input_names_[idx]));
+    const auto &input = inputs[i];
+    PADDLE_ENFORCE_GT(input.shape.size(), 0UL,
+                      paddle::platform::errors::InvalidArgument(
+                          "The input %s should have a batch dimension.",
+                          input_names_[idx]));
+    PADDLE_ENFORCE_GE(
+        input.data.length(),
+        NumElements(input.shape, 0) * GetNumBytesOfDataType(input.dtype),
+        paddle::platform::errors::InvalidArgument(
+            "The data of the input %s is smaller than its shape.",
+            input_names_[idx]));
+    if (!input.lod.empty()) {
+      PADDLE_ENFORCE_EQ(input.lod.back().back(),
+                        static_cast<size_t>(input.shape[0]),
+                        paddle::platform::errors::InvalidArgument(
+                            "The LoD of the input %s should end at its %d "
+                            "rows.",
+                            input_names_[idx], input.shape[0]));
+    }
+    request.inputs[idx] = &input;
+  }
+  request.samples = NumSamples(*request.inputs[0]);
+  request.batchable = request.samples <= batching_.max_batch_size;
+  for (auto *input : request.inputs) {
+    request.batchable &= NumSamples(*input) == request.samples;
+  }
+  request.outputs = outputs;
+  request.arrival = Clock::now();
+  auto done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_.push_back(&request);
+  }
+  queue_cv_.notify_one();
+  return done.get();
+}
+
+void BatchingPredictor::Impl::Work(Worker *worker) {
+  std::vector<BatchRequest *> batch;
+  while (true) {
+    batch.clear();
+    {
+      std::lock_guard<std::mutex> lock(gather_mutex_);
+      Gather(&batch);
+    }
+    // Gather leaves the batch empty only when stopping with no requests left
+    if (batch.empty()) return;
+    RunBatch(worker, batch);
+  }
+}
+
+void BatchingPredictor::Impl::Gather(std::vector<BatchRequest *> *batch) {
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+  if (queue_.empty()) return;
+  auto *first = queue_.front();
+  queue_.pop_front();
+  batch->push_back(first);
+  if (!first->batchable || !splittable_) return;
+
+  size_t samples = first->samples;
+  const auto deadline =
+      first->arrival + std::chrono::microseconds(batching_.max_queue_delay_us);
+  // The requests that don't fit stay in the queue, in order, for the batches
+  // after this one.
+  size_t skipped = 0;
+  while (samples < batching_.max_batch_size) {
+    if (skipped == queue_.size()) {
+      if (stop_ || Clock::now() >= deadline) break;
+      queue_cv_.wait_until(lock, deadline);
+      continue;
+    }
+    auto next = queue_.begin() + skipped;
+    if ((*next)->batchable &&
+        samples + (*next)->samples <= batching_.max_batch_size &&
+        Compatible(*first, **next)) {
+      samples += (*next)->samples;
+      batch->push_back(*next);
+      queue_.erase(next);
+    } else {
+      ++skipped;
+    }
+  }
+}
+
+bool BatchingPredictor::Impl::Compatible(const BatchRequest &a,
+                                         const BatchRequest &b) const {
+  for (size_t i = 0; i < a.inputs.size(); ++i) {
+    const auto &x = *a.inputs[i];
+    const auto &y = *b.inputs[i];
+    if (x.dtype != y.dtype || x.lod.size() != y.lod.size() ||
+        x.shape.size() != y.shape.size() ||
+        !std::equal(x.shape.begin() + 1, x.shape.end(), y.shape.begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BatchingPredictor::Impl::RunBatch(
+    Worker *worker, const std::vector<BatchRequest *> &batch) {
+  const auto start = Clock::now();
+  bool success = false;
+  try {
+    Feed(worker, batch);
+    success = worker->predictor->ZeroCopyRun();
+    if (success && !Fetch(worker, batch)) {
+      if (splittable_.exchange(false)) {
+        LOG(WARNING) << "The outputs of the model can't be split by request, "
+                        "so BatchingPredictor runs each request alone.";
+      }
+      for (auto *request : batch) RunBatch(worker, {request});
+      return;
+    }
+  } catch (...) {
+    for (auto *request : batch) {
+      request->done.set_exception(std::current_exception());
+    }
+    return;
+  }
+  // The requests are gone once their callers are woken up
+  Record(batch, start);
+  for (auto *request : batch) request->done.set_value(success);
+}
+
+void BatchingPredictor::Impl::Feed(Worker *worker,
+                                   const std::vector<BatchRequest *> &batch) {
+  for (size_t i = 0; i < input_names_.size(); ++i) {
+    const auto &first = *batch[0]->inputs[i];
+    const size_t element_size = GetNumBytesOfDataType(first.dtype);
+    std::vector<int> shape(first.shape);
+    std::vector<std::vector<size_t>> lod;
+    size_t bytes = 0;
+    shape[0] = 0;
+    for (auto *request : batch) {
+      const auto &input = *request->inputs[i];
+      shape[0] += input.shape[0];
+      bytes += NumElements(input.shape, 0) * element_size;
+      if (!input.lod.empty()) {
+        paddle::inference::AppendBatchLoD(input.lod, &lod);
+      }
+    }
+
+    auto *tensor = worker->inputs[i].get();
+    tensor->Reshape(shape);
+    tensor->SetLoD(lod);
+    // CPU predictors take the requests in place, GPU ones through the host
+    char *data;
+    if (use_gpu_) {
+      worker->staging.resize(bytes);
+      data = worker->staging.data();
+    } else {
+      data = MutableData(tensor, first.dtype);
+    }
+    for (auto *request : batch) {
+      const auto &input = *request->inputs[i];
+      const size_t size = NumElements(input.shape, 0) * element_size;
+      std::memcpy(data, input.data.data(), size);
+      data += size;
+    }
+    if (use_gpu_) CopyFromCpu(tensor, first.dtype, worker->staging.data());
+  }
+}
+
+bool BatchingPredictor::Impl::Fetch(Worker *worker,
+                                    const std::vector<BatchRequest *> &batch) {
+  size_t samples = 0;
+  for (auto *request : batch) samples += request->samples;
+  for (auto *request : batch) request->outputs->resize(output_names_.size());
+
+  for (size_t i = 0; i < output_names_.size(); ++i) {
+    auto *tensor = worker->outputs[i].get();
+    const auto shape = tensor->shape();
+    const auto lod = tensor->lod();
+    const auto dtype = tensor->type();
+    const size_t element_size = GetNumBytesOfDataType(dtype);
+    const bool by_lod = !lod.empty() && lod[0].size() == samples + 1;
+    const bool by_rows =
+        !shape.empty() && static_cast<size_t>(shape[0]) == samples;
+    if (batch.size() > 1 && !by_lod && !by_rows) return false;
+
+    const char *data;
+    if (use_gpu_) {
+      worker->staging.resize(NumElements(shape, 0) * element_size);
+      CopyToCpu(tensor, dtype, worker->staging.data());
+      data = worker->staging.data();
+    } else {
+      data = CpuData(tensor, dtype);
+    }
+
+    const size_t row_size = NumElements(shape, 1) * element_size;
+    size_t sample = 0;
+    for (auto *request : batch) {
+      auto &output = (*request->outputs)[i];
+      output.name = output_names_[i];
+      output.dtype = dtype;
+      output.shape = shape;
+      std::pair<size_t, size_t> rows;
+      if (batch.size() == 1) {
+        output.lod = lod;
+        rows = std::make_pair(0, shape.empty() ? 1 : shape[0]);
+      } else if (by_lod) {
+        rows = paddle::inference::SliceBatchLoD(
+            lod, sample, sample + request->samples, &output.lod);
+        output.shape[0] = rows.second - rows.first;
+      } else {
+        output.lod.clear();
+        rows = std::make_pair(sample, sample + request->samples);
+        output.shape[0] = request->samples;
+      }
+      const size_t size = (rows.second - rows.first) * row_size;
+      output.data.Resize(size);
+      if (size > 0) {
+        std::memcpy(output.data.data(), data + rows.first * row_size, size);
+      }
+      sample += request->samples;
+    }
+  }
+  return true;
+}
+
+void BatchingPredictor::Impl::Record(const std::vector<BatchRequest *> &batch,
+                                     Clock::time_point start) {
+  const auto end = Clock::now();
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  ++batches_;
+  for (auto *request : batch) {
+    ++requests_;
+    samples_ += request->samples;
+    queue_us_ += std::chrono::duration<double, std::micro>(
+                     start - request->arrival)
+                     .count();
+    const double latency =
+        std::chrono::duration<double, std::micro>(end - request->arrival)
+            .count();
+    if (latencies_.size() < kLatencyWindow) {
+      latencies_.push_back(latency);
+    } else {
+      latencies_[next_latency_] = latency;
+      next_latency_ = (next_latency_ + 1) % kLatencyWindow;
+    }
+  }
+}
+
+BatchingStats BatchingPredictor::Impl::GetStats() const {
+  BatchingStats stats;
+  std::vector<double> latencies;
+  double seconds;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats.requests = requests_;
+    stats.batches = batches_;
+    stats.samples = samples_;
+    if (requests_ > 0) stats.mean_queue_us = queue_us_ / requests_;
+    latencies = latencies_;
+    seconds =
+        std::chrono::duration<double>(Clock::now() - stats_since_).count();
+  }
+  if (stats.batches > 0) {
+    stats.mean_batch_size = static_cast<double>(stats.samples) / stats.batches;
+  }
+  if (seconds > 0) stats.throughput = stats.requests / seconds;
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    const size_t last = latencies.size() - 1;
+    stats.p50_latency_us = latencies[last / 2];
+    stats.p99_latency_us = latencies[last * 99 / 100];
+    stats.max_latency_us = latencies[last];
+  }
+  return stats;
+}
+
+void BatchingPredictor::Impl::ResetStats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_since_ = Clock::now();
+  requests_ = batches_ = samples_ = 0;
+  queue_us_ = 0;
+  latencies_.clear();
+  next_latency_ = 0;
+}
+
+BatchingPredictor::BatchingPredictor(const Config &config,
+                                     const BatchingConfig &batching)
+    : impl_(new Impl(config, batching)) {}
+
+BatchingPredictor::~BatchingPredictor() {}
+
+std::vector<std::string> BatchingPredictor::GetInputNames() {
+  return impl_->input_names_;
+}
+
+std::vector<std::string> BatchingPredictor::GetOutputNames() {
+  return impl_->output_names_;
+}
+
+bool BatchingPredictor::Run(const std::vector<PaddleTensor> &inputs,
+                            std::vector<PaddleTensor> *outputs) {
+  return impl_->Run(inputs, outputs);
+}
+
+BatchingStats BatchingPredictor::GetStats() const { return impl_->GetStats(); }
+
+void BatchingPredictor::ResetStats() { impl_->ResetStats(); }
+
+}  // namespace services
+}  // namespace paddle_infer
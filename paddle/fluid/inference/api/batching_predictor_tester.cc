@@ -0,0 +1,163 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <thread>  // NOLINT
+#include "paddle/fluid/inference/api/helper.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "dirname to tests.");
+DEFINE_int32(batching_max_batch_size, 16, "Max batch size of the load test.");
+DEFINE_int32(batching_queue_delay_us, 1000,
+             "Max queue delay of the load test, in microseconds.");
+DEFINE_int32(batching_predictors, 1, "Predictors of the load test.");
+DEFINE_int32(batching_requests, 200,
+             "Requests of each client of the load test.");
+
+namespace paddle_infer {
+namespace services {
+
+using paddle::PaddleTensor;
+
+// Requests of the word2vec model, with `samples` rows of the four words
+struct Word2VecRequest {
+  Word2VecRequest(int samples, std::mt19937 *engine)
+      : words(4, std::vector<int64_t>(samples)), inputs(4) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      for (auto &word : words[i]) word = (*engine)() % 2000;
+      inputs[i].shape = {samples, 1};
+      inputs[i].dtype = paddle::PaddleDType::INT64;
+      inputs[i].data.Reset(words[i].data(), samples * sizeof(int64_t));
+    }
+  }
+
+  std::vector<std::vector<int64_t>> words;
+  std::vector<PaddleTensor> inputs;
+};
+
+Config Word2VecConfig() {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(1);
+  return config;
+}
+
+TEST(BatchingPredictor, lod) {
+  std::vector<std::vector<size_t>> lod;
+  paddle::inference::AppendBatchLoD({{0, 2}, {0, 1, 3}}, &lod);
+  paddle::inference::AppendBatchLoD({{0, 1, 2}, {0, 2, 3}}, &lod);
+  std::vector<std::vector<size_t>> merged{{0, 2, 3, 4}, {0, 1, 3, 5, 6}};
+  ASSERT_EQ(lod, merged);
+
+  std::vector<std::vector<size_t>> sliced;
+  auto rows = paddle::inference::SliceBatchLoD(lod, 1, 3, &sliced);
+  std::vector<std::vector<size_t>> second{{0, 1, 2}, {0, 2, 3}};
+  ASSERT_EQ(sliced, second);
+  ASSERT_EQ(rows.first, 3UL);
+  ASSERT_EQ(rows.second, 6UL);
+}
+
+void CompareOutputs(const PaddleTensor &a, const PaddleTensor &b) {
+  ASSERT_EQ(a.shape, b.shape);
+  ASSERT_EQ(a.dtype, paddle::PaddleDType::FLOAT32);
+  const size_t numel = std::accumulate(a.shape.begin(), a.shape.end(), 1,
+                                       std::multiplies<int>());
+  const float *x = static_cast<const float *>(a.data.data());
+  const float *y = static_cast<const float *>(b.data.data());
+  for (size_t i = 0; i < numel; ++i) {
+    EXPECT_NEAR(x[i], y[i], 1e-5);
+  }
+}
+
+TEST(BatchingPredictor, word2vec) {
+  auto config = Word2VecConfig();
+  auto predictor = paddle::CreatePaddlePredictor<Config>(config);
+  BatchingConfig batching;
+  batching.max_batch_size = 8;
+  batching.num_predictors = 2;
+  BatchingPredictor batching_predictor(config, batching);
+  ASSERT_EQ(batching_predictor.GetInputNames(), predictor->GetInputNames());
+
+  const int num_threads = 8;
+  const int num_requests = 20;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      // Each request should get what it gets when run alone
+      auto ref_predictor = predictor->Clone();
+      std::mt19937 engine(tid);
+      for (int i = 0; i < num_requests; ++i) {
+        Word2VecRequest request(engine() % 3 + 1, &engine);
+        std::vector<PaddleTensor> outputs, refs;
+        ASSERT_TRUE(batching_predictor.Run(request.inputs, &outputs));
+        ASSERT_TRUE(ref_predictor->Run(request.inputs, &refs));
+        ASSERT_EQ(outputs.size(), refs.size());
+        for (size_t j = 0; j < outputs.size(); ++j) {
+          CompareOutputs(outputs[j], refs[j]);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  auto stats = batching_predictor.GetStats();
+  LOG(INFO) << "requests: " << stats.requests << ", batches: " << stats.batches
+            << ", mean batch size: " << stats.mean_batch_size;
+  ASSERT_EQ(stats.requests, static_cast<uint64_t>(num_threads * num_requests));
+  ASSERT_LE(stats.batches, stats.requests);
+}
+
+// Throughput against latency of closed-loop clients, with batching and
+// without. Run with the flags of the model and options to look at others.
+TEST(BatchingPredictor, load) {
+  auto config = Word2VecConfig();
+  for (int max_batch_size : {1, FLAGS_batching_max_batch_size}) {
+    BatchingConfig batching;
+    batching.max_batch_size = max_batch_size;
+    batching.max_queue_delay_us = FLAGS_batching_queue_delay_us;
+    batching.num_predictors = FLAGS_batching_predictors;
+    BatchingPredictor batching_predictor(config, batching);
+    for (int clients : {1, 2, 4, 8, 16, 32}) {
+      batching_predictor.ResetStats();
+      std::vector<std::thread> threads;
+      for (int tid = 0; tid < clients; ++tid) {
+        threads.emplace_back([&, tid] {
+          std::mt19937 engine(tid);
+          Word2VecRequest request(1, &engine);
+          std::vector<PaddleTensor> outputs;
+          for (int i = 0; i < FLAGS_batching_requests; ++i) {
+            ASSERT_TRUE(batching_predictor.Run(request.inputs, &outputs));
+          }
+        });
+      }
+      for (auto &thread : threads) thread.join();
+      auto stats = batching_predictor.GetStats();
+      LOG(INFO) << "max batch size: " << max_batch_size
+                << ", clients: " << clients
+                << ", throughput: " << stats.throughput
+                << " requests/s, mean batch size: " << stats.mean_batch_size
+                << ", latency p50: " << stats.p50_latency_us
+                << "us, p99: " << stats.p99_latency_us << "us";
+    }
+  }
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
@@ -145,6 +147,31 @@ void ZeroCopyTensor::copy_to_cpu(T *data) {
 #endif
   }
 }
+template <typename T>
+void ZeroCopyTensor::ShareExternalData(T *data,
+                                       const std::vector<int> &shape) {
+  PADDLE_ENFORCE_EQ(input_or_output_, true,
+                    platform::errors::PermissionDenied(
+                        "Can't share data with the output tensor %s, it is "
+                        "readonly.",
+                        name_));
+  PADDLE_ENFORCE_EQ(place_, PaddlePlace::kCPU,
+                    platform::errors::Unimplemented(
+                        "Only the CPU tensor can share external data."));
+  PADDLE_ENFORCE_NOT_NULL(data, platform::errors::InvalidArgument(
+                                    "The data shared with the tensor %s "
+                                    "should not be null.",
+                                    name_));
+  EAGER_GET_TENSOR;
+  tensor->Resize(framework::make_ddim(shape));
+  // The allocation does not own the memory, which is released by the caller
+  size_t size = tensor->numel() * sizeof(T);
+  tensor->ResetHolderWithType(
+      std::make_shared<memory::Allocation>(static_cast<void *>(data), size,
+                                           platform::CPUPlace()),
+      framework::DataTypeTrait<T>::DataType());
+}
+
 template PD_INFER_DECL void ZeroCopyTensor::copy_from_cpu<float>(
     const float *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_from_cpu<int64_t>(
@@ -158,6 +185,15 @@ template PD_INFER_DECL void ZeroCopyTensor::copy_to_cpu<int64_t>(int64_t *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_to_cpu<int32_t>(int32_t *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_to_cpu<uint8_t>(uint8_t *data);
 
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<float>(
+    float *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<int64_t>(
+    int64_t *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<int32_t>(
+    int32_t *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<uint8_t>(
+    uint8_t *data, const std::vector<int> &shape);
+
 template PD_INFER_DECL float *ZeroCopyTensor::data<float>(PaddlePlace *place,
                                                           int *size) const;
 template PD_INFER_DECL int64_t *ZeroCopyTensor::data<int64_t>(
@@ -35,6 +35,15 @@ template PD_INFER_DECL int64_t *ZeroCopyTensor::data<int64_t>(
 template float *ZeroCopyTensor::mutable_data(PaddlePlace place);
 template int64_t *ZeroCopyTensor::mutable_data(PaddlePlace place);
 
+template <typename T>
+void ZeroCopyTensor::ShareExternalData(T *data,
+                                       const std::vector<int> &shape) {}
+
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<float>(
+    float *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<int64_t>(
+    int64_t *data, const std::vector<int> &shape);
+
 void *ZeroCopyTensor::FindTensor() const { return nullptr; }
 
 std::vector<int> ZeroCopyTensor::shape() const { return {}; }
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "paddle/fluid/inference/api/helper.h"
+#include <algorithm>
+#include <cstring>
 
 namespace paddle {
 namespace inference {
@@ -40,5 +42,73 @@ std::string to_string<std::vector<std::vector<float>>>(
   return ss.str();
 }
 
+void AppendBatchLoD(const std::vector<std::vector<size_t>> &src,
+                    std::vector<std::vector<size_t>> *dst) {
+  if (dst->empty()) dst->assign(src.size(), std::vector<size_t>(1, 0));
+  PADDLE_ENFORCE_EQ(
+      src.size(), dst->size(),
+      platform::errors::InvalidArgument(
+          "The LoD levels of the requests in a batch should be equal, but "
+          "they are %d and %d.",
+          src.size(), dst->size()));
+  for (size_t level = 0; level < src.size(); ++level) {
+    auto &merged = (*dst)[level];
+    const size_t base = merged.back();
+    for (size_t i = 1; i < src[level].size(); ++i) {
+      merged.push_back(base + src[level][i] - src[level][0]);
+    }
+  }
+}
+
+std::pair<size_t, size_t> SliceBatchLoD(
+    const std::vector<std::vector<size_t>> &lod, size_t begin, size_t end,
+    std::vector<std::vector<size_t>> *out) {
+  out->resize(lod.size());
+  for (size_t level = 0; level < lod.size(); ++level) {
+    PADDLE_ENFORCE_LT(end, lod[level].size(),
+                      platform::errors::OutOfRange(
+                          "The sequence %d is out of the %d sequences of the "
+                          "LoD level %d.",
+                          end, lod[level].size() - 1, level));
+    auto &sliced = (*out)[level];
+    sliced.clear();
+    for (size_t i = begin; i <= end; ++i) {
+      sliced.push_back(lod[level][i] - lod[level][begin]);
+    }
+    begin = lod[level][begin];
+    end = lod[level][end];
+  }
+  return std::make_pair(begin, end);
+}
+
+void ResizeAxis(const void *src, const std::vector<int64_t> &shape, int axis,
+                int64_t length, size_t element_size, void *dst) {
+  PADDLE_ENFORCE_LT(axis, static_cast<int>(shape.size()),
+                    platform::errors::OutOfRange(
+                        "The axis %d is out of the %d dimensions.", axis,
+                        shape.size()));
+  PADDLE_ENFORCE_EQ(src != dst || length <= shape[axis], true,
+                    platform::errors::InvalidArgument(
+                        "The axis can only be cut in place, but it is padded "
+                        "from %d to %d.",
+                        shape[axis], length));
+  size_t outer = 1;
+  for (int i = 0; i < axis; ++i) outer *= shape[i];
+  size_t inner = element_size;
+  for (size_t i = axis + 1; i < shape.size(); ++i) inner *= shape[i];
+  const size_t src_stride = shape[axis] * inner;
+  const size_t dst_stride = length * inner;
+  const size_t bytes = std::min(src_stride, dst_stride);
+  auto *from = static_cast<const char *>(src);
+  auto *to = static_cast<char *>(dst);
+  // Going forward, a cut in place only overwrites the rows already moved
+  for (size_t i = 0; i < outer; ++i) {
+    std::memmove(to + i * dst_stride, from + i * src_stride, bytes);
+    if (dst_stride > bytes) {
+      std::memset(to + i * dst_stride + bytes, 0, dst_stride - bytes);
+    }
+  }
+}
+
 }  // namespace inference
 }  // namespace paddle
@@ -26,6 +26,7 @@
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
@@ -366,6 +367,23 @@ static void PrintTime(int batch_size, int repeat, int num_threads, int tid,
             << ", data type: " << DataTypeToString(data_type) << " ======";
 }
 
+// Appends the LoD of a request to the LoD of the batch it joins. Each level
+// of src is shifted past the entries of the batch at the next level.
+void AppendBatchLoD(const std::vector<std::vector<size_t>> &src,
+                    std::vector<std::vector<size_t>> *dst);
+
+// Takes the top-level sequences [begin, end) out of the LoD of a batch, with
+// offsets starting from 0, and returns the range of rows they cover.
+std::pair<size_t, size_t> SliceBatchLoD(
+    const std::vector<std::vector<size_t>> &lod, size_t begin, size_t end,
+    std::vector<std::vector<size_t>> *out);
+
+// Copies the tensor src of the given shape into dst, with the size of the
+// axis changed to length: the axis is cut or padded with zeros. dst may be
+// src when the axis is cut.
+void ResizeAxis(const void *src, const std::vector<int64_t> &shape, int axis,
+                int64_t length, size_t element_size, void *dst);
+
 static bool IsFileExists(const std::string &path) {
   std::ifstream file(path);
   bool exists = file.is_open();
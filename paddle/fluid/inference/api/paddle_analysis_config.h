@@ -130,6 +130,35 @@ struct PD_INFER_DECL AnalysisConfig {
     opt_cache_dir_ = opt_cache_dir;
   }
   ///
+  /// \brief Cache the optimized program of the model and its parameters in
+  /// a directory, so that the later predictors of the same model and config
+  /// load them instead of running the analysis again. The entries are keyed
+  /// by the program, the parameter files, the config, the passes, the
+  /// version of Paddle and the instruction set of the CPU.
+  ///
+  /// \param cache_dir the path of the cache directory, shared by the models.
+  ///
+  void EnableOptimizedProgramCache(const std::string& cache_dir) {
+    optimized_program_cache_dir_ = cache_dir;
+  }
+  ///
+  /// \brief A boolean state telling whether the optimized program cache is
+  /// enabled.
+  ///
+  /// \return bool Whether the optimized program cache is enabled.
+  ///
+  bool optimized_program_cache_enabled() const {
+    return !optimized_program_cache_dir_.empty();
+  }
+  ///
+  /// \brief Get the path of the optimized program cache directory.
+  ///
+  /// \return const std::string& The path of the cache directory.
+  ///
+  const std::string& optimized_program_cache_dir() const {
+    return optimized_program_cache_dir_;
+  }
+  ///
   /// \brief Get the model directory path.
   ///
   /// \return const std::string& The model directory path.
@@ -380,6 +409,43 @@ struct PD_INFER_DECL AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Pad the variable-length inputs up to the smallest of the bucket
+  /// lengths, so that a predictor only ever runs a few input shapes. Each
+  /// bucket keeps its own scope and executor, whose intermediate tensors and
+  /// kernel caches stay warm for the shapes of the bucket.
+  ///
+  /// The inputs of the run length along seq_axis are padded with zeros, and
+  /// the outputs of the bucket length along seq_axis are cut back to the run
+  /// length. This keeps the results of the models which mask the padding by
+  /// one of their inputs, such as the input_mask of ERNIE. Runs with LoD
+  /// inputs or longer than all the buckets are not padded. Only supported on
+  /// CPU.
+  ///
+  /// \param lengths The bucket lengths.
+  /// \param seq_axis The axis of the variable length in the inputs and the
+  /// outputs.
+  ///
+  void EnableShapeBucketing(const std::vector<int>& lengths, int seq_axis = 1);
+  ///
+  /// \brief A boolean state telling whether the shape bucketing is enabled.
+  ///
+  /// \return bool Whether the shape bucketing is enabled.
+  ///
+  bool shape_bucketing_enabled() const { return !shape_buckets_.empty(); }
+  ///
+  /// \brief The bucket lengths of the shape bucketing, in ascending order.
+  ///
+  /// \return const std::vector<int>& The bucket lengths.
+  ///
+  const std::vector<int>& shape_buckets() const { return shape_buckets_; }
+  ///
+  /// \brief The axis padded by the shape bucketing.
+  ///
+  /// \return int The axis of the variable length.
+  ///
+  int shape_bucket_seq_axis() const { return shape_bucket_seq_axis_; }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -467,6 +533,24 @@ struct PD_INFER_DECL AnalysisConfig {
   /// \return bool Whether the memory optimization is activated.
   ///
   bool enable_memory_optim() const;
+  ///
+  /// \brief Load the combined parameters file through a memory mapping, so
+  /// that CPU parameters share the page cache instead of being read into
+  /// newly allocated memory. Only works with a combined parameters file.
+  /// The parameters saved by save_combine with align_data, like those of the
+  /// optimized program cache, are always used in place. The parameters of
+  /// the other files are copied if their data is not aligned in the file.
+  ///
+  /// \param x Whether to load the parameters with memory mapping.
+  ///
+  void EnableMemoryMapParams(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the parameters are loaded with
+  /// memory mapping.
+  ///
+  /// \return bool Whether the parameters are loaded with memory mapping.
+  ///
+  bool memory_map_params_enabled() const { return memory_map_params_; }
 
   ///
   /// \brief Turn on profiling report.
@@ -573,6 +657,7 @@ struct PD_INFER_DECL AnalysisConfig {
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
 
   bool model_from_memory_{false};
+  bool memory_map_params_{false};
 
   bool enable_ir_optim_{true};
   bool use_feed_fetch_ops_{true};
@@ -601,6 +686,10 @@ struct PD_INFER_DECL AnalysisConfig {
   bool use_xpu_{false};
   int xpu_l3_workspace_size_;
 
+  // shape bucketing related.
+  std::vector<int> shape_buckets_;
+  int shape_bucket_seq_axis_{1};
+
   // mkldnn related.
   int mkldnn_cache_capacity_{0};
   bool use_mkldnn_quantizer_{false};
@@ -613,6 +702,7 @@ struct PD_INFER_DECL AnalysisConfig {
   // So we release the memory when the predictor is set up.
   mutable bool is_valid_{true};
   std::string opt_cache_dir_;
+  std::string optimized_program_cache_dir_;
 };
 
 }  // namespace paddle
@@ -206,6 +206,15 @@ class PD_INFER_DECL ZeroCopyTensor {
   template <typename T>
   void copy_to_cpu(T* data);
 
+  /// \brief Use the host memory as the tensor data, without copying.
+  /// It's usually used to bind a caller-owned input buffer once and reuse it
+  /// for many runs. The buffer must hold the elements of the shape and
+  /// outlive the runs reading it. Only supported on CPU.
+  /// \param data The caller-owned buffer.
+  /// \param shape The shape of the data.
+  template <typename T>
+  void ShareExternalData(T* data, const std::vector<int>& shape);
+
   /// \brief Return the shape of the Tensor.
   std::vector<int> shape() const;
 
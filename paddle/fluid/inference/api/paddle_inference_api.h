@@ -21,7 +21,10 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -71,6 +74,25 @@ class PD_INFER_DECL Tensor {
   std::unique_ptr<paddle::ZeroCopyTensor> tensor_;
 };
 
+namespace services {
+class PredictorPool;
+}  // namespace services
+
+///
+/// \brief The runs of a length bucket of the shape bucketing, see
+/// Config::EnableShapeBucketing.
+///
+struct PD_INFER_DECL ShapeBucketStats {
+  /// The bucket length, or -1 for the runs which fit in no bucket.
+  int length{-1};
+  /// The runs padded up to the bucket.
+  uint64_t runs{0};
+  /// The runs on input shapes new to the bucket, which paid for the shape
+  /// inference, allocations and kernel creation of a cold run. Not counted
+  /// for the runs which fit in no bucket.
+  uint64_t cold_runs{0};
+};
+
 class PD_INFER_DECL Predictor {
  public:
   Predictor() = default;
@@ -91,9 +113,11 @@ class PD_INFER_DECL Predictor {
 
   std::unique_ptr<Predictor> Clone();
   void ClearIntermediateTensor();
+  std::vector<ShapeBucketStats> GetShapeBucketStats();
 
  private:
   std::unique_ptr<paddle::PaddlePredictor> predictor_;
+  friend class services::PredictorPool;
 };
 
 PD_INFER_DECL std::shared_ptr<Predictor> CreatePredictor(
@@ -128,6 +152,59 @@ T* Tensor::data(PlaceType* place, int* size) const {
 namespace paddle_infer {
 namespace services {
 
+///
+/// \brief Options of PredictorPool.
+///
+struct PD_INFER_DECL PredictorPoolConfig {
+  /// Number of predictors, the first one and its clones.
+  size_t size{1};
+  /// Whether the thread that checks out a predictor runs on cores of its own
+  /// until it returns it, and then on the cores it ran on before. Predictor
+  /// i gets cpu_math_library_num_threads cores from core
+  /// i * cpu_math_library_num_threads on, wrapping around. The OpenMP
+  /// workers of the thread are pinned with it, but the threads of an MKL
+  /// built without OpenMP are not. Linux only.
+  bool pin_cpu_cores{false};
+  /// Whether the predictors are spread over the NUMA nodes of the cores the
+  /// pool starts on, predictor i on node i % nodes. The first predictor of
+  /// each node loads a copy of the parameters, moved to pages of their own
+  /// bound to the node, which the other predictors of the node share. The
+  /// thread that checks a predictor out runs on cores of its node and prefers
+  /// the node for the pages it touches first, until it returns the predictor
+  /// and gets its own memory policy back. The chunks the CPU allocator
+  /// reuses, like most of the intermediate tensors, stay on the node that
+  /// first touched them. Implies pin_cpu_cores, with the cores taken within
+  /// the node. It needs a CPU predictor on Linux and at least two nodes, and
+  /// otherwise the predictors share the parameters of the first one as usual.
+  bool numa_aware{false};
+  /// Bound of the memory of the intermediate tensors of each predictor, in
+  /// bytes. A predictor returned with more than that frees them. 0 means no
+  /// bound.
+  size_t max_intermediate_bytes{0};
+  /// Run on every predictor at startup, pinned if pin_cpu_cores is set, so
+  /// that the first requests find the memory and the kernel caches of these
+  /// runs ready. It should run the predictor on representative shapes.
+  std::function<void(Predictor*)> warmup;
+};
+
+///
+/// \brief Where a predictor of PredictorPool runs.
+///
+struct PD_INFER_DECL PredictorPlacement {
+  /// The NUMA node of the predictor, or -1 if the pool is not NUMA aware.
+  int numa_node{-1};
+  /// The cores the predictor runs on, or none if it is not pinned.
+  std::vector<int> cores;
+  /// Bytes of the parameters of the predictor bound to its NUMA node.
+  size_t numa_param_bytes{0};
+};
+
+///
+/// \brief A pool of predictors that share the parameters of the first.
+///
+/// Threads serving requests take a free predictor with Checkout() and give it
+/// back with Return(). Both are lock-free.
+///
 class PD_INFER_DECL PredictorPool {
  public:
   PredictorPool() = delete;
@@ -135,11 +212,119 @@ class PD_INFER_DECL PredictorPool {
   PredictorPool& operator=(const PredictorPool&) = delete;
 
   explicit PredictorPool(const Config& config, size_t size = 1);
+  PredictorPool(const Config& config, const PredictorPoolConfig& pool);
   Predictor* Retrive(size_t idx);
 
+  /// \brief Takes a free predictor, or returns nullptr if all are taken.
+  Predictor* TryCheckout();
+  /// \brief Takes a free predictor, yielding until one is returned.
+  Predictor* Checkout();
+  /// \brief Gives back a predictor taken by the calling thread, once.
+  void Return(Predictor* pred);
+
+  size_t size() const { return preds_.size() + 1; }
+
+  /// \brief The placement of each predictor, by index.
+  std::vector<PredictorPlacement> GetPlacements() const;
+
  private:
+  void Pin(size_t idx);
+  void Unpin();
+
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
+
+  PredictorPoolConfig pool_;
+  std::map<const Predictor*, size_t> index_;
+  // A stack of the free predictors. The top is in the low 32 bits of head_
+  // and the entry below predictor i in next_[i], both as index + 1 with 0 for
+  // none. The high 32 bits of head_ count the changes, against ABA.
+  std::atomic<uint64_t> head_{0};
+  std::unique_ptr<std::atomic<uint32_t>[]> next_;
+  // Whether each predictor is checked out, against returning it twice
+  std::unique_ptr<std::atomic<bool>[]> checked_out_;
+  std::vector<std::vector<int>> cores_;
+  std::vector<int> all_cores_;
+  // The NUMA node of each predictor, and the bytes of parameters bound to
+  // each node
+  std::vector<int> nodes_;
+  std::map<int, size_t> node_param_bytes_;
+};
+
+///
+/// \brief Options of BatchingPredictor.
+///
+struct PD_INFER_DECL BatchingConfig {
+  /// Most samples a merged batch holds. A sample is a row of the inputs, or a
+  /// top-level sequence for inputs with LoD.
+  size_t max_batch_size{16};
+  /// How long, in microseconds, the first request of a batch waits for others
+  /// to join it.
+  int64_t max_queue_delay_us{1000};
+  /// Number of predictors, the first one and its clones. Each of them runs
+  /// the batches on its own thread.
+  size_t num_predictors{1};
+};
+
+///
+/// \brief Metrics of BatchingPredictor since it started or since the last
+/// ResetStats().
+///
+struct PD_INFER_DECL BatchingStats {
+  uint64_t requests{0};
+  uint64_t batches{0};
+  uint64_t samples{0};
+  /// Samples per batch.
+  double mean_batch_size{0};
+  /// Microseconds from Run() to the start of the batch, on average.
+  double mean_queue_us{0};
+  /// Microseconds from Run() to the return, over the latest requests.
+  double p50_latency_us{0};
+  double p99_latency_us{0};
+  double max_latency_us{0};
+  /// Requests per second.
+  double throughput{0};
+};
+
+///
+/// \brief Serves single requests by batching them.
+///
+/// Run() may be called from many threads, each with one request of a few
+/// samples. The requests that arrive while a predictor is busy, or within
+/// max_queue_delay_us of each other, are concatenated along the batch
+/// dimension, with the LoD of sequence inputs merged, and run together with
+/// ZeroCopyRun(). Each request then gets its own slice of the outputs.
+///
+/// Outputs are split by the LoD of their top level or by their first
+/// dimension, whichever has one entry per sample. Models with other outputs
+/// run each request alone.
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  BatchingPredictor() = delete;
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  BatchingPredictor(const Config& config, const BatchingConfig& batching);
+  ~BatchingPredictor();
+
+  std::vector<std::string> GetInputNames();
+  std::vector<std::string> GetOutputNames();
+
+  /// \brief Runs one request and waits for its outputs.
+  /// \param[in] inputs The inputs, matched by name or else by position.
+  /// \param[out] outputs The outputs of the request, in the order of
+  /// GetOutputNames(). Their buffers are reused when large enough.
+  /// \return Whether the run succeeded.
+  bool Run(const std::vector<paddle::PaddleTensor>& inputs,
+           std::vector<paddle::PaddleTensor>* outputs);
+
+  BatchingStats GetStats() const;
+  void ResetStats();
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
 };
 }  // namespace services
 }  // namespace paddle_infer
@@ -105,6 +105,8 @@ GpuPassStrategy::GpuPassStrategy() : PassStrategy({}) {
     //   "identity_scale_op_clean_pass",             //
     "is_test_pass",                                  //
         "simplify_with_basic_ops_pass",              //
+        "common_subexpression_elimination_pass",     //
+        "dead_code_elimination_pass",                //
         "conv_affine_channel_fuse_pass",             //
         "conv_eltwiseadd_affine_channel_fuse_pass",  //
         "conv_bn_fuse_pass",                         //
@@ -150,9 +152,12 @@ void GpuPassStrategy::EnableMkldnnBfloat16() {
 CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
   // NOTE the large fusions should be located in the front, so that they will
   // not be damaged by smaller ones.
-  passes_.assign({"simplify_with_basic_ops_pass",   //
-                  "attention_lstm_fuse_pass",       //
-                  "seqconv_eltadd_relu_fuse_pass",  //
+  passes_.assign({"simplify_with_basic_ops_pass",           //
+                  "common_subexpression_elimination_pass",  //
+                  "constant_folding_pass",                  //
+                  "dead_code_elimination_pass",             //
+                  "attention_lstm_fuse_pass",               //
+                  "seqconv_eltadd_relu_fuse_pass",          //
                   // "seqpool_concat_fuse_pass",    //
                   "seqpool_cvm_concat_fuse_pass",  //
                   // "embedding_fc_lstm_fuse_pass", //
@@ -168,6 +173,7 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "conv_eltwiseadd_bn_fuse_pass",            //
                   "conv_transpose_bn_fuse_pass",             //
                   "conv_transpose_eltwiseadd_bn_fuse_pass",  //
+                  "gemm_weight_pack_pass",                   //
                   "is_test_pass",                            //
                   // following pass should be located in the last, since
                   // it will work on all fused ops.
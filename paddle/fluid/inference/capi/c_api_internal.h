@@ -15,6 +15,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
 #include "paddle/fluid/inference/api/paddle_api.h"
 #include "paddle/fluid/inference/capi/paddle_c_api.h"
@@ -39,6 +40,13 @@ struct PD_Predictor {
   std::unique_ptr<paddle::PaddlePredictor> predictor;
 };
 
+struct PD_RunHandle {
+  PD_Predictor* predictor;
+  std::vector<std::unique_ptr<paddle::ZeroCopyTensor>> inputs;
+  std::vector<std::unique_ptr<paddle::ZeroCopyTensor>> outputs;
+  std::vector<std::vector<int>> output_shapes;
+};
+
 namespace paddle {
 paddle::PaddleDType ConvertToPaddleDType(PD_DataType dtype);
 
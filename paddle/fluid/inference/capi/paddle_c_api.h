@@ -291,6 +291,30 @@ PADDLE_CAPI_EXPORT extern void PD_GetZeroCopyOutput(PD_Predictor* predictor,
 
 PADDLE_CAPI_EXPORT extern void PD_ZeroCopyRun(PD_Predictor* predictor);
 
+// Prepared run, which binds the caller-owned input buffers once and reads the
+// outputs in place, so that the runs copy and allocate nothing in the C API.
+// The handle has to be deleted before its predictor.
+typedef struct PD_RunHandle PD_RunHandle;
+
+PADDLE_CAPI_EXPORT extern PD_RunHandle* PD_NewRunHandle(
+    PD_Predictor* predictor);
+
+PADDLE_CAPI_EXPORT extern void PD_DeleteRunHandle(PD_RunHandle* handle);
+
+// Uses the data as the n-th input, in the order of PD_GetInputName, until it
+// is bound again. The data must outlive the runs reading it.
+PADDLE_CAPI_EXPORT extern void PD_RunHandleBindInput(
+    PD_RunHandle* handle, int n, void* data, PD_DataType dtype,
+    const int* shape, int shape_size);
+
+PADDLE_CAPI_EXPORT extern bool PD_RunHandleRun(PD_RunHandle* handle);
+
+// Returns the data of the n-th output, in the order of PD_GetOutputName,
+// which is valid until the next run. The shape is owned by the handle.
+PADDLE_CAPI_EXPORT extern const void* PD_RunHandleGetOutput(
+    PD_RunHandle* handle, int n, PD_DataType* dtype, const int** shape,
+    int* shape_size);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
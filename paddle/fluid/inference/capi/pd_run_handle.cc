@@ -0,0 +1,125 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_api.h"
+#include "paddle/fluid/inference/capi/c_api_internal.h"
+#include "paddle/fluid/inference/capi/paddle_c_api.h"
+
+using paddle::ConvertToPDDataType;
+
+extern "C" {
+
+PD_RunHandle* PD_NewRunHandle(PD_Predictor* predictor) {
+  PADDLE_ENFORCE_NOT_NULL(predictor,
+                          paddle::platform::errors::InvalidArgument(
+                              "The predictor of the run handle is null."));
+  auto* paddle_predictor = predictor->predictor.get();
+  PD_RunHandle* handle = new PD_RunHandle;
+  handle->predictor = predictor;
+  // The tensors are looked up once, so that the runs only use the pointers
+  for (auto& name : paddle_predictor->GetInputNames()) {
+    handle->inputs.emplace_back(paddle_predictor->GetInputTensor(name));
+  }
+  for (auto& name : paddle_predictor->GetOutputNames()) {
+    handle->outputs.emplace_back(paddle_predictor->GetOutputTensor(name));
+  }
+  handle->output_shapes.resize(handle->outputs.size());
+  return handle;
+}
+
+void PD_DeleteRunHandle(PD_RunHandle* handle) {
+  if (handle) {
+    delete handle;
+    handle = nullptr;
+  }
+}
+
+void PD_RunHandleBindInput(PD_RunHandle* handle, int n, void* data,
+                           PD_DataType dtype, const int* shape,
+                           int shape_size) {
+  PADDLE_ENFORCE_NOT_NULL(handle, paddle::platform::errors::InvalidArgument(
+                                      "The run handle is null."));
+  PADDLE_ENFORCE_EQ(
+      n >= 0 && n < static_cast<int>(handle->inputs.size()), true,
+      paddle::platform::errors::OutOfRange(
+          "The predictor has %d inputs, but received the input %d.",
+          handle->inputs.size(), n));
+  auto& input = handle->inputs[n];
+  std::vector<int> dims(shape, shape + shape_size);
+  switch (dtype) {
+    case PD_FLOAT32:
+      input->ShareExternalData(static_cast<float*>(data), dims);
+      break;
+    case PD_INT32:
+      input->ShareExternalData(static_cast<int32_t*>(data), dims);
+      break;
+    case PD_INT64:
+      input->ShareExternalData(static_cast<int64_t*>(data), dims);
+      break;
+    case PD_UINT8:
+      input->ShareExternalData(static_cast<uint8_t*>(data), dims);
+      break;
+    default:
+      PADDLE_THROW(paddle::platform::errors::InvalidArgument(
+          "Unsupported data type of the input %s.", input->name()));
+  }
+}
+
+bool PD_RunHandleRun(PD_RunHandle* handle) {
+  PADDLE_ENFORCE_NOT_NULL(handle, paddle::platform::errors::InvalidArgument(
+                                      "The run handle is null."));
+  return handle->predictor->predictor->ZeroCopyRun();
+}
+
+const void* PD_RunHandleGetOutput(PD_RunHandle* handle, int n,
+                                  PD_DataType* dtype, const int** shape,
+                                  int* shape_size) {
+  PADDLE_ENFORCE_NOT_NULL(handle, paddle::platform::errors::InvalidArgument(
+                                      "The run handle is null."));
+  PADDLE_ENFORCE_EQ(
+      n >= 0 && n < static_cast<int>(handle->outputs.size()), true,
+      paddle::platform::errors::OutOfRange(
+          "The predictor has %d outputs, but received the output %d.",
+          handle->outputs.size(), n));
+  auto& output = handle->outputs[n];
+  *dtype = ConvertToPDDataType(output->type());
+  if (shape != nullptr && shape_size != nullptr) {
+    auto& output_shape = handle->output_shapes[n];
+    output_shape = output->shape();
+    *shape = output_shape.data();
+    *shape_size = static_cast<int>(output_shape.size());
+  }
+
+  paddle::PaddlePlace place;
+  int size = 0;
+  switch (*dtype) {
+    case PD_FLOAT32:
+      return output->data<float>(&place, &size);
+    case PD_INT32:
+      return output->data<int32_t>(&place, &size);
+    case PD_INT64:
+      return output->data<int64_t>(&place, &size);
+    case PD_UINT8:
+      return output->data<uint8_t>(&place, &size);
+    default:
+      PADDLE_THROW(paddle::platform::errors::InvalidArgument(
+          "Unsupported data type of the output %s.", output->name()));
+  }
+  return nullptr;
+}
+
+}  // extern "C"
@@ -70,7 +70,7 @@ void LoadPersistables(framework::Executor* executor, framework::Scope* scope,
                       const framework::ProgramDesc& main_program,
                       const std::string& dirname,
                       const std::string& param_filename,
-                      bool model_from_memory = false) {
+                      bool model_from_memory, bool use_mmap) {
   const framework::BlockDesc& global_block = main_program.Block(0);
 
   framework::ProgramDesc* load_program = new framework::ProgramDesc();
@@ -115,6 +115,7 @@ void LoadPersistables(framework::Executor* executor, framework::Scope* scope,
     op->SetOutput("Out", paramlist);
     op->SetAttr("file_path", {param_filename});
     op->SetAttr("model_from_memory", {model_from_memory});
+    op->SetAttr("use_mmap", use_mmap);
     op->CheckAttrs();
   }
 
@@ -145,7 +146,8 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
 
 std::unique_ptr<framework::ProgramDesc> Load(
     framework::Executor* executor, framework::Scope* scope,
-    const std::string& prog_filename, const std::string& param_filename) {
+    const std::string& prog_filename, const std::string& param_filename,
+    bool use_mmap) {
   std::string program_desc_str;
   ReadBinaryFile(prog_filename, &program_desc_str);
 
@@ -156,7 +158,7 @@ std::unique_ptr<framework::ProgramDesc> Load(
                  main_program->Version());
 
   LoadPersistables(executor, scope, *main_program, "", param_filename,
-                   false /* model_from_memory */);
+                   false /* model_from_memory */, use_mmap);
   return main_program;
 }
 
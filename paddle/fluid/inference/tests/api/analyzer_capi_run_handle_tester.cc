@@ -0,0 +1,157 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "paddle/fluid/inference/capi/paddle_c_api.h"
+#include "paddle/fluid/inference/tests/api/tester_helper.h"
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+const int kChannels = 3;
+const int kHeight = 224;
+const int kWidth = 224;
+
+PD_AnalysisConfig *NewConfig() {
+  std::string model_dir = FLAGS_infer_model;
+  PD_AnalysisConfig *config = PD_NewAnalysisConfig();
+  PD_SetModel(config, (model_dir + "/model").c_str(),
+              (model_dir + "/params").c_str());
+  PD_DisableGpu(config);
+  PD_SwitchUseFeedFetchOps(config, false);
+  PD_SwitchSpecifyInputNames(config, true);
+  return config;
+}
+
+std::vector<float> NewInput(int batch_size) {
+  std::vector<float> input(batch_size * kChannels * kHeight * kWidth);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<float>(i % 255) / 255.f;
+  }
+  return input;
+}
+
+// Sets the input by the zero copy API, which copies the data
+void SetCopiedInput(PD_Predictor *predictor, std::vector<float> *input,
+                    int *shape, PD_ZeroCopyTensor *tensor) {
+  PD_InitZeroCopyTensor(tensor);
+  tensor->name = const_cast<char *>(PD_GetInputName(predictor, 0));
+  tensor->data.data = static_cast<void *>(input->data());
+  tensor->data.length = input->size() * sizeof(float);
+  tensor->data.capacity = tensor->data.length;
+  tensor->shape.data = static_cast<void *>(shape);
+  tensor->shape.length = 4 * sizeof(int);
+  tensor->shape.capacity = tensor->shape.length;
+  tensor->dtype = PD_FLOAT32;
+  PD_SetZeroCopyInput(predictor, tensor);
+}
+
+TEST(PD_RunHandle, run_in_place) {
+  PD_AnalysisConfig *config = NewConfig();
+  PD_Predictor *predictor = PD_NewPredictor(config);
+  std::vector<float> input = NewInput(FLAGS_batch_size);
+  int shape[4] = {FLAGS_batch_size, kChannels, kHeight, kWidth};
+
+  PD_ZeroCopyTensor copied_input;
+  SetCopiedInput(predictor, &input, shape, &copied_input);
+  PD_ZeroCopyRun(predictor);
+  PD_ZeroCopyTensor ref;
+  PD_InitZeroCopyTensor(&ref);
+  ref.name = const_cast<char *>(PD_GetOutputName(predictor, 0));
+  PD_GetZeroCopyOutput(predictor, &ref);
+
+  PD_RunHandle *handle = PD_NewRunHandle(predictor);
+  PD_RunHandleBindInput(handle, 0, input.data(), PD_FLOAT32, shape, 4);
+  // The bound input and the outputs are reused by the runs
+  for (int i = 0; i < 2; ++i) {
+    CHECK(PD_RunHandleRun(handle));
+    PD_DataType dtype;
+    const int *out_shape = nullptr;
+    int out_shape_size = 0;
+    auto *out = static_cast<const float *>(PD_RunHandleGetOutput(
+        handle, 0, &dtype, &out_shape, &out_shape_size));
+    CHECK_EQ(dtype, PD_FLOAT32);
+    CHECK_EQ(out_shape_size * sizeof(int), ref.shape.length);
+    int numel = 1;
+    for (int j = 0; j < out_shape_size; ++j) {
+      CHECK_EQ(out_shape[j], static_cast<int *>(ref.shape.data)[j]);
+      numel *= out_shape[j];
+    }
+    CHECK_EQ(numel * sizeof(float), ref.data.length);
+    auto *ref_data = static_cast<float *>(ref.data.data);
+    for (int j = 0; j < numel; ++j) {
+      CHECK_LE(std::abs(out[j] - ref_data[j]), 1e-5);
+    }
+  }
+
+  PD_DeleteRunHandle(handle);
+  PD_DestroyZeroCopyTensor(&ref);
+  PD_DeletePredictor(predictor);
+  PD_DeleteAnalysisConfig(config);
+}
+
+TEST(PD_RunHandle, benchmark) {
+  PD_AnalysisConfig *config = NewConfig();
+  PD_Predictor *predictor = PD_NewPredictor(config);
+  std::vector<float> input = NewInput(FLAGS_batch_size);
+  int shape[4] = {FLAGS_batch_size, kChannels, kHeight, kWidth};
+  const int repeat = std::max(FLAGS_repeat, 1);
+  Timer timer;
+
+  // The zero copy API copies the input and the output of every run
+  PD_ZeroCopyTensor copied_input;
+  PD_ZeroCopyTensor output;
+  PD_InitZeroCopyTensor(&output);
+  output.name = const_cast<char *>(PD_GetOutputName(predictor, 0));
+  SetCopiedInput(predictor, &input, shape, &copied_input);
+  PD_ZeroCopyRun(predictor);
+  timer.tic();
+  for (int i = 0; i < repeat; ++i) {
+    PD_SetZeroCopyInput(predictor, &copied_input);
+    PD_ZeroCopyRun(predictor);
+    PD_GetZeroCopyOutput(predictor, &output);
+  }
+  double copied_latency = timer.toc() / repeat;
+  PD_DestroyZeroCopyTensor(&output);
+
+  // The run handle binds the input once and reads the output in place
+  PD_RunHandle *handle = PD_NewRunHandle(predictor);
+  PD_RunHandleBindInput(handle, 0, input.data(), PD_FLOAT32, shape, 4);
+  PD_DataType dtype;
+  timer.tic();
+  for (int i = 0; i < repeat; ++i) {
+    CHECK(PD_RunHandleRun(handle));
+    CHECK_NOTNULL(PD_RunHandleGetOutput(handle, 0, &dtype, nullptr, nullptr));
+  }
+  double in_place_latency = timer.toc() / repeat;
+
+  LOG(INFO) << "batch_size: " << FLAGS_batch_size << ", repeat: " << repeat
+            << ", latency of the zero copy run: " << copied_latency
+            << " ms, latency of the run handle: " << in_place_latency
+            << " ms";
+  PD_DeleteRunHandle(handle);
+  PD_DeletePredictor(predictor);
+  PD_DeleteAnalysisConfig(config);
+}
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
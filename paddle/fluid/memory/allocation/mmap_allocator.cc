@@ -51,6 +51,15 @@ MemoryMapReaderAllocation::~MemoryMapReaderAllocation() {
   VLOG(3) << "~MemoryMapReaderAllocation: " << this->ipc_name();
 }
 
+MemoryMapFileAllocation::~MemoryMapFileAllocation() {
+  if (this->size() == 0) return;
+  PADDLE_ENFORCE_NE(
+      munmap(this->ptr(), this->size()), -1,
+      platform::errors::Unavailable("could not unmap the memory mapped file %s",
+                                    this->file_name()));
+  VLOG(3) << "~MemoryMapFileAllocation: " << this->file_name();
+}
+
 std::string GetIPCName() {
   static std::random_device rd;
   std::string handle = "/paddle_";
@@ -101,6 +110,29 @@ std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
   return std::make_shared<MemoryMapReaderAllocation>(ptr, size, ipc_name);
 }
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd, -1, platform::errors::Unavailable(
+                                "File %s open failed", file_name.c_str()));
+
+  struct stat file_stat;
+  PADDLE_ENFORCE_EQ(fstat(fd, &file_stat), 0,
+                    platform::errors::Unavailable(
+                        "Get the status of file %s failed", file_name.c_str()));
+  size_t size = static_cast<size_t>(file_stat.st_size);
+
+  void *ptr = nullptr;
+  if (size > 0) {
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    PADDLE_ENFORCE_NE(ptr, MAP_FAILED,
+                      platform::errors::Unavailable(
+                          "Memory map failed when map file %s.", file_name));
+  }
+  close(fd);
+  return std::make_shared<MemoryMapFileAllocation>(ptr, size, file_name);
+}
+
 MemoryMapFdSet &MemoryMapFdSet::Instance() {  // NOLINT
   static MemoryMapFdSet set;
   return set;
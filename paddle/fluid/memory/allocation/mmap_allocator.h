@@ -58,9 +58,44 @@ class MemoryMapReaderAllocation : public Allocation {
   std::string ipc_name_;
 };
 
+// A private, copy-on-write mapping of a regular file. Reading is served
+// from the page cache shared by all processes mapping the same file, and
+// pages are only copied when they are written.
+class MemoryMapFileAllocation : public Allocation {
+ public:
+  explicit MemoryMapFileAllocation(void *ptr, size_t size,
+                                   std::string file_name)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        file_name_(std::move(file_name)) {}
+
+  inline const std::string &file_name() const { return file_name_; }
+
+  ~MemoryMapFileAllocation() override;
+
+ private:
+  std::string file_name_;
+};
+
+// A piece of a MemoryMapFileAllocation, which keeps the whole mapping alive
+// so that tensors can adopt their data from the mapped file directly.
+class MemoryMapFileSliceAllocation : public Allocation {
+ public:
+  MemoryMapFileSliceAllocation(std::shared_ptr<MemoryMapFileAllocation> file,
+                               size_t offset, size_t size)
+      : Allocation(static_cast<char *>(file->ptr()) + offset, size,
+                   platform::CPUPlace()),
+        file_(std::move(file)) {}
+
+ private:
+  std::shared_ptr<MemoryMapFileAllocation> file_;
+};
+
 std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
     size_t size);
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &file_name);
+
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
     const std::string &ipc_name, size_t size);
 
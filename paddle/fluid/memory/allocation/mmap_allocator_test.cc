@@ -18,6 +18,9 @@
 
 #include <sys/types.h>
 
+#include <cstdio>
+#include <fstream>
+
 #include "gtest/gtest.h"
 
 namespace paddle {
@@ -47,6 +50,35 @@ TEST(MemoryMapAllocation, test_allocation_base) {
   }
 }
 
+TEST(MemoryMapAllocation, test_file_allocation) {
+  std::string file_name = "mmap_allocator_test_file";
+  {
+    std::ofstream fout(file_name, std::ios::binary);
+    for (int32_t i = 0; i < 1024; ++i) {
+      fout.write(reinterpret_cast<const char*>(&i), sizeof(i));
+    }
+  }
+  {
+    auto file_holder = AllocateMemoryMapFileAllocation(file_name);
+    ASSERT_EQ(file_holder->size(), 4UL * 1024);
+    // the slice keeps the mapping alive after the file holder is released
+    auto slice_holder = std::make_shared<MemoryMapFileSliceAllocation>(
+        file_holder, 4UL * 512, 4UL * 512);
+    file_holder.reset();
+    auto* slice_ptr = static_cast<int32_t*>(slice_holder->ptr());
+    for (int32_t i = 0; i < 512; ++i) {
+      ASSERT_EQ(slice_ptr[i], i + 512);
+    }
+    // writes are private to the mapping
+    slice_ptr[0] = -1;
+  }
+  {
+    auto file_holder = AllocateMemoryMapFileAllocation(file_name);
+    ASSERT_EQ(static_cast<int32_t*>(file_holder->ptr())[512], 512);
+  }
+  std::remove(file_name.c_str());
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <string>
 #include <unordered_map>
 #include "paddle/fluid/framework/data_layout.h"
+#include "paddle/fluid/operators/math/norm_cpu.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -427,22 +428,13 @@ class BatchNormKernel<platform::CPUDeviceContext, T>
         bias_arr - mean_arr * inv_std * scale_arr;
 
     switch (data_layout) {
-      case DataLayout::kNCHW: {
-        EigenArrayMap<T> y_arr(y->mutable_data<T>(ctx.GetPlace()), sample_size,
-                               N * C);
-        ConstEigenArrayMap<T> x_arr(x->data<T>(), sample_size, N * C);
-        for (int nc = 0; nc < N * C; ++nc) {
-          y_arr.col(nc) = x_arr.col(nc) * new_scale(nc % C) + new_bias(nc % C);
-        }
-        break;
-      }
+      case DataLayout::kNCHW:
       case DataLayout::kNHWC: {
-        EigenArrayMap<T>(y->mutable_data<T>(ctx.GetPlace()), C,
-                         N * sample_size) =
-            (ConstEigenArrayMap<T>(x->data<T>(), C, N * sample_size).colwise() *
-             new_scale)
-                .colwise() +
-            new_bias;
+        math::BatchNormAffineCPU(x->data<T>(), new_scale.data(),
+                                 new_bias.data(),
+                                 y->mutable_data<T>(ctx.GetPlace()), N, C,
+                                 sample_size,
+                                 data_layout == DataLayout::kNHWC);
         break;
       }
       default:
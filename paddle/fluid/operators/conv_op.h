@@ -21,10 +21,13 @@ limitations under the License. */
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/conv_winograd_cpu.h"
 #include "paddle/fluid/operators/math/depthwise_conv.h"
 #include "paddle/fluid/operators/math/im2col.h"
 #include "paddle/fluid/operators/math/vol2col.h"
 
+DECLARE_bool(conv_winograd);
+
 namespace paddle {
 namespace operators {
 
@@ -138,6 +141,33 @@ inline bool IsExpand(const std::vector<int64_t>& filter_dim,
   return !(filter_1 && strides_1 && padding_0 && dilation_1);
 }
 
+// The shape of an NCHW conv2d for math::ConvDirectCPU, paddings as
+// UpdatePaddingAndDilation leaves them: {top, bottom, left, right}.
+inline math::ConvDirectShape GetConvDirectShape(
+    const framework::DDim& in_dims, const framework::DDim& filter_dims,
+    const framework::DDim& out_dims, int groups,
+    const std::vector<int>& strides, const std::vector<int>& paddings,
+    const std::vector<int>& dilations) {
+  math::ConvDirectShape shape;
+  shape.batch = in_dims[0];
+  shape.in_c = in_dims[1];
+  shape.in_h = in_dims[2];
+  shape.in_w = in_dims[3];
+  shape.out_c = out_dims[1];
+  shape.out_h = out_dims[2];
+  shape.out_w = out_dims[3];
+  shape.groups = groups;
+  shape.kernel_h = filter_dims[2];
+  shape.kernel_w = filter_dims[3];
+  shape.stride_h = strides[0];
+  shape.stride_w = strides[1];
+  shape.pad_h = paddings[0];
+  shape.pad_w = paddings[2];
+  shape.dilation_h = dilations[0];
+  shape.dilation_w = dilations[1];
+  return shape;
+}
+
 template <typename DeviceContext, typename T>
 inline void ResizeToChannelFirst(const framework::ExecutionContext& context,
                                  const Tensor* input,
@@ -359,6 +389,39 @@ class GemmConvKernel : public framework::OpKernel<T> {
     UpdatePaddingAndDilation(&paddings, &dilations, padding_algorithm,
                              in_data_dims, strides, ksize);
 
+    // On CPU depthwise and few channel convolutions run without im2col, and
+    // fp32 3x3 stride 1 ones by Winograd in inference, where the cached
+    // transformed filters do not go stale and the rounding is not trained on
+    if (platform::is_cpu_place(context.GetPlace()) &&
+        filter_dims.size() == 4) {
+      auto shape = GetConvDirectShape(trans_in_dims, filter_dims,
+                                      transformed_output.dims(), groups,
+                                      strides, paddings, dilations);
+      bool direct = math::UseConvDirect(shape);
+      bool winograd = !direct && FLAGS_conv_winograd &&
+                      context.Attr<bool>("is_test") &&
+                      math::UseConvWinograd<T>(shape);
+      if (direct || winograd) {
+        T* out_data = transformed_output.mutable_data<T>(context.GetPlace());
+        if (direct) {
+          math::ConvDirectCPU<T>(shape, transformed_input.data<T>(),
+                                 filter.data<T>(), nullptr, nullptr,
+                                 math::ConvDirectActivation::kIdentity,
+                                 out_data);
+        } else {
+          auto u = math::WinogradFilterCache<T>::Instance().Get(
+              filter.data<T>(), shape.out_c, shape.in_c);
+          math::ConvWinogradCPU<T>(shape, transformed_input.data<T>(),
+                                   u->data(), out_data);
+        }
+        if (channel_last) {
+          TransToChannelLast<DeviceContext, T>(context, &transformed_output,
+                                               output);
+        }
+        return;
+      }
+    }
+
     auto& dev_ctx = context.template device_context<DeviceContext>();
 
     const int batch_size = static_cast<int>(transformed_input.dims()[0]);
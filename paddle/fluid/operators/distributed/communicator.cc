@@ -17,6 +17,7 @@ limitations under the License. */
 #include <paddle/fluid/framework/program_desc.h>
 #include <algorithm>
 #include <chrono>  // NOLINT
+#include <cmath>
 #include <map>
 #include <thread>  // NOLINT
 #include <unordered_set>
@@ -581,6 +582,12 @@ void GeoCommunicator::SendSparse(const std::string &varname, int batches) {
 }
 
 void GeoCommunicator::SendDense(const std::string &varname) {
+  if (dense_threshold_ > 0 &&
+      send_varname_to_ctx_.at(varname).splited_varnames.size() == 1) {
+    SendDenseDelta(varname);
+    return;
+  }
+
   auto *var_latest = recv_scope_->FindVar(varname);
   auto *var_timestamp = old_scope_->FindVar(varname);
 
@@ -614,6 +621,71 @@ void GeoCommunicator::SendDense(const std::string &varname) {
   send(ctx, *delta_scope_, true, 1);
 }
 
+void GeoCommunicator::SendDenseDelta(const std::string &varname) {
+  auto *var_latest = recv_scope_->FindVar(varname);
+  auto *var_timestamp = old_scope_->FindVar(varname);
+
+  PADDLE_ENFORCE_EQ(var_latest->IsInitialized(), true,
+                    platform::errors::Unavailable(
+                        "%s is not initialized, please check", varname));
+  PADDLE_ENFORCE_EQ(var_timestamp->IsInitialized(), true,
+                    platform::errors::Unavailable(
+                        "%s is not initialized, please check", varname));
+
+  auto &t_latest = var_latest->Get<framework::LoDTensor>();
+  auto t_timestamp = var_timestamp->GetMutable<framework::LoDTensor>();
+
+  auto height = t_latest.dims()[0];
+  auto width = t_latest.numel() / height;
+
+  auto cpu_ctx = paddle::platform::CPUDeviceContext();
+  auto blas = math::GetBlas<platform::CPUDeviceContext, float>(cpu_ctx);
+  float coefficient = 1.0 / static_cast<float>(trainers_);
+
+  std::vector<int64_t> ids;
+  std::vector<float> values;
+  std::vector<float> v_delta(width);
+
+  // the rows not sent keep their delta in t_latest - t_timestamp, so they
+  // will be sent once they accumulate enough change
+  for (int64_t i = 0; i < height; ++i) {
+    auto *latest = t_latest.data<float>() + i * width;
+    auto *timestamp = t_timestamp->data<float>() + i * width;
+    blas.VSUB(width, latest, timestamp, v_delta.data());
+    blas.SCAL(width, coefficient, v_delta.data());
+
+    float max_delta = 0;
+    for (int64_t j = 0; j < width; ++j) {
+      max_delta = std::max(max_delta, std::fabs(v_delta[j]));
+    }
+    if (max_delta <= dense_threshold_) {
+      continue;
+    }
+    ids.push_back(i);
+    values.insert(values.end(), v_delta.begin(), v_delta.end());
+    blas.VADD(width, timestamp, v_delta.data(), timestamp);
+  }
+
+  VLOG(1) << "SendDenseDelta var: " << varname << " rows: " << ids.size()
+          << "/" << height;
+  if (ids.empty()) {
+    return;
+  }
+
+  auto *var_delta = delta_scope_->Var(varname);
+  auto *t_delta = var_delta->GetMutable<framework::SelectedRows>();
+  t_delta->set_height(height);
+  t_delta->set_rows(ids);
+  auto *t_value = t_delta->mutable_value()->mutable_data<float>(
+      framework::make_ddim({static_cast<int64_t>(ids.size()), width}),
+      cpu_ctx.GetPlace());
+  std::copy(values.begin(), values.end(), t_value);
+
+  auto &ctx = send_varname_to_ctx_.at(varname);
+  auto send = distributed::ParameterSend<float>();
+  send(ctx, *delta_scope_, true, 1);
+}
+
 void GeoCommunicator::RecvByCommunicator() {
   std::vector<std::future<void>> tasks;
   tasks.reserve(recv_varname_to_ctx_.size());
@@ -690,6 +762,12 @@ void GeoCommunicator::RecvSparse(const std::string &varname) {
 }
 
 void GeoCommunicator::RecvDense(const std::string &varname) {
+  if (dense_threshold_ > 0 &&
+      recv_varname_to_ctx_.at(varname).splited_varnames.size() == 1) {
+    RecvDenseDelta(varname);
+    return;
+  }
+
   auto *var_latest = recv_scope_->FindVar(varname);
   auto *var_timestamp = old_scope_->FindVar(varname);
   auto *var_psrever = pserver_scope_->Var(varname);
@@ -721,6 +799,54 @@ void GeoCommunicator::RecvDense(const std::string &varname) {
              t_timestamp->data<float>());
 }
 
+void GeoCommunicator::RecvDenseDelta(const std::string &varname) {
+  auto *var_latest = recv_scope_->FindVar(varname);
+  auto *var_timestamp = old_scope_->FindVar(varname);
+  auto *var_psrever = pserver_scope_->Var(varname);
+
+  // receive the changed rows as SelectedRows, see
+  // RequestGetHandler::GetDenseDelta
+  auto ctx = recv_varname_to_ctx_.at(varname);
+  ctx.is_sparse = true;
+  auto recv = distributed::ParameterRecv<float>();
+  recv(ctx, *pserver_scope_, true);
+
+  PADDLE_ENFORCE_EQ(
+      var_psrever->IsInitialized(), true,
+      platform::errors::Unavailable(
+          "%s in pserver scope is not initialized, please check", varname));
+
+  auto &slr_psrever = var_psrever->Get<framework::SelectedRows>();
+  auto &rows = slr_psrever.rows();
+  auto *t_latest = var_latest->GetMutable<framework::LoDTensor>();
+  auto *t_timestamp = var_timestamp->GetMutable<framework::LoDTensor>();
+
+  auto height = t_latest->dims()[0];
+  auto width = t_latest->numel() / height;
+  PADDLE_ENFORCE_EQ(
+      slr_psrever.value().numel(), static_cast<int64_t>(rows.size()) * width,
+      platform::errors::InvalidArgument(
+          "received rows of %s mismatch the width of the dense parameter",
+          varname));
+
+  VLOG(1) << "RecvDenseDelta var: " << varname << " rows: " << rows.size();
+
+  auto cpu_ctx = paddle::platform::CPUDeviceContext();
+  auto blas = math::GetBlas<platform::CPUDeviceContext, float>(cpu_ctx);
+  std::vector<float> v_delta(width);
+  auto *psrever_data = slr_psrever.value().data<float>();
+
+  for (size_t j = 0; j < rows.size(); ++j) {
+    // the pserver replies the row `height` alone if no row changed
+    if (rows[j] >= height) continue;
+    auto *latest = t_latest->data<float>() + rows[j] * width;
+    auto *timestamp = t_timestamp->data<float>() + rows[j] * width;
+    blas.VSUB(width, psrever_data + j * width, timestamp, v_delta.data());
+    blas.VADD(width, latest, v_delta.data(), latest);
+    blas.VCOPY(width, psrever_data + j * width, timestamp);
+  }
+}
+
 void GeoCommunicator::Init() {
   std::vector<std::future<void>> tasks;
   tasks.reserve(recv_varname_to_ctx_.size());
@@ -414,6 +414,10 @@ class GeoCommunicator : public AsyncCommunicator {
     send_queue_size_ = max_merge_var_num_;
     trainers_ = std::stoi(envs.at("trainers"));
     sparse_attrs_ = envs.at("sparse_attrs");
+    if (envs.find("communicator_geo_dense_threshold") != envs.end()) {
+      dense_threshold_ =
+          std::stof(envs.at("communicator_geo_dense_threshold"));
+    }
     VLOG(0) << "GeoCommunicator Initialized";
   }
 
@@ -427,6 +431,8 @@ class GeoCommunicator : public AsyncCommunicator {
 
   void SendDense(const std::string &varname);
 
+  void SendDenseDelta(const std::string &varname);
+
   void SendGlobalStep(int batches) override {}
 
   void RecvByCommunicator() override;
@@ -435,6 +441,8 @@ class GeoCommunicator : public AsyncCommunicator {
 
   void RecvDense(const std::string &varname);
 
+  void RecvDenseDelta(const std::string &varname);
+
   void Init();
 
   void InitSparse();
@@ -445,6 +453,10 @@ class GeoCommunicator : public AsyncCommunicator {
   int trainers_;
   std::string sparse_attrs_;
 
+  // if positive, dense params are sent and received as rows whose change
+  // exceeds it instead of full tensors
+  float dense_threshold_ = 0.0;
+
   // parameter for delta calc and send
   std::shared_ptr<Scope> delta_scope_;
 
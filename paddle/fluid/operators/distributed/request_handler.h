@@ -30,6 +30,7 @@
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/platform/macros.h"
 
@@ -163,7 +164,9 @@ class RequestHandler {
         executor_(nullptr),
         scope_(nullptr),
         program_(nullptr),
-        rpc_server_(nullptr) {}
+        rpc_server_(nullptr),
+        optimize_pool_(nullptr),
+        sparse_shard_min_rows_(0) {}
 
   virtual ~RequestHandler() {}
 
@@ -203,6 +206,15 @@ class RequestHandler {
 
   void SetRPCServer(RPCServer* rpc_server) { rpc_server_ = rpc_server; }
 
+  // Used for applying optimize blocks on a dedicated server thread pool.
+  // Sparse gradients with at least `sparse_shard_min_rows` rows are split
+  // into row shards and updated in parallel, 0 disables the sharding.
+  void SetOptimizeThreadPool(framework::ThreadPool* pool,
+                             int64_t sparse_shard_min_rows) {
+    optimize_pool_ = pool;
+    sparse_shard_min_rows_ = sparse_shard_min_rows;
+  }
+
   // Get attributes.
   int distributed_mode() { return distributed_mode_; }
   framework::Scope* scope() { return scope_; }
@@ -254,6 +266,10 @@ class RequestHandler {
   // used for lr decay
   std::shared_ptr<framework::ExecutorPrepareContext> lr_decay_prepared_ctx_;
   RPCServer* rpc_server_;
+
+  // used for parallel optimize
+  framework::ThreadPool* optimize_pool_;
+  int64_t sparse_shard_min_rows_;
 };
 
 }  // namespace distributed
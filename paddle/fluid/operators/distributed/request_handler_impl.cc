@@ -13,10 +13,14 @@
 // limitations under the License.
 
 #include "paddle/fluid/operators/distributed/request_handler_impl.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "gflags/gflags.h"
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -31,6 +35,10 @@
 #include "paddle/fluid/operators/distributed/heart_beat_monitor.h"
 #include "paddle/fluid/operators/distributed/large_scale_kv.h"
 
+DEFINE_double(rpc_server_geo_dense_pull_threshold, 0.0,
+              "in geo mode, a row of a dense parameter is sent back to a "
+              "trainer only if it changed more than this since its last pull");
+
 namespace paddle {
 namespace operators {
 namespace distributed {
@@ -39,6 +47,88 @@ namespace distributed {
 // to directory specified.
 constexpr char LOOKUP_TABLE_PATH[] = "kLookupTablePath";
 
+// Optimizers whose sparse update only touches the rows present in the
+// gradient, so that disjoint row shards can be applied concurrently.
+static const std::unordered_set<std::string> kRowwiseSparseOptimizers = {
+    "sgd", "adagrad"};
+
+bool RequestSendHandler::RunShardedSparseOptimize(const std::string &varname,
+                                                  framework::Scope *scope) {
+  if (optimize_pool_ == nullptr || sparse_shard_min_rows_ <= 0) {
+    return false;
+  }
+  auto *var = scope->FindVar(varname);
+  if (var == nullptr || !var->IsType<framework::SelectedRows>()) {
+    return false;
+  }
+  auto &grad = var->Get<framework::SelectedRows>();
+  auto &rows = grad.rows();
+  auto &value = grad.value();
+  if (static_cast<int64_t>(rows.size()) < sparse_shard_min_rows_ ||
+      !platform::is_cpu_place(value.place())) {
+    return false;
+  }
+
+  auto *ctx = (*grad_to_prepared_ctx_)[varname].get();
+  for (auto &op : ctx->ops_) {
+    if (kRowwiseSparseOptimizers.count(op->Type()) == 0) {
+      VLOG(4) << "op " << op->Type() << " of " << varname
+              << " can not be sharded by rows";
+      return false;
+    }
+  }
+
+  // Shard by row id instead of by position so that duplicated ids of an
+  // unmerged gradient always fall into the same shard.
+  int64_t shard_num =
+      static_cast<int64_t>(rows.size()) / sparse_shard_min_rows_;
+  std::vector<std::vector<size_t>> shard_index(shard_num);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    shard_index[rows[i] % shard_num].push_back(i);
+  }
+
+  int64_t width = value.numel() / value.dims()[0];
+  size_t elem_size = framework::SizeOfType(value.type());
+  auto *src = reinterpret_cast<const char *>(value.data<void>());
+
+  std::vector<framework::Scope *> shard_scopes;
+  for (int64_t s = 0; s < shard_num; ++s) {
+    if (shard_index[s].empty()) continue;
+    auto *shard_scope = &scope->NewScope();
+    auto *shard =
+        shard_scope->Var(varname)->GetMutable<framework::SelectedRows>();
+    shard->set_height(grad.height());
+    auto *shard_rows = shard->mutable_rows();
+    shard_rows->reserve(shard_index[s].size());
+    auto *shard_value = shard->mutable_value();
+    shard_value->Resize(framework::make_ddim(
+        {static_cast<int64_t>(shard_index[s].size()), width}));
+    auto *dst = reinterpret_cast<char *>(
+        shard_value->mutable_data(value.place(), value.type()));
+    size_t row_bytes = width * elem_size;
+    for (size_t i = 0; i < shard_index[s].size(); ++i) {
+      auto idx = shard_index[s][i];
+      shard_rows->push_back(rows[idx]);
+      memcpy(dst + i * row_bytes, src + idx * row_bytes, row_bytes);
+    }
+    shard_scopes.push_back(shard_scope);
+  }
+
+  VLOG(3) << "run optimize of " << varname << " with " << shard_scopes.size()
+          << " row shards";
+  std::vector<std::future<void>> fs;
+  for (auto *shard_scope : shard_scopes) {
+    fs.push_back(optimize_pool_->Run([this, ctx, shard_scope]() {
+      executor_->RunPreparedContext(ctx, shard_scope);
+    }));
+  }
+  for (auto &f : fs) f.wait();
+  for (auto *shard_scope : shard_scopes) {
+    scope->DeleteScope(shard_scope);
+  }
+  return true;
+}
+
 bool RequestSendHandler::Handle(const std::string &varname,
                                 framework::Scope *scope,
                                 framework::Variable *invar,
@@ -109,8 +199,10 @@ bool RequestSendHandler::Handle(const std::string &varname,
         }
       }
 
-      executor_->RunPreparedContext((*grad_to_prepared_ctx_)[run_varname].get(),
-                                    scope);
+      if (!RunShardedSparseOptimize(run_varname, scope)) {
+        executor_->RunPreparedContext(
+            (*grad_to_prepared_ctx_)[run_varname].get(), scope);
+      }
       return true;
     } else {  // sync
       rpc_server_->WaitCond(kRequestSend);
@@ -123,6 +215,69 @@ bool RequestSendHandler::Handle(const std::string &varname,
   return true;
 }
 
+void RequestGetHandler::GetDenseDelta(const std::string &varname,
+                                      const int trainer_id,
+                                      framework::SelectedRows *out_slr) {
+  auto &origin_tensor = scope_->FindVar(varname)->Get<framework::LoDTensor>();
+  PADDLE_ENFORCE_EQ(
+      origin_tensor.type(), framework::proto::VarType::FP32,
+      platform::errors::InvalidArgument(
+          "geo dense delta only supports float parameter, but %s is %s",
+          varname, framework::DataTypeToString(origin_tensor.type())));
+  auto *origin_data = origin_tensor.data<float>();
+  int64_t height = origin_tensor.dims()[0];
+  int64_t width = origin_tensor.numel() / height;
+
+  framework::LoDTensor *snapshot = nullptr;
+  bool first_pull = false;
+  {
+    std::lock_guard<std::mutex> lock(dense_snapshot_mutex_);
+    auto &trainer_snapshots = dense_snapshots_[varname];
+    first_pull = trainer_snapshots.count(trainer_id) == 0;
+    snapshot = &trainer_snapshots[trainer_id];
+  }
+  if (first_pull) {
+    snapshot->mutable_data<float>(origin_tensor.dims(), platform::CPUPlace());
+  }
+  auto *snapshot_data = snapshot->data<float>();
+
+  std::vector<int64_t> updated_rows;
+  for (int64_t i = 0; i < height; ++i) {
+    auto *cur = origin_data + i * width;
+    auto *old = snapshot_data + i * width;
+    float max_diff = 0;
+    for (int64_t j = 0; j < width; ++j) {
+      max_diff = std::max(max_diff, std::fabs(cur[j] - old[j]));
+    }
+    if (first_pull || max_diff > FLAGS_rpc_server_geo_dense_pull_threshold) {
+      updated_rows.push_back(i);
+    }
+  }
+  VLOG(3) << "geo dense " << varname << " trainer " << trainer_id << " pulls "
+          << updated_rows.size() << "/" << height << " rows";
+
+  out_slr->set_height(height);
+  if (updated_rows.empty()) {
+    // The rpc can not send a SelectedRows without rows, so the reply of no
+    // changes is a single zero row of the id `height`, which the trainer
+    // skips, see GeoCommunicator::RecvDenseDelta
+    out_slr->set_rows(std::vector<int64_t>{height});
+    auto *data = out_slr->mutable_value()->mutable_data<float>(
+        framework::make_ddim({1, width}), platform::CPUPlace());
+    std::fill(data, data + width, 0.0f);
+    return;
+  }
+  out_slr->set_rows(updated_rows);
+  auto *data = out_slr->mutable_value()->mutable_data<float>(
+      framework::make_ddim({static_cast<int64_t>(updated_rows.size()), width}),
+      platform::CPUPlace());
+  for (size_t i = 0; i < updated_rows.size(); ++i) {
+    auto offset = updated_rows[i] * width;
+    memcpy(data + i * width, origin_data + offset, sizeof(float) * width);
+    memcpy(snapshot_data + offset, origin_data + offset, sizeof(float) * width);
+  }
+}
+
 bool RequestGetHandler::Handle(const std::string &varname,
                                framework::Scope *scope,
                                framework::Variable *invar,
@@ -196,6 +351,12 @@ bool RequestGetHandler::Handle(const std::string &varname,
           memcpy(data + i * width, origin_tensor_data + updated_rows[i] * width,
                  sizeof(float) * width);
         }
+      } else if (distributed_mode_ == DistributedMode::kGeo &&
+                 !table_name.empty() &&
+                 scope_->FindVar(varname)->IsType<framework::LoDTensor>()) {
+        *outvar = scope->Var();
+        GetDenseDelta(varname, trainer_id,
+                      (*outvar)->GetMutable<framework::SelectedRows>());
       } else {
         *outvar = scope_->FindVar(varname);
       }
@@ -18,6 +18,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -50,6 +51,12 @@ class RequestSendHandler final : public RequestHandler {
               const std::string& table_name = "") override;
 
  private:
+  // Split the sparse gradient `varname` into row shards and run the
+  // optimize block of each shard in parallel on `optimize_pool_`.
+  // Returns false if the gradient or the block is not suitable for it.
+  bool RunShardedSparseOptimize(const std::string& varname,
+                                framework::Scope* scope);
+
   bool enable_dc_asgd_;
 };
 
@@ -66,7 +73,18 @@ class RequestGetHandler final : public RequestHandler {
               const std::string& table_name = "") override;
 
  private:
+  // Geo mode: fill `out_slr` with the rows of the dense parameter `varname`
+  // that changed since `trainer_id` pulled it last time.
+  void GetDenseDelta(const std::string& varname, const int trainer_id,
+                     framework::SelectedRows* out_slr);
+
   bool enable_dc_asgd_;
+
+  // the dense parameter snapshot every trainer holds, varname -> trainer_id
+  std::mutex dense_snapshot_mutex_;
+  std::unordered_map<std::string,
+                     std::unordered_map<int, framework::LoDTensor>>
+      dense_snapshots_;
 };
 
 class RequestGetNoBarrierHandler final : public RequestHandler {
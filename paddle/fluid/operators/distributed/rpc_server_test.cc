@@ -14,18 +14,23 @@ limitations under the License. */
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/block_desc.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
 
+#include "paddle/fluid/operators/distributed/async_sparse_param_update_recorder.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
 #include "paddle/fluid/operators/distributed/heart_beat_monitor.h"
+#include "paddle/fluid/operators/distributed/large_scale_kv.h"
 #include "paddle/fluid/operators/distributed/request_handler_impl.h"
 #include "paddle/fluid/operators/distributed/rpc_client.h"
 #include "paddle/fluid/operators/distributed/rpc_server.h"
@@ -36,6 +41,9 @@ namespace distributed = paddle::operators::distributed;
 
 USE_NO_KERNEL_OP(lookup_sparse_table_read);
 USE_OP(scale);
+USE_OP(adagrad);
+
+DECLARE_double(rpc_server_geo_dense_pull_threshold);
 
 std::unique_ptr<distributed::RPCServer> g_rpc_service;
 std::unique_ptr<distributed::RequestHandler> g_req_handler;
@@ -230,3 +238,139 @@ TEST(SENDANDRECV, CPU) {
   g_rpc_service.reset(nullptr);
   g_req_handler.reset(nullptr);
 }
+
+// In geo mode, a trainer pulls the rows of a dense parameter that changed
+// more than the threshold since its own last pull.
+TEST(GEO_DENSE_PULL, CPU) {
+  FLAGS_rpc_server_geo_dense_pull_threshold = 0.5;
+  std::unordered_map<std::string, std::string> grad_to_param;
+  distributed::AsyncSparseParamUpdateRecorder::Init(2, grad_to_param);
+
+  framework::Scope scope;
+  platform::CPUPlace place;
+  auto* w = scope.Var("w_dense")->GetMutable<framework::LoDTensor>();
+  float* w_data = w->mutable_data<float>(framework::make_ddim({4, 3}), place);
+  std::fill(w_data, w_data + 12, 0.0f);
+
+  distributed::RequestGetHandler handler(distributed::DistributedMode::kGeo);
+  handler.SetScope(&scope);
+
+  framework::Scope reply_scope;
+  auto pull = [&](int trainer_id) {
+    framework::Variable* outvar = nullptr;
+    handler.Handle("w_dense", &reply_scope, nullptr, &outvar, trainer_id, "",
+                   "w_dense");
+    auto& slr = outvar->Get<framework::SelectedRows>();
+    EXPECT_EQ(slr.height(), 4);
+    EXPECT_EQ(slr.value().dims()[0], static_cast<int64_t>(slr.rows().size()));
+    for (size_t i = 0; i < slr.rows().size(); ++i) {
+      // the row `height` is the reply of no changes, and is zeros
+      const float* expect =
+          slr.rows()[i] < 4 ? w_data + slr.rows()[i] * 3 : nullptr;
+      for (int j = 0; j < 3; ++j) {
+        EXPECT_EQ(slr.value().data<float>()[i * 3 + j],
+                  expect ? expect[j] : 0.0f);
+      }
+    }
+    return std::vector<int64_t>(slr.rows().begin(), slr.rows().end());
+  };
+
+  EXPECT_EQ(pull(0), (std::vector<int64_t>{0, 1, 2, 3}));
+  EXPECT_EQ(pull(0), std::vector<int64_t>{4});
+
+  w_data[2 * 3 + 1] += 1.0f;
+  w_data[1 * 3] += 0.3f;
+  EXPECT_EQ(pull(0), std::vector<int64_t>{2});
+  EXPECT_EQ(pull(1), (std::vector<int64_t>{0, 1, 2, 3}));
+
+  // the change of row 1 accumulates for trainer 0 until it exceeds the
+  // threshold, while trainer 1 pulled it after the first change
+  w_data[1 * 3] += 0.3f;
+  EXPECT_EQ(pull(0), std::vector<int64_t>{1});
+  EXPECT_EQ(pull(1), std::vector<int64_t>{4});
+}
+
+framework::BlockDesc* AppendAdagradBlock(framework::ProgramDesc* program) {
+  auto root_block = program->MutableBlock(0);
+  auto* block = program->AppendBlock(*root_block);
+
+  framework::OpDesc* op = block->AppendOp();
+  op->SetType("adagrad");
+  op->SetInput("Param", {"w"});
+  op->SetInput("Grad", {"w@GRAD"});
+  op->SetInput("Moment", {"m"});
+  op->SetInput("LearningRate", {"lr"});
+  op->SetOutput("ParamOut", {"w"});
+  op->SetOutput("MomentOut", {"m"});
+  op->SetAttr("epsilon", 1.0e-6f);
+  return block;
+}
+
+// A sparse gradient of 64 rows with the 20 ids repeated, so that the merge
+// of the duplicated ids shows in the moment of adagrad
+void InitAdagradVars(framework::Scope* scope, platform::CPUPlace* place) {
+  auto* w = scope->Var("w")->GetMutable<framework::LoDTensor>();
+  auto* w_data = w->mutable_data<float>(framework::make_ddim({100, 4}), *place);
+  std::fill(w_data, w_data + w->numel(), 1.0f);
+  auto* m = scope->Var("m")->GetMutable<framework::LoDTensor>();
+  auto* m_data = m->mutable_data<float>(framework::make_ddim({100, 4}), *place);
+  std::fill(m_data, m_data + m->numel(), 0.0f);
+  auto* lr = scope->Var("lr")->GetMutable<framework::LoDTensor>();
+  lr->mutable_data<float>(framework::make_ddim({1}), *place)[0] = 0.1f;
+
+  auto* grad = scope->Var("w@GRAD")->GetMutable<framework::SelectedRows>();
+  grad->set_height(100);
+  std::vector<int64_t> rows(64);
+  for (int64_t i = 0; i < 64; ++i) rows[i] = (i * 7) % 20;
+  grad->set_rows(rows);
+  auto* g_data = grad->mutable_value()->mutable_data<float>(
+      framework::make_ddim({64, 4}), *place);
+  for (int64_t i = 0; i < 64 * 4; ++i) g_data[i] = 0.01f * (i % 13 + 1);
+}
+
+// The optimize of a sparse gradient sharded by row ids on the optimize pool
+// gives the same parameter and moment as the optimize of the whole gradient
+TEST(SPARSE_SHARD_OPTIMIZE, CPU) {
+  std::vector<distributed::SparseMeta> metas;
+  distributed::LargeScaleKV::Init(metas);
+  distributed::HeartBeatMonitor::Init(2, true, "w@grad");
+
+  framework::ProgramDesc program;
+  platform::CPUPlace place;
+  framework::Executor exe(place);
+  platform::CPUDeviceContext ctx(place);
+  auto* block = AppendAdagradBlock(&program);
+  auto prepared = exe.Prepare(program, std::vector<int>{block->ID()});
+  std::unordered_map<std::string,
+                     std::shared_ptr<framework::ExecutorPrepareContext>>
+      grad_to_prepared_ctx;
+  grad_to_prepared_ctx["w@GRAD"] = prepared[0];
+
+  framework::Scope expect_scope;
+  InitAdagradVars(&expect_scope, &place);
+  exe.RunPreparedContext(prepared[0].get(), &expect_scope);
+
+  framework::Scope scope;
+  InitAdagradVars(&scope, &place);
+  framework::ThreadPool pool(4);
+  distributed::RequestSendHandler handler(distributed::DistributedMode::kAsync);
+  handler.SetProgram(&program);
+  handler.SetGradToPreparedCtx(&grad_to_prepared_ctx);
+  handler.SetDevCtx(&ctx);
+  handler.SetScope(&scope);
+  handler.SetExecutor(&exe);
+  // 8 shards of the 64 rows
+  handler.SetOptimizeThreadPool(&pool, 8);
+  handler.Handle("w@GRAD", &scope, nullptr, nullptr, 0);
+
+  for (auto* name : {"w", "m"}) {
+    auto& expect = expect_scope.FindVar(name)->Get<framework::LoDTensor>();
+    auto& actual = scope.FindVar(name)->Get<framework::LoDTensor>();
+    for (int64_t i = 0; i < expect.numel(); ++i) {
+      EXPECT_FLOAT_EQ(actual.data<float>()[i], expect.data<float>()[i])
+          << name << " " << i;
+    }
+  }
+  // the shard scopes are dropped after the optimize
+  EXPECT_TRUE(scope.kids().empty());
+}
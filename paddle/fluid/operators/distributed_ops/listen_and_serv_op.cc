@@ -35,6 +35,12 @@ limitations under the License. */
 DEFINE_int32(rpc_send_thread_num, 12, "number of threads for rpc send");
 DEFINE_int32(rpc_get_thread_num, 12, "number of threads for rpc get");
 DEFINE_int32(rpc_prefetch_thread_num, 12, "number of threads for rpc prefetch");
+DEFINE_int32(rpc_server_optimize_thread_num, 0,
+             "number of threads pserver uses to run optimize blocks, 0 means "
+             "using the global thread pool and disables sparse row sharding");
+DEFINE_int64(rpc_server_sparse_shard_rows, 65536,
+             "sparse gradients with at least this many rows are split into "
+             "row shards and optimized in parallel on pserver, 0 to disable");
 
 namespace paddle {
 namespace operators {
@@ -66,10 +72,14 @@ static void ParallelExecuteBlocks(
     const std::vector<size_t> &parallel_blkids, framework::Executor *executor,
     const std::vector<std::shared_ptr<framework::ExecutorPrepareContext>>
         &prepared,
-    framework::ProgramDesc *program, framework::Scope *scope) {
+    framework::ProgramDesc *program, framework::Scope *scope,
+    framework::ThreadPool *pool) {
+  if (pool == nullptr) {
+    pool = framework::ThreadPool::GetInstance();
+  }
   std::vector<std::future<void>> fs;
   for (size_t idx : parallel_blkids) {
-    fs.push_back(framework::Async([&executor, &prepared, &scope, idx]() {
+    fs.push_back(pool->Run([&executor, &prepared, &scope, idx]() {
       int run_block = idx;  // thread local
       try {
         VLOG(3) << "running server block: " << run_block
@@ -182,14 +192,14 @@ void ListenAndServOp::RunSyncLoop(
       int blkid = optimize_blocks[i]->ID();
       if (program->Block(blkid).Parent() != last_parent_blkid) {
         ParallelExecuteBlocks(parallel_blkids, executor, optimize_prepared,
-                              program, recv_scope);
+                              program, recv_scope, optimize_pool_.get());
         parallel_blkids.clear();
         last_parent_blkid = program->Block(blkid).Parent();
       }
       parallel_blkids.push_back(blkid);
     }
     ParallelExecuteBlocks(parallel_blkids, executor, optimize_prepared, program,
-                          recv_scope);
+                          recv_scope, optimize_pool_.get());
     VLOG(3) << "run all blocks spent " << GetTimestamp() - ts << "(ms)";
 
     VLOG(3) << "ResetReceivedVars";
@@ -317,7 +327,7 @@ static void FillRequestCtx(
         *sparse_grad_name_to_param_name,
     std::shared_ptr<framework::ExecutorPrepareContext> checkpoint_ctx,
     std::shared_ptr<framework::ExecutorPrepareContext> lr_decay_ctx,
-    distributed::RPCServer *rpc_server) {
+    distributed::RPCServer *rpc_server, framework::ThreadPool *optimize_pool) {
   h->SetScope(scope);
   h->SetDevCtx(dev_ctx);
   h->SetExecutor(executor);
@@ -327,6 +337,7 @@ static void FillRequestCtx(
   h->SetRPCServer(rpc_server);
   h->SetCheckpointNotifyPreparedCtx(checkpoint_ctx);
   h->SetLrDecayPreparedCtx(lr_decay_ctx);
+  h->SetOptimizeThreadPool(optimize_pool, FLAGS_rpc_server_sparse_shard_rows);
 }
 
 void ListenAndServOp::CacheVarsType(const std::vector<std::string> &varnames,
@@ -424,6 +435,13 @@ void ListenAndServOp::RunImpl(const framework::Scope &scope,
 
   framework::Executor executor(dev_place);
 
+  if (FLAGS_rpc_server_optimize_thread_num > 0) {
+    VLOG(1) << "pserver runs optimize blocks with "
+            << FLAGS_rpc_server_optimize_thread_num << " threads";
+    optimize_pool_.reset(
+        new framework::ThreadPool(FLAGS_rpc_server_optimize_thread_num));
+  }
+
   std::shared_ptr<framework::ExecutorPrepareContext> ckpt_pre_context = nullptr;
   if (checkpoint_block_id != -1) {
     auto ctx = executor.Prepare(*program, checkpoint_block_id);
@@ -486,7 +504,7 @@ void ListenAndServOp::RunImpl(const framework::Scope &scope,
       std::bind(FillRequestCtx, std::placeholders::_1, &recv_scope, &dev_ctx,
                 &executor, program, &prefetch_var_name_to_prepared_ctx,
                 &sparse_grad_name_to_param_name, ckpt_pre_context,
-                lr_decay_context, rpc_service_.get());
+                lr_decay_context, rpc_service_.get(), optimize_pool_.get());
 
   f(request_send_handler_.get());
   f(request_get_handler_.get());
@@ -103,6 +103,7 @@ class ListenAndServOp : public framework::OperatorBase {
       request_send_and_recv_handler_;
 
   mutable std::shared_ptr<std::thread> server_thread_;
+  mutable std::shared_ptr<framework::ThreadPool> optimize_pool_;
   mutable std::vector<std::string> sparse_vars_;
   mutable std::vector<std::string> dense_vars_;
 };
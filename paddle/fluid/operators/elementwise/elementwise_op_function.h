@@ -19,6 +19,8 @@ limitations under the License. */
 #include <algorithm>
 #include <functional>  // for multiplies
 #include <iterator>
+#include <numeric>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/eigen.h"
@@ -167,6 +169,102 @@ inline void GetBroadcastDimsArrays(const framework::DDim &x_dims,
   }
 }
 
+// The broadcast of two operands collapsed to the fewest dims, adjacent dims
+// are merged when each operand is broadcast in both or in neither of them.
+// A stride is 0 in the dims where the operand is broadcast, and the stride
+// of the innermost dim is always 0 or 1.
+struct BroadcastLoopDims {
+  std::vector<int64_t> out_dims;
+  std::vector<int64_t> x_strides;
+  std::vector<int64_t> y_strides;
+
+  int64_t rows() const {
+    return std::accumulate(out_dims.begin(), out_dims.end() - 1,
+                           static_cast<int64_t>(1),
+                           std::multiplies<int64_t>());
+  }
+
+  // Offsets of x and y at the start of an output row
+  void RowOffsets(int64_t row, int64_t *x_offset, int64_t *y_offset) const {
+    *x_offset = 0;
+    *y_offset = 0;
+    for (int d = static_cast<int>(out_dims.size()) - 2; d >= 0; --d) {
+      int64_t i = row % out_dims[d];
+      row /= out_dims[d];
+      *x_offset += i * x_strides[d];
+      *y_offset += i * y_strides[d];
+    }
+  }
+};
+
+inline BroadcastLoopDims CollapseBroadcastDims(const int *x_dims_array,
+                                               const int *y_dims_array,
+                                               const int *out_dims_array,
+                                               int max_dim) {
+  BroadcastLoopDims loop;
+  std::vector<bool> x_bcast, y_bcast;
+  for (int i = 0; i < max_dim; ++i) {
+    if (out_dims_array[i] == 1) continue;
+    bool xb = x_dims_array[i] == 1;
+    bool yb = y_dims_array[i] == 1;
+    if (!loop.out_dims.empty() && x_bcast.back() == xb &&
+        y_bcast.back() == yb) {
+      loop.out_dims.back() *= out_dims_array[i];
+    } else {
+      loop.out_dims.push_back(out_dims_array[i]);
+      x_bcast.push_back(xb);
+      y_bcast.push_back(yb);
+    }
+  }
+  if (loop.out_dims.empty()) {
+    loop.out_dims.push_back(1);
+    x_bcast.push_back(false);
+    y_bcast.push_back(false);
+  }
+
+  int rank = loop.out_dims.size();
+  loop.x_strides.resize(rank);
+  loop.y_strides.resize(rank);
+  int64_t x_stride = 1, y_stride = 1;
+  for (int d = rank - 1; d >= 0; --d) {
+    loop.x_strides[d] = x_bcast[d] ? 0 : x_stride;
+    loop.y_strides[d] = y_bcast[d] ? 0 : y_stride;
+    x_stride *= x_bcast[d] ? 1 : loop.out_dims[d];
+    y_stride *= y_bcast[d] ? 1 : loop.out_dims[d];
+  }
+  return loop;
+}
+
+// Outputs below this size are not worth waking the threads for
+constexpr int64_t kMinParallelBroadcastSize = 1 << 15;
+
+// out[i] = func(x[i * x_stride], y[i * y_stride]) with the strides being 0
+// or 1, the loops are specialized so that the compiler can vectorize them.
+template <typename Functor, typename T, typename OutType>
+inline void BroadcastForwardInnerLoop(const T *x, int64_t x_stride,
+                                      const T *y, int64_t y_stride,
+                                      OutType *out, int64_t n, Functor func) {
+  if (x_stride == 1 && y_stride == 1) {
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i], y[i]);
+    }
+  } else if (x_stride == 1) {
+    const T y0 = y[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i], y0);
+    }
+  } else if (y_stride == 1) {
+    const T x0 = x[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x0, y[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i * x_stride], y[i * y_stride]);
+    }
+  }
+}
+
 template <typename Functor, typename T, typename OutType = T>
 void CommonForwardBroadcastCPU(const framework::Tensor *x,
                                const framework::Tensor *y, framework::Tensor *z,
@@ -175,24 +273,34 @@ void CommonForwardBroadcastCPU(const framework::Tensor *x,
                                const platform::CPUDeviceContext &ctx,
                                Functor func,
                                const bool is_xsize_larger = true) {
-  std::vector<int> index_array(max_dim, 0);
   const T *x_data = x->data<T>();
   const T *y_data = y->data<T>();
   OutType *out_data = z->mutable_data<OutType>(ctx.GetPlace());
 
   const int out_size = std::accumulate(out_dims_array, out_dims_array + max_dim,
                                        1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (is_xsize_larger) {
-      out_data[out_index] = func(x_data[x_index], y_data[y_index]);
-    } else {
-      out_data[out_index] = func(y_data[y_index], x_data[x_index]);
-    }
-
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
+  if (out_size <= 0) return;
+
+  // func always takes the element of the larger operand first
+  if (!is_xsize_larger) {
+    std::swap(x_data, y_data);
+    std::swap(x_dims_array, y_dims_array);
+  }
+  auto loop = CollapseBroadcastDims(x_dims_array, y_dims_array,
+                                    out_dims_array, max_dim);
+  const int64_t inner = loop.out_dims.back();
+  const int64_t x_inner_stride = loop.x_strides.back();
+  const int64_t y_inner_stride = loop.y_strides.back();
+  const int64_t rows = loop.rows();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (out_size >= kMinParallelBroadcastSize)
+#endif
+  for (int64_t row = 0; row < rows; ++row) {
+    int64_t x_offset, y_offset;
+    loop.RowOffsets(row, &x_offset, &y_offset);
+    BroadcastForwardInnerLoop(x_data + x_offset, x_inner_stride,
+                              y_data + y_offset, y_inner_stride,
+                              out_data + row * inner, inner, func);
   }
 }
 
@@ -312,6 +420,140 @@ void CommonForwardBroadcastCUDA(
 
 #endif  // __NVCC__
 
+// d[i * d_stride] += op(x[i * x_stride], y[i * y_stride], out[i], dout[i]),
+// where d is dx if IsDx else dy. The strides are 0 or 1, d is reduced into
+// d[0] when its stride is 0.
+template <typename T, typename OP, bool IsDx>
+inline void BroadcastGradInnerLoop(const T *x, int64_t x_stride, const T *y,
+                                   int64_t y_stride, const T *out,
+                                   const T *dout, T *d, int64_t n, OP op) {
+  const int64_t d_stride = IsDx ? x_stride : y_stride;
+  if (d_stride == 1) {
+    if (x_stride == 1 && y_stride == 1) {
+      for (int64_t i = 0; i < n; ++i) {
+        d[i] += op(x[i], y[i], out[i], dout[i]);
+      }
+    } else if (x_stride == 1) {
+      const T y0 = y[0];
+      for (int64_t i = 0; i < n; ++i) {
+        d[i] += op(x[i], y0, out[i], dout[i]);
+      }
+    } else {
+      const T x0 = x[0];
+      for (int64_t i = 0; i < n; ++i) {
+        d[i] += op(x0, y[i], out[i], dout[i]);
+      }
+    }
+  } else {
+    T sum = static_cast<T>(0);
+    if (x_stride == 1) {
+      const T y0 = y[0];
+      for (int64_t i = 0; i < n; ++i) {
+        sum += op(x[i], y0, out[i], dout[i]);
+      }
+    } else if (y_stride == 1) {
+      const T x0 = x[0];
+      for (int64_t i = 0; i < n; ++i) {
+        sum += op(x0, y[i], out[i], dout[i]);
+      }
+    } else {
+      for (int64_t i = 0; i < n; ++i) {
+        sum += op(x[0], y[0], out[i], dout[i]);
+      }
+    }
+    d[0] += sum;
+  }
+}
+
+// Accumulate the gradient of one operand over the output rows. The rows are
+// split across threads along the outermost dim in which the operand is not
+// broadcast, so that no two threads write the same element of d.
+template <typename T, typename OP, bool IsDx>
+void BroadcastGradReduce(const BroadcastLoopDims &loop, const T *x_data,
+                         const T *y_data, const T *out_data,
+                         const T *dout_data, T *d_data, OP op) {
+  const auto &d_strides = IsDx ? loop.x_strides : loop.y_strides;
+  const int rank = loop.out_dims.size();
+  const int64_t inner = loop.out_dims.back();
+  const int64_t x_inner_stride = loop.x_strides.back();
+  const int64_t y_inner_stride = loop.y_strides.back();
+  const int64_t rows = loop.rows();
+
+  int split_dim = -1;
+  for (int d = 0; d < rank - 1; ++d) {
+    if (d_strides[d] != 0) {
+      split_dim = d;
+      break;
+    }
+  }
+  if (split_dim < 0) {
+    for (int64_t row = 0; row < rows; ++row) {
+      int64_t x_offset, y_offset;
+      loop.RowOffsets(row, &x_offset, &y_offset);
+      BroadcastGradInnerLoop<T, OP, IsDx>(
+          x_data + x_offset, x_inner_stride, y_data + y_offset,
+          y_inner_stride, out_data + row * inner, dout_data + row * inner,
+          d_data + (IsDx ? x_offset : y_offset), inner, op);
+    }
+    return;
+  }
+
+  // rows = outer * split * rest, each thread owns a range of split
+  const int64_t split = loop.out_dims[split_dim];
+  const int64_t rest = std::accumulate(
+      loop.out_dims.begin() + split_dim + 1, loop.out_dims.end() - 1,
+      static_cast<int64_t>(1), std::multiplies<int64_t>());
+  const int64_t outer = rows / (split * rest);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (rows * inner >= kMinParallelBroadcastSize)
+#endif
+  for (int64_t s = 0; s < split; ++s) {
+    for (int64_t o = 0; o < outer; ++o) {
+      for (int64_t r = 0; r < rest; ++r) {
+        int64_t row = (o * split + s) * rest + r;
+        int64_t x_offset, y_offset;
+        loop.RowOffsets(row, &x_offset, &y_offset);
+        BroadcastGradInnerLoop<T, OP, IsDx>(
+            x_data + x_offset, x_inner_stride, y_data + y_offset,
+            y_inner_stride, out_data + row * inner, dout_data + row * inner,
+            d_data + (IsDx ? x_offset : y_offset), inner, op);
+      }
+    }
+  }
+}
+
+// dx and dy are computed in their own passes, each one is zeroed first and
+// then accumulated over the output.
+template <typename T, typename DX_OP, typename DY_OP>
+void BroadcastGradCPU(const T *x_data, const T *y_data, const T *out_data,
+                      const T *dout_data, T *dx_data, T *dy_data,
+                      const int *x_dims_array, const int *y_dims_array,
+                      const int *out_dims_array, int max_dim, DX_OP dx_op,
+                      DY_OP dy_op) {
+  auto numel = [max_dim](const int *dims) {
+    return std::accumulate(dims, dims + max_dim, static_cast<int64_t>(1),
+                           std::multiplies<int64_t>());
+  };
+  if (dx_data != nullptr) {
+    memset(dx_data, 0, numel(x_dims_array) * sizeof(T));
+  }
+  if (dy_data != nullptr) {
+    memset(dy_data, 0, numel(y_dims_array) * sizeof(T));
+  }
+  if (numel(out_dims_array) <= 0) return;
+
+  auto loop = CollapseBroadcastDims(x_dims_array, y_dims_array,
+                                    out_dims_array, max_dim);
+  if (dx_data != nullptr) {
+    BroadcastGradReduce<T, DX_OP, true>(loop, x_data, y_data, out_data,
+                                        dout_data, dx_data, dx_op);
+  }
+  if (dy_data != nullptr) {
+    BroadcastGradReduce<T, DY_OP, false>(loop, x_data, y_data, out_data,
+                                         dout_data, dy_data, dy_op);
+  }
+}
+
 template <typename T, typename DX_OP, typename DY_OP>
 void CommonGradBroadcastCPU(
     const framework::Tensor &x, const framework::Tensor &y,
@@ -319,36 +561,11 @@ void CommonGradBroadcastCPU(
     framework::Tensor *dx, framework::Tensor *dy, int *x_dims_array,
     int *y_dims_array, int *out_dims_array, int max_dim,
     const platform::CPUDeviceContext &ctx, DX_OP dx_op, DY_OP dy_op) {
-  std::vector<int> index_array(max_dim, 0);
-  const T *x_data = x.data<T>();
-  const T *y_data = y.data<T>();
-  const T *out_data = out.data<T>();
-  const T *dout_data = dout.data<T>();
   T *dx_data = dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace());
   T *dy_data = dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace());
-  if (dx_data != nullptr) {
-    memset(dx_data, 0, dx->numel() * sizeof(T));
-  }
-  if (dy_data != nullptr) {
-    memset(dy_data, 0, dy->numel() * sizeof(T));
-  }
-  const int out_size = std::accumulate(out_dims_array, out_dims_array + max_dim,
-                                       1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (dx_data != nullptr) {
-      dx_data[x_index] += dx_op(x_data[x_index], y_data[y_index],
-                                out_data[out_index], dout_data[out_index]);
-    }
-    if (dy_data != nullptr) {
-      dy_data[y_index] += dy_op(x_data[x_index], y_data[y_index],
-                                out_data[out_index], dout_data[out_index]);
-    }
-
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
-  }
+  BroadcastGradCPU(x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(),
+                   dx_data, dy_data, x_dims_array, y_dims_array,
+                   out_dims_array, max_dim, dx_op, dy_op);
 }
 
 inline void ComputeBroadcastKernelSize(int *x_dims_array, int *out_dims_array,
@@ -1465,43 +1682,12 @@ static void ElemwiseGradBroadcast1CPU(const T *x, const T *y, const T *out,
                                       const T *dout, int h, int w,
                                       bool is_xsize_larger, DX_OP dx_op,
                                       DY_OP dy_op, T *dx, T *dy) {
-  if (is_xsize_larger) {
-    for (int i = 0; i < h; ++i) {
-      for (int j = 0; j < w; ++j) {
-        int x_offset = i * w + j;
-        if (dx != nullptr) {
-          dx[x_offset] =
-              dx_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-        }
-        if (dy != nullptr) {
-          T tmp = dy_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-          if (i == 0) {
-            dy[j] = tmp;
-          } else {
-            dy[j] += tmp;
-          }
-        }
-      }
-    }
-  } else {  // x.dims < y.dims, broadcast for x.
-    for (int i = 0; i < h; ++i) {
-      for (int j = 0; j < w; ++j) {
-        int y_offset = i * w + j;
-        if (dy != nullptr) {
-          dy[y_offset] =
-              dy_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-        }
-        if (dx != nullptr) {
-          T tmp = dx_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-          if (i == 0) {
-            dx[j] = tmp;
-          } else {
-            dx[j] += tmp;
-          }
-        }
-      }
-    }
-  }
+  int large_dims[2] = {h, w};
+  int small_dims[2] = {1, w};
+  BroadcastGradCPU(x, y, out, dout, dx, dy,
+                   is_xsize_larger ? large_dims : small_dims,
+                   is_xsize_larger ? small_dims : large_dims, large_dims, 2,
+                   dx_op, dy_op);
 }
 
 #ifdef __NVCC__
@@ -1534,47 +1720,12 @@ static void ElemwiseGradBroadcast2CPU(const T *x, const T *y, const T *out,
                                       const T *dout, int pre, int n, int post,
                                       bool is_xsize_larger, DX_OP dx_op,
                                       DY_OP dy_op, T *dx, T *dy) {
-  if (is_xsize_larger) {
-    for (int i = 0; i < pre; ++i) {
-      for (int j = 0; j < n; ++j) {
-        for (int k = 0; k < post; ++k) {
-          int x_offset = i * n * post + j * post + k;
-          if (dx != nullptr) {
-            dx[x_offset] =
-                dx_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-          }
-          if (dy != nullptr) {
-            T tmp = dy_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-            if (i == 0 && k == 0) {
-              dy[j] = tmp;
-            } else {
-              dy[j] += tmp;
-            }
-          }
-        }
-      }
-    }
-  } else {  // x.dims < y.dims, broadcast for x.
-    for (int i = 0; i < pre; ++i) {
-      for (int j = 0; j < n; ++j) {
-        for (int k = 0; k < post; ++k) {
-          int y_offset = i * n * post + j * post + k;
-          if (dy != nullptr) {
-            dy[y_offset] =
-                dy_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-          }
-          if (dx != nullptr) {
-            T tmp = dx_op(x[j], y[y_offset], out[y_offset], dout[y_offset]);
-            if (i == 0 && k == 0) {
-              dx[j] = tmp;
-            } else {
-              dx[j] += tmp;
-            }
-          }
-        }
-      }
-    }
-  }
+  int large_dims[3] = {pre, n, post};
+  int small_dims[3] = {1, n, 1};
+  BroadcastGradCPU(x, y, out, dout, dx, dy,
+                   is_xsize_larger ? large_dims : small_dims,
+                   is_xsize_larger ? small_dims : large_dims, large_dims, 3,
+                   dx_op, dy_op);
 }
 
 #ifdef __NVCC__
@@ -1769,6 +1920,13 @@ void ElemwiseGradComputeWithBroadcast(
         ctx, x_dims, y_dims, x, y, out, dout, axis, dx, dy, dx_op, dy_op);
     return;
   }
+  // for inplace strategy. The CPU kernels clear dx before accumulating into
+  // it, which would clear dout too and get wrong result.
+  if (platform::is_cpu_place(ctx.GetPlace()) && dx &&
+      dx->IsSharedBufferWith(dout)) {
+    dx->clear();
+    dx->mutable_data<T>(x_dims, ctx.GetPlace());
+  }
   if (post == 1) {
     if (platform::is_gpu_place(ctx.GetPlace())) {
 #ifdef __NVCC__
@@ -1952,13 +2110,14 @@ void ElementwiseComputeEx(const framework::ExecutionContext &ctx,
 #endif
     return;
   }
-  if (post == 1) {
-    functor.RunRowWise(n, pre);
-    return;
-  } else {
-    functor.RunMidWise(n, pre, post);
-    return;
-  }
+  // x=[pre, n, post] with y=[n], or the reverse, on the CPU broadcast engine
+  int large_dims[3] = {pre, n, post};
+  int small_dims[3] = {1, n, 1};
+  CommonForwardBroadcastCPU<Functor, T, OutType>(
+      x, y, z, is_xsize_larger ? large_dims : small_dims,
+      is_xsize_larger ? small_dims : large_dims, large_dims, 3,
+      ctx.template device_context<platform::CPUDeviceContext>(), func,
+      is_xsize_larger);
 }
 
 // FusedElemwiseAndAct
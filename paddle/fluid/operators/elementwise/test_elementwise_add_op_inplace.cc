@@ -14,8 +14,10 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <random>
+#include <vector>
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
@@ -118,6 +120,65 @@ TEST(test_elementwise_add_not_inplace, cpu_place) {
   ASSERT_TRUE(TestMain<float>(p, dims, false));
 }
 
+// Computes the gradients of a bias-shaped Y, with dx sharing the buffer of
+// dout as the inplace pass does
+static bool TestBroadcastGradInplace(const framework::DDim &x_dims,
+                                     const framework::DDim &y_dims,
+                                     int axis) {
+  platform::CPUPlace place;
+  framework::Scope scope;
+  auto *x = scope.Var("x")->GetMutable<framework::LoDTensor>();
+  auto *y = scope.Var("y")->GetMutable<framework::LoDTensor>();
+  auto *dout = scope.Var("dout")->GetMutable<framework::LoDTensor>();
+  auto *dx = scope.Var("dx")->GetMutable<framework::LoDTensor>();
+  auto *dy = scope.Var("dy")->GetMutable<framework::LoDTensor>();
+
+  x->Resize(x_dims);
+  y->Resize(y_dims);
+  dout->Resize(x_dims);
+  x->mutable_data<float>(place);
+  y->mutable_data<float>(place);
+  auto *dout_ptr = dout->mutable_data<float>(place);
+  dx->Resize(x_dims);
+  dx->ShareBufferWith(*dout);
+
+  // y is broadcast over the pre and post dims of x
+  const int64_t n = framework::product(y_dims);
+  int64_t pre = 1;
+  for (int i = 0; i < axis; ++i) {
+    pre *= x_dims[i];
+  }
+  const int64_t post = framework::product(x_dims) / (pre * n);
+  std::vector<float> dout_data(framework::product(x_dims));
+  std::vector<float> dy_result(n, 0.f);
+  for (size_t i = 0; i < dout_data.size(); ++i) {
+    dout_data[i] = static_cast<float>(i % 7) - 3.f;
+    dy_result[(i / post) % n] += dout_data[i];
+  }
+  std::memcpy(dout_ptr, dout_data.data(), dout_data.size() * sizeof(float));
+
+  auto op = framework::OpRegistry::CreateOp(
+      "elementwise_add_grad",
+      {{"X", {"x"}}, {"Y", {"y"}}, {framework::GradVarName("Out"), {"dout"}}},
+      {{framework::GradVarName("X"), {"dx"}},
+       {framework::GradVarName("Y"), {"dy"}}},
+      {{"axis", axis}});
+  op->Run(scope, place);
+
+  auto *dx_ptr = dx->data<float>();
+  auto *dy_ptr = dy->data<float>();
+  return std::equal(dx_ptr, dx_ptr + dout_data.size(), dout_data.data()) &&
+         std::equal(dy_ptr, dy_ptr + n, dy_result.data());
+}
+
+TEST(test_elementwise_add_grad_inplace, broadcast_rows) {
+  ASSERT_TRUE(TestBroadcastGradInplace({32, 64}, {64}, 1));
+}
+
+TEST(test_elementwise_add_grad_inplace, broadcast_mid) {
+  ASSERT_TRUE(TestBroadcastGradInplace({4, 16, 8}, {16}, 1));
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(test_elementwise_add_inplace, gpu_place) {
   framework::DDim dims({32, 64});
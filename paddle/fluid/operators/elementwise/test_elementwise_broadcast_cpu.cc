@@ -0,0 +1,128 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
+
+namespace paddle {
+namespace operators {
+
+struct TestSubFunctor {
+  float operator()(float a, float b) const { return a - b; }
+};
+
+struct TestDxFunctor {
+  float operator()(float x, float y, float out, float dout) const {
+    return dout * y;
+  }
+};
+
+struct TestDyFunctor {
+  float operator()(float x, float y, float out, float dout) const {
+    return dout * x + out;
+  }
+};
+
+static void RandomFill(framework::Tensor *tensor) {
+  static std::mt19937 engine(2020);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  float *data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(engine);
+  }
+}
+
+// Compare the broadcast engine with walking every output element
+static void TestBroadcast(const std::vector<int> &x_shape,
+                          const std::vector<int> &y_shape) {
+  int max_dim = x_shape.size();
+  std::vector<int> x_dims(x_shape), y_dims(y_shape), out_dims(max_dim);
+  for (int i = 0; i < max_dim; ++i) {
+    out_dims[i] = std::max(x_dims[i], y_dims[i]);
+  }
+  auto to_ddim = [](const std::vector<int> &dims) {
+    return framework::make_ddim(std::vector<int64_t>(dims.begin(), dims.end()));
+  };
+
+  framework::Tensor x, y, out, dout, dx, dy;
+  x.Resize(to_ddim(x_dims));
+  y.Resize(to_ddim(y_dims));
+  dout.Resize(to_ddim(out_dims));
+  out.Resize(to_ddim(out_dims));
+  dx.Resize(to_ddim(x_dims));
+  dy.Resize(to_ddim(y_dims));
+  RandomFill(&x);
+  RandomFill(&y);
+  RandomFill(&dout);
+
+  platform::CPUDeviceContext ctx;
+  CommonForwardBroadcastCPU<TestSubFunctor, float>(
+      &x, &y, &out, x_dims.data(), y_dims.data(), out_dims.data(), max_dim,
+      ctx, TestSubFunctor());
+  CommonGradBroadcastCPU<float>(x, y, out, dout, &dx, &dy, x_dims.data(),
+                                y_dims.data(), out_dims.data(), max_dim, ctx,
+                                TestDxFunctor(), TestDyFunctor());
+
+  const float *x_data = x.data<float>();
+  const float *y_data = y.data<float>();
+  const float *out_data = out.data<float>();
+  const float *dout_data = dout.data<float>();
+  std::vector<float> dx_ref(x.numel(), 0.f), dy_ref(y.numel(), 0.f);
+  std::vector<int> index_array(max_dim, 0);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    int x_index =
+        GetElementwiseIndex(x_dims.data(), max_dim, index_array.data());
+    int y_index =
+        GetElementwiseIndex(y_dims.data(), max_dim, index_array.data());
+    ASSERT_EQ(out_data[i], x_data[x_index] - y_data[y_index]);
+    dx_ref[x_index] += TestDxFunctor()(x_data[x_index], y_data[y_index],
+                                       out_data[i], dout_data[i]);
+    dy_ref[y_index] += TestDyFunctor()(x_data[x_index], y_data[y_index],
+                                       out_data[i], dout_data[i]);
+    UpdateElementwiseIndexArray(out_dims.data(), max_dim, index_array.data());
+  }
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    ASSERT_NEAR(dx.data<float>()[i], dx_ref[i], 1e-3);
+  }
+  for (int64_t i = 0; i < y.numel(); ++i) {
+    ASSERT_NEAR(dy.data<float>()[i], dy_ref[i], 1e-3);
+  }
+}
+
+TEST(ElementwiseBroadcastCPU, NCHW) {
+  TestBroadcast({8, 16, 32, 32}, {1, 16, 1, 1});
+  TestBroadcast({8, 16, 32, 32}, {8, 16, 1, 1});
+  TestBroadcast({8, 16, 32, 32}, {1, 1, 32, 32});
+  TestBroadcast({8, 1, 32, 32}, {1, 16, 1, 1});
+}
+
+TEST(ElementwiseBroadcastCPU, BTH) {
+  TestBroadcast({4, 50, 256}, {1, 1, 256});
+  TestBroadcast({4, 50, 256}, {4, 50, 1});
+  TestBroadcast({4, 50, 256}, {4, 1, 256});
+  TestBroadcast({4, 1, 256}, {1, 50, 1});
+  TestBroadcast({1, 50, 1}, {4, 1, 256});
+}
+
+TEST(ElementwiseBroadcastCPU, Degenerate) {
+  TestBroadcast({1, 1, 1}, {1, 1, 1});
+  TestBroadcast({3, 1, 5}, {1, 1, 1});
+  TestBroadcast({1, 1, 1}, {3, 4, 5});
+  TestBroadcast({2, 3, 1, 5}, {2, 1, 4, 1});
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/fc_op.h"
 #include <vector>
+#include "paddle/fluid/framework/op_version_registry.h"
 
 namespace paddle {
 namespace operators {
@@ -121,6 +122,10 @@ class FCOpMaker : public framework::OpProtoAndCheckerMaker {
     AddInput("W", "(Tensor), The weight fc op with shape (I, O).");
     AddInput("Bias", "(Tensor, optional) Bias vector with shape (1 x O")
         .AsDispensable();
+    AddInput("PackedW",
+             "(Tensor, optional) W packed for MKL by gemm_weight_pack_pass, "
+             "used in place of W on CPU.")
+        .AsDispensable();
     AddOutput("Out",
               "(Tensor) The output tensor of fully connected operator. ");
     AddAttr<int>("in_num_col_dims",
@@ -188,3 +193,8 @@ REGISTER_OPERATOR(
 REGISTER_OP_CPU_KERNEL(
     fc, ops::FCOpKernel<paddle::platform::CPUDeviceContext, float>,
     ops::FCOpKernel<paddle::platform::CPUDeviceContext, double>);
+
+REGISTER_OP_VERSION(fc).AddCheckpoint(
+    R"ROC(Add the dispensable input `PackedW` of the pre-packed weights.)ROC",
+    paddle::framework::compatible::OpVersionDesc().NewInput(
+        "PackedW", "The weight W packed for MKL by gemm_weight_pack_pass."));
@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include "paddle/fluid/operators/conv_op.h"
@@ -125,6 +126,67 @@ class Conv2DFusionOp : public operators::ConvOp {
   }
 };
 
+// On CPU the bias, the residual and the activation are fused into the
+// direct convolution where it applies, and into one pass over the output of
+// the conv2d kernel otherwise.
+template <typename T>
+class Conv2DFusionCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* input = ctx.Input<Tensor>("Input");
+    auto* filter = ctx.Input<Tensor>("Filter");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* residual = ctx.Input<Tensor>("ResidualData");
+    auto* output = ctx.Output<Tensor>("Output");
+
+    std::vector<int> strides = ctx.Attr<std::vector<int>>("strides");
+    std::vector<int> paddings = ctx.Attr<std::vector<int>>("paddings");
+    std::vector<int> dilations = ctx.Attr<std::vector<int>>("dilations");
+    auto in_dims = input->dims();
+    auto filter_dims = filter->dims();
+    std::vector<int> ksize = framework::vectorize<int>(
+        framework::slice_ddim(filter_dims, 2, filter_dims.size()));
+    UpdatePaddingAndDilation(
+        &paddings, &dilations, ctx.Attr<std::string>("padding_algorithm"),
+        framework::slice_ddim(in_dims, 2, in_dims.size()), strides, ksize);
+
+    auto act =
+        math::GetConvDirectActivation(ctx.Attr<std::string>("activation"));
+    const T* residual_data = residual ? residual->data<T>() : nullptr;
+    auto out_dims = output->dims();
+    auto shape = GetConvDirectShape(in_dims, filter_dims, out_dims,
+                                    ctx.Attr<int>("groups"), strides,
+                                    paddings, dilations);
+    if (math::UseConvDirect(shape)) {
+      math::ConvDirectCPU<T>(shape, input->data<T>(), filter->data<T>(),
+                             bias->data<T>(), residual_data, act,
+                             output->mutable_data<T>(ctx.GetPlace()));
+    } else {
+      // Winograd or im2col and GEMM, as for conv2d
+      GemmConvKernel<platform::CPUDeviceContext, T>().Compute(ctx);
+      math::ConvBiasActivationCPU<T>(output->data<T>(), bias->data<T>(),
+                                     residual_data, act, out_dims[0],
+                                     out_dims[1], out_dims[2] * out_dims[3]);
+    }
+
+    std::vector<int> split_channels =
+        ctx.Attr<std::vector<int>>("split_channels");
+    if (split_channels.empty()) return;
+    auto outputs = ctx.MultiOutput<Tensor>("Outputs");
+    const int64_t plane = out_dims[2] * out_dims[3];
+    int64_t channel = 0;
+    for (size_t i = 0; i < split_channels.size(); ++i) {
+      T* dst = outputs[i]->mutable_data<T>(ctx.GetPlace());
+      for (int64_t n = 0; n < out_dims[0]; ++n) {
+        std::copy_n(output->data<T>() + (n * out_dims[1] + channel) * plane,
+                    split_channels[i] * plane,
+                    dst + n * split_channels[i] * plane);
+      }
+      channel += split_channels[i];
+    }
+  }
+};
+
 // TODO(qingqing): add gradient operator for conv2d_fusion
 
 }  // namespace operators
@@ -136,3 +198,5 @@ REGISTER_OPERATOR(
     ops::ConvOpInferVarType,
     paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
     paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(conv2d_fusion, ops::Conv2DFusionCPUKernel<float>,
+                       ops::Conv2DFusionCPUKernel<double>);
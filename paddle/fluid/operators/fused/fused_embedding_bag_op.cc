@@ -0,0 +1,209 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fused_embedding_bag_op.h"
+#include <memory>
+#include "paddle/fluid/framework/var_type_inference.h"
+
+namespace paddle {
+namespace operators {
+
+class FusedEmbeddingBagOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    OP_INOUT_CHECK(ctx->HasInput("W"), "Input", "W", "FusedEmbeddingBag");
+    OP_INOUT_CHECK(ctx->HasInputs("Ids"), "Input", "Ids", "FusedEmbeddingBag");
+    OP_INOUT_CHECK(ctx->HasOutputs("Out"), "Output", "Out",
+                   "FusedEmbeddingBag");
+    auto table_dims = ctx->GetInputDim("W");
+    auto ids_dims = ctx->GetInputsDim("Ids");
+    EmbeddingBagPoolType(ctx->Attrs().Get<std::string>("combiner"));
+
+    PADDLE_ENFORCE_EQ(table_dims.size(), 2,
+                      platform::errors::InvalidArgument(
+                          "The dim size of the input tensor 'W' should be 2. "
+                          "But received W's size = %d.",
+                          table_dims.size()));
+    PADDLE_ENFORCE_EQ(ctx->Outputs("Out").size(), ids_dims.size(),
+                      platform::errors::InvalidArgument(
+                          "Every slot of Input(Ids) should have an output, "
+                          "but received %d slots and %d outputs.",
+                          ids_dims.size(), ctx->Outputs("Out").size()));
+    for (size_t i = 0; i < ids_dims.size(); ++i) {
+      PADDLE_ENFORCE_EQ(
+          ids_dims[i][ids_dims[i].size() - 1], 1,
+          platform::errors::InvalidArgument(
+              "The last dimension of the input tensor 'Ids' should be 1. "
+              "But received size %d in slot %d.",
+              ids_dims[i][ids_dims[i].size() - 1], i));
+    }
+
+    if (!ctx->IsRuntime()) {
+      // in compile time, the lod level of ids must be 1
+      auto ids_descs = ctx->GetInputVarPtrs("Ids");
+      for (size_t i = 0; i < ids_descs.size(); ++i) {
+        auto* ids_desc = BOOST_GET(framework::VarDesc*, ids_descs[i]);
+        PADDLE_ENFORCE_EQ(
+            ids_desc->GetLoDLevel(), 1,
+            platform::errors::InvalidArgument(
+                "In compile time, the LoD Level of Ids should be 1. But "
+                "received LoD Level %d in slot %d.",
+                ids_desc->GetLoDLevel(), i));
+      }
+    }
+
+    // the batch size of every slot is known only from its LoD in run time
+    std::vector<framework::DDim> out_dims(
+        ids_dims.size(), framework::make_ddim({-1, table_dims[1]}));
+    ctx->SetOutputsDim("Out", out_dims);
+  }
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override {
+    auto data_type = OperatorWithKernel::IndicateVarDataType(ctx, "W");
+    return framework::OpKernelType(data_type, ctx.device_context());
+  }
+};
+
+class FusedEmbeddingBagOpMaker : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("W",
+             "(Tensor) The input represents embedding tensors, "
+             "which is a learnable parameter.");
+    AddInput("Ids",
+             "(LoDTensor) The int64 ids of every slot to be looked up in W, "
+             "one bag per sequence. The last dimension size must be 1.")
+        .AsDuplicable();
+    AddOutput("Out",
+              "(LoDTensor) The pooled embedding of every bag, one output "
+              "of shape [batch_size, width of W] for every slot.")
+        .AsDuplicable();
+    AddAttr<std::string>("combiner",
+                         "(string, default sum) "
+                         "How the embeddings of a bag are pooled: sum, mean "
+                         "or sqrt, which divides the sum by the square root "
+                         "of the bag length.")
+        .SetDefault("sum")
+        .InEnum({"sum", "mean", "sqrt"});
+    AddAttr<int64_t>("padding_idx",
+                     "(int64, default -1) "
+                     "If the value is -1, it makes no effect to lookup. "
+                     "Otherwise the given id is skipped, it neither adds to "
+                     "the bag nor counts in its length.")
+        .SetDefault(kEmbeddingBagNoPadding);
+    AddAttr<bool>("is_sparse",
+                  "(boolean, default false) "
+                  "Sparse update.")
+        .SetDefault(false);
+    AddAttr<bool>(framework::kAllKernelsMustComputeRuntimeShape,
+                  "Skip calling InferShape() function in the runtime.")
+        .SetDefault(true);
+    AddComment(R"DOC(
+FusedEmbeddingBag Operator.
+
+Looks up the embeddings of many slots at once and pools every sequence
+(bag) of ids into one row, in a single pass over the rows of W.
+
+The bags of all slots are processed in parallel, and the rows of the next
+bag are prefetched while the current one is pooled. An empty bag gives a
+row of zeros.
+
+The gradient of W is either dense or, with is_sparse, a SelectedRows whose
+rows are unique and sorted.
+
+)DOC");
+  }
+};
+
+class FusedEmbeddingBagOpGrad : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    auto table_dims = ctx->GetInputDim("W");
+    ctx->SetOutputDim(framework::GradVarName("W"), table_dims);
+  }
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override {
+    auto data_type = OperatorWithKernel::IndicateVarDataType(
+        ctx, framework::GradVarName("Out"));
+    return framework::OpKernelType(data_type, ctx.device_context());
+  }
+};
+
+class FusedEmbeddingBagOpGradVarTypeInference
+    : public framework::VarTypeInference {
+ public:
+  void operator()(framework::InferVarTypeContext* ctx) const override {
+    auto out_var_name = framework::GradVarName("W");
+    auto attr = ctx->GetAttr("is_sparse");
+    bool is_sparse = BOOST_GET(bool, attr);
+    if (is_sparse) {
+      VLOG(3) << "fused_embedding_bag_grad op " << framework::GradVarName("W")
+              << " is set to SelectedRows";
+      ctx->SetOutputType(out_var_name,
+                         framework::proto::VarType::SELECTED_ROWS);
+    } else {
+      VLOG(3) << "fused_embedding_bag_grad op " << framework::GradVarName("W")
+              << " is set to LoDTensor";
+      ctx->SetOutputType(out_var_name, framework::proto::VarType::LOD_TENSOR);
+    }
+    ctx->SetOutputDataType(out_var_name, ctx->GetInputDataType("W"));
+  }
+};
+
+DECLARE_NO_NEED_BUFFER_VARS_INFERER(FusedEmbeddingBagGradNoBufferVarsInferer,
+                                    "W");
+
+template <typename T>
+class FusedEmbeddingBagGradOpMaker : public framework::SingleGradOpMaker<T> {
+ public:
+  using framework::SingleGradOpMaker<T>::SingleGradOpMaker;
+
+ protected:
+  void Apply(GradOpPtr<T> op) const override {
+    op->SetType("fused_embedding_bag_grad");
+    op->SetInput("Ids", this->Input("Ids"));
+    op->SetInput("W", this->Input("W"));
+    op->SetInput(framework::GradVarName("Out"), this->OutputGrad("Out"));
+    op->SetOutput(framework::GradVarName("W"), this->InputGrad("W"));
+    op->SetAttrMap(this->Attrs());
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+
+REGISTER_OPERATOR(fused_embedding_bag, ops::FusedEmbeddingBagOp,
+                  ops::FusedEmbeddingBagGradOpMaker<paddle::framework::OpDesc>,
+                  ops::FusedEmbeddingBagGradOpMaker<paddle::imperative::OpBase>,
+                  ops::FusedEmbeddingBagOpMaker);
+REGISTER_OPERATOR(fused_embedding_bag_grad, ops::FusedEmbeddingBagOpGrad,
+                  ops::FusedEmbeddingBagGradNoBufferVarsInferer,
+                  ops::FusedEmbeddingBagOpGradVarTypeInference);
+
+REGISTER_OP_CPU_KERNEL(fused_embedding_bag,
+                       ops::FusedEmbeddingBagKernel<float>,
+                       ops::FusedEmbeddingBagKernel<double>);
+REGISTER_OP_CPU_KERNEL(fused_embedding_bag_grad,
+                       ops::FusedEmbeddingBagGradKernel<float>,
+                       ops::FusedEmbeddingBagGradKernel<double>);
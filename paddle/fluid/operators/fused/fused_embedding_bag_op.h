@@ -0,0 +1,300 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+
+namespace paddle {
+namespace operators {
+
+using LoDTensor = framework::LoDTensor;
+using SelectedRows = framework::SelectedRows;
+using DDim = framework::DDim;
+
+constexpr int64_t kEmbeddingBagNoPadding = -1;
+// The rows of the next bag are prefetched while the current one is pooled,
+// at most this many of them
+constexpr int64_t kEmbeddingBagPrefetchRows = 16;
+
+inline jit::SeqPoolType EmbeddingBagPoolType(const std::string& combiner) {
+  if (combiner == "mean") {
+    return jit::SeqPoolType::kAvg;
+  } else if (combiner == "sqrt") {
+    return jit::SeqPoolType::kSqrt;
+  }
+  PADDLE_ENFORCE_EQ(combiner, "sum",
+                    platform::errors::InvalidArgument(
+                        "The combiner of fused_embedding_bag should be sum, "
+                        "mean or sqrt, but received %s.",
+                        combiner));
+  return jit::SeqPoolType::kSum;
+}
+
+// All the bags of all the slots laid out back to back, with the padding ids
+// dropped: bag b holds ids[offset[b], offset[b + 1]).
+struct EmbeddingBags {
+  std::vector<int64_t> ids;
+  std::vector<size_t> offset;
+  // The first bag of every slot, one extra entry at the end
+  std::vector<size_t> slot_offset;
+
+  size_t size() const { return offset.size() - 1; }
+  int64_t length(size_t b) const {
+    return static_cast<int64_t>(offset[b + 1] - offset[b]);
+  }
+};
+
+// Checks the ids of every slot in one serial pass, so that the parallel
+// lookups and the gradient need no error handling.
+inline void FlattenEmbeddingBags(const std::vector<const LoDTensor*>& ids_t,
+                                 int64_t table_height, int64_t padding_idx,
+                                 EmbeddingBags* bags) {
+  size_t total_ids = 0;
+  size_t total_bags = 0;
+  for (size_t s = 0; s < ids_t.size(); ++s) {
+    const auto& lod = ids_t[s]->lod();
+    PADDLE_ENFORCE_EQ(lod.size(), 1UL,
+                      platform::errors::InvalidArgument(
+                          "The LoD level of Input(Ids) should be 1, but "
+                          "received LoD level %d in slot %d.",
+                          lod.size(), s));
+    PADDLE_ENFORCE_EQ(static_cast<size_t>(ids_t[s]->numel()), lod[0].back(),
+                      platform::errors::InvalidArgument(
+                          "Every id of Input(Ids) should be a row of its "
+                          "own, but slot %d has %d ids and LoD %s.",
+                          s, ids_t[s]->numel(), lod));
+    total_ids += lod[0].back();
+    total_bags += lod[0].size() - 1;
+  }
+
+  bags->ids.clear();
+  bags->ids.reserve(total_ids);
+  bags->offset.resize(total_bags + 1);
+  bags->slot_offset.resize(ids_t.size() + 1);
+  bags->offset[0] = 0;
+  bags->slot_offset[0] = 0;
+  size_t b = 0;
+  for (size_t s = 0; s < ids_t.size(); ++s) {
+    const auto& lod = ids_t[s]->lod()[0];
+    const int64_t* ids_data = ids_t[s]->data<int64_t>();
+    for (size_t i = 0; i + 1 < lod.size(); ++i) {
+      for (size_t j = lod[i]; j < lod[i + 1]; ++j) {
+        int64_t id = ids_data[j];
+        if (id == padding_idx) continue;
+        PADDLE_ENFORCE_EQ(id >= 0 && id < table_height, true,
+                          platform::errors::InvalidArgument(
+                              "The ids of slot %d should be in [0, %d), but "
+                              "received %d.",
+                              s, table_height, id));
+        bags->ids.push_back(id);
+      }
+      bags->offset[++b] = bags->ids.size();
+    }
+    bags->slot_offset[s + 1] = b;
+  }
+}
+
+template <typename T>
+inline void PrefetchEmbeddingRows(const T* table, int64_t width,
+                                  const int64_t* ids, int64_t len) {
+#if !defined(_WIN32)
+  constexpr int64_t kLine = 64 / sizeof(T);
+  len = std::min(len, kEmbeddingBagPrefetchRows);
+  for (int64_t i = 0; i < len; ++i) {
+    const T* row = table + ids[i] * width;
+    for (int64_t k = 0; k < width; k += kLine) {
+      __builtin_prefetch(row + k);
+    }
+  }
+#endif
+}
+
+template <typename T>
+inline T EmbeddingBagScale(jit::SeqPoolType type, int64_t len) {
+  if (type == jit::SeqPoolType::kAvg) {
+    return static_cast<T>(1) / static_cast<T>(len);
+  } else if (type == jit::SeqPoolType::kSqrt) {
+    return static_cast<T>(1) / std::sqrt(static_cast<T>(len));
+  }
+  return static_cast<T>(1);
+}
+
+template <typename T>
+class FusedEmbeddingBagKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& context) const override {
+    auto ids_t = context.MultiInput<LoDTensor>("Ids");
+    auto outs_t = context.MultiOutput<LoDTensor>("Out");
+    const LoDTensor* table_t = context.Input<LoDTensor>("W");
+    int64_t padding_idx = context.Attr<int64_t>("padding_idx");
+    auto pool_type =
+        EmbeddingBagPoolType(context.Attr<std::string>("combiner"));
+
+    int64_t table_height = table_t->dims()[0];
+    int64_t table_width = table_t->dims()[1];
+    const T* table = table_t->data<T>();
+
+    EmbeddingBags bags;
+    FlattenEmbeddingBags(ids_t, table_height, padding_idx, &bags);
+
+    std::vector<T*> bag_out(bags.size());
+    for (size_t s = 0; s < outs_t.size(); ++s) {
+      int64_t batch_size = bags.slot_offset[s + 1] - bags.slot_offset[s];
+      outs_t[s]->Resize({batch_size, table_width});
+      T* out = outs_t[s]->template mutable_data<T>(context.GetPlace());
+      for (int64_t i = 0; i < batch_size; ++i) {
+        bag_out[bags.slot_offset[s] + i] = out + i * table_width;
+      }
+    }
+
+    // The kernel only depends on the width and the pool type, fetch it before
+    // going parallel since the kernel cache is not thread safe
+    jit::emb_seq_pool_attr_t attr(table_height, table_width, 1, 1, table_width,
+                                  pool_type);
+    auto emb_seqpool =
+        jit::KernelFuncs<jit::EmbSeqPoolTuple<T>, platform::CPUPlace>::Cache()
+            .At(attr);
+
+    const int64_t num_bags = static_cast<int64_t>(bags.size());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t b = 0; b < num_bags; ++b) {
+      if (b + 1 < num_bags) {
+        PrefetchEmbeddingRows(table, table_width,
+                              bags.ids.data() + bags.offset[b + 1],
+                              bags.length(b + 1));
+      }
+      int64_t len = bags.length(b);
+      if (len == 0) {
+        std::memset(bag_out[b], 0, table_width * sizeof(T));
+        continue;
+      }
+      jit::emb_seq_pool_attr_t bag_attr(attr);
+      bag_attr.index_height = len;
+      emb_seqpool(table, bags.ids.data() + bags.offset[b], bag_out[b],
+                  &bag_attr);
+    }
+  }
+};
+
+template <typename T>
+class FusedEmbeddingBagGradKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& context) const override {
+    auto* table_var = context.InputVar("W");
+    DDim table_dim;
+    if (table_var->IsType<LoDTensor>()) {
+      table_dim = context.Input<LoDTensor>("W")->dims();
+    } else if (table_var->IsType<SelectedRows>()) {
+      table_dim = context.Input<SelectedRows>("W")->value().dims();
+    } else {
+      PADDLE_THROW(platform::errors::InvalidArgument(
+          "The parameter W of fused_embedding_bag must be either LoDTensor "
+          "or SelectedRows."));
+    }
+    auto ids_t = context.MultiInput<LoDTensor>("Ids");
+    auto d_outs_t =
+        context.MultiInput<LoDTensor>(framework::GradVarName("Out"));
+    int64_t padding_idx = context.Attr<int64_t>("padding_idx");
+    auto pool_type =
+        EmbeddingBagPoolType(context.Attr<std::string>("combiner"));
+    int64_t width = table_dim[1];
+
+    EmbeddingBags bags;
+    FlattenEmbeddingBags(ids_t, table_dim[0], padding_idx, &bags);
+
+    std::vector<const T*> bag_d_out(bags.size());
+    for (size_t s = 0; s < d_outs_t.size(); ++s) {
+      const T* d_out = d_outs_t[s]->data<T>();
+      for (size_t b = bags.slot_offset[s]; b < bags.slot_offset[s + 1]; ++b) {
+        bag_d_out[b] = d_out + (b - bags.slot_offset[s]) * width;
+      }
+    }
+
+    // The touched rows, sorted and unique, so the gradient is merged already
+    std::vector<int64_t> rows(bags.ids);
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // For every row the bags it appears in, by counting sort
+    std::vector<size_t> row_offset(rows.size() + 1, 0);
+    std::vector<size_t> row_pos(bags.ids.size());
+    for (size_t i = 0; i < bags.ids.size(); ++i) {
+      row_pos[i] = std::lower_bound(rows.begin(), rows.end(), bags.ids[i]) -
+                   rows.begin();
+      ++row_offset[row_pos[i] + 1];
+    }
+    for (size_t r = 0; r < rows.size(); ++r) {
+      row_offset[r + 1] += row_offset[r];
+    }
+    std::vector<size_t> row_bags(bags.ids.size());
+    std::vector<size_t> fill(row_offset.begin(), row_offset.end() - 1);
+    for (size_t b = 0; b < bags.size(); ++b) {
+      for (size_t i = bags.offset[b]; i < bags.offset[b + 1]; ++i) {
+        row_bags[fill[row_pos[i]]++] = b;
+      }
+    }
+
+    T* d_table_data = nullptr;
+    bool is_sparse = context.Attr<bool>("is_sparse");
+    if (is_sparse) {
+      auto* d_table = context.Output<SelectedRows>(framework::GradVarName("W"));
+      d_table->set_height(table_dim[0]);
+      d_table->set_rows(rows);
+      auto* d_table_value = d_table->mutable_value();
+      d_table_value->Resize(
+          {static_cast<int64_t>(rows.size()), static_cast<int64_t>(width)});
+      d_table_data = d_table_value->mutable_data<T>(context.GetPlace());
+    } else {
+      auto* d_table = context.Output<LoDTensor>(framework::GradVarName("W"));
+      d_table->Resize(table_dim);
+      d_table_data = d_table->mutable_data<T>(context.GetPlace());
+      std::memset(d_table_data, 0, d_table->numel() * sizeof(T));
+    }
+
+    // Every row is owned by one iteration, so there is nothing to lock
+    const int64_t num_rows = static_cast<int64_t>(rows.size());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t r = 0; r < num_rows; ++r) {
+      T* dst = d_table_data + (is_sparse ? r : rows[r]) * width;
+      if (is_sparse) {
+        std::memset(dst, 0, width * sizeof(T));
+      }
+      for (size_t i = row_offset[r]; i < row_offset[r + 1]; ++i) {
+        size_t b = row_bags[i];
+        T scale = EmbeddingBagScale<T>(pool_type, bags.length(b));
+        const T* src = bag_d_out[b];
+        for (int64_t k = 0; k < width; ++k) {
+          dst[k] += scale * src[k];
+        }
+      }
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
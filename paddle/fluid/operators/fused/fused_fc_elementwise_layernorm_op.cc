@@ -12,7 +12,10 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <string>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/norm_cpu.h"
 
 namespace paddle {
 namespace operators {
@@ -175,6 +178,47 @@ add_out <= elementwise_add(fc_out, Y)
   }
 };
 
+template <typename T>
+class FusedFCElementwiseLayerNormCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto *x = ctx.Input<framework::Tensor>("X");
+    auto *w = ctx.Input<framework::Tensor>("W");
+    auto *y = ctx.Input<framework::Tensor>("Y");
+    auto *bias_0 = ctx.Input<framework::Tensor>("Bias0");
+    auto *bias_1 = ctx.Input<framework::Tensor>("Bias1");
+    auto *scale = ctx.Input<framework::Tensor>("Scale");
+    auto *out = ctx.Output<framework::Tensor>("Out");
+    auto *mean = ctx.Output<framework::Tensor>("Mean");
+    auto *variance = ctx.Output<framework::Tensor>("Variance");
+
+    auto w_dims = w->dims();
+    int N = w_dims[1];
+    int K = w_dims[0];
+    int M = framework::product(x->dims()) / K;
+
+    T* out_data = out->mutable_data<T>(ctx.GetPlace());
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(dev_ctx);
+    blas.GEMM(false, false, M, N, K, static_cast<T>(1.0), x->data<T>(), K,
+              w->data<T>(), N, static_cast<T>(0.0), out_data, N);
+
+    // The bias, activation and residual add are applied in the first pass
+    // of the normalization, while the row is read for its mean
+    math::LayerNormInput<T> in;
+    in.x = out_data;
+    in.bias0 = bias_0 ? bias_0->data<T>() : nullptr;
+    in.residual = y->data<T>();
+    in.relu = ctx.Attr<std::string>("activation_type") == "relu";
+    math::LayerNormCPU(
+        in, scale ? scale->data<T>() : nullptr,
+        bias_1 ? bias_1->data<T>() : nullptr, out_data,
+        mean ? mean->mutable_data<T>(ctx.GetPlace()) : nullptr,
+        variance ? variance->mutable_data<T>(ctx.GetPlace()) : nullptr, M, N,
+        ctx.Attr<float>("epsilon"));
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -184,3 +228,6 @@ REGISTER_OPERATOR(
     ops::FusedFCElementwiseLayerNormOpMaker,
     paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
     paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(fused_fc_elementwise_layernorm,
+                       ops::FusedFCElementwiseLayerNormCPUKernel<float>,
+                       ops::FusedFCElementwiseLayerNormCPUKernel<double>);
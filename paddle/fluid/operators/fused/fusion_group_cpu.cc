@@ -0,0 +1,236 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fusion_group_cpu.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace fusion_group {
+
+CPUElementwiseProgram::CPUElementwiseProgram(const std::string& code) {
+  // The operations by name, with their number of operands
+  static const std::unordered_map<std::string, std::pair<OpCode, size_t>> ops{
+      {"add", {OpCode::kAdd, 2}},         {"sub", {OpCode::kSub, 2}},
+      {"mul", {OpCode::kMul, 2}},         {"div", {OpCode::kDiv, 2}},
+      {"min", {OpCode::kMin, 2}},         {"max", {OpCode::kMax, 2}},
+      {"relu", {OpCode::kRelu, 1}},       {"sigmoid", {OpCode::kSigmoid, 1}},
+      {"tanh", {OpCode::kTanh, 1}},       {"sqrt", {OpCode::kSqrt, 1}},
+      {"square", {OpCode::kSquare, 1}},   {"copy", {OpCode::kCopy, 1}},
+      {"scale", {OpCode::kScale, 1}}};
+
+  std::istringstream lines(code);
+  std::string line;
+  auto parse_operand = [&](const std::string& token) -> Operand {
+    const bool is_valid =
+        token.size() > 1 && std::string("xyt").find(token[0]) !=
+                                std::string::npos &&
+        std::all_of(token.begin() + 1, token.end(), ::isdigit);
+    PADDLE_ENFORCE_EQ(is_valid, true,
+                      platform::errors::InvalidArgument(
+                          "Invalid operand %s in the statement `%s`.", token,
+                          line));
+    Operand operand{token[0], std::stoi(token.substr(1))};
+    int* count = operand.kind == 'x'
+                     ? &num_inputs_
+                     : (operand.kind == 'y' ? &num_outputs_ : &num_temps_);
+    *count = std::max(*count, operand.index + 1);
+    return operand;
+  };
+
+  while (std::getline(lines, line)) {
+    std::istringstream stream(line);
+    std::vector<std::string> tokens{std::istream_iterator<std::string>(stream),
+                                    std::istream_iterator<std::string>()};
+    if (tokens.empty() || tokens[0].compare(0, 2, "//") == 0) continue;
+    PADDLE_ENFORCE_EQ(tokens.size() >= 3 && tokens[1] == "=", true,
+                      platform::errors::InvalidArgument(
+                          "Expected a statement `dst = operation operands`, "
+                          "but received `%s`.",
+                          line));
+    auto iter = ops.find(tokens[2]);
+    PADDLE_ENFORCE_NE(iter, ops.end(),
+                      platform::errors::Unimplemented(
+                          "Operation %s is not supported on CPU yet.",
+                          tokens[2]));
+    Statement stmt;
+    stmt.op = iter->second.first;
+    const size_t num_srcs = iter->second.second;
+    const size_t num_attrs = stmt.op == OpCode::kScale ? 2 : 0;
+    PADDLE_ENFORCE_EQ(tokens.size(), 3 + num_srcs + num_attrs,
+                      platform::errors::InvalidArgument(
+                          "Operation %s expects %d operands, but received "
+                          "the statement `%s`.",
+                          tokens[2], num_srcs + num_attrs, line));
+    stmt.dst = parse_operand(tokens[0]);
+    PADDLE_ENFORCE_NE(stmt.dst.kind, 'x',
+                      platform::errors::InvalidArgument(
+                          "The inputs are read only, but the statement `%s` "
+                          "writes one.",
+                          line));
+    for (size_t i = 0; i < num_srcs; ++i) {
+      stmt.srcs.push_back(parse_operand(tokens[3 + i]));
+    }
+    if (stmt.op == OpCode::kScale) {
+      stmt.scale = std::stod(tokens[4]);
+      stmt.bias = std::stod(tokens[5]);
+    }
+    statements_.push_back(std::move(stmt));
+  }
+  PADDLE_ENFORCE_GT(statements_.size(), 0UL,
+                    platform::errors::InvalidArgument(
+                        "The code of fusion_group has no statements."));
+}
+
+const CPUElementwiseProgram& CPUElementwiseProgram::Get(
+    const std::string& code) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string,
+                            std::unique_ptr<CPUElementwiseProgram>>
+      programs;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& program = programs[code];
+  if (program == nullptr) {
+    program.reset(new CPUElementwiseProgram(code));
+  }
+  return *program;
+}
+
+template <typename T>
+void CPUElementwiseProgram::RunTile(const Statement& stmt, T* dst, const T* x,
+                                    const T* y, int len) const {
+  using platform::CPUPlace;
+  switch (stmt.op) {
+    case OpCode::kAdd:
+      jit::KernelFuncs<jit::VAddTuple<T>, CPUPlace>::Cache().At(len)(x, y, dst,
+                                                                     len);
+      break;
+    case OpCode::kSub:
+      jit::KernelFuncs<jit::VSubTuple<T>, CPUPlace>::Cache().At(len)(x, y, dst,
+                                                                     len);
+      break;
+    case OpCode::kMul:
+      jit::KernelFuncs<jit::VMulTuple<T>, CPUPlace>::Cache().At(len)(x, y, dst,
+                                                                     len);
+      break;
+    case OpCode::kDiv:
+      for (int i = 0; i < len; ++i) dst[i] = x[i] / y[i];
+      break;
+    case OpCode::kMin:
+      for (int i = 0; i < len; ++i) dst[i] = x[i] < y[i] ? x[i] : y[i];
+      break;
+    case OpCode::kMax:
+      for (int i = 0; i < len; ++i) dst[i] = x[i] > y[i] ? x[i] : y[i];
+      break;
+    case OpCode::kRelu:
+      jit::KernelFuncs<jit::VReluTuple<T>, CPUPlace>::Cache().At(len)(x, dst,
+                                                                      len);
+      break;
+    case OpCode::kSigmoid:
+      jit::KernelFuncs<jit::VSigmoidTuple<T>, CPUPlace>::Cache().At(len)(
+          x, dst, len);
+      break;
+    case OpCode::kTanh:
+      jit::KernelFuncs<jit::VTanhTuple<T>, CPUPlace>::Cache().At(len)(x, dst,
+                                                                      len);
+      break;
+    case OpCode::kSqrt:
+      for (int i = 0; i < len; ++i) dst[i] = std::sqrt(x[i]);
+      break;
+    case OpCode::kSquare:
+      jit::KernelFuncs<jit::VSquareTuple<T>, CPUPlace>::Cache().At(len)(
+          x, dst, len);
+      break;
+    case OpCode::kCopy:
+      if (dst != x) std::memcpy(dst, x, len * sizeof(T));
+      break;
+    case OpCode::kScale: {
+      const T scale = static_cast<T>(stmt.scale);
+      const T bias = static_cast<T>(stmt.bias);
+      if (scale != static_cast<T>(1)) {
+        jit::KernelFuncs<jit::VScalTuple<T>, CPUPlace>::Cache().At(len)(
+            &scale, x, dst, len);
+      } else if (dst != x) {
+        std::memcpy(dst, x, len * sizeof(T));
+      }
+      if (bias != static_cast<T>(0)) {
+        jit::KernelFuncs<jit::VAddBiasTuple<T>, CPUPlace>::Cache().At(len)(
+            &bias, dst, dst, len);
+      }
+      break;
+    }
+  }
+}
+
+template <typename T>
+void CPUElementwiseProgram::Run(int64_t n, const std::vector<const T*>& ins,
+                                const std::vector<T*>& outs) const {
+  PADDLE_ENFORCE_GE(ins.size(), static_cast<size_t>(num_inputs_),
+                    platform::errors::InvalidArgument(
+                        "The code reads %d inputs, but received %d.",
+                        num_inputs_, ins.size()));
+  PADDLE_ENFORCE_GE(outs.size(), static_cast<size_t>(num_outputs_),
+                    platform::errors::InvalidArgument(
+                        "The code writes %d outputs, but received %d.",
+                        num_outputs_, outs.size()));
+  const int64_t num_tiles = (n + kTileSize - 1) / kTileSize;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel if (num_tiles > 1)
+#endif
+  {
+    std::vector<T> temps(static_cast<size_t>(num_temps_) * kTileSize);
+    auto data = [&](const Operand& operand, int64_t begin) -> T* {
+      if (operand.kind == 'x') {
+        return const_cast<T*>(ins[operand.index]) + begin;
+      } else if (operand.kind == 'y') {
+        return outs[operand.index] + begin;
+      }
+      return temps.data() + operand.index * kTileSize;
+    };
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+    for (int64_t tile = 0; tile < num_tiles; ++tile) {
+      const int64_t begin = tile * kTileSize;
+      const int len =
+          static_cast<int>(std::min<int64_t>(kTileSize, n - begin));
+      for (const auto& stmt : statements_) {
+        const T* y = stmt.srcs.size() > 1 ? data(stmt.srcs[1], begin) : nullptr;
+        RunTile(stmt, data(stmt.dst, begin), data(stmt.srcs[0], begin), y,
+                len);
+      }
+    }
+  }
+}
+
+template void CPUElementwiseProgram::Run<float>(
+    int64_t n, const std::vector<const float*>& ins,
+    const std::vector<float*>& outs) const;
+template void CPUElementwiseProgram::Run<double>(
+    int64_t n, const std::vector<const double*>& ins,
+    const std::vector<double*>& outs) const;
+
+}  // namespace fusion_group
+}  // namespace operators
+}  // namespace paddle
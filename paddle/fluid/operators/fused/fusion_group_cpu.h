@@ -0,0 +1,107 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace operators {
+namespace fusion_group {
+
+/*
+ * The CPU code of a fusion_group op of elementwise operations, generated by
+ * the CPUCodeGenerator of fusion_group_pass. The code has one statement per
+ * line, in the order of execution:
+ *
+ *   // comment
+ *   t0 = add x0 x1
+ *   t0 = relu t0
+ *   y0 = scale t0 2 0.5
+ *
+ * where xi is the i-th input of the op, yj its j-th output and tk a
+ * temporary. The operations are add, sub, mul, div, min, max of two
+ * operands, relu, sigmoid, tanh, sqrt, square, copy of one operand, and
+ * scale x a b, which is a * x + b.
+ *
+ * The program runs over tiles of the inputs small enough for the
+ * temporaries to stay in the L1 cache, so that the inputs are read and the
+ * outputs written once, however many operations there are. The tiles are
+ * run in parallel, and each operation on a tile by a JIT kernel if there is
+ * one.
+ */
+class CPUElementwiseProgram {
+ public:
+  explicit CPUElementwiseProgram(const std::string& code);
+
+  // The program of the code, compiled at the first call
+  static const CPUElementwiseProgram& Get(const std::string& code);
+
+  template <typename T>
+  void Run(int64_t n, const std::vector<const T*>& ins,
+           const std::vector<T*>& outs) const;
+
+  int num_inputs() const { return num_inputs_; }
+  int num_outputs() const { return num_outputs_; }
+  int num_temps() const { return num_temps_; }
+
+  static constexpr int kTileSize = 1024;
+
+ private:
+  enum class OpCode {
+    kAdd,
+    kSub,
+    kMul,
+    kDiv,
+    kMin,
+    kMax,
+    kRelu,
+    kSigmoid,
+    kTanh,
+    kSqrt,
+    kSquare,
+    kCopy,
+    kScale,
+  };
+
+  struct Operand {
+    char kind;  // 'x' for the inputs, 'y' for the outputs, 't' for temps
+    int index;
+  };
+
+  struct Statement {
+    OpCode op;
+    Operand dst;
+    std::vector<Operand> srcs;
+    double scale{1.0};
+    double bias{0.0};
+  };
+
+  template <typename T>
+  void RunTile(const Statement& stmt, T* dst, const T* x, const T* y,
+               int len) const;
+
+  std::vector<Statement> statements_;
+  int num_inputs_{0};
+  int num_outputs_{0};
+  int num_temps_{0};
+
+  DISABLE_COPY_AND_ASSIGN(CPUElementwiseProgram);
+};
+
+}  // namespace fusion_group
+}  // namespace operators
+}  // namespace paddle
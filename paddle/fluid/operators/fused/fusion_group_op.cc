@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/fused/fusion_group_op.h"
+#include "paddle/fluid/framework/op_version_registry.h"
 
 namespace paddle {
 namespace operators {
@@ -71,6 +72,17 @@ class FusionGroupOp : public framework::OperatorWithKernel {
  protected:
   framework::OpKernelType GetExpectedKernelType(
       const framework::ExecutionContext& ctx) const override {
+    if (platform::is_cpu_place(ctx.GetPlace())) {
+      // The CPU kernel runs on the data type of the generated code
+      const auto& outs_dtype = ctx.Attr<std::vector<int>>("outs_dtype");
+      PADDLE_ENFORCE_GT(
+          outs_dtype.size(), 0UL,
+          platform::errors::InvalidArgument(
+              "The data type of the outputs of fusion_group is not set."));
+      return framework::OpKernelType(
+          static_cast<framework::proto::VarType::Type>(outs_dtype[0]),
+          ctx.GetPlace());
+    }
     return framework::OpKernelType(framework::proto::VarType::FP32,
                                    platform::CUDAPlace(0));
   };
@@ -94,11 +106,17 @@ class FusionGroupOpMaker : public framework::OpProtoAndCheckerMaker {
     AddAttr<int>("type", "Fusion type.").SetDefault(0);
     AddAttr<std::string>("func_name", "Name of the generated functions.")
         .SetDefault("");
+    AddAttr<std::string>("code",
+                         "The generated code run by the CPU kernel, empty "
+                         "when the op is generated for GPU.")
+        .SetDefault("");
     AddComment(R"DOC(
 fusion_group Operator.
 
 It is used to execute a generated CUDA kernel which fuse the computation of
-multiple operators into one. It supports several types:
+multiple operators into one, or on CPU, the generated code of the attribute
+`code`, which computes them in one pass over the memory. It supports several
+types:
 0, fused computation of elementwise operations in which all the dims of inputs
     and outputs should be exactly the same.
 )DOC");
@@ -110,3 +128,12 @@ multiple operators into one. It supports several types:
 
 namespace ops = paddle::operators;
 REGISTER_OPERATOR(fusion_group, ops::FusionGroupOp, ops::FusionGroupOpMaker);
+REGISTER_OP_CPU_KERNEL(
+    fusion_group,
+    ops::FusionGroupKernel<paddle::platform::CPUDeviceContext, float>,
+    ops::FusionGroupKernel<paddle::platform::CPUDeviceContext, double>);
+
+REGISTER_OP_VERSION(fusion_group).AddCheckpoint(
+    R"ROC(Add the attribute `code` of the generated CPU code.)ROC",
+    paddle::framework::compatible::OpVersionDesc().NewAttr(
+        "code", "The generated code run by the CPU kernel.", std::string("")));
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/fused/fusion_group_cpu.h"
 #include "paddle/fluid/platform/device_code.h"
 
 namespace paddle {
@@ -88,5 +89,51 @@ class FusionGroupKernel : public framework::OpKernel<T> {
   }
 };
 
+// On CPU, the code generated by fusion_group_pass is carried by the op
+template <typename T>
+class FusionGroupKernel<platform::CPUDeviceContext, T>
+    : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto ins = ctx.MultiInput<framework::LoDTensor>("Inputs");
+    auto outs = ctx.MultiOutput<framework::LoDTensor>("Outs");
+    const auto& code = ctx.Attr<std::string>("code");
+    PADDLE_ENFORCE_EQ(
+        code.empty(), false,
+        platform::errors::Unimplemented(
+            "The fusion_group op %s has no CPU code. It is only generated "
+            "when fusion_group_pass runs for CPU.",
+            ctx.Attr<std::string>("func_name")));
+
+    // The code runs elementwise over the inputs of one data type
+    const auto dtype = framework::DataTypeTrait<T>::DataType();
+    const int64_t numel = ins[0]->numel();
+    std::vector<const T*> in_data;
+    for (size_t i = 0; i < ins.size(); ++i) {
+      PADDLE_ENFORCE_EQ(
+          ins[i]->type(), dtype,
+          platform::errors::InvalidArgument(
+              "The data type of the input %d of the fusion_group op %s is %s, "
+              "but the CPU code runs in %s.",
+              i, ctx.Attr<std::string>("func_name"),
+              framework::DataTypeToString(ins[i]->type()),
+              framework::DataTypeToString(dtype)));
+      PADDLE_ENFORCE_EQ(
+          ins[i]->numel(), numel,
+          platform::errors::InvalidArgument(
+              "The numel of the input %d of the fusion_group op %s is %d, "
+              "but that of the input 0 is %d.",
+              i, ctx.Attr<std::string>("func_name"), ins[i]->numel(), numel));
+      in_data.push_back(ins[i]->data<T>());
+    }
+    std::vector<T*> out_data;
+    for (auto* out : outs) {
+      out_data.push_back(out->mutable_data<T>(ctx.GetPlace()));
+    }
+    fusion_group::CPUElementwiseProgram::Get(code).Run(numel, in_data,
+                                                       out_data);
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
@@ -90,6 +90,7 @@ framework::OpDesc* CreateFusionGroupOp(
   return op;
 }
 
+#ifdef PADDLE_WITH_CUDA
 void PrepareDeviceCode(platform::Place place, std::string func_name,
                        std::string cuda_kernel_str) {
   paddle::platform::DeviceCodePool& pool =
@@ -100,6 +101,7 @@ void PrepareDeviceCode(platform::Place place, std::string func_name,
   code->Compile();
   pool.Set(std::move(code));
 }
+#endif
 
 void CheckOutputs(framework::Scope* scope,
                   const std::vector<std::string>& output_names,
@@ -134,20 +136,28 @@ void CheckOutputs(framework::Scope* scope,
   }
 }
 
-void TestMain(const std::vector<std::string>& input_names,
+void TestMain(const platform::Place& place,
+              const std::vector<std::string>& input_names,
               const std::vector<std::vector<int64_t>>& input_shapes,
               const std::vector<std::string>& output_names, int type,
-              std::string func_name, std::string cuda_kernel_str,
+              std::string func_name, std::string kernel_str,
               CPUKernelFunc cpu_kernel_func) {
-  // Compile the device code
-  paddle::framework::InitDevices(false, {0});
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  PrepareDeviceCode(place, func_name, cuda_kernel_str);
-
   // Create a ProgramDesc that has a fusion_group_op.
   framework::ProgramDesc program;
   framework::OpDesc* op_desc = CreateFusionGroupOp(
       &program, input_names, input_shapes, output_names, type, func_name);
+
+  if (platform::is_gpu_place(place)) {
+#ifdef PADDLE_WITH_CUDA
+    // Compile the device code
+    paddle::framework::InitDevices(false, {0});
+    PrepareDeviceCode(place, func_name, kernel_str);
+#endif
+  } else {
+    // The CPU kernel runs the code of the op
+    paddle::framework::InitDevices(false, {});
+    op_desc->SetAttr("code", kernel_str);
+  }
   auto fusion_group_op = framework::OpRegistry::CreateOp(*op_desc);
 
   framework::Scope scope;
@@ -177,6 +187,7 @@ void TestMain(const std::vector<std::string>& input_names,
                cpu_kernel_func);
 }
 
+#ifdef PADDLE_WITH_CUDA
 TEST(FusionGroupOp, elementwise) {
   if (!platform::dynload::HasNVRTC() || !platform::dynload::HasCUDADriver()) {
     return;
@@ -217,11 +228,42 @@ void elementwise_cuda_kernel_0(size_t n, float *x, float* y, float* z) {
     }
   };
 
-  TestMain(input_names, input_shapes, output_names, 0,
+  TestMain(platform::CUDAPlace(0), input_names, input_shapes, output_names, 0,
            "elementwise_cuda_kernel_0", kernel, elementwise_cpu_kernel_0);
 }
+#endif
+
+TEST(FusionGroupOp, elementwise_cpu) {
+  // z = relu(x + y), w = 2 * (x + y) + 0.5
+  std::vector<std::string> input_names = {"x", "y"};
+  std::vector<std::string> output_names = {"z", "w"};
+  // Not a multiple of the tile size
+  std::vector<std::vector<int64_t>> input_shapes = {{100, 37}, {100, 37}};
+  constexpr auto code = R"(
+// elementwise_cpu_kernel_0
+t0 = add x0 x1
+y0 = relu t0
+y1 = scale t0 2 0.5
+)";
+
+  auto elementwise_cpu_kernel_0 = [](size_t n,
+                                     std::vector<void*> args) -> void {
+    float* x = static_cast<float*>(args[0]);
+    float* y = static_cast<float*>(args[1]);
+    float* z = static_cast<float*>(args[2]);
+    float* w = static_cast<float*>(args[3]);
+    for (size_t i = 0; i < n; ++i) {
+      float tmp_0 = x[i] + y[i];
+      z[i] = tmp_0 > 0 ? tmp_0 : 0;
+      w[i] = 2 * tmp_0 + 0.5;
+    }
+  };
+
+  TestMain(platform::CPUPlace(), input_names, input_shapes, output_names, 0,
+           "elementwise_cpu_kernel_0", code, elementwise_cpu_kernel_0);
+}
 
 }  // namespace operators
 }  // namespace paddle
 
-USE_CUDA_ONLY_OP(fusion_group);
+USE_OP(fusion_group);
@@ -16,6 +16,7 @@ limitations under the License. */
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/math_function.h"
 
 namespace paddle {
 namespace operators {
@@ -80,6 +81,46 @@ class TransposeFlattenConcatFusionOp : public framework::OperatorWithKernel {
   }
 };
 
+template <typename T>
+class TransposeFlattenConcatFusionCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto ins = ctx.MultiInput<framework::Tensor>("X");
+    auto *out = ctx.Output<framework::Tensor>("Out");
+    out->mutable_data<T>(ctx.GetPlace());
+    auto odims = out->dims();
+
+    std::vector<int> trans_axis = ctx.Attr<std::vector<int>>("trans_axis");
+    int flatten_axis = ctx.Attr<int>("flatten_axis");
+    int concat_axis = ctx.Attr<int>("concat_axis");
+
+    int rank = ins[0]->dims().size();
+    std::vector<int64_t> stride_y(rank, 1);
+    T *odata = out->data<T>();
+    for (size_t k = 0; k < ins.size(); ++k) {
+      auto perm_shape = GetPermuteShape(trans_axis, ins[k]->dims());
+      // Each input is transposed straight into its slice of the output, when
+      // concat_axis is 1 the rows of the slice are odims[1] apart.
+      for (int i = rank - 2; i >= 0; i--) {
+        if (((i + 1) == flatten_axis) && (concat_axis == 1)) {
+          stride_y[i] = odims[1];
+        } else {
+          stride_y[i] = stride_y[i + 1] * perm_shape[i + 1];
+        }
+      }
+      math::TransposeCPU(ins[k]->data<T>(), odata, sizeof(T),
+                         framework::vectorize(ins[k]->dims()), trans_axis,
+                         stride_y);
+      if (concat_axis == 0) {
+        odata += ins[k]->numel();
+      } else {
+        auto flat_shape = GetFlattenShape(flatten_axis, perm_shape);
+        odata += flat_shape[1];
+      }
+    }
+  }
+};
+
 class TransposeFlattenConcatFusionOpMaker
     : public framework::OpProtoAndCheckerMaker {
  public:
@@ -121,3 +162,6 @@ REGISTER_OPERATOR(
     ops::TransposeFlattenConcatFusionOpMaker,
     paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
     paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(fusion_transpose_flatten_concat,
+                       ops::TransposeFlattenConcatFusionCPUKernel<float>,
+                       ops::TransposeFlattenConcatFusionCPUKernel<double>);
@@ -0,0 +1,133 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/norm_cpu.h"
+
+namespace paddle {
+namespace operators {
+
+class SkipLayerNormOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext *ctx) const override {
+    OP_INOUT_CHECK(ctx->HasInput("X"), "Input", "X", "SkipLayerNorm");
+    OP_INOUT_CHECK(ctx->HasInput("Y"), "Input", "Y", "SkipLayerNorm");
+    OP_INOUT_CHECK(ctx->HasInput("Scale"), "Input", "Scale", "SkipLayerNorm");
+    OP_INOUT_CHECK(ctx->HasInput("Bias"), "Input", "Bias", "SkipLayerNorm");
+    OP_INOUT_CHECK(ctx->HasOutput("Out"), "Output", "Out", "SkipLayerNorm");
+
+    auto x_dims = ctx->GetInputDim("X");
+    auto y_dims = ctx->GetInputDim("Y");
+    PADDLE_ENFORCE_EQ(x_dims, y_dims,
+                      platform::errors::InvalidArgument(
+                          "The shapes of Input(X) and Input(Y) of "
+                          "skip_layernorm should be the same, but received "
+                          "X's shape [%s] and Y's shape [%s].",
+                          x_dims, y_dims));
+
+    int begin_norm_axis = ctx->Attrs().Get<int>("begin_norm_axis");
+    PADDLE_ENFORCE_LT(begin_norm_axis, x_dims.size(),
+                      platform::errors::InvalidArgument(
+                          "'begin_norm_axis' must be less than the rank of "
+                          "Input(X), but received %d and rank %d.",
+                          begin_norm_axis, x_dims.size()));
+    if (ctx->IsRuntime()) {
+      auto width = framework::flatten_to_2d(x_dims, begin_norm_axis)[1];
+      PADDLE_ENFORCE_EQ(framework::product(ctx->GetInputDim("Scale")), width,
+                        platform::errors::InvalidArgument(
+                            "The size of Input(Scale) should be %d, the size "
+                            "of the normalized dims.",
+                            width));
+      PADDLE_ENFORCE_EQ(framework::product(ctx->GetInputDim("Bias")), width,
+                        platform::errors::InvalidArgument(
+                            "The size of Input(Bias) should be %d, the size "
+                            "of the normalized dims.",
+                            width));
+    }
+
+    ctx->SetOutputDim("Out", x_dims);
+    ctx->ShareLoD("X", "Out");
+  }
+};
+
+class SkipLayerNormOpMaker : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("X", "(Tensor), The first input of the residual add.");
+    AddInput("Y",
+             "(Tensor), The second input of the residual add, of the same "
+             "shape as X.");
+    AddInput("Scale", "(Tensor), The 1-D scale of layer_norm.");
+    AddInput("Bias", "(Tensor), The 1-D bias of layer_norm.");
+    AddOutput("Out", "(Tensor), The normalized sum, of the shape of X.");
+    AddAttr<float>("epsilon",
+                   "Constant for numerical stability [default 1e-5].")
+        .SetDefault(1e-5)
+        .AddCustomChecker([](const float &epsilon) {
+          PADDLE_ENFORCE_EQ(epsilon >= 0.0f && epsilon <= 0.001f, true,
+                            platform::errors::InvalidArgument(
+                                "'epsilon' should be between 0.0 and 0.001, "
+                                "but received %f.",
+                                epsilon));
+        });
+    AddAttr<int>("begin_norm_axis",
+                 "the axis of `begin_norm_axis ... Rank(X) - 1` will be "
+                 "normalized. [default 1].")
+        .SetDefault(1)
+        .GreaterThan(0);
+    AddComment(R"DOC(
+SkipLayerNorm Operator.
+
+out <= layer_norm(elementwise_add(X, Y), Scale, Bias)
+
+The sum is built in the first pass of the normalization of every row, the
+rows are normalized in parallel.
+)DOC");
+  }
+};
+
+template <typename T>
+class SkipLayerNormCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto *x = ctx.Input<framework::Tensor>("X");
+    auto *y = ctx.Input<framework::Tensor>("Y");
+    auto *scale = ctx.Input<framework::Tensor>("Scale");
+    auto *bias = ctx.Input<framework::Tensor>("Bias");
+    auto *out = ctx.Output<framework::Tensor>("Out");
+
+    auto matrix_dim =
+        framework::flatten_to_2d(x->dims(), ctx.Attr<int>("begin_norm_axis"));
+    math::LayerNormInput<T> in;
+    in.x = x->data<T>();
+    in.residual = y->data<T>();
+    math::LayerNormCPU(in, scale->data<T>(), bias->data<T>(),
+                       out->mutable_data<T>(ctx.GetPlace()), nullptr, nullptr,
+                       matrix_dim[0], matrix_dim[1],
+                       ctx.Attr<float>("epsilon"));
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(
+    skip_layernorm, ops::SkipLayerNormOp, ops::SkipLayerNormOpMaker,
+    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
+    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(skip_layernorm, ops::SkipLayerNormCPUKernel<float>,
+                       ops::SkipLayerNormCPUKernel<double>);
@@ -357,7 +357,7 @@ void BenchKernelSgd() {
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelMatMul() {
   using T = typename KernelTuple::data_type;
-  for (int m : {1, 2, 3, 4}) {
+  for (int m : {1, 2, 3, 4, 8, 16, 32}) {
     for (int n : TestSizes()) {
       for (int k : TestSizes()) {
         Tensor a, b, c;
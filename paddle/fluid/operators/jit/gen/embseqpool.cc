@@ -28,7 +28,10 @@ namespace gen {
 void EmbSeqPoolJitCode::genCode() {
   preCode();
   constexpr int block = YMM_FLOAT_BLOCK;
-  constexpr int max_num_regs = 8;
+  // avg and sqrt keep the scale in the last ymm, so use one register less
+  const bool need_scale =
+      type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt;
+  const int max_num_regs = need_scale ? 7 : 8;
   const int num_block = tbl_w_ / block;
   const int num_groups = num_block / max_num_regs;
   const size_t block_size = sizeof(float) * block;
@@ -44,6 +47,19 @@ void EmbSeqPoolJitCode::genCode() {
       qword[param_attr + offsetof(emb_seq_pool_attr_t, index_width)]);
   mov(reg_idx_height,
       qword[param_attr + offsetof(emb_seq_pool_attr_t, index_height)]);
+  if (need_scale) {
+    // scale = 1 / h or 1 / sqrt(h), computed in registers only so that the
+    // same code can be called from many threads at once
+    vcvtsi2ss(xmm_t(14), xmm_t(14), reg_idx_height);
+    vshufps(xmm_t(14), xmm_t(14), xmm_t(14), 0);
+    vinsertf128(ymm_t(14), ymm_t(14), xmm_t(14), 1);
+    if (type_ == SeqPoolType::kSqrt) {
+      vsqrtps(ymm_t(14), ymm_t(14));
+    }
+    mov(reg_tmp, reinterpret_cast<size_t>(exp_float_consts));
+    vmovaps(ymm_t(15), ptr[reg_tmp + OFFSET_EXP_ONE]);
+    vdivps(ymm_t(15), ymm_t(15), ymm_t(14));
+  }
   mov(rax, sizeof(int64_t));
   mul(reg_idx_width_in_byte);
   mov(reg_idx_width_in_byte, rax);
@@ -102,9 +118,11 @@ void EmbSeqPoolJitCode::genCode() {
         jl(l_next_idx_h, T_NEAR);
       }  // end of idx h
       L(l_save_now);
-      // avg or sqrt here, if needed
       w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
+        if (need_scale) {
+          vmulps(ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs), ymm_t(15));
+        }
         vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i + num_regs));
         w_offset += block_size;
       }
@@ -127,7 +145,7 @@ class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
            attr.table_width % YMM_FLOAT_BLOCK == 0;
   }
   size_t CodeSize(const emb_seq_pool_attr_t& attr) const override {
-    return 96 + (attr.table_width / YMM_FLOAT_BLOCK) * 96 * 8;
+    return 128 + (attr.table_width / YMM_FLOAT_BLOCK) * 96 * 8;
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const emb_seq_pool_attr_t& attr) const override {
@@ -32,9 +32,10 @@ class EmbSeqPoolJitCode : public JitCode {
       : JitCode(code_size, code_ptr),
         tbl_w_(attr.table_width),
         type_(attr.pool_type) {
-    if (type_ != SeqPoolType::kSum) {
-      PADDLE_THROW(
-          platform::errors::Unimplemented("Only supports sum pool yet."));
+    if (!(type_ == SeqPoolType::kSum || type_ == SeqPoolType::kAvg ||
+          type_ == SeqPoolType::kSqrt)) {
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Only supports sum, average and sqrt pool type."));
     }
     this->genCode();
   }
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/operators/jit/gen/matmul.h"
 #include <stddef.h>  // offsetof
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include "paddle/fluid/operators/jit/registry.h"
@@ -24,96 +25,214 @@ namespace operators {
 namespace jit {
 namespace gen {
 
+// Lanes [0, rest) of the AVX2 tail mask start at &g_tail_mask[8 - rest]
+static constexpr int avx2_mask_idx = 15;
+static const int32_t g_tail_mask[2 * YMM_FLOAT_BLOCK] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+void MatMulJitCode::MatMulTileShape(int m, int n, int* tile_rows,
+                                    int* tile_blocks) {
+  const bool use_avx512 = platform::MayIUse(platform::avx512f);
+  const int block = use_avx512 ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
+  const int num_regs = use_avx512 ? 32 : 16;
+  const int max_blocks = use_avx512 ? 4 : 2;
+  *tile_blocks = std::min(max_blocks, (n + block - 1) / block);
+  const int max_rows = (num_regs - 2 - *tile_blocks) / *tile_blocks;
+  *tile_rows = std::min(std::min(max_rows, 8), m);
+}
+
 void MatMulJitCode::genCode() {
   preCode();
-  int block, rest;
-  const auto groups = packed_groups(n_, k_, &block, &rest);
-  PADDLE_ENFORCE_GT(groups.front(), 0);
-
-  const int block_len = sizeof(float) * block;
-  const int x_reg_idx = (block == ZMM_FLOAT_BLOCK ? 32 : 16) - 1;
-  const int w_reg_idx = x_reg_idx - 1;
-  // from packed mov(reg_ptr_wgt, ptr[param_attr + offsetof(matmul_attr_t,
-  // packed_weight)]);
-  mov(reg_ptr_wgt, param_y);
-  size_t z_offset = 0;
-  size_t wgt_offset = 0;
-  for (size_t g = 0; g < groups.size(); ++g) {
-    size_t x_offset = 0;
-    size_t wgt_offset_tmp = 0;
-    for (size_t i = 0; i < g; ++i) {
-      wgt_offset_tmp += groups[i] * block_len;
-    }
-    for (int k = 0; k < k_; ++k) {
-      wgt_offset = wgt_offset_tmp;
-      vbroadcastss(zmm_t(x_reg_idx), ptr[param_x + x_offset]);
-      // clean
-      if (k == 0) {
-        for (int i = 0; i < groups[g]; ++i) {
-          vxorps(zmm_t(i), zmm_t(i), zmm_t(i));
-        }
+  const int rest = n_ % block_;
+  if (rest != 0) {
+    if (use_avx512_) {
+      mov(reg_tmp.cvt32(), (1 << rest) - 1);
+      kmovw(k1, reg_tmp.cvt32());
+    } else {
+      mov(reg_tmp,
+          reinterpret_cast<size_t>(&g_tail_mask[YMM_FLOAT_BLOCK - rest]));
+      vmovups(ymm_t(avx2_mask_idx), ptr[reg_tmp]);
+    }
+  }
+  if (with_bias_) {
+    mov(reg_ptr_bias, ptr[param_attr + offsetof(matmul_attr_t, bias)]);
+  }
+
+  const int tile_cols = tile_blocks_ * block_;
+  for (int col = 0; col < n_; col += tile_cols) {
+    const int cols = std::min(tile_cols, n_ - col);
+    const int blocks = (cols + block_ - 1) / block_;
+    for (int row = 0; row < m_; row += tile_rows_) {
+      GenTile(row, std::min(tile_rows_, m_ - row), col, blocks, cols % block_);
+    }
+  }
+  postCode();
+}
+
+void MatMulJitCode::GenTile(int row, int rows, int col, int blocks,
+                            int rest) {
+  // acc: [0, rows * blocks), wgt: blocks registers below x, the last one
+  // is the AVX2 tail mask
+  const int num_regs = use_avx512_ ? 32 : 16;
+  const int x_idx = num_regs - 2;
+  auto acc = [&](int r, int j) { return r * blocks + j; };
+  auto wgt = [&](int j) { return x_idx - 1 - j; };
+  auto masked = [&](int j) { return rest != 0 && j == blocks - 1; };
+  const size_t block_len = sizeof(float) * block_;
+
+  for (int r = 0; r < rows; ++r) {
+    for (int j = 0; j < blocks; ++j) {
+      VZero(acc(r, j));
+    }
+  }
+
+  lea(reg_ptr_x, ptr[param_x + row * k_ * sizeof(float)]);
+  lea(reg_ptr_wgt, ptr[param_y + col * sizeof(float)]);
+  mov(reg_k, k_);
+  Label l_k;
+  L(l_k);
+  {
+    for (int j = 0; j < blocks; ++j) {
+      LoadVector(wgt(j), ptr[reg_ptr_wgt + j * block_len], masked(j));
+    }
+    for (int r = 0; r < rows; ++r) {
+      VBroadcast(x_idx, ptr[reg_ptr_x + r * k_ * sizeof(float)]);
+      for (int j = 0; j < blocks; ++j) {
+        VFmadd(acc(r, j), wgt(j), x_idx);
       }
-      for (int i = 0; i < groups[g]; ++i) {
-        vmovups(zmm_t(w_reg_idx),
-                ptr[reg_ptr_wgt + wgt_offset + k * n_ * sizeof(float)]);
-        vfmadd231ps(zmm_t(i), zmm_t(w_reg_idx), zmm_t(x_reg_idx));
-        wgt_offset += block_len;
+    }
+    add(reg_ptr_x, sizeof(float));
+    add(reg_ptr_wgt, n_ * sizeof(float));
+    dec(reg_k);
+  }
+  jnz(l_k, T_NEAR);
+
+  if (with_bias_) {
+    const size_t bias_offset = col * sizeof(float);
+    for (int j = 0; j < blocks; ++j) {
+      LoadVector(wgt(j), ptr[reg_ptr_bias + bias_offset + j * block_len],
+                 masked(j));
+    }
+    for (int r = 0; r < rows; ++r) {
+      for (int j = 0; j < blocks; ++j) {
+        VBinary(ADD, acc(r, j), wgt(j));
       }
-      // last one, save
-      if (k == k_ - 1) {
-        for (int i = 0; i < groups[g]; ++i) {
-          // only rest save should be careful
-          if (rest != 0 && g == groups.size() - 1 && i == groups[g] - 1) {
-            break;
-          }
-          vmovups(ptr[param_z + z_offset + i * block_len], zmm_t(i));
-        }
+    }
+  }
+  if (with_relu_) {
+    VZero(x_idx);
+    for (int r = 0; r < rows; ++r) {
+      for (int j = 0; j < blocks; ++j) {
+        VBinary(MAX, acc(r, j), x_idx);
       }
-      x_offset += sizeof(float);
     }
-    z_offset += block_len * groups[g];
   }
 
-  if (rest != 0) {
-    // below should refine with mask
-    int reg_idx = groups.back() - 1;
-    z_offset = (n_ - rest) * sizeof(float);
-    int inner_block = 8;
-    while (rest > 0) {
-      if (rest >= 8) {
-        inner_block = 8;
-        vmovups(ptr[param_z + z_offset], ymm_t(reg_idx));
-        // shift zmm of inner_block, change reg_idx if update
-      } else if (rest >= 4) {
-        inner_block = 4;
-        vmovups(ptr[param_z + z_offset], xmm_t(reg_idx));
-      } else if (rest >= 2) {
-        inner_block = 2;
-        vmovq(ptr[param_z + z_offset], xmm_t(reg_idx));
-      } else {
-        inner_block = 1;
-        vmovss(ptr[param_z + z_offset], xmm_t(reg_idx));
-      }
-      z_offset += inner_block * sizeof(float);
-      rest -= inner_block;
+  for (int r = 0; r < rows; ++r) {
+    const size_t z_offset = ((row + r) * n_ + col) * sizeof(float);
+    for (int j = 0; j < blocks; ++j) {
+      StoreVector(ptr[param_z + z_offset + j * block_len], acc(r, j),
+                  masked(j));
     }
   }
+}
 
-  postCode();
+void MatMulJitCode::LoadVector(int idx, const Xbyak::Address& addr,
+                               bool masked) {
+  if (use_avx512_) {
+    if (masked) {
+      vmovups(zmm_t(idx) | k1 | T_z, addr);
+    } else {
+      vmovups(zmm_t(idx), addr);
+    }
+  } else {
+    if (masked) {
+      vmaskmovps(ymm_t(idx), ymm_t(avx2_mask_idx), addr);
+    } else {
+      vmovups(ymm_t(idx), addr);
+    }
+  }
+}
+
+void MatMulJitCode::StoreVector(const Xbyak::Address& addr, int idx,
+                                bool masked) {
+  if (use_avx512_) {
+    if (masked) {
+      vmovups(addr | k1, zmm_t(idx));
+    } else {
+      vmovups(addr, zmm_t(idx));
+    }
+  } else {
+    if (masked) {
+      vmaskmovps(addr, ymm_t(avx2_mask_idx), ymm_t(idx));
+    } else {
+      vmovups(addr, ymm_t(idx));
+    }
+  }
+}
+
+void MatMulJitCode::VFmadd(int dst, int src1, int src2) {
+  if (use_avx512_) {
+    vfmadd231ps(zmm_t(dst), zmm_t(src1), zmm_t(src2));
+  } else {
+    vfmadd231ps(ymm_t(dst), ymm_t(src1), ymm_t(src2));
+  }
+}
+
+void MatMulJitCode::VBinary(operand_type type, int dst, int src) {
+  PADDLE_ENFORCE_EQ(type == ADD || type == MAX, true,
+                    platform::errors::Unimplemented(
+                        "MatMulJitCode only supports add and max."));
+  if (use_avx512_) {
+    if (type == ADD) {
+      vaddps(zmm_t(dst), zmm_t(dst), zmm_t(src));
+    } else {
+      vmaxps(zmm_t(dst), zmm_t(dst), zmm_t(src));
+    }
+  } else {
+    if (type == ADD) {
+      vaddps(ymm_t(dst), ymm_t(dst), ymm_t(src));
+    } else {
+      vmaxps(ymm_t(dst), ymm_t(dst), ymm_t(src));
+    }
+  }
+}
+
+void MatMulJitCode::VZero(int idx) {
+  if (use_avx512_) {
+    // vxorps on zmm needs avx512dq
+    vpxord(zmm_t(idx), zmm_t(idx), zmm_t(idx));
+  } else {
+    vxorps(ymm_t(idx), ymm_t(idx), ymm_t(idx));
+  }
+}
+
+void MatMulJitCode::VBroadcast(int idx, const Xbyak::Address& addr) {
+  if (use_avx512_) {
+    vbroadcastss(zmm_t(idx), addr);
+  } else {
+    vbroadcastss(ymm_t(idx), addr);
+  }
 }
 
 class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
  public:
   bool CanBeUsed(const matmul_attr_t& attr) const override {
-    return attr.m == 1 && platform::MayIUse(platform::avx512f) &&
-           attr.n % ZMM_FLOAT_BLOCK == 0 && attr.k < 512;
+    // Larger problems amortize the BLAS call, and would bloat the unrolled
+    // tiles here
+    return platform::MayIUse(platform::avx2) && attr.m <= 32 &&
+           attr.m * attr.n <= 16384;
   }
   size_t CodeSize(const matmul_attr_t& attr) const override {
     int block = YMM_FLOAT_BLOCK;
     if (platform::MayIUse(platform::avx512f)) {
       block = ZMM_FLOAT_BLOCK;
     }
-    return 96 + 4 * attr.k * (attr.n / block + 1) * 8;
+    int rows, blocks;
+    MatMulJitCode::MatMulTileShape(attr.m, attr.n, &rows, &blocks);
+    const size_t tiles = static_cast<size_t>((attr.m + rows - 1) / rows) *
+                         ((attr.n + blocks * block - 1) / (blocks * block));
+    return 256 + tiles * (128 + 64 * rows * blocks + 16 * (rows + blocks));
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const matmul_attr_t& attr) const override {
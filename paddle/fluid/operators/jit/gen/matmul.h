@@ -26,13 +26,24 @@ namespace operators {
 namespace jit {
 namespace gen {
 
+// C(M,N) = A(M,K) * B(K,N) with an optional bias and relu, for the small M
+// of attention and FC layers. C is computed in register tiles of
+// tile_rows x (tile_blocks * block), each tile loops over K at runtime and
+// the last block of every row is masked when N is not a multiple of block.
 class MatMulJitCode : public JitCode {
  public:
   explicit MatMulJitCode(const matmul_attr_t& attr,
                          size_t code_size = 256 * 1024,
                          void* code_ptr = nullptr)
-      : JitCode(code_size, code_ptr), m_(attr.m), n_(attr.n), k_(attr.k) {
-    PADDLE_ENFORCE_EQ(m_, 1, "Only support m==1 yet");
+      : JitCode(code_size, code_ptr),
+        m_(attr.m),
+        n_(attr.n),
+        k_(attr.k),
+        with_bias_(attr.bias != nullptr),
+        with_relu_(attr.with_relu) {
+    use_avx512_ = platform::MayIUse(platform::avx512f);
+    block_ = use_avx512_ ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
+    MatMulTileShape(m_, n_, &tile_rows_, &tile_blocks_);
     this->genCode();
   }
 
@@ -40,12 +51,34 @@ class MatMulJitCode : public JitCode {
     std::string base = "MatMulJitCode";
     base = base + "_M" + std::to_string(m_) + "_N" + std::to_string(n_) + "_K" +
            std::to_string(k_);
-    return base;
+    if (with_bias_) {
+      base += "_Bias";
+    }
+    if (with_relu_) {
+      base += "_Relu";
+    }
+    return base + (use_avx512_ ? "_AVX512" : "_AVX2");
   }
   void genCode() override;
 
+  // The register tile used for C, accumulators of tile_rows x tile_blocks
+  // plus tile_blocks registers of B, one broadcast of A and one mask.
+  static void MatMulTileShape(int m, int n, int* tile_rows, int* tile_blocks);
+
  private:
+  void GenTile(int row, int rows, int col, int blocks, int rest);
+  void LoadVector(int idx, const Xbyak::Address& addr, bool masked);
+  void StoreVector(const Xbyak::Address& addr, int idx, bool masked);
+  void VFmadd(int dst, int src1, int src2);
+  void VBinary(operand_type type, int dst, int src);
+  void VZero(int idx);
+  void VBroadcast(int idx, const Xbyak::Address& addr);
+
   int m_, n_, k_;
+  bool with_bias_, with_relu_;
+  bool use_avx512_;
+  int block_;
+  int tile_rows_, tile_blocks_;
 
   reg64_t param_x{abi_param1};
   reg64_t param_y{abi_param2};
@@ -53,7 +86,10 @@ class MatMulJitCode : public JitCode {
   reg64_t param_attr{abi_param4};
   reg64_t reg_tmp{rax};
 
+  reg64_t reg_ptr_x{r8};
   reg64_t reg_ptr_wgt{r10};
+  reg64_t reg_ptr_bias{r11};
+  reg64_t reg_k{r9};
 };
 
 }  // namespace gen
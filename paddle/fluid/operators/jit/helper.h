@@ -271,6 +271,12 @@ inline std::ostream& operator<<(std::ostream& os, const sgd_attr_t& attr) {
 
 inline std::ostream& operator<<(std::ostream& os, const matmul_attr_t& attr) {
   os << "M[" << attr.m << "],N[" << attr.n << "],K[" << attr.k << "]";
+  if (attr.bias != nullptr) {
+    os << ",bias";
+  }
+  if (attr.with_relu) {
+    os << ",relu";
+  }
   return os;
 }
 
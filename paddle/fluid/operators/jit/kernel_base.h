@@ -272,6 +272,9 @@ struct SgdTuple {
 typedef struct matmul_attr_s {
   int m, n, k;
   void* packed_weight{nullptr};
+  // Optional epilogue C = relu(A * B + bias), the bias has n elements
+  const void* bias{nullptr};
+  bool with_relu{false};
   matmul_attr_s() = default;
   explicit matmul_attr_s(int m_, int n_, int k_, void* packed_weight_ = nullptr)
       : m(m_), n(n_), k(k_), packed_weight(packed_weight_) {}
@@ -51,12 +51,15 @@ int64_t JitCodeKey<seq_pool_attr_t>(const seq_pool_attr_t& attr) {
 
 template <>
 int64_t JitCodeKey<matmul_attr_t>(const matmul_attr_t& attr) {
-  return XXH64(&attr, sizeof(int) * 3, 0);  // m, n, k
+  int keys[4] = {attr.m, attr.n, attr.k,
+                 (attr.bias != nullptr ? 1 : 0) | (attr.with_relu ? 2 : 0)};
+  return XXH64(keys, sizeof(int) * 4, 0);
 }
 
 template <>
 int64_t JitCodeKey<emb_seq_pool_attr_t>(const emb_seq_pool_attr_t& attr) {
-  return attr.table_width;
+  int64_t keys[2] = {attr.table_width, static_cast<int64_t>(attr.pool_type)};
+  return XXH64(keys, sizeof(int64_t) * 2, 0);
 }
 
 template <>
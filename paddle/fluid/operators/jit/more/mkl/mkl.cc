@@ -30,6 +30,7 @@ void MatMul<float>(const float* a, const float* b, float* c,
   platform::dynload::cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
                                  attr->m, attr->n, attr->k, 1.f, a, attr->k, b,
                                  attr->n, 0.f, c, attr->n);
+  refer::MatMulEpilogue(c, attr);
 }
 
 template <>
@@ -38,6 +39,7 @@ void MatMul<double>(const double* a, const double* b, double* c,
   platform::dynload::cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
                                  attr->m, attr->n, attr->k, 1.0, a, attr->k, b,
                                  attr->n, 0.0, c, attr->n);
+  refer::MatMulEpilogue(c, attr);
 }
 
 template <>
@@ -123,6 +123,17 @@ void EmbSeqPool(const T* table, const int64_t* idx, T* out,
                out + w * attr->table_width, attr->table_width);
     }
   }
+
+  if (attr->pool_type == SeqPoolType::kAvg ||
+      attr->pool_type == SeqPoolType::kSqrt) {
+    T scalar = static_cast<T>(1);
+    if (attr->pool_type == SeqPoolType::kAvg) {
+      scalar = scalar / static_cast<T>(attr->index_height);
+    } else {
+      scalar = scalar / std::sqrt(static_cast<T>(attr->index_height));
+    }
+    VScal<T>(&scalar, out, out, attr->out_width);
+  }
 }
 
 template <typename T>
@@ -376,6 +376,26 @@ void SeqPool(const T* x, T* y, const seq_pool_attr_t* attr) {
   }
 }
 
+// Apply the optional bias and relu of matmul_attr_t on C(M,N)
+template <typename T>
+void MatMulEpilogue(T* C, const matmul_attr_t* attr) {
+  if (attr->bias == nullptr && !attr->with_relu) {
+    return;
+  }
+  const T* bias = static_cast<const T*>(attr->bias);
+  for (int m = 0; m < attr->m; ++m) {
+    T* pc = C + m * attr->n;
+    for (int n = 0; n < attr->n; ++n) {
+      if (bias) {
+        pc[n] += bias[n];
+      }
+      if (attr->with_relu) {
+        pc[n] = pc[n] > static_cast<T>(0) ? pc[n] : static_cast<T>(0);
+      }
+    }
+  }
+}
+
 // A(M,K) * B(K,N) = C(M,N)
 template <typename T>
 void MatMul(const T* A, const T* B, T* C, const matmul_attr_t* attr) {
@@ -393,6 +413,7 @@ void MatMul(const T* A, const T* B, T* C, const matmul_attr_t* attr) {
       }
     }
   }
+  MatMulEpilogue(C, attr);
 }
 
 template <typename T>
@@ -486,6 +507,17 @@ void EmbSeqPool(const T* table, const int64_t* idx, T* out,
            out + w * attr->table_width, attr->table_width);
     }
   }
+
+  if (attr->pool_type == SeqPoolType::kAvg ||
+      attr->pool_type == SeqPoolType::kSqrt) {
+    T scalar = static_cast<T>(1);
+    if (attr->pool_type == SeqPoolType::kAvg) {
+      scalar = scalar / static_cast<T>(attr->index_height);
+    } else {
+      scalar = scalar / std::sqrt(static_cast<T>(attr->index_height));
+    }
+    VScal<T>(&scalar, out, out, attr->out_width);
+  }
 }
 
 // SGD algorithm:
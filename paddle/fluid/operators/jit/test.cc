@@ -622,7 +622,7 @@ void TestKernelEmbSeqPool() {
   VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
   int64_t tbl_h = 1e4;
   std::vector<jit::SeqPoolType> pool_types = {
-      jit::SeqPoolType::kSum};  // only support sum yet
+      jit::SeqPoolType::kSum, jit::SeqPoolType::kAvg, jit::SeqPoolType::kSqrt};
   auto test_sizes = TestSizes();
   test_sizes.erase(std::remove(test_sizes.begin(), test_sizes.end(), 1000));
   for (int tbl_w : test_sizes) {
@@ -681,8 +681,8 @@ void TestKernelMatMul() {
   // export MKL_CBWR=AVX would make MKL force to use AVX
   // export KMP_DETERMINISTIC_REDUCTION=yes would make the result deterministic
   FLAGS_acc = 1e-3;
-  for (int m : {1, 2, 3, 4}) {
-    for (int n : {1, 2, 3, 4}) {
+  for (int m : {1, 2, 3, 4, 7, 32}) {
+    for (int n : {1, 2, 3, 4, 9, 33, 70}) {
       for (int k : TestSizes()) {
         auto ref = jit::GetReferFunc<KernelTuple>();
         EXPECT_TRUE(ref != nullptr);
@@ -711,6 +711,16 @@ void TestKernelMatMul() {
           ExpectEQ<T>(c_data, cref_data, attr.m * attr.n);
         };
         TestAllImpls<KernelTuple, PlaceType>(attr, verifier, a, b, c, attr);
+
+        // with the bias and relu epilogue
+        std::vector<T> bias(n);
+        RandomVec<T>(n, bias.data());
+        jit::matmul_attr_t epilogue_attr(m, n, k);
+        epilogue_attr.bias = bias.data();
+        epilogue_attr.with_relu = true;
+        ref(a_data, b_data, c_data, &epilogue_attr);
+        TestAllImpls<KernelTuple, PlaceType>(epilogue_attr, verifier, a, b, c,
+                                             epilogue_attr);
       }
     }
   }
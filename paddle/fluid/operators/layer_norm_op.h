@@ -21,11 +21,8 @@ limitations under the License. */
 #include "paddle/fluid/operators/elementwise/elementwise_op_function.cu.h"
 #include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
 #include "paddle/fluid/operators/math/blas.h"
-#if !defined(PADDLE_WITH_CUDA) && !defined(_WIN32) && !defined(__APPLE__) && \
-    !defined(__OSX__)
-#include "paddle/fluid/operators/jit/kernels.h"
-#endif
 #include "paddle/fluid/operators/math/math_function.h"
+#include "paddle/fluid/operators/math/norm_cpu.h"
 
 namespace paddle {
 namespace operators {
@@ -195,8 +192,40 @@ class LayerNormKernel : public framework::OpKernel<T> {
     out.ShareDataWith(*y);
     out.Resize(matrix_shape);
 
-#if defined(PADDLE_WITH_CUDA) || defined(_WIN32) || defined(__APPLE__) || \
-    defined(__OSX__)
+    if (platform::is_cpu_place(ctx.GetPlace())) {
+      PADDLE_ENFORCE_EQ(
+          mean->numel(), left,
+          platform::errors::InvalidArgument(
+              "mean's length (%d) is not equal with expected (%d).",
+              mean->numel(), left));
+      PADDLE_ENFORCE_EQ(
+          var->numel(), left,
+          platform::errors::InvalidArgument(
+              "var's length (%d) is not equal with expected (%d).",
+              var->numel(), left));
+      if (scale) {
+        PADDLE_ENFORCE_EQ(
+            scale->numel(), right,
+            platform::errors::InvalidArgument(
+                "scale's length (%d) is not equal with expected (%d).",
+                scale->numel(), right));
+      }
+      if (bias) {
+        PADDLE_ENFORCE_EQ(
+            bias->numel(), right,
+            platform::errors::InvalidArgument(
+                "bias's length (%d) is not equal with expected (%d).",
+                bias->numel(), right));
+      }
+      math::LayerNormInput<T> in;
+      in.x = x.data<T>();
+      math::LayerNormCPU(in, scale ? scale->data<T>() : nullptr,
+                         bias ? bias->data<T>() : nullptr, out.data<T>(),
+                         mean->data<T>(), var->data<T>(), left, right,
+                         epsilon);
+      return;
+    }
+
     auto& dev_ctx = ctx.template device_context<DeviceContext>();
     RowwiseMean2D<DeviceContext, T> row_mean(left, right, ctx.device_context());
 
@@ -223,37 +252,6 @@ class LayerNormKernel : public framework::OpKernel<T> {
       ElementwiseComputeEx<AddFunctor<T>, DeviceContext, T>(
           ctx, &out, bias, /*axis*/ 1, AddFunctor<T>(), &out);
     }
-#else
-    PADDLE_ENFORCE_EQ(mean->numel(), left,
-                      platform::errors::InvalidArgument(
-                          "mean's length (%d) is not equal with expected (%d).",
-                          mean->numel(), left));
-    PADDLE_ENFORCE_EQ(var->numel(), left,
-                      platform::errors::InvalidArgument(
-                          "var's length (%d) is not equal with expected (%d).",
-                          var->numel(), left));
-    if (scale) {
-      PADDLE_ENFORCE_EQ(
-          scale->numel(), right,
-          platform::errors::InvalidArgument(
-              "scale's length (%d) is not equal with expected (%d).",
-              scale->numel(), right));
-    }
-    if (bias) {
-      PADDLE_ENFORCE_EQ(
-          bias->numel(), right,
-          platform::errors::InvalidArgument(
-              "bias's length (%d) is not equal with expected (%d).",
-              bias->numel(), right));
-    }
-
-    auto ker =
-        jit::KernelFuncs<jit::LayerNormTuple<T>, platform::CPUPlace>::Cache()
-            .At(right);
-    ker(x.data<T>(), out.data<T>(), mean->data<T>(), var->data<T>(),
-        scale ? scale->data<T>() : nullptr, bias ? bias->data<T>() : nullptr,
-        static_cast<int>(left), static_cast<const float>(epsilon), right);
-#endif
   }
 };
 
@@ -59,6 +59,12 @@ class LoadCombineOpProtoMaker : public framework::OpProtoAndCheckerMaker {
                   "If true, file_path is in memory, and LoDTensors will be "
                   "loaded directly from memory")
         .SetDefault(false);
+    AddAttr<bool>("use_mmap",
+                  "(boolean, default false)"
+                  "If true, the file is memory mapped and CPU LoDTensors "
+                  "share the mapped pages instead of being read into newly "
+                  "allocated memory.")
+        .SetDefault(false);
     AddComment(R"DOC(
 LoadCombine Operator.
 
@@ -33,6 +33,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
     auto filename = ctx.Attr<std::string>("file_path");
     auto load_as_fp16 = ctx.Attr<bool>("load_as_fp16");
     auto model_from_memory = ctx.Attr<bool>("model_from_memory");
+    auto use_mmap = ctx.Attr<bool>("use_mmap");
     auto out_var_names = ctx.OutputNames("Out");
 
     PADDLE_ENFORCE_GT(out_var_names.size(), 0UL,
@@ -40,6 +41,13 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "The number of variables to be loaded is %d, expect "
                           "it to be greater than 0.",
                           out_var_names.size()));
+#ifndef _WIN32
+    if (use_mmap && !model_from_memory) {
+      LoadParamsFromMemoryMap(ctx, place, filename, load_as_fp16,
+                              out_var_names);
+      return;
+    }
+#endif
     if (!model_from_memory) {
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(
@@ -88,26 +96,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
       // Get data from fin to tensor
       DeserializeFromStream(*buffer, tensor, dev_ctx);
 
-      auto in_dtype = tensor->type();
-      auto out_dtype =
-          load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
-
-      if (in_dtype != out_dtype) {
-        // convert to float16 tensor
-        auto in_kernel_type = framework::OpKernelType(in_dtype, place);
-        auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor fp16_tensor;
-        // copy LoD info to the new tensor
-        fp16_tensor.set_lod(tensor->lod());
-        framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
-                                 &fp16_tensor);
-
-        // reset output tensor
-        out_vars[i]->Clear();
-        tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
-        tensor->set_lod(fp16_tensor.lod());
-        tensor->ShareDataWith(fp16_tensor);
-      }
+      ConvertToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
     }
     buffer->peek();
     PADDLE_ENFORCE_EQ(buffer->eof(), true,
@@ -115,6 +104,60 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "Not allowed to load partial data via "
                           "load_combine_op, please use load_op instead."));
   }
+
+#ifndef _WIN32
+  void LoadParamsFromMemoryMap(
+      const framework::ExecutionContext &context, const platform::Place &place,
+      const std::string &filename, bool load_as_fp16,
+      const std::vector<std::string> &out_var_names) const {
+    platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
+    auto &dev_ctx = *pool.Get(place);
+    auto out_vars = context.MultiOutputVar("Out");
+
+    auto file = memory::allocation::AllocateMemoryMapFileAllocation(filename);
+    size_t offset = 0;
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      VLOG(4) << "loading tensor: " << out_var_names[i] << " from mmap";
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i], platform::errors::InvalidArgument(
+                           "The variable %s to be loaded cannot be found.",
+                           out_var_names[i]));
+
+      auto *tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
+      framework::DeserializeFromMemoryMap(file, &offset, tensor, dev_ctx);
+
+      ConvertToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
+    }
+    PADDLE_ENFORCE_EQ(offset, file->size(),
+                      platform::errors::Unavailable(
+                          "Not allowed to load partial data via "
+                          "load_combine_op, please use load_op instead."));
+  }
+#endif
+
+  void ConvertToFP16IfNeeded(const platform::Place &place, bool load_as_fp16,
+                             framework::Variable *out_var) const {
+    auto *tensor = out_var->GetMutable<framework::LoDTensor>();
+    auto in_dtype = tensor->type();
+    auto out_dtype = load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type = framework::OpKernelType(in_dtype, place);
+      auto out_kernel_type = framework::OpKernelType(out_dtype, place);
+      framework::LoDTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
+                               &fp16_tensor);
+
+      // reset output tensor
+      out_var->Clear();
+      tensor = out_var->GetMutable<framework::LoDTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
 };
 
 }  // namespace operators
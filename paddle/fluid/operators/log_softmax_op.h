@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/softmax_cpu.h"
 
 namespace paddle {
 namespace operators {
@@ -119,6 +120,20 @@ struct LogSoftmaxFunctor {
   }
 };
 
+template <typename T>
+struct LogSoftmaxFunctor<platform::CPUDeviceContext, T> {
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor* X, framework::Tensor* Y,
+                  const int axis) {
+    if (X->numel() == 0) return;
+    const int axis_dim = X->dims()[axis];
+    const int n = SizeToAxis(axis, X->dims());
+    const int d = SizeFromAxis(axis, X->dims());
+    math::SoftmaxCPU<T, true>(X->data<T>(), Y->data<T>(), n, axis_dim,
+                              d / axis_dim);
+  }
+};
+
 template <typename DeviceContext, typename T>
 class LogSoftmaxKernel : public framework::OpKernel<T> {
  public:
@@ -51,6 +51,11 @@ struct CBlas<float> {
     platform::dynload::cblas_sgemm_pack(args...);
   }
 
+  template <typename... ARGS>
+  static size_t GEMM_PACK_GET_SIZE(ARGS... args) {
+    return platform::dynload::cblas_sgemm_pack_get_size(args...);
+  }
+
   template <typename... ARGS>
   static void GEMM_COMPUTE(ARGS... args) {
     platform::dynload::cblas_sgemm_compute(args...);
@@ -177,6 +182,11 @@ struct CBlas<double> {
     platform::dynload::cblas_dgemm_pack(args...);
   }
 
+  template <typename... ARGS>
+  static size_t GEMM_PACK_GET_SIZE(ARGS... args) {
+    return platform::dynload::cblas_dgemm_pack_get_size(args...);
+  }
+
   template <typename... ARGS>
   static void GEMM_COMPUTE(ARGS... args) {
     platform::dynload::cblas_dgemm_compute(args...);
@@ -0,0 +1,279 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// Output channels computed together, so every input element loaded is used
+// by all of them
+constexpr int kConvDirectBlock = 4;
+// Output columns kept in registers, kConvDirectBlock * kConvDirectStrip
+// accumulators in all
+constexpr int kConvDirectStrip = 8;
+// Output rows of one parallel task
+constexpr int64_t kConvDirectRows = 4;
+// Input channels per group up to which the direct convolution beats im2col
+// and a GEMM whose inner dimension is in_c / groups * kernel_h * kernel_w
+constexpr int64_t kConvDirectMaxChannels = 4;
+constexpr int64_t kMinParallelConvSize = 1 << 15;
+
+enum class ConvDirectActivation { kIdentity, kRelu, kRelu6, kSigmoid, kTanh };
+
+inline ConvDirectActivation GetConvDirectActivation(const std::string& type) {
+  if (type == "identity") return ConvDirectActivation::kIdentity;
+  if (type == "relu") return ConvDirectActivation::kRelu;
+  if (type == "relu6") return ConvDirectActivation::kRelu6;
+  if (type == "sigmoid") return ConvDirectActivation::kSigmoid;
+  if (type == "tanh") return ConvDirectActivation::kTanh;
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "The activation %s of the CPU convolution is not supported, it should "
+      "be one of identity, relu, relu6, sigmoid and tanh.",
+      type));
+}
+
+// The shape of an NCHW conv2d. pad_h and pad_w are the top and left
+// paddings, the bottom and right ones follow from out_h and out_w.
+struct ConvDirectShape {
+  int64_t batch;
+  int64_t in_c;
+  int64_t in_h;
+  int64_t in_w;
+  int64_t out_c;
+  int64_t out_h;
+  int64_t out_w;
+  int64_t groups;
+  int64_t kernel_h;
+  int64_t kernel_w;
+  int64_t stride_h;
+  int64_t stride_w;
+  int64_t pad_h;
+  int64_t pad_w;
+  int64_t dilation_h;
+  int64_t dilation_w;
+};
+
+// Depthwise and few channel 1x1 and 3x3 convolutions of stride 1 or 2, where
+// im2col moves more memory than the GEMM after it computes.
+inline bool UseConvDirect(const ConvDirectShape& s) {
+  bool kernel = (s.kernel_h == 1 && s.kernel_w == 1) ||
+                (s.kernel_h == 3 && s.kernel_w == 3);
+  bool stride =
+      (s.stride_h == 1 || s.stride_h == 2) && s.stride_w == s.stride_h;
+  return kernel && stride && s.dilation_h == 1 && s.dilation_w == 1 &&
+         s.in_c / s.groups <= kConvDirectMaxChannels;
+}
+
+// out = act(out + bias + residual) over n elements of one channel, residual
+// may be null.
+template <typename T>
+void ConvDirectEpilogue(T* out, int64_t n, T bias, const T* residual,
+                        ConvDirectActivation act) {
+  if (residual) {
+    for (int64_t i = 0; i < n; ++i) out[i] += bias + residual[i];
+  } else if (bias != static_cast<T>(0)) {
+    for (int64_t i = 0; i < n; ++i) out[i] += bias;
+  }
+  switch (act) {
+    case ConvDirectActivation::kIdentity:
+      break;
+    case ConvDirectActivation::kRelu:
+      for (int64_t i = 0; i < n; ++i) {
+        out[i] = std::max(out[i], static_cast<T>(0));
+      }
+      break;
+    case ConvDirectActivation::kRelu6:
+      for (int64_t i = 0; i < n; ++i) {
+        out[i] = std::min(std::max(out[i], static_cast<T>(0)),
+                          static_cast<T>(6));
+      }
+      break;
+    case ConvDirectActivation::kSigmoid:
+      for (int64_t i = 0; i < n; ++i) {
+        out[i] = static_cast<T>(1) / (static_cast<T>(1) + std::exp(-out[i]));
+      }
+      break;
+    case ConvDirectActivation::kTanh:
+      for (int64_t i = 0; i < n; ++i) out[i] = std::tanh(out[i]);
+      break;
+  }
+}
+
+// act(out + bias[c] + residual) over every channel of an NCHW tensor, for the
+// convolutions computed by im2col and GEMM.
+template <typename T>
+void ConvBiasActivationCPU(T* out, const T* bias, const T* residual,
+                           ConvDirectActivation act, int64_t batch,
+                           int64_t channels, int64_t plane) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (batch * channels * plane >= kMinParallelConvSize)
+#endif
+  for (int64_t nc = 0; nc < batch * channels; ++nc) {
+    ConvDirectEpilogue(out + nc * plane, plane,
+                       bias ? bias[nc % channels] : static_cast<T>(0),
+                       residual ? residual + nc * plane : nullptr, act);
+  }
+}
+
+// Computes the output rows [oh_begin, oh_end) of kBlock output channels of
+// one group. in points to the input channels of the group, filter to the
+// filter of the first output channel and out to its output plane. The
+// columns whose window is inside the input are computed kConvDirectStrip at
+// a time in registers, the others one by one with bounds checks.
+template <typename T, int kBlock, int kStride>
+void ConvDirectTile(const ConvDirectShape& s, const T* in, const T* filter,
+                    T* out, int64_t oh_begin, int64_t oh_end) {
+  const int64_t in_c = s.in_c / s.groups;
+  const int64_t in_plane = s.in_h * s.in_w;
+  const int64_t out_plane = s.out_h * s.out_w;
+  const int64_t ksize = s.kernel_h * s.kernel_w;
+  const int64_t filter_size = in_c * ksize;
+  const int64_t kw = s.kernel_w;
+
+  // The columns [ow_lo, ow_hi) read no padding
+  const int64_t ow_lo = std::min(s.out_w, (s.pad_w + kStride - 1) / kStride);
+  const int64_t last = s.in_w - kw + s.pad_w;
+  const int64_t ow_hi =
+      last < 0 ? ow_lo
+               : std::max(ow_lo, std::min(s.out_w, last / kStride + 1));
+
+  for (int64_t oh = oh_begin; oh < oh_end; ++oh) {
+    const int64_t ih0 = oh * s.stride_h - s.pad_h;
+    const int64_t r_lo = std::max<int64_t>(0, -ih0);
+    const int64_t r_hi = std::min(s.kernel_h, s.in_h - ih0);
+    T* dst = out + oh * s.out_w;
+
+    auto edge = [&](int64_t ow) {
+      const int64_t iw0 = ow * kStride - s.pad_w;
+      const int64_t c_lo = std::max<int64_t>(0, -iw0);
+      const int64_t c_hi = std::min(kw, s.in_w - iw0);
+      T acc[kBlock] = {0};
+      for (int64_t ic = 0; ic < in_c; ++ic) {
+        for (int64_t r = r_lo; r < r_hi; ++r) {
+          const T* src = in + ic * in_plane + (ih0 + r) * s.in_w;
+          const T* w = filter + ic * ksize + r * kw;
+          for (int64_t c = c_lo; c < c_hi; ++c) {
+            for (int b = 0; b < kBlock; ++b) {
+              acc[b] += w[b * filter_size + c] * src[iw0 + c];
+            }
+          }
+        }
+      }
+      for (int b = 0; b < kBlock; ++b) dst[b * out_plane + ow] = acc[b];
+    };
+
+    for (int64_t ow = 0; ow < ow_lo; ++ow) edge(ow);
+    int64_t ow = ow_lo;
+    for (; ow + kConvDirectStrip <= ow_hi; ow += kConvDirectStrip) {
+      T acc[kBlock][kConvDirectStrip] = {{0}};
+      for (int64_t ic = 0; ic < in_c; ++ic) {
+        for (int64_t r = r_lo; r < r_hi; ++r) {
+          const T* src = in + ic * in_plane + (ih0 + r) * s.in_w +
+                         ow * kStride - s.pad_w;
+          const T* w = filter + ic * ksize + r * kw;
+          for (int64_t c = 0; c < kw; ++c) {
+            for (int b = 0; b < kBlock; ++b) {
+              const T wv = w[b * filter_size + c];
+              for (int j = 0; j < kConvDirectStrip; ++j) {
+                acc[b][j] += wv * src[j * kStride + c];
+              }
+            }
+          }
+        }
+      }
+      for (int b = 0; b < kBlock; ++b) {
+        std::copy_n(acc[b], kConvDirectStrip, dst + b * out_plane + ow);
+      }
+    }
+    for (; ow < s.out_w; ++ow) edge(ow);
+  }
+}
+
+// conv2d of an NCHW input with an [out_c, in_c / groups, kernel_h, kernel_w]
+// filter without im2col, fused with act(out + bias[c] + residual). bias and
+// residual may be null. Blocks of kConvDirectBlock output channels, or
+// single ones at the end of a group, are computed by kConvDirectRows rows in
+// parallel. Requires UseConvDirect(s).
+template <typename T>
+void ConvDirectCPU(const ConvDirectShape& s, const T* input, const T* filter,
+                   const T* bias, const T* residual, ConvDirectActivation act,
+                   T* output) {
+  const int64_t in_c = s.in_c / s.groups;
+  const int64_t out_c = s.out_c / s.groups;
+  const int64_t in_plane = s.in_h * s.in_w;
+  const int64_t out_plane = s.out_h * s.out_w;
+  const int64_t filter_size = in_c * s.kernel_h * s.kernel_w;
+
+  // The first output channel and the number of channels of every block
+  std::vector<std::pair<int64_t, int>> blocks;
+  for (int64_t g = 0; g < s.groups; ++g) {
+    int64_t oc = g * out_c;
+    for (; oc + kConvDirectBlock <= (g + 1) * out_c; oc += kConvDirectBlock) {
+      blocks.emplace_back(oc, kConvDirectBlock);
+    }
+    for (; oc < (g + 1) * out_c; ++oc) blocks.emplace_back(oc, 1);
+  }
+  const int64_t num_blocks = static_cast<int64_t>(blocks.size());
+  const int64_t row_tiles = (s.out_h + kConvDirectRows - 1) / kConvDirectRows;
+  const int64_t tasks = s.batch * num_blocks * row_tiles;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (s.batch * s.out_c * out_plane * filter_size >= \
+                             kMinParallelConvSize)
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    const int64_t n = t / (num_blocks * row_tiles);
+    const int64_t oc = blocks[(t / row_tiles) % num_blocks].first;
+    const int width = blocks[(t / row_tiles) % num_blocks].second;
+    const int64_t oh_begin = (t % row_tiles) * kConvDirectRows;
+    const int64_t oh_end = std::min(s.out_h, oh_begin + kConvDirectRows);
+
+    const T* in = input + (n * s.in_c + oc / out_c * in_c) * in_plane;
+    const T* w = filter + oc * filter_size;
+    T* out = output + (n * s.out_c + oc) * out_plane;
+    if (width == kConvDirectBlock && s.stride_w == 1) {
+      ConvDirectTile<T, kConvDirectBlock, 1>(s, in, w, out, oh_begin, oh_end);
+    } else if (width == kConvDirectBlock) {
+      ConvDirectTile<T, kConvDirectBlock, 2>(s, in, w, out, oh_begin, oh_end);
+    } else if (s.stride_w == 1) {
+      ConvDirectTile<T, 1, 1>(s, in, w, out, oh_begin, oh_end);
+    } else {
+      ConvDirectTile<T, 1, 2>(s, in, w, out, oh_begin, oh_end);
+    }
+
+    const int64_t offset = oh_begin * s.out_w;
+    const int64_t size = (oh_end - oh_begin) * s.out_w;
+    for (int b = 0; b < width; ++b) {
+      ConvDirectEpilogue(
+          out + b * out_plane + offset, size,
+          bias ? bias[oc + b] : static_cast<T>(0),
+          residual ? residual + (n * s.out_c + oc + b) * out_plane + offset
+                   : nullptr,
+          act);
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
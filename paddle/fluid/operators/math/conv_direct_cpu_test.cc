@@ -0,0 +1,115 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "paddle/fluid/operators/math/conv_direct_cpu.h"
+
+using paddle::operators::math::ConvDirectActivation;
+using paddle::operators::math::ConvDirectShape;
+
+template <typename T>
+void ref_conv(const ConvDirectShape& s, const std::vector<T>& in,
+              const std::vector<T>& filter, const std::vector<T>& bias,
+              const std::vector<T>& residual, std::vector<T>* out) {
+  const int64_t in_c = s.in_c / s.groups;
+  const int64_t out_c = s.out_c / s.groups;
+  for (int64_t n = 0; n < s.batch; ++n) {
+    for (int64_t oc = 0; oc < s.out_c; ++oc) {
+      const int64_t g = oc / out_c;
+      for (int64_t oh = 0; oh < s.out_h; ++oh) {
+        for (int64_t ow = 0; ow < s.out_w; ++ow) {
+          T sum = 0;
+          for (int64_t ic = 0; ic < in_c; ++ic) {
+            for (int64_t r = 0; r < s.kernel_h; ++r) {
+              for (int64_t c = 0; c < s.kernel_w; ++c) {
+                int64_t ih = oh * s.stride_h - s.pad_h + r;
+                int64_t iw = ow * s.stride_w - s.pad_w + c;
+                if (ih < 0 || ih >= s.in_h || iw < 0 || iw >= s.in_w) continue;
+                sum += in[((n * s.in_c + g * in_c + ic) * s.in_h + ih) *
+                              s.in_w +
+                          iw] *
+                       filter[((oc * in_c + ic) * s.kernel_h + r) * s.kernel_w +
+                              c];
+              }
+            }
+          }
+          int64_t i = ((n * s.out_c + oc) * s.out_h + oh) * s.out_w + ow;
+          (*out)[i] = std::max(sum + bias[oc] + residual[i], static_cast<T>(0));
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+void TestConvDirect(int64_t batch, int64_t in_c, int64_t out_c, int64_t size,
+                    int64_t groups, int64_t kernel, int64_t stride,
+                    int64_t pad) {
+  ConvDirectShape s;
+  s.batch = batch;
+  s.in_c = in_c;
+  s.in_h = size;
+  s.in_w = size + 3;
+  s.out_c = out_c;
+  s.groups = groups;
+  s.kernel_h = s.kernel_w = kernel;
+  s.stride_h = s.stride_w = stride;
+  s.pad_h = s.pad_w = pad;
+  s.dilation_h = s.dilation_w = 1;
+  s.out_h = (s.in_h + 2 * pad - kernel) / stride + 1;
+  s.out_w = (s.in_w + 2 * pad - kernel) / stride + 1;
+  ASSERT_TRUE(paddle::operators::math::UseConvDirect(s));
+
+  std::mt19937 engine(in_c * 131 + out_c * 17 + size);
+  std::uniform_real_distribution<T> dist(-1, 1);
+  auto random = [&](int64_t n) {
+    std::vector<T> v(n);
+    for (auto& x : v) x = dist(engine);
+    return v;
+  };
+  auto in = random(batch * in_c * s.in_h * s.in_w);
+  auto filter = random(out_c * in_c / groups * kernel * kernel);
+  auto bias = random(out_c);
+  auto residual = random(batch * out_c * s.out_h * s.out_w);
+  std::vector<T> out(residual.size()), ref(residual.size());
+  paddle::operators::math::ConvDirectCPU<T>(
+      s, in.data(), filter.data(), bias.data(), residual.data(),
+      ConvDirectActivation::kRelu, out.data());
+  ref_conv(s, in, filter, bias, residual, &ref);
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(out[i], ref[i], 1e-4);
+  }
+}
+
+TEST(ConvDirectCPU, depthwise) {
+  for (int64_t stride : {1, 2}) {
+    TestConvDirect<float>(2, 8, 8, 13, 8, 3, stride, 1);
+    TestConvDirect<float>(1, 4, 8, 20, 4, 3, stride, 0);
+    TestConvDirect<double>(1, 3, 3, 9, 3, 1, stride, 0);
+  }
+}
+
+TEST(ConvDirectCPU, small_channels) {
+  for (int64_t stride : {1, 2}) {
+    TestConvDirect<float>(2, 3, 16, 24, 1, 3, stride, 1);
+    TestConvDirect<float>(1, 1, 6, 17, 1, 3, stride, 2);
+    TestConvDirect<float>(1, 4, 7, 11, 1, 1, stride, 0);
+    TestConvDirect<double>(2, 6, 10, 10, 2, 3, stride, 1);
+  }
+}
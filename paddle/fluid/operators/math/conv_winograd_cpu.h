@@ -0,0 +1,298 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "paddle/fluid/operators/math/conv_direct_cpu.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// Winograd F(4x4, 3x3): every 4x4 output tile is computed from a 6x6 input
+// tile by 36 element-wise products instead of 144.
+constexpr int kWinogradAlpha = 6;
+constexpr int kWinogradOut = 4;
+constexpr int kWinogradPoints = kWinogradAlpha * kWinogradAlpha;
+// Tiles transformed together by one parallel task, the columns of its 36
+// small GEMMs
+constexpr int kWinogradTiles = 16;
+// Output channels of one register block of those GEMMs, unrolled in
+// ConvWinogradCPU
+constexpr int kWinogradBlock = 4;
+// Below this many channels the transforms cost more than they save
+constexpr int64_t kWinogradMinChannels = 8;
+// Transformed filters kept before the cache starts over
+constexpr size_t kWinogradCacheSize = 1024;
+
+// fp32 3x3 stride 1 convolutions without groups or dilation.
+template <typename T>
+inline bool UseConvWinograd(const ConvDirectShape& s) {
+  return std::is_same<T, float>::value && s.groups == 1 && s.kernel_h == 3 &&
+         s.kernel_w == 3 && s.stride_h == 1 && s.stride_w == 1 &&
+         s.dilation_h == 1 && s.dilation_w == 1 &&
+         s.in_c >= kWinogradMinChannels && s.out_c >= kWinogradMinChannels;
+}
+
+// The filter of [out_c, in_c, 3, 3] as G g G^T in blocks of kWinogradBlock
+// output channels: u[((p * blocks + ob) * in_c + ic) * kWinogradBlock + b]
+// is the point p of output channel ob * kWinogradBlock + b. The channels
+// past out_c are 0.
+template <typename T>
+void WinogradTransformFilter(const T* filter, int64_t out_c, int64_t in_c,
+                             T* u) {
+  static const T G[kWinogradAlpha][3] = {
+      {1.0 / 4, 0, 0},
+      {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+      {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+      {1.0 / 24, 1.0 / 12, 1.0 / 6},
+      {1.0 / 24, -1.0 / 12, 1.0 / 6},
+      {0, 0, 1}};
+  const int64_t blocks = (out_c + kWinogradBlock - 1) / kWinogradBlock;
+  std::fill_n(u, kWinogradPoints * blocks * in_c * kWinogradBlock,
+              static_cast<T>(0));
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t oc = 0; oc < out_c; ++oc) {
+    const int64_t ob = oc / kWinogradBlock;
+    const int64_t b = oc % kWinogradBlock;
+    for (int64_t ic = 0; ic < in_c; ++ic) {
+      const T* g = filter + (oc * in_c + ic) * 9;
+      T tmp[kWinogradAlpha][3];
+      for (int i = 0; i < kWinogradAlpha; ++i) {
+        for (int j = 0; j < 3; ++j) {
+          tmp[i][j] = G[i][0] * g[j] + G[i][1] * g[3 + j] + G[i][2] * g[6 + j];
+        }
+      }
+      for (int i = 0; i < kWinogradAlpha; ++i) {
+        for (int j = 0; j < kWinogradAlpha; ++j) {
+          const int64_t p = i * kWinogradAlpha + j;
+          u[((p * blocks + ob) * in_c + ic) * kWinogradBlock + b] =
+              tmp[i][0] * G[j][0] + tmp[i][1] * G[j][1] + tmp[i][2] * G[j][2];
+        }
+      }
+    }
+  }
+}
+
+// Transformed filters by the filter they come from. An entry keeps a copy of
+// its filter and serves only while the filter still equals it, so updated
+// weights, or another filter allocated at the same address, are transformed
+// again. Predictors sharing their weights share the entries.
+template <typename T>
+class WinogradFilterCache {
+ public:
+  static WinogradFilterCache& Instance() {
+    static WinogradFilterCache cache;
+    return cache;
+  }
+
+  std::shared_ptr<const std::vector<T>> Get(const T* filter, int64_t out_c,
+                                            int64_t in_c) {
+    const size_t size = static_cast<size_t>(out_c * in_c * 9);
+    std::shared_ptr<const Entry> entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(filter);
+      if (it != entries_.end()) entry = it->second;
+    }
+    if (entry && entry->filter.size() == size &&
+        std::equal(entry->filter.begin(), entry->filter.end(), filter)) {
+      return entry->transformed;
+    }
+
+    auto fresh = std::make_shared<Entry>();
+    fresh->filter.assign(filter, filter + size);
+    const int64_t blocks = (out_c + kWinogradBlock - 1) / kWinogradBlock;
+    auto transformed = std::make_shared<std::vector<T>>(
+        kWinogradPoints * blocks * in_c * kWinogradBlock);
+    WinogradTransformFilter(filter, out_c, in_c, transformed->data());
+    fresh->transformed = transformed;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.size() >= kWinogradCacheSize) entries_.clear();
+    entries_[filter] = fresh;
+    return fresh->transformed;
+  }
+
+ private:
+  struct Entry {
+    std::vector<T> filter;
+    std::shared_ptr<const std::vector<T>> transformed;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<const T*, std::shared_ptr<const Entry>> entries_;
+};
+
+// y = B^T x over 6 elements strided by stride
+template <typename T>
+inline void WinogradInputRow(const T* x, int64_t stride, T* y,
+                             int64_t y_stride) {
+  const T x0 = x[0], x1 = x[stride], x2 = x[2 * stride];
+  const T x3 = x[3 * stride], x4 = x[4 * stride], x5 = x[5 * stride];
+  y[0] = 4 * x0 - 5 * x2 + x4;
+  y[y_stride] = -4 * x1 - 4 * x2 + x3 + x4;
+  y[2 * y_stride] = 4 * x1 - 4 * x2 - x3 + x4;
+  y[3 * y_stride] = -2 * x1 - x2 + 2 * x3 + x4;
+  y[4 * y_stride] = 2 * x1 - x2 - 2 * x3 + x4;
+  y[5 * y_stride] = 4 * x1 - 5 * x3 + x5;
+}
+
+// y = A^T x, 4 elements out of 6
+template <typename T>
+inline void WinogradOutputRow(const T* x, int64_t stride, T* y,
+                              int64_t y_stride) {
+  const T x0 = x[0], x1 = x[stride], x2 = x[2 * stride];
+  const T x3 = x[3 * stride], x4 = x[4 * stride], x5 = x[5 * stride];
+  y[0] = x0 + x1 + x2 + x3 + x4;
+  y[y_stride] = x1 - x2 + 2 * x3 - 2 * x4;
+  y[2 * y_stride] = x1 + x2 + 4 * x3 + 4 * x4;
+  y[3 * y_stride] = x1 - x2 + 8 * x3 - 8 * x4 + x5;
+}
+
+// conv2d of an NCHW input by the filter transformed by
+// WinogradTransformFilter, requires UseConvWinograd(s). Every task takes
+// kWinogradTiles output tiles of an image: their input tiles are transformed
+// into v[in_c][36][kWinogradTiles], multiplied by the filter in 36 GEMMs
+// blocked by kWinogradBlock output channels, and transformed back. v keeps
+// the points of a channel together, 36 rows a power of two apart would all
+// fall in the same cache set.
+template <typename T>
+void ConvWinogradCPU(const ConvDirectShape& s, const T* input, const T* u,
+                     T* output) {
+  const int64_t tiles_h = (s.out_h + kWinogradOut - 1) / kWinogradOut;
+  const int64_t tiles_w = (s.out_w + kWinogradOut - 1) / kWinogradOut;
+  const int64_t tiles = tiles_h * tiles_w;
+  const int64_t tile_blocks = (tiles + kWinogradTiles - 1) / kWinogradTiles;
+  const int64_t blocks = (s.out_c + kWinogradBlock - 1) / kWinogradBlock;
+  const int64_t in_plane = s.in_h * s.in_w;
+  const int64_t out_plane = s.out_h * s.out_w;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t task = 0; task < s.batch * tile_blocks; ++task) {
+    const int64_t n = task / tile_blocks;
+    const int64_t t_begin = (task % tile_blocks) * kWinogradTiles;
+    const int64_t t_count = std::min<int64_t>(kWinogradTiles, tiles - t_begin);
+    std::vector<T> v(kWinogradPoints * s.in_c * kWinogradTiles,
+                     static_cast<T>(0));
+    std::vector<T> m(kWinogradPoints * kWinogradBlock * kWinogradTiles);
+
+    for (int64_t ic = 0; ic < s.in_c; ++ic) {
+      const T* in = input + (n * s.in_c + ic) * in_plane;
+      for (int64_t t = 0; t < t_count; ++t) {
+        const int64_t ih0 = (t_begin + t) / tiles_w * kWinogradOut - s.pad_h;
+        const int64_t iw0 = (t_begin + t) % tiles_w * kWinogradOut - s.pad_w;
+        T d[kWinogradPoints];
+        if (ih0 >= 0 && iw0 >= 0 && ih0 + kWinogradAlpha <= s.in_h &&
+            iw0 + kWinogradAlpha <= s.in_w) {
+          for (int i = 0; i < kWinogradAlpha; ++i) {
+            std::copy_n(in + (ih0 + i) * s.in_w + iw0, kWinogradAlpha,
+                        d + i * kWinogradAlpha);
+          }
+        } else {
+          for (int i = 0; i < kWinogradAlpha; ++i) {
+            for (int j = 0; j < kWinogradAlpha; ++j) {
+              const int64_t ih = ih0 + i, iw = iw0 + j;
+              d[i * kWinogradAlpha + j] =
+                  ih >= 0 && ih < s.in_h && iw >= 0 && iw < s.in_w
+                      ? in[ih * s.in_w + iw]
+                      : static_cast<T>(0);
+            }
+          }
+        }
+        // B^T d B, the columns then the rows
+        T tmp[kWinogradPoints];
+        for (int j = 0; j < kWinogradAlpha; ++j) {
+          WinogradInputRow(d + j, kWinogradAlpha, tmp + j, kWinogradAlpha);
+        }
+        T* dst = v.data() + ic * kWinogradPoints * kWinogradTiles + t;
+        for (int i = 0; i < kWinogradAlpha; ++i) {
+          WinogradInputRow(tmp + i * kWinogradAlpha, 1,
+                           dst + i * kWinogradAlpha * kWinogradTiles,
+                           kWinogradTiles);
+        }
+      }
+    }
+
+    for (int64_t ob = 0; ob < blocks; ++ob) {
+      for (int p = 0; p < kWinogradPoints; ++p) {
+        const T* w = u + (p * blocks + ob) * s.in_c * kWinogradBlock;
+        const T* src = v.data() + p * kWinogradTiles;
+        static_assert(kWinogradBlock == 4, "The block is unrolled by hand");
+        T acc[kWinogradBlock][kWinogradTiles] = {{0}};
+        for (int64_t ic = 0; ic < s.in_c; ++ic) {
+          const T* x = src + ic * kWinogradPoints * kWinogradTiles;
+          const T w0 = w[ic * kWinogradBlock];
+          const T w1 = w[ic * kWinogradBlock + 1];
+          const T w2 = w[ic * kWinogradBlock + 2];
+          const T w3 = w[ic * kWinogradBlock + 3];
+          for (int t = 0; t < kWinogradTiles; ++t) {
+            acc[0][t] += w0 * x[t];
+            acc[1][t] += w1 * x[t];
+            acc[2][t] += w2 * x[t];
+            acc[3][t] += w3 * x[t];
+          }
+        }
+        for (int b = 0; b < kWinogradBlock; ++b) {
+          std::copy_n(acc[b], kWinogradTiles,
+                      m.data() + (p * kWinogradBlock + b) * kWinogradTiles);
+        }
+      }
+
+      const int64_t point_stride = kWinogradBlock * kWinogradTiles;
+      for (int b = 0; b < kWinogradBlock; ++b) {
+        const int64_t oc = ob * kWinogradBlock + b;
+        if (oc >= s.out_c) break;
+        T* out = output + (n * s.out_c + oc) * out_plane;
+        for (int64_t t = 0; t < t_count; ++t) {
+          // A^T m A, the columns then the rows
+          const T* src = m.data() + b * kWinogradTiles + t;
+          T tmp[kWinogradOut * kWinogradAlpha];
+          for (int j = 0; j < kWinogradAlpha; ++j) {
+            WinogradOutputRow(src + j * point_stride,
+                              kWinogradAlpha * point_stride, tmp + j,
+                              kWinogradAlpha);
+          }
+          T y[kWinogradOut * kWinogradOut];
+          for (int i = 0; i < kWinogradOut; ++i) {
+            WinogradOutputRow(tmp + i * kWinogradAlpha, 1,
+                              y + i * kWinogradOut, 1);
+          }
+          const int64_t oh0 = (t_begin + t) / tiles_w * kWinogradOut;
+          const int64_t ow0 = (t_begin + t) % tiles_w * kWinogradOut;
+          const int64_t rows = std::min<int64_t>(kWinogradOut, s.out_h - oh0);
+          const int64_t cols = std::min<int64_t>(kWinogradOut, s.out_w - ow0);
+          for (int64_t i = 0; i < rows; ++i) {
+            std::copy_n(y + i * kWinogradOut, cols,
+                        out + (oh0 + i) * s.out_w + ow0);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
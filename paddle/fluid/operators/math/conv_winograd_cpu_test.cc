@@ -0,0 +1,103 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "paddle/fluid/operators/math/conv_winograd_cpu.h"
+
+using paddle::operators::math::ConvDirectShape;
+
+ConvDirectShape WinogradShape(int64_t batch, int64_t in_c, int64_t out_c,
+                              int64_t in_h, int64_t in_w, int64_t pad) {
+  ConvDirectShape s;
+  s.batch = batch;
+  s.in_c = in_c;
+  s.in_h = in_h;
+  s.in_w = in_w;
+  s.out_c = out_c;
+  s.out_h = in_h + 2 * pad - 2;
+  s.out_w = in_w + 2 * pad - 2;
+  s.groups = 1;
+  s.kernel_h = s.kernel_w = 3;
+  s.stride_h = s.stride_w = 1;
+  s.pad_h = s.pad_w = pad;
+  s.dilation_h = s.dilation_w = 1;
+  return s;
+}
+
+// What im2col and GEMM compute, accumulated in double
+void ref_conv3x3(const ConvDirectShape& s, const std::vector<float>& in,
+                 const std::vector<float>& filter, std::vector<double>* out) {
+  for (int64_t n = 0; n < s.batch; ++n) {
+    for (int64_t oc = 0; oc < s.out_c; ++oc) {
+      for (int64_t oh = 0; oh < s.out_h; ++oh) {
+        for (int64_t ow = 0; ow < s.out_w; ++ow) {
+          double sum = 0;
+          for (int64_t ic = 0; ic < s.in_c; ++ic) {
+            for (int64_t r = 0; r < 3; ++r) {
+              for (int64_t c = 0; c < 3; ++c) {
+                int64_t ih = oh - s.pad_h + r, iw = ow - s.pad_w + c;
+                if (ih < 0 || ih >= s.in_h || iw < 0 || iw >= s.in_w) continue;
+                sum += in[((n * s.in_c + ic) * s.in_h + ih) * s.in_w + iw] *
+                       filter[((oc * s.in_c + ic) * 3 + r) * 3 + c];
+              }
+            }
+          }
+          (*out)[((n * s.out_c + oc) * s.out_h + oh) * s.out_w + ow] = sum;
+        }
+      }
+    }
+  }
+}
+
+void TestConvWinograd(const ConvDirectShape& s) {
+  ASSERT_TRUE(paddle::operators::math::UseConvWinograd<float>(s));
+  std::mt19937 engine(s.in_c * 131 + s.out_c * 17 + s.in_h);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> in(s.batch * s.in_c * s.in_h * s.in_w);
+  std::vector<float> filter(s.out_c * s.in_c * 9);
+  for (auto& v : in) v = dist(engine);
+  for (auto& v : filter) v = dist(engine);
+
+  auto& cache =
+      paddle::operators::math::WinogradFilterCache<float>::Instance();
+  std::vector<float> out(s.batch * s.out_c * s.out_h * s.out_w);
+  std::vector<double> ref(out.size());
+  for (int round = 0; round < 2; ++round) {
+    // The second round changes the filter in place, which the cache notices
+    if (round == 1) filter[filter.size() / 2] += 1;
+    auto u = cache.Get(filter.data(), s.out_c, s.in_c);
+    paddle::operators::math::ConvWinogradCPU<float>(s, in.data(), u->data(),
+                                                    out.data());
+    ref_conv3x3(s, in, filter, &ref);
+    // The error of both fp32 paths grows with the input channels
+    const double eps = 1e-5 * std::sqrt(9.0 * s.in_c);
+    for (size_t i = 0; i < out.size(); ++i) {
+      EXPECT_NEAR(out[i], ref[i], eps * (1 + std::fabs(ref[i])));
+    }
+  }
+}
+
+TEST(ConvWinogradCPU, shapes) {
+  // Tiles across the image edges and the task boundary, channels across the
+  // register blocks
+  TestConvWinograd(WinogradShape(1, 8, 8, 6, 6, 0));
+  TestConvWinograd(WinogradShape(2, 8, 10, 9, 13, 1));
+  TestConvWinograd(WinogradShape(1, 16, 9, 30, 29, 1));
+  TestConvWinograd(WinogradShape(1, 64, 32, 14, 14, 1));
+  TestConvWinograd(WinogradShape(1, 12, 8, 7, 5, 2));
+}
@@ -26,7 +26,33 @@ class FCFunctor<platform::CPUDeviceContext, T> {
   void operator()(const platform::CPUDeviceContext& context, const int M,
                   const int N, const int K, const T* X, const T* W, T* Y,
                   const T* B = nullptr, bool relu = false,
-                  bool padding_weights = false) {
+                  bool padding_weights = false,
+                  const T* packed_weights = nullptr) {
+    if (!padding_weights && (B != nullptr || !relu)) {
+      // Small GEMMs run on the jit microkernels with the bias and relu fused,
+      // where the overhead of the BLAS call would dominate
+      jit::matmul_attr_t attr(M, N, K);
+      attr.bias = B;
+      attr.with_relu = relu;
+      if (jit::GetJitCode<jit::MatMulTuple<T>, platform::CPUPlace>(attr)) {
+        auto matmul =
+            jit::KernelFuncs<jit::MatMulTuple<T>, platform::CPUPlace>::Cache()
+                .At(attr);
+        matmul(X, W, Y, &attr);
+        return;
+      }
+    }
+#ifdef PADDLE_WITH_MKLML
+    if (packed_weights != nullptr) {
+      // Larger GEMMs run on W packed by gemm_weight_pack_pass, from the
+      // padded layout if any, so that MKL does not repack W on every call
+      auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
+      blas.GEMM_COMPUTE(CblasNoTrans, CblasPacked, M, N, K, X, K,
+                        packed_weights, N, static_cast<T>(0.0), Y, N);
+      AddBiasRelu(M, N, Y, Y, N, B, relu);
+      return;
+    }
+#endif
     auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
     framework::Tensor Y1;
     T* Y1_data = nullptr;
@@ -47,13 +73,25 @@ class FCFunctor<platform::CPUDeviceContext, T> {
     } else {
       blas.MatMul(M, N, K, X, W, Y);
     }
+    if (padding_weights) {
+      AddBiasRelu(M, N, Y1_data, Y, N + 4, B, relu);
+    } else {
+      AddBiasRelu(M, N, Y, Y, N, B, relu);
+    }
+  }
+
+ private:
+  // Adds the bias and relu to the M x N GEMM result src, of leading dimension
+  // ld, into Y
+  void AddBiasRelu(const int M, const int N, const T* src, T* Y, const int ld,
+                   const T* B, bool relu) {
     if (B == NULL) {
-      if (padding_weights) {
+      if (src != Y) {
 #ifdef PADDLE_WITH_MKLML
 #pragma omp parallel for
 #endif
         for (int i = 0; i < M; i++) {
-          memcpy(Y + i * N, Y1_data + i * (N + 4), N * sizeof(T));
+          memcpy(Y + i * N, src + i * ld, N * sizeof(T));
         }
       }
       PADDLE_ENFORCE_EQ(relu, false,
@@ -72,9 +110,7 @@ class FCFunctor<platform::CPUDeviceContext, T> {
 #pragma omp parallel for
 #endif
     for (int i = 0; i < M; i++) {
-      T* dst = Y + i * N;
-      T* src = (padding_weights) ? Y1_data + i * (N + 4) : dst;
-      compute(B, src, dst, N);
+      compute(B, src + i * ld, Y + i * N, N);
     }
   }
 };
@@ -27,9 +27,29 @@ class FCFunctor {
   void operator()(const DeviceContext& context, const int M, const int N,
                   const int K, const T* X, const T* W, T* Y,
                   const T* B = nullptr, bool relu = false,
-                  bool weight_pass = false);
+                  bool weight_pass = false,
+                  const T* packed_weights = nullptr);
 };
 
+// Y = X * W of the mul and matmul kernels, on W packed by
+// gemm_weight_pack_pass. The pass only packs the weights of CPU programs, so
+// the kernels of the other devices never get packed weights.
+template <typename DeviceContext, typename T>
+void PackedMatMul(const DeviceContext& context, const int M, const int N,
+                  const int K, const T* X, const T* W, const T* packed_weights,
+                  T* Y) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Packed weights are only supported on CPU."));
+}
+
+template <typename T>
+void PackedMatMul(const platform::CPUDeviceContext& context, const int M,
+                  const int N, const int K, const T* X, const T* W,
+                  const T* packed_weights, T* Y) {
+  FCFunctor<platform::CPUDeviceContext, T> fc;
+  fc(context, M, N, K, X, W, Y, nullptr, false, false, packed_weights);
+}
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle
@@ -22,6 +22,12 @@ limitations under the License. */
 #include <cblas.h>
 #endif
 
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <numeric>
 #include <vector>
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/operators/math/math_function_impl.h"
@@ -42,6 +48,281 @@ template struct SetConstant<platform::CPUDeviceContext, int64_t>;
 template struct SetConstant<platform::CPUDeviceContext, bool>;
 template struct SetConstant<platform::CPUDeviceContext, uint8_t>;
 
+// Minimal number of elements to transpose on several threads
+static constexpr int64_t kMinParallelTransposeSize = 1 << 15;
+// Side of the square tiles that a transposed plane is copied in
+static constexpr int64_t kTransposeTile = 32;
+
+// The out dims with their strides in in and out, after dropping the size-1
+// dims and merging the dims that are adjacent in both in and out
+struct TransposeLoopDims {
+  std::vector<int64_t> dims;
+  std::vector<int64_t> in_strides;
+  std::vector<int64_t> out_strides;
+};
+
+static TransposeLoopDims CollapseTransposeDims(
+    const std::vector<int64_t>& in_dims, const std::vector<int>& axis,
+    const std::vector<int64_t>& out_strides) {
+  int rank = in_dims.size();
+  std::vector<int64_t> in_strides(rank, 1);
+  for (int i = rank - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * in_dims[i + 1];
+  }
+  std::vector<int64_t> strides(out_strides);
+  if (strides.empty()) {
+    strides.assign(rank, 1);
+    for (int i = rank - 2; i >= 0; --i) {
+      strides[i] = strides[i + 1] * in_dims[axis[i + 1]];
+    }
+  }
+
+  TransposeLoopDims loop;
+  for (int i = 0; i < rank; ++i) {
+    int64_t dim = in_dims[axis[i]];
+    int64_t in_stride = in_strides[axis[i]];
+    if (dim == 1) continue;
+    if (!loop.dims.empty() && loop.in_strides.back() == in_stride * dim &&
+        loop.out_strides.back() == strides[i] * dim) {
+      loop.dims.back() *= dim;
+      loop.in_strides.back() = in_stride;
+      loop.out_strides.back() = strides[i];
+    } else {
+      loop.dims.push_back(dim);
+      loop.in_strides.push_back(in_stride);
+      loop.out_strides.push_back(strides[i]);
+    }
+  }
+  return loop;
+}
+
+// The offsets in in and out of the index-th element of the dims listed in
+// outer_dims
+static inline void TransposeOffsets(const TransposeLoopDims& loop,
+                                    const std::vector<int>& outer_dims,
+                                    int64_t index, int64_t* in_offset,
+                                    int64_t* out_offset) {
+  *in_offset = 0;
+  *out_offset = 0;
+  for (int i = static_cast<int>(outer_dims.size()) - 1; i >= 0; --i) {
+    int dim = outer_dims[i];
+    int64_t idx = index % loop.dims[dim];
+    index /= loop.dims[dim];
+    *in_offset += idx * loop.in_strides[dim];
+    *out_offset += idx * loop.out_strides[dim];
+  }
+}
+
+#ifdef __AVX__
+// out[j * out_stride + i] = in[i * in_stride + j] for an 8x8 block of 32-bit
+// elements, with the unpack/shuffle/permute sequence in registers
+static inline void Transpose8x8(const uint32_t* in, int64_t in_stride,
+                                uint32_t* out, int64_t out_stride) {
+  const float* src = reinterpret_cast<const float*>(in);
+  float* dst = reinterpret_cast<float*>(out);
+  __m256 r0 = _mm256_loadu_ps(src);
+  __m256 r1 = _mm256_loadu_ps(src + in_stride);
+  __m256 r2 = _mm256_loadu_ps(src + 2 * in_stride);
+  __m256 r3 = _mm256_loadu_ps(src + 3 * in_stride);
+  __m256 r4 = _mm256_loadu_ps(src + 4 * in_stride);
+  __m256 r5 = _mm256_loadu_ps(src + 5 * in_stride);
+  __m256 r6 = _mm256_loadu_ps(src + 6 * in_stride);
+  __m256 r7 = _mm256_loadu_ps(src + 7 * in_stride);
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+  r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  _mm256_storeu_ps(dst, _mm256_permute2f128_ps(r0, r4, 0x20));
+  _mm256_storeu_ps(dst + out_stride, _mm256_permute2f128_ps(r1, r5, 0x20));
+  _mm256_storeu_ps(dst + 2 * out_stride,
+                   _mm256_permute2f128_ps(r2, r6, 0x20));
+  _mm256_storeu_ps(dst + 3 * out_stride,
+                   _mm256_permute2f128_ps(r3, r7, 0x20));
+  _mm256_storeu_ps(dst + 4 * out_stride,
+                   _mm256_permute2f128_ps(r0, r4, 0x31));
+  _mm256_storeu_ps(dst + 5 * out_stride,
+                   _mm256_permute2f128_ps(r1, r5, 0x31));
+  _mm256_storeu_ps(dst + 6 * out_stride,
+                   _mm256_permute2f128_ps(r2, r6, 0x31));
+  _mm256_storeu_ps(dst + 7 * out_stride,
+                   _mm256_permute2f128_ps(r3, r7, 0x31));
+}
+#endif
+
+// out[j * out_stride + i] = in[i * in_stride + j] for a rows x cols tile
+template <typename T>
+static inline void TransposeTileScalar(const T* in, int64_t in_stride, T* out,
+                                       int64_t out_stride, int64_t rows,
+                                       int64_t cols) {
+  for (int64_t j = 0; j < cols; ++j) {
+    for (int64_t i = 0; i < rows; ++i) {
+      out[j * out_stride + i] = in[i * in_stride + j];
+    }
+  }
+}
+
+template <typename T>
+static inline void TransposeTile(const T* in, int64_t in_stride, T* out,
+                                 int64_t out_stride, int64_t rows,
+                                 int64_t cols) {
+  TransposeTileScalar(in, in_stride, out, out_stride, rows, cols);
+}
+
+#ifdef __AVX__
+template <>
+inline void TransposeTile<uint32_t>(const uint32_t* in, int64_t in_stride,
+                                    uint32_t* out, int64_t out_stride,
+                                    int64_t rows, int64_t cols) {
+  int64_t full_rows = rows / 8 * 8, full_cols = cols / 8 * 8;
+  for (int64_t i = 0; i < full_rows; i += 8) {
+    for (int64_t j = 0; j < full_cols; j += 8) {
+      Transpose8x8(in + i * in_stride + j, in_stride, out + j * out_stride + i,
+                   out_stride);
+    }
+  }
+  if (full_cols < cols) {
+    TransposeTileScalar(in + full_cols, in_stride,
+                        out + full_cols * out_stride, out_stride, rows,
+                        cols - full_cols);
+  }
+  if (full_rows < rows) {
+    TransposeTileScalar(in + full_rows * in_stride, in_stride,
+                        out + full_rows, out_stride, rows - full_rows,
+                        full_cols);
+  }
+}
+#endif
+
+template <typename T>
+static void TransposeCPUImpl(const T* in, T* out,
+                             const TransposeLoopDims& loop) {
+  int rank = loop.dims.size();
+  int64_t numel = 1;
+  for (auto dim : loop.dims) numel *= dim;
+  if (rank == 0) {
+    *out = *in;
+    return;
+  }
+
+  int inner = rank - 1;
+  if (loop.in_strides[inner] == 1 && loop.out_strides[inner] == 1) {
+    // The innermost dim is kept, every row is one copy
+    std::vector<int> outer_dims(inner);
+    std::iota(outer_dims.begin(), outer_dims.end(), 0);
+    int64_t len = loop.dims[inner];
+    int64_t rows = numel / len;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (numel >= kMinParallelTransposeSize)
+#endif
+    for (int64_t row = 0; row < rows; ++row) {
+      int64_t in_offset, out_offset;
+      TransposeOffsets(loop, outer_dims, row, &in_offset, &out_offset);
+      std::copy(in + in_offset, in + in_offset + len, out + out_offset);
+    }
+    return;
+  }
+
+  // The dim contiguous in in, it becomes the columns of the transposed plane
+  int col_dim = std::find(loop.in_strides.begin(), loop.in_strides.end(), 1) -
+                loop.in_strides.begin();
+  if (col_dim == rank || loop.out_strides[inner] != 1) {
+    // Out strides that do not end with 1, copy element by element
+    std::vector<int> outer_dims(rank);
+    std::iota(outer_dims.begin(), outer_dims.end(), 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (numel >= kMinParallelTransposeSize)
+#endif
+    for (int64_t i = 0; i < numel; ++i) {
+      int64_t in_offset, out_offset;
+      TransposeOffsets(loop, outer_dims, i, &in_offset, &out_offset);
+      out[out_offset] = in[in_offset];
+    }
+    return;
+  }
+
+  std::vector<int> outer_dims;
+  for (int i = 0; i < rank; ++i) {
+    if (i != col_dim && i != inner) outer_dims.push_back(i);
+  }
+  int64_t rows = loop.dims[inner], cols = loop.dims[col_dim];
+  int64_t row_tiles = (rows + kTransposeTile - 1) / kTransposeTile;
+  int64_t col_tiles = (cols + kTransposeTile - 1) / kTransposeTile;
+  int64_t tasks = numel / (rows * cols) * row_tiles * col_tiles;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (numel >= kMinParallelTransposeSize)
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    int64_t in_offset, out_offset;
+    TransposeOffsets(loop, outer_dims, t / (row_tiles * col_tiles),
+                     &in_offset, &out_offset);
+    int64_t row = t / col_tiles % row_tiles * kTransposeTile;
+    int64_t col = t % col_tiles * kTransposeTile;
+    TransposeTile(in + in_offset + row * loop.in_strides[inner] + col,
+                  loop.in_strides[inner],
+                  out + out_offset + col * loop.out_strides[col_dim] + row,
+                  loop.out_strides[col_dim],
+                  std::min(kTransposeTile, rows - row),
+                  std::min(kTransposeTile, cols - col));
+  }
+}
+
+void TransposeCPU(const void* in, void* out, size_t elem_size,
+                  const std::vector<int64_t>& in_dims,
+                  const std::vector<int>& axis,
+                  const std::vector<int64_t>& out_strides) {
+  PADDLE_ENFORCE_EQ(
+      axis.size(), in_dims.size(),
+      platform::errors::InvalidArgument(
+          "The size of axis (%d) should be equal to the rank of input (%d).",
+          axis.size(), in_dims.size()));
+  for (auto dim : in_dims) {
+    if (dim == 0) return;
+  }
+  auto loop = CollapseTransposeDims(in_dims, axis, out_strides);
+  switch (elem_size) {
+    case 1:
+      TransposeCPUImpl(static_cast<const uint8_t*>(in),
+                       static_cast<uint8_t*>(out), loop);
+      break;
+    case 2:
+      TransposeCPUImpl(static_cast<const uint16_t*>(in),
+                       static_cast<uint16_t*>(out), loop);
+      break;
+    case 4:
+      TransposeCPUImpl(static_cast<const uint32_t*>(in),
+                       static_cast<uint32_t*>(out), loop);
+      break;
+    case 8:
+      TransposeCPUImpl(static_cast<const uint64_t*>(in),
+                       static_cast<uint64_t*>(out), loop);
+      break;
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Transposing elements of %d bytes is not supported on CPU.",
+          elem_size));
+  }
+}
+
+template <typename T, int Rank>
+void Transpose<platform::CPUDeviceContext, T, Rank>::operator()(
+    const platform::CPUDeviceContext& context, const framework::Tensor& in,
+    framework::Tensor* out, const std::vector<int>& axis) {
+  TransposeCPU(in.data<T>(), out->data<T>(), sizeof(T),
+               framework::vectorize(in.dims()), axis);
+}
+
 #define DEFINE_CPU_TRANS(RANK)                                              \
   template struct Transpose<platform::CPUDeviceContext, platform::float16,  \
                             RANK>;                                          \
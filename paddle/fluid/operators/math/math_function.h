@@ -32,6 +32,27 @@ struct Transpose {
                   framework::Tensor* out, const std::vector<int>& axis);
 };
 
+// The CPU transpose runs on TransposeCPU instead of an Eigen shuffle
+template <typename T, int Rank>
+struct Transpose<platform::CPUDeviceContext, T, Rank> {
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& in, framework::Tensor* out,
+                  const std::vector<int>& axis);
+};
+
+// Copies the elements of size elem_size from in to out with out dim i being
+// in dim axis[i]. out_strides gives the stride of every out dim in elements,
+// so the result can be written into a slice of a larger tensor, and it is
+// contiguous when out_strides is empty.
+// The dims that stay adjacent are merged first. Rows are then copied as a
+// whole when the innermost dim is kept, otherwise the plane of the two
+// innermost dims of in and out is transposed in cache sized tiles. The
+// tiles or rows are split between threads.
+void TransposeCPU(const void* in, void* out, size_t elem_size,
+                  const std::vector<int64_t>& in_dims,
+                  const std::vector<int>& axis,
+                  const std::vector<int64_t>& out_strides = {});
+
 template <typename DeviceContext, typename T>
 struct SetConstant {
   void operator()(const DeviceContext& context, framework::Tensor* tensor,
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "paddle/fluid/operators/math/math_function.h"
+#include <vector>
 #include "gtest/gtest.h"
 #include "paddle/fluid/operators/math/blas.h"
 
@@ -282,3 +283,73 @@ TEST(math_function, gemm_warp) {
   GemmWarpTest<double>(8, 5, 6, 1.0, 0.0);
   GemmWarpTest<double>(8, 5, 6, 2.0, 1.0);
 }
+
+template <typename T>
+void TransposeTest(const std::vector<int64_t>& in_dims,
+                   const std::vector<int>& axis) {
+  int rank = in_dims.size();
+  paddle::framework::Tensor in, out;
+  auto* cpu_place = new paddle::platform::CPUPlace();
+  T* in_data = in.mutable_data<T>(paddle::framework::make_ddim(in_dims),
+                                  *cpu_place);
+  std::vector<int64_t> out_dims(rank);
+  for (int i = 0; i < rank; ++i) out_dims[i] = in_dims[axis[i]];
+  T* out_data = out.mutable_data<T>(paddle::framework::make_ddim(out_dims),
+                                    *cpu_place);
+  for (int64_t i = 0; i < in.numel(); ++i) {
+    in_data[i] = static_cast<T>(i % 127);
+  }
+
+  paddle::platform::CPUDeviceContext context(*cpu_place);
+  switch (rank) {
+    case 2:
+      paddle::operators::math::Transpose<paddle::platform::CPUDeviceContext,
+                                         T, 2>()(context, in, &out, axis);
+      break;
+    case 4:
+      paddle::operators::math::Transpose<paddle::platform::CPUDeviceContext,
+                                         T, 4>()(context, in, &out, axis);
+      break;
+    default:
+      FAIL() << "Unexpected rank " << rank;
+  }
+
+  std::vector<int64_t> in_strides(rank, 1);
+  for (int i = rank - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * in_dims[i + 1];
+  }
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    int64_t index = i, in_offset = 0;
+    for (int j = rank - 1; j >= 0; --j) {
+      in_offset += index % out_dims[j] * in_strides[axis[j]];
+      index /= out_dims[j];
+    }
+    ASSERT_EQ(out_data[i], in_data[in_offset]);
+  }
+  delete cpu_place;
+}
+
+TEST(math_function, transpose) {
+  TransposeTest<float>({37, 53}, {1, 0});
+  TransposeTest<float>({64, 64}, {1, 0});
+  TransposeTest<float>({2, 128, 12, 64}, {0, 2, 1, 3});
+  TransposeTest<float>({2, 16, 33, 33}, {0, 2, 3, 1});
+  TransposeTest<double>({2, 33, 33, 16}, {0, 3, 1, 2});
+  TransposeTest<int64_t>({3, 5, 7, 9}, {3, 1, 2, 0});
+  TransposeTest<uint8_t>({1, 17, 1, 9}, {3, 2, 1, 0});
+  TransposeTest<paddle::platform::float16>({4, 3, 40, 20}, {0, 3, 2, 1});
+}
+
+TEST(math_function, transpose_strided_out) {
+  // [2, 3, 4] transposed to [3, 2, 4] into rows that are 10 elements apart
+  std::vector<float> in(24), out(30, -1.f);
+  for (int i = 0; i < 24; ++i) in[i] = i;
+  paddle::operators::math::TransposeCPU(in.data(), out.data(), sizeof(float),
+                                        {2, 3, 4}, {1, 0, 2}, {10, 4, 1});
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      float expected = j < 8 ? in[(j / 4) * 12 + i * 4 + j % 4] : -1.f;
+      EXPECT_EQ(out[i * 10 + j], expected);
+    }
+  }
+}
@@ -0,0 +1,164 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+constexpr int64_t kMinParallelNormSize = 1 << 15;
+// Independent partial sums of a row reduction, enough for the compiler to
+// keep them in one vector register
+constexpr int kNormLanes = 8;
+
+template <typename T>
+inline T NormRowSum(const T* x, int64_t n) {
+  T acc[kNormLanes] = {0};
+  int64_t i = 0;
+  for (; i + kNormLanes <= n; i += kNormLanes) {
+    for (int k = 0; k < kNormLanes; ++k) acc[k] += x[i + k];
+  }
+  for (; i < n; ++i) acc[0] += x[i];
+  T sum = 0;
+  for (int k = 0; k < kNormLanes; ++k) sum += acc[k];
+  return sum;
+}
+
+template <typename T>
+inline T NormRowSquaredDeviation(const T* x, T mean, int64_t n) {
+  T acc[kNormLanes] = {0};
+  int64_t i = 0;
+  for (; i + kNormLanes <= n; i += kNormLanes) {
+    for (int k = 0; k < kNormLanes; ++k) {
+      T d = x[i + k] - mean;
+      acc[k] += d * d;
+    }
+  }
+  for (; i < n; ++i) acc[0] += (x[i] - mean) * (x[i] - mean);
+  T sum = 0;
+  for (int k = 0; k < kNormLanes; ++k) sum += acc[k];
+  return sum;
+}
+
+// The input of a fused layer_norm: act(x + bias0) + residual, where bias0 is
+// broadcast over the rows and any of the parts may be absent.
+template <typename T>
+struct LayerNormInput {
+  const T* x = nullptr;
+  const T* bias0 = nullptr;
+  const T* residual = nullptr;
+  bool relu = false;
+
+  bool fused() const { return bias0 || residual || relu; }
+};
+
+// Normalizes one row of width elements in three passes, the first of which
+// also builds the fused input into out. The row is in cache after it, so the
+// variance is a second exact pass rather than a running update.
+template <typename T>
+void LayerNormRow(const LayerNormInput<T>& in, const T* scale, const T* bias,
+                  T* out, T* mean, T* var, int64_t width, T epsilon) {
+  const T* src = in.x;
+  if (in.fused()) {
+    for (int64_t j = 0; j < width; ++j) {
+      T v = in.bias0 ? in.x[j] + in.bias0[j] : in.x[j];
+      v = in.relu && v < static_cast<T>(0) ? static_cast<T>(0) : v;
+      out[j] = in.residual ? v + in.residual[j] : v;
+    }
+    src = out;
+  }
+  T m = NormRowSum(src, width) / static_cast<T>(width);
+  T v = NormRowSquaredDeviation(src, m, width) / static_cast<T>(width);
+  if (mean) *mean = m;
+  if (var) *var = v;
+
+  T inv_std = static_cast<T>(1) / std::sqrt(v + epsilon);
+  if (scale && bias) {
+    for (int64_t j = 0; j < width; ++j) {
+      out[j] = (src[j] - m) * inv_std * scale[j] + bias[j];
+    }
+  } else if (scale) {
+    for (int64_t j = 0; j < width; ++j) {
+      out[j] = (src[j] - m) * inv_std * scale[j];
+    }
+  } else if (bias) {
+    for (int64_t j = 0; j < width; ++j) {
+      out[j] = (src[j] - m) * inv_std + bias[j];
+    }
+  } else {
+    for (int64_t j = 0; j < width; ++j) {
+      out[j] = (src[j] - m) * inv_std;
+    }
+  }
+}
+
+// layer_norm over the rows of a [rows, width] matrix, the rows in parallel.
+// The inputs in `in` and mean / var are offset by the row, bias0, scale and
+// bias are shared by all of them. out may be in.x.
+template <typename T>
+void LayerNormCPU(const LayerNormInput<T>& in, const T* scale, const T* bias,
+                  T* out, T* mean, T* var, int64_t rows, int64_t width,
+                  float epsilon) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (rows * width >= kMinParallelNormSize)
+#endif
+  for (int64_t i = 0; i < rows; ++i) {
+    LayerNormInput<T> row_in(in);
+    row_in.x = in.x + i * width;
+    row_in.residual = in.residual ? in.residual + i * width : nullptr;
+    LayerNormRow(row_in, scale, bias, out + i * width, mean ? mean + i : mean,
+                 var ? var + i : var, width, static_cast<T>(epsilon));
+  }
+}
+
+// y = x * scale[c] + bias[c] for every channel c of an NCHW (channel_last
+// false) or NHWC tensor, that is batch_norm with its statistics folded into
+// scale and bias.
+template <typename T>
+void BatchNormAffineCPU(const T* x, const T* scale, const T* bias, T* y,
+                        int64_t N, int64_t C, int64_t sample_size,
+                        bool channel_last) {
+  if (!channel_last) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (N * C * sample_size >= kMinParallelNormSize)
+#endif
+    for (int64_t nc = 0; nc < N * C; ++nc) {
+      const T* src = x + nc * sample_size;
+      T* dst = y + nc * sample_size;
+      const T s = scale[nc % C];
+      const T b = bias[nc % C];
+      for (int64_t j = 0; j < sample_size; ++j) {
+        dst[j] = src[j] * s + b;
+      }
+    }
+  } else {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (N * C * sample_size >= kMinParallelNormSize)
+#endif
+    for (int64_t i = 0; i < N * sample_size; ++i) {
+      const T* src = x + i * C;
+      T* dst = y + i * C;
+      for (int64_t c = 0; c < C; ++c) {
+        dst[c] = src[c] * scale[c] + bias[c];
+      }
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,191 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "paddle/fluid/operators/math/cpu_vec.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// Elements of a contiguous row are exponentiated this many at a time in a
+// stack buffer
+constexpr int kSoftmaxChunkSize = 512;
+// Columns of a strided axis handled together, their whole axis stays in
+// cache between the passes
+constexpr int kSoftmaxColumnTile = 64;
+constexpr int64_t kMinParallelSoftmaxSize = 1 << 15;
+
+// The shifted logits are clipped here, as ValueClip does
+template <typename T>
+inline T SoftmaxClip(T x) {
+  const T kThreshold = static_cast<T>(-64.);
+  return x < kThreshold ? kThreshold : x;
+}
+
+template <typename T>
+inline T SoftmaxSum(const T* x, int n) {
+  T acc[4] = {0, 0, 0, 0};
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc[0] += x[i];
+    acc[1] += x[i + 1];
+    acc[2] += x[i + 2];
+    acc[3] += x[i + 3];
+  }
+  for (; i < n; ++i) acc[0] += x[i];
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+// The max of x[0, n) and the sum of exp(x - max), in one read of x: the sum
+// is rescaled whenever a chunk raises the max.
+template <typename T>
+void SoftmaxRowMaxSum(const T* x, int64_t n, T* max, T* sum) {
+  T buf[kSoftmaxChunkSize];
+  T m = -std::numeric_limits<T>::infinity();
+  T s = 0;
+  for (int64_t c = 0; c < n; c += kSoftmaxChunkSize) {
+    int len = static_cast<int>(std::min<int64_t>(kSoftmaxChunkSize, n - c));
+    const T* src = x + c;
+    T chunk_max = src[0];
+    for (int i = 1; i < len; ++i) {
+      chunk_max = chunk_max < src[i] ? src[i] : chunk_max;
+    }
+    if (chunk_max > m) {
+      s *= std::exp(m - chunk_max);
+      m = chunk_max;
+    }
+    for (int i = 0; i < len; ++i) {
+      buf[i] = SoftmaxClip(src[i] - m);
+    }
+    vec_exp<T>(len, buf, buf);
+    s += SoftmaxSum(buf, len);
+  }
+  *max = m;
+  *sum = s;
+}
+
+// y = softmax(x) or log_softmax(x) of one contiguous row, with one read of
+// x for the statistics and one pass writing y
+template <typename T, bool kLog>
+void SoftmaxRow(const T* x, T* y, int64_t n) {
+  T m, s;
+  SoftmaxRowMaxSum(x, n, &m, &s);
+  if (kLog) {
+    T shift = m + std::log(s);
+    T floor = m - static_cast<T>(64.);
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = (x[i] < floor ? floor : x[i]) - shift;
+    }
+    return;
+  }
+  T scale = static_cast<T>(1) / s;
+  for (int64_t c = 0; c < n; c += kSoftmaxChunkSize) {
+    int len = static_cast<int>(std::min<int64_t>(kSoftmaxChunkSize, n - c));
+    T* dst = y + c;
+    for (int i = 0; i < len; ++i) {
+      dst[i] = SoftmaxClip(x[c + i] - m);
+    }
+    vec_exp<T>(len, dst, dst);
+    for (int i = 0; i < len; ++i) {
+      dst[i] *= scale;
+    }
+  }
+}
+
+// The same for width columns of a strided axis: x[j * inner + k] for j in
+// [0, axis_dim). The tile is read once for the max and once for the sum, it
+// is small enough to be in cache for the second read and for the output.
+template <typename T, bool kLog>
+void SoftmaxColumns(const T* x, T* y, int64_t axis_dim, int64_t inner,
+                    int width) {
+  T m[kSoftmaxColumnTile];
+  T s[kSoftmaxColumnTile];
+  T buf[kSoftmaxColumnTile];
+  std::copy(x, x + width, m);
+  for (int64_t j = 1; j < axis_dim; ++j) {
+    const T* src = x + j * inner;
+    for (int k = 0; k < width; ++k) {
+      m[k] = m[k] < src[k] ? src[k] : m[k];
+    }
+  }
+  std::fill(s, s + width, static_cast<T>(0));
+  for (int64_t j = 0; j < axis_dim; ++j) {
+    const T* src = x + j * inner;
+    T* dst = kLog ? buf : y + j * inner;
+    for (int k = 0; k < width; ++k) {
+      dst[k] = SoftmaxClip(src[k] - m[k]);
+    }
+    vec_exp<T>(width, dst, dst);
+    for (int k = 0; k < width; ++k) {
+      s[k] += dst[k];
+    }
+  }
+  if (kLog) {
+    for (int k = 0; k < width; ++k) {
+      s[k] = std::log(s[k]);
+    }
+    for (int64_t j = 0; j < axis_dim; ++j) {
+      const T* src = x + j * inner;
+      T* dst = y + j * inner;
+      for (int k = 0; k < width; ++k) {
+        dst[k] = SoftmaxClip(src[k] - m[k]) - s[k];
+      }
+    }
+  } else {
+    for (int k = 0; k < width; ++k) {
+      s[k] = static_cast<T>(1) / s[k];
+    }
+    for (int64_t j = 0; j < axis_dim; ++j) {
+      T* dst = y + j * inner;
+      for (int k = 0; k < width; ++k) {
+        dst[k] *= s[k];
+      }
+    }
+  }
+}
+
+// y = softmax(x) (or log_softmax with kLog) along the middle dim of x viewed
+// as [outer, axis_dim, inner], threaded over the rows or column tiles.
+template <typename T, bool kLog>
+void SoftmaxCPU(const T* x, T* y, int64_t outer, int64_t axis_dim,
+                int64_t inner) {
+  if (outer * axis_dim * inner == 0) return;
+  int64_t tiles = (inner + kSoftmaxColumnTile - 1) / kSoftmaxColumnTile;
+  int64_t tasks = outer * tiles;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (outer * axis_dim * inner >= \
+                             kMinParallelSoftmaxSize)
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    int64_t o = t / tiles;
+    int64_t col = t % tiles * kSoftmaxColumnTile;
+    const T* src = x + o * axis_dim * inner + col;
+    T* dst = y + o * axis_dim * inner + col;
+    if (inner == 1) {
+      SoftmaxRow<T, kLog>(src, dst, axis_dim);
+    } else {
+      int width = static_cast<int>(
+          std::min<int64_t>(kSoftmaxColumnTile, inner - col));
+      SoftmaxColumns<T, kLog>(src, dst, axis_dim, inner, width);
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
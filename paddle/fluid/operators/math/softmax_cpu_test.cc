@@ -0,0 +1,87 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "paddle/fluid/operators/math/softmax_cpu.h"
+
+template <typename T, bool kLog>
+void ref_softmax(const std::vector<T>& x, std::vector<T>* y, int64_t outer,
+                 int64_t axis_dim, int64_t inner) {
+  for (int64_t i = 0; i < outer; ++i) {
+    for (int64_t k = 0; k < inner; ++k) {
+      const T* src = x.data() + i * axis_dim * inner + k;
+      T* dst = y->data() + i * axis_dim * inner + k;
+      T max = src[0];
+      for (int64_t j = 1; j < axis_dim; ++j) {
+        max = std::max(max, src[j * inner]);
+      }
+      T sum = 0;
+      for (int64_t j = 0; j < axis_dim; ++j) {
+        sum += std::exp(std::max(src[j * inner] - max, static_cast<T>(-64)));
+      }
+      for (int64_t j = 0; j < axis_dim; ++j) {
+        T shifted = std::max(src[j * inner] - max, static_cast<T>(-64));
+        dst[j * inner] =
+            kLog ? shifted - std::log(sum) : std::exp(shifted) / sum;
+      }
+    }
+  }
+}
+
+template <typename T, bool kLog>
+void TestSoftmax(int64_t outer, int64_t axis_dim, int64_t inner, T scale,
+                 T eps) {
+  std::mt19937 engine(outer * 131 + axis_dim * 17 + inner);
+  std::uniform_real_distribution<T> dist(-scale, scale);
+  std::vector<T> x(outer * axis_dim * inner);
+  for (auto& v : x) {
+    v = dist(engine);
+  }
+  std::vector<T> y(x.size()), ref(x.size());
+  paddle::operators::math::SoftmaxCPU<T, kLog>(x.data(), y.data(), outer,
+                                               axis_dim, inner);
+  ref_softmax<T, kLog>(x, &ref, outer, axis_dim, inner);
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(y[i], ref[i], eps * (1 + std::fabs(ref[i])));
+  }
+}
+
+template <typename T, bool kLog>
+void TestSoftmaxShapes(T eps) {
+  // Contiguous rows across the chunk boundary, then strided axes across the
+  // column tile boundary
+  const int64_t shapes[][3] = {{3, 1, 1},   {4, 7, 1},    {2, 512, 1},
+                               {2, 513, 1}, {3, 3000, 1}, {2, 5, 3},
+                               {3, 17, 64}, {2, 9, 65},   {1, 300, 200}};
+  for (auto& shape : shapes) {
+    for (T scale : {static_cast<T>(1), static_cast<T>(100)}) {
+      TestSoftmax<T, kLog>(shape[0], shape[1], shape[2], scale, eps);
+    }
+  }
+}
+
+TEST(SoftmaxCPU, softmax) {
+  TestSoftmaxShapes<float, false>(1e-5f);
+  TestSoftmaxShapes<double, false>(1e-12);
+}
+
+TEST(SoftmaxCPU, log_softmax) {
+  TestSoftmaxShapes<float, true>(1e-5f);
+  TestSoftmaxShapes<double, true>(1e-12);
+}
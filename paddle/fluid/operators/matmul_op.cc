@@ -16,7 +16,10 @@ limitations under the License. */
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/fc.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -56,6 +59,45 @@ static framework::DDim ColumnMatrixFromVector(const framework::DDim &y_dim) {
   return framework::make_ddim({y_dim[0], 1});
 }
 
+// Small GEMMs without transposes and scaling run on the jit microkernels,
+// where the overhead of the BLAS call would dominate. Returns false if the
+// jit kernels can not be used.
+template <typename DeviceContext, typename T>
+static bool MatMulWithJitKernel(const framework::Tensor &x,
+                                const math::MatDescriptor &mat_dim_a,
+                                const framework::Tensor &y,
+                                const math::MatDescriptor &mat_dim_b, T alpha,
+                                framework::Tensor *out) {
+  if (!std::is_same<DeviceContext, platform::CPUDeviceContext>::value ||
+      mat_dim_a.trans_ || mat_dim_b.trans_ || alpha != static_cast<T>(1)) {
+    return false;
+  }
+  if (mat_dim_a.batch_size_ != 0 && mat_dim_b.batch_size_ != 0 &&
+      mat_dim_a.batch_size_ != mat_dim_b.batch_size_) {
+    return false;
+  }
+  jit::matmul_attr_t attr(mat_dim_a.height_, mat_dim_b.width_,
+                          mat_dim_a.width_);
+  if (!jit::GetJitCode<jit::MatMulTuple<T>, platform::CPUPlace>(attr)) {
+    return false;
+  }
+  auto matmul =
+      jit::KernelFuncs<jit::MatMulTuple<T>, platform::CPUPlace>::Cache().At(
+          attr);
+  const T *a_data = x.data<T>();
+  const T *b_data = y.data<T>();
+  T *out_data = out->data<T>();
+  int64_t batch_size =
+      std::max<int64_t>(std::max(mat_dim_a.batch_size_, mat_dim_b.batch_size_),
+                        1);
+  for (int64_t i = 0; i < batch_size; ++i) {
+    matmul(a_data + (mat_dim_a.batch_size_ ? i * mat_dim_a.stride_ : 0),
+           b_data + (mat_dim_b.batch_size_ ? i * mat_dim_b.stride_ : 0),
+           out_data + i * attr.m * attr.n, &attr);
+  }
+  return true;
+}
+
 template <typename DeviceContext, typename T>
 class MatMulKernel : public framework::OpKernel<T> {
  public:
@@ -88,6 +130,27 @@ class MatMulKernel : public framework::OpKernel<T> {
         mat_dim_a.batch_size_ = 0;
       }
     }
+    if (head_number <= 1 &&
+        MatMulWithJitKernel<DeviceContext, T>(x, mat_dim_a, y, mat_dim_b,
+                                              scale, out)) {
+      return;
+    }
+    // gemm_weight_pack_pass only packs the Y of 2-D weights without
+    // transposes and scaling. The attributes are checked again here, since
+    // they may be changed after the pass, and the other cases fall back to
+    // the blas.
+    auto *packed_y = context.Input<framework::Tensor>("PackedY");
+    if (packed_y != nullptr && head_number <= 1 && y_dims.size() == 2 &&
+        !mat_dim_a.trans_ && !mat_dim_b.trans_ && mat_dim_b.batch_size_ == 0 &&
+        scale == static_cast<T>(1)) {
+      auto &dev_ctx = context.template device_context<DeviceContext>();
+      int64_t M =
+          mat_dim_a.height_ * std::max<int64_t>(mat_dim_a.batch_size_, 1);
+      math::PackedMatMul(dev_ctx, M, mat_dim_b.width_, mat_dim_a.width_,
+                         x.data<T>(), y.data<T>(), packed_y->data<T>(),
+                         out->data<T>());
+      return;
+    }
 #if defined(PADDLE_WITH_MKLML) && !defined(PADDLE_WITH_CUDA)
     bool split_vertical_y = (mat_dim_a.width_ != mat_dim_b.height_);
 
@@ -499,6 +562,10 @@ class MatMulOpMaker : public framework::OpProtoAndCheckerMaker {
   void Make() override {
     AddInput("X", "The first input of MatMul op");
     AddInput("Y", "The second input of MatMul op");
+    AddInput("PackedY",
+             "(Tensor, optional) Y packed for MKL by gemm_weight_pack_pass, "
+             "used in place of Y on CPU.")
+        .AsDispensable();
     AddOutput("Out", "The output of MatMul op");
     AddAttr<bool>("transpose_X",
                   R"DOC(If true, use the transpose of `X`.
@@ -676,3 +743,8 @@ REGISTER_OP_CUDA_KERNEL(
     ops::MatMulGradKernel<paddle::platform::CUDADeviceContext,
                           paddle::platform::float16>);
 #endif
+
+REGISTER_OP_VERSION(matmul).AddCheckpoint(
+    R"ROC(Add the dispensable input `PackedY` of the pre-packed weights.)ROC",
+    paddle::framework::compatible::OpVersionDesc().NewInput(
+        "PackedY", "The weight Y packed for MKL by gemm_weight_pack_pass."));
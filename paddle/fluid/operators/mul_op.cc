@@ -17,6 +17,7 @@ limitations under the License. */
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "paddle/fluid/framework/op_version_registry.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -127,6 +128,10 @@ class MulOpMaker : public framework::OpProtoAndCheckerMaker {
   void Make() override {
     AddInput("X", "(Tensor), The first input tensor of mul op.");
     AddInput("Y", "(Tensor), The second input tensor of mul op.");
+    AddInput("PackedY",
+             "(Tensor, optional) Y packed for MKL by gemm_weight_pack_pass, "
+             "used in place of Y on CPU.")
+        .AsDispensable();
     AddOutput("Out", "(Tensor), The output tensor of mul op.");
     AddAttr<bool>("use_mkldnn",
                   "(bool, default false) Only used in mkldnn kernel")
@@ -326,3 +331,8 @@ REGISTER_OP_CPU_KERNEL(
     mul_grad_grad,
     ops::MulDoubleGradKernel<paddle::platform::CPUDeviceContext, float>,
     ops::MulDoubleGradKernel<paddle::platform::CPUDeviceContext, double>);
+
+REGISTER_OP_VERSION(mul).AddCheckpoint(
+    R"ROC(Add the dispensable input `PackedY` of the pre-packed weights.)ROC",
+    paddle::framework::compatible::OpVersionDesc().NewInput(
+        "PackedY", "The weight Y packed for MKL by gemm_weight_pack_pass."));
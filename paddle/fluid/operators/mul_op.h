@@ -17,6 +17,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/fc.h"
 #include "paddle/fluid/operators/math/math_function.h"
 
 namespace paddle {
@@ -50,9 +51,19 @@ class MulKernel : public framework::OpKernel<T> {
       z->Resize({x_matrix.dims()[0], y_matrix.dims()[1]});
     }
 
-    auto blas = math::GetBlas<DeviceContext, T>(context);
-
-    blas.MatMul(x_matrix, y_matrix, z);
+    // gemm_weight_pack_pass packs the Y of 2-D weights only, so the other
+    // shapes fall back to the blas
+    auto* packed_y = context.Input<Tensor>("PackedY");
+    if (packed_y != nullptr && y->dims().size() == 2) {
+      auto& dev_ctx = context.template device_context<DeviceContext>();
+      math::PackedMatMul(
+          dev_ctx, x_matrix.dims()[0], y_matrix.dims()[1], x_matrix.dims()[1],
+          x_matrix.data<T>(), y_matrix.data<T>(), packed_y->data<T>(),
+          z->data<T>());
+    } else {
+      auto blas = math::GetBlas<DeviceContext, T>(context);
+      blas.MatMul(x_matrix, y_matrix, z);
+    }
     if (z_dim.size() != 2) {
       z->Resize(z_dim);
     }
@@ -0,0 +1,389 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+
+// Minimal number of elements to run a reduction on several threads
+constexpr int64_t kMinParallelReduceSize = 1 << 15;
+// Fewer (outer, column tile) tasks than this also split the reduced axis
+constexpr int64_t kMinParallelReduceTasks = 64;
+// Rows reduced by a plain loop at the leaves of the pairwise tree
+constexpr int64_t kPairwiseReduceBlock = 128;
+// Columns reduced together when the reduced axis is not the innermost one
+constexpr int64_t kReduceColumnTile = 64;
+// Elements handled by one task when a long axis is split between threads
+constexpr int64_t kReduceChunkSize = 1 << 14;
+
+// The input dims with the size-1 dims dropped and the adjacent dims that are
+// both kept or both reduced merged, so a reduction over any set of axes is a
+// few passes of the (outer, reduce, inner) form.
+struct ReduceLoopDims {
+  std::vector<int64_t> dims;
+  std::vector<bool> reduced;
+
+  int64_t ReduceNumel() const {
+    int64_t numel = 1;
+    for (size_t i = 0; i < dims.size(); ++i) {
+      if (reduced[i]) numel *= dims[i];
+    }
+    return numel;
+  }
+};
+
+inline ReduceLoopDims CollapseReduceDims(const framework::DDim& x_dims,
+                                         const std::vector<int>& reduce_dims,
+                                         bool reduce_all) {
+  int rank = x_dims.size();
+  std::vector<bool> is_reduced(rank, reduce_all);
+  for (auto dim : reduce_dims) {
+    is_reduced[dim < 0 ? dim + rank : dim] = true;
+  }
+  ReduceLoopDims loop;
+  for (int i = 0; i < rank; ++i) {
+    if (x_dims[i] == 1) continue;
+    if (!loop.dims.empty() && loop.reduced.back() == is_reduced[i]) {
+      loop.dims.back() *= x_dims[i];
+    } else {
+      loop.dims.push_back(x_dims[i]);
+      loop.reduced.push_back(is_reduced[i]);
+    }
+  }
+  // A reduction over size-1 dims only still runs one pass of length 1, so
+  // that the map and finalize steps of the reducer are applied
+  if (std::find(loop.reduced.begin(), loop.reduced.end(), true) ==
+      loop.reduced.end()) {
+    loop.dims.push_back(1);
+    loop.reduced.push_back(true);
+  }
+  return loop;
+}
+
+template <typename T>
+inline T ReduceLowest() {
+  return std::numeric_limits<T>::has_infinity
+             ? -std::numeric_limits<T>::infinity()
+             : std::numeric_limits<T>::lowest();
+}
+
+template <typename T>
+inline T ReduceHighest() {
+  return std::numeric_limits<T>::has_infinity
+             ? std::numeric_limits<T>::infinity()
+             : std::numeric_limits<T>::max();
+}
+
+template <typename T>
+struct ReduceIdentityMap {
+  inline T operator()(T x, int64_t out_idx) const { return x; }
+};
+
+template <typename T>
+struct ReduceSquareMap {
+  inline T operator()(T x, int64_t out_idx) const { return x * x; }
+};
+
+template <typename T>
+struct ReduceAddOp {
+  inline T operator()(T a, T b) const { return a + b; }
+};
+
+template <typename T>
+struct ReduceMulOp {
+  inline T operator()(T a, T b) const { return a * b; }
+};
+
+template <typename T>
+struct ReduceMaxOp {
+  inline T operator()(T a, T b) const { return a > b ? a : b; }
+};
+
+template <typename T>
+struct ReduceMinOp {
+  inline T operator()(T a, T b) const { return a < b ? a : b; }
+};
+
+// Reduces n contiguous elements. The leaves keep eight independent
+// accumulators so that the loop vectorizes, and they are combined pairwise,
+// which keeps the rounding error of a sum at O(log(n)).
+template <typename T, typename MapOp, typename ReduceOp>
+T PairwiseReduce(const T* x, int64_t n, int64_t out_idx, T init, MapOp map,
+                 ReduceOp reduce) {
+  if (n > kPairwiseReduceBlock) {
+    int64_t half = n / 2;
+    return reduce(PairwiseReduce(x, half, out_idx, init, map, reduce),
+                  PairwiseReduce(x + half, n - half, out_idx, init, map,
+                                 reduce));
+  }
+  T acc[8] = {init, init, init, init, init, init, init, init};
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    for (int k = 0; k < 8; ++k) {
+      acc[k] = reduce(acc[k], map(x[i + k], out_idx));
+    }
+  }
+  for (; i < n; ++i) {
+    acc[0] = reduce(acc[0], map(x[i], out_idx));
+  }
+  for (int width = 4; width > 0; width /= 2) {
+    for (int k = 0; k < width; ++k) {
+      acc[k] = reduce(acc[k], acc[k + width]);
+    }
+  }
+  return acc[0];
+}
+
+// Reduces n rows of `width` (at most kReduceColumnTile) contiguous columns,
+// the rows are `stride` apart. Rows are combined pairwise like above.
+template <typename T, typename MapOp, typename ReduceOp>
+void PairwiseReduceColumns(const T* x, int64_t n, int64_t stride,
+                           int64_t width, int64_t out_idx, T init, MapOp map,
+                           ReduceOp reduce, T* acc) {
+  if (n > kPairwiseReduceBlock) {
+    int64_t half = n / 2;
+    T rest[kReduceColumnTile];
+    PairwiseReduceColumns(x, half, stride, width, out_idx, init, map, reduce,
+                          acc);
+    PairwiseReduceColumns(x + half * stride, n - half, stride, width, out_idx,
+                          init, map, reduce, rest);
+    for (int64_t i = 0; i < width; ++i) {
+      acc[i] = reduce(acc[i], rest[i]);
+    }
+    return;
+  }
+  std::fill(acc, acc + width, init);
+  for (int64_t j = 0; j < n; ++j) {
+    const T* row = x + j * stride;
+    for (int64_t i = 0; i < width; ++i) {
+      acc[i] = reduce(acc[i], map(row[i], out_idx + i));
+    }
+  }
+}
+
+// y[o, i] = reduce(map(x[o, j, i], o * inner + i) for j in [0, n)), the
+// output index is passed to map so that it can read a per output value.
+// When there are too few (outer, column tile) tasks to feed the threads, the
+// reduced axis is split into chunks whose partial results are reduced again.
+template <typename T, typename MapOp, typename ReduceOp>
+void ReduceAxisCPU(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+                   T init, MapOp map, ReduceOp reduce) {
+  if (outer * inner == 0) return;
+  int64_t tiles = (inner + kReduceColumnTile - 1) / kReduceColumnTile;
+  int64_t chunk_rows = std::max<int64_t>(n, 1);
+  if (outer * tiles < kMinParallelReduceTasks &&
+      outer * n * inner >= kMinParallelReduceSize) {
+    chunk_rows = std::max(kPairwiseReduceBlock, kReduceChunkSize / inner);
+  }
+  int64_t chunks = (std::max<int64_t>(n, 1) + chunk_rows - 1) / chunk_rows;
+
+  std::vector<T> partial;
+  T* out = y;
+  if (chunks > 1) {
+    partial.resize(outer * chunks * inner);
+    out = partial.data();
+  }
+  int64_t tasks = outer * chunks * tiles;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (outer * n * inner >= kMinParallelReduceSize)
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    int64_t o = t / (chunks * tiles);
+    int64_t chunk = t / tiles % chunks;
+    int64_t col = t % tiles * kReduceColumnTile;
+    int64_t rows = std::min(chunk_rows, n - chunk * chunk_rows);
+    int64_t width = std::min(kReduceColumnTile, inner - col);
+    const T* src = x + (o * n + chunk * chunk_rows) * inner + col;
+    T* dst = out + (o * chunks + chunk) * inner + col;
+    if (inner == 1) {
+      *dst = PairwiseReduce(src, rows, o, init, map, reduce);
+    } else {
+      T acc[kReduceColumnTile];
+      PairwiseReduceColumns(src, rows, inner, width, o * inner + col, init,
+                            map, reduce, acc);
+      std::copy(acc, acc + width, dst);
+    }
+  }
+  if (chunks > 1) {
+    ReduceAxisCPU(partial.data(), y, outer, chunks, inner, init,
+                  ReduceIdentityMap<T>(), reduce);
+  }
+}
+
+// Runs the reducer over the collapsed dims, one pass per reduced group from
+// the innermost one. A reducer provides
+//   void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+//             bool first) const;
+//   void Finalize(T* y, int64_t numel, int64_t reduce_numel) const;
+// where only the first pass sees the input elements and Finalize runs once
+// on the output.
+template <typename T, typename Reducer>
+void ReduceCPU(const T* x, T* y, const ReduceLoopDims& loop,
+               const Reducer& reducer) {
+  std::vector<int64_t> dims(loop.dims);
+  std::vector<bool> reduced(loop.reduced);
+  int64_t reduce_numel = loop.ReduceNumel();
+  std::vector<T> buffers[2];
+  const T* src = x;
+  for (int pass = 0;; ++pass) {
+    int group = static_cast<int>(dims.size()) - 1;
+    while (!reduced[group]) --group;
+    int64_t outer = 1, inner = 1;
+    for (int i = 0; i < group; ++i) outer *= dims[i];
+    for (size_t i = group + 1; i < dims.size(); ++i) inner *= dims[i];
+    bool last = std::count(reduced.begin(), reduced.end(), true) == 1;
+
+    T* dst = y;
+    if (!last) {
+      buffers[pass % 2].resize(outer * inner);
+      dst = buffers[pass % 2].data();
+    }
+    reducer.Pass(src, dst, outer, dims[group], inner, pass == 0);
+    if (last) {
+      reducer.Finalize(y, outer * inner, reduce_numel);
+      return;
+    }
+
+    dims.erase(dims.begin() + group);
+    reduced.erase(reduced.begin() + group);
+    if (group > 0 && group < static_cast<int>(dims.size()) &&
+        !reduced[group - 1] && !reduced[group]) {
+      dims[group - 1] *= dims[group];
+      dims.erase(dims.begin() + group);
+      reduced.erase(reduced.begin() + group);
+    }
+    src = dst;
+  }
+}
+
+// dx[i] = grad(x[i], y[j], dy[j], reduce_numel), where j is the output
+// element that x[i] is reduced into.
+template <typename T, typename GradOp>
+void ReduceGradCPU(const T* x, const T* y, const T* dy, T* dx,
+                   const ReduceLoopDims& loop, const GradOp& grad) {
+  const std::vector<int64_t>& dims = loop.dims;
+  int rank = dims.size();
+  int64_t reduce_numel = loop.ReduceNumel();
+  int64_t numel = 1, out_numel = 1;
+  std::vector<int64_t> out_strides(rank, 0);
+  for (int i = rank - 1; i >= 0; --i) {
+    if (!loop.reduced[i]) {
+      out_strides[i] = out_numel;
+      out_numel *= dims[i];
+    }
+    numel *= dims[i];
+  }
+  if (numel == 0) return;
+
+  // Long rows are split so that a full reduction still uses every thread
+  int64_t inner = dims[rank - 1];
+  bool inner_reduced = loop.reduced[rank - 1];
+  int64_t chunk = std::min(inner, kReduceChunkSize);
+  int64_t row_chunks = (inner + chunk - 1) / chunk;
+  int64_t tasks = numel / inner * row_chunks;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (numel >= kMinParallelReduceSize)
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    int64_t row = t / row_chunks;
+    int64_t begin = t % row_chunks * chunk;
+    int64_t end = std::min(inner, begin + chunk);
+    int64_t out_offset = 0, index = row;
+    for (int i = rank - 2; i >= 0; --i) {
+      out_offset += index % dims[i] * out_strides[i];
+      index /= dims[i];
+    }
+    const T* x_row = x + row * inner;
+    T* dx_row = dx + row * inner;
+    if (inner_reduced) {
+      T y_val = y[out_offset], dy_val = dy[out_offset];
+      for (int64_t i = begin; i < end; ++i) {
+        dx_row[i] = grad(x_row[i], y_val, dy_val, reduce_numel);
+      }
+    } else {
+      const T* y_row = y + out_offset;
+      const T* dy_row = dy + out_offset;
+      for (int64_t i = begin; i < end; ++i) {
+        dx_row[i] = grad(x_row[i], y_row[i], dy_row[i], reduce_numel);
+      }
+    }
+  }
+}
+
+// Maps the Eigen functor of a reduce op to its CPU reducer (forward) or its
+// element gradient (backward). The ops with a native CPU kernel specialize
+// it next to their Eigen functors, e.g.
+//   template <>
+//   struct CPUReduceTraits<SumFunctor> {
+//     static constexpr bool kSupported = true;
+//     template <typename T>
+//     using Reducer = SumReducer<T>;
+//   };
+template <typename Functor>
+struct CPUReduceTraits {
+  static constexpr bool kSupported = false;
+};
+
+// Returns false when there is no native kernel for the device, the functor
+// or the data type, the caller then falls back to Eigen.
+template <typename DeviceContext, typename Functor, typename T,
+          typename Enable = void>
+struct CPUReduceDispatch {
+  static bool Forward(const framework::Tensor& x, framework::Tensor* out,
+                      const std::vector<int>& dims, bool reduce_all) {
+    return false;
+  }
+
+  static bool Backward(const framework::Tensor& x, const framework::Tensor& y,
+                       const framework::Tensor& dy, framework::Tensor* dx,
+                       const std::vector<int>& dims, bool reduce_all) {
+    return false;
+  }
+};
+
+template <typename Functor, typename T>
+struct CPUReduceDispatch<
+    platform::CPUDeviceContext, Functor, T,
+    typename std::enable_if<CPUReduceTraits<Functor>::kSupported &&
+                            std::is_arithmetic<T>::value &&
+                            !std::is_same<T, bool>::value>::type> {
+  using Reducer = typename CPUReduceTraits<Functor>::template Reducer<T>;
+
+  static bool Forward(const framework::Tensor& x, framework::Tensor* out,
+                      const std::vector<int>& dims, bool reduce_all) {
+    ReduceCPU(x.data<T>(), out->data<T>(),
+              CollapseReduceDims(x.dims(), dims, reduce_all), Reducer());
+    return true;
+  }
+
+  static bool Backward(const framework::Tensor& x, const framework::Tensor& y,
+                       const framework::Tensor& dy, framework::Tensor* dx,
+                       const std::vector<int>& dims, bool reduce_all) {
+    ReduceGradCPU(x.data<T>(), y.data<T>(), dy.data<T>(), dx->data<T>(),
+                  CollapseReduceDims(x.dims(), dims, reduce_all), Reducer());
+    return true;
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,138 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/reduce_ops/logsumexp_op.h"
+#include "paddle/fluid/operators/reduce_ops/reduce_min_max_op.h"
+#include "paddle/fluid/operators/reduce_ops/reduce_sum_op.h"
+
+namespace paddle {
+namespace operators {
+
+enum class RefReduceType { kSum, kMax, kLogsumexp };
+
+// Reduce by walking every input element, the reduced dims are given as flags
+static std::vector<double> RefReduce(const std::vector<double>& x,
+                                     const std::vector<int64_t>& shape,
+                                     const std::vector<bool>& reduced,
+                                     RefReduceType type) {
+  int rank = shape.size();
+  std::vector<int64_t> out_strides(rank, 0);
+  int64_t out_numel = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    if (!reduced[i]) {
+      out_strides[i] = out_numel;
+      out_numel *= shape[i];
+    }
+  }
+  auto out_index = [&](int64_t index) {
+    int64_t offset = 0;
+    for (int i = rank - 1; i >= 0; --i) {
+      offset += index % shape[i] * out_strides[i];
+      index /= shape[i];
+    }
+    return offset;
+  };
+  std::vector<double> max(out_numel, -INFINITY), out(out_numel, 0.0);
+  for (size_t i = 0; i < x.size(); ++i) {
+    auto o = out_index(i);
+    max[o] = std::max(max[o], x[i]);
+  }
+  if (type == RefReduceType::kMax) return max;
+  for (size_t i = 0; i < x.size(); ++i) {
+    auto o = out_index(i);
+    out[o] += type == RefReduceType::kSum ? x[i] : std::exp(x[i] - max[o]);
+  }
+  if (type == RefReduceType::kLogsumexp) {
+    for (int64_t i = 0; i < out_numel; ++i) out[i] = max[i] + std::log(out[i]);
+  }
+  return out;
+}
+
+template <typename Reducer>
+static void TestReduce(const std::vector<int64_t>& shape,
+                       const std::vector<int>& dims, RefReduceType type) {
+  static std::mt19937 engine(2020);
+  std::uniform_real_distribution<double> dist(-2.0, 2.0);
+  int64_t numel = 1;
+  for (auto d : shape) numel *= d;
+  std::vector<double> x(numel);
+  for (auto& v : x) v = dist(engine);
+
+  std::vector<bool> reduced(shape.size(), false);
+  for (auto d : dims) reduced[d] = true;
+  auto ref = RefReduce(x, shape, reduced, type);
+
+  std::vector<double> out(ref.size());
+  auto loop = CollapseReduceDims(framework::make_ddim(shape), dims, false);
+  ReduceCPU(x.data(), out.data(), loop, Reducer());
+  for (size_t i = 0; i < ref.size(); ++i) {
+    ASSERT_NEAR(out[i], ref[i], 1e-9 * std::max(1.0, std::fabs(ref[i])));
+  }
+}
+
+template <typename Reducer>
+static void TestReduceShapes(RefReduceType type) {
+  TestReduce<Reducer>({1 << 20}, {0}, type);
+  TestReduce<Reducer>({3, 100000}, {1}, type);
+  TestReduce<Reducer>({100000, 3}, {0}, type);
+  TestReduce<Reducer>({8, 16, 32, 32}, {0, 2, 3}, type);
+  TestReduce<Reducer>({2, 3, 4, 5, 6}, {1, 3}, type);
+  TestReduce<Reducer>({7, 1, 9}, {1}, type);
+  TestReduce<Reducer>({2000, 70}, {0}, type);
+}
+
+TEST(CPUReduce, sum) {
+  TestReduceShapes<SumReducer<double>>(RefReduceType::kSum);
+}
+
+TEST(CPUReduce, max) {
+  TestReduceShapes<MaxReducer<double>>(RefReduceType::kMax);
+}
+
+TEST(CPUReduce, logsumexp) {
+  TestReduceShapes<LogsumexpReducer<double>>(RefReduceType::kLogsumexp);
+}
+
+TEST(CPUReduce, pairwise_sum) {
+  std::vector<float> x(1 << 24, 0.1f);
+  float out;
+  auto loop = CollapseReduceDims(framework::make_ddim({1 << 24}), {0}, false);
+  ReduceCPU(x.data(), &out, loop, SumReducer<float>());
+  // A sequential float sum stops growing at 2^21 here
+  EXPECT_NEAR(out, 0.1 * (1 << 24), 1.0);
+}
+
+TEST(CPUReduce, grad) {
+  std::vector<int64_t> shape = {4, 5, 6};
+  std::vector<double> x(120), dy(4 * 6), dx(120);
+  for (size_t i = 0; i < x.size(); ++i) x[i] = i % 7;
+  for (size_t i = 0; i < dy.size(); ++i) dy[i] = i;
+  auto loop = CollapseReduceDims(framework::make_ddim(shape), {1}, false);
+  ReduceGradCPU(x.data(), dy.data(), dy.data(), dx.data(), loop,
+                SumGradReducer<double>());
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 5; ++j) {
+      for (int k = 0; k < 6; ++k) {
+        ASSERT_EQ(dx[(i * 5 + j) * 6 + k], dy[i * 6 + k]);
+      }
+    }
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <cmath>
 #include <vector>
 
 #include "paddle/fluid/operators/reduce_ops/reduce_op.h"
@@ -50,5 +51,46 @@ struct FrobeniusNormGradFunctor {
   }
 };
 
+template <typename T>
+struct FrobeniusNormReducer {
+  void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+            bool first) const {
+    if (first) {
+      ReduceAxisCPU(x, y, outer, n, inner, static_cast<T>(0),
+                    ReduceSquareMap<T>(), ReduceAddOp<T>());
+    } else {
+      ReduceAxisCPU(x, y, outer, n, inner, static_cast<T>(0),
+                    ReduceIdentityMap<T>(), ReduceAddOp<T>());
+    }
+  }
+
+  void Finalize(T* y, int64_t numel, int64_t reduce_numel) const {
+    for (int64_t i = 0; i < numel; ++i) {
+      y[i] = std::sqrt(y[i]);
+    }
+  }
+};
+
+template <typename T>
+struct FrobeniusNormGradReducer {
+  T operator()(T x, T y, T dy, int64_t size) const {
+    return x / (y + static_cast<T>(1e-12f)) * dy;
+  }
+};
+
+template <>
+struct CPUReduceTraits<FrobeniusNormFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = FrobeniusNormReducer<T>;
+};
+
+template <>
+struct CPUReduceTraits<FrobeniusNormGradFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = FrobeniusNormGradReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <cmath>
+#include <vector>
+
 #include "paddle/fluid/operators/reduce_ops/reduce_op.h"
 
 namespace paddle {
@@ -54,5 +57,54 @@ struct LogsumexpGradFunctor {
   }
 };
 
+template <typename T>
+struct LogsumexpShiftedExpMap {
+  const T* max;
+  inline T operator()(T x, int64_t out_idx) const {
+    return std::exp(x - max[out_idx]);
+  }
+};
+
+// logsumexp over several reduced groups is the logsumexp of the results of
+// the inner groups, so every pass runs the same two steps: the max, then the
+// sum of the exponents shifted by it.
+template <typename T>
+struct LogsumexpReducer {
+  void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+            bool first) const {
+    ReduceAxisCPU(x, y, outer, n, inner, ReduceLowest<T>(),
+                  ReduceIdentityMap<T>(), ReduceMaxOp<T>());
+    std::vector<T> sum(outer * inner);
+    ReduceAxisCPU(x, sum.data(), outer, n, inner, static_cast<T>(0),
+                  LogsumexpShiftedExpMap<T>{y}, ReduceAddOp<T>());
+    for (int64_t i = 0; i < outer * inner; ++i) {
+      y[i] += std::log(sum[i]);
+    }
+  }
+
+  void Finalize(T* y, int64_t numel, int64_t reduce_numel) const {}
+};
+
+template <typename T>
+struct LogsumexpGradReducer {
+  T operator()(T x, T y, T dy, int64_t size) const {
+    return dy * std::exp(x - y);
+  }
+};
+
+template <>
+struct CPUReduceTraits<LogsumexpFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = LogsumexpReducer<T>;
+};
+
+template <>
+struct CPUReduceTraits<LogsumexpGradFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = LogsumexpGradReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
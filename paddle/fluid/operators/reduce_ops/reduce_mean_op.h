@@ -35,5 +35,42 @@ struct MeanGradFunctor {
   }
 };
 
+template <typename T>
+struct MeanReducer {
+  void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+            bool first) const {
+    ReduceAxisCPU(x, y, outer, n, inner, static_cast<T>(0),
+                  ReduceIdentityMap<T>(), ReduceAddOp<T>());
+  }
+
+  void Finalize(T* y, int64_t numel, int64_t reduce_numel) const {
+    T scale = static_cast<T>(reduce_numel);
+    for (int64_t i = 0; i < numel; ++i) {
+      y[i] /= scale;
+    }
+  }
+};
+
+template <typename T>
+struct MeanGradReducer {
+  T operator()(T x, T y, T dy, int64_t size) const {
+    return dy / static_cast<T>(size);
+  }
+};
+
+template <>
+struct CPUReduceTraits<MeanFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = MeanReducer<T>;
+};
+
+template <>
+struct CPUReduceTraits<MeanGradFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = MeanGradReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
@@ -46,5 +46,55 @@ struct MaxOrMinGradFunctor {
   }
 };
 
+template <typename T>
+struct MaxReducer {
+  void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+            bool first) const {
+    ReduceAxisCPU(x, y, outer, n, inner, ReduceLowest<T>(),
+                  ReduceIdentityMap<T>(), ReduceMaxOp<T>());
+  }
+
+  void Finalize(T* y, int64_t numel, int64_t reduce_numel) const {}
+};
+
+template <typename T>
+struct MinReducer {
+  void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+            bool first) const {
+    ReduceAxisCPU(x, y, outer, n, inner, ReduceHighest<T>(),
+                  ReduceIdentityMap<T>(), ReduceMinOp<T>());
+  }
+
+  void Finalize(T* y, int64_t numel, int64_t reduce_numel) const {}
+};
+
+template <typename T>
+struct MaxOrMinGradReducer {
+  T operator()(T x, T y, T dy, int64_t size) const {
+    return x == y ? dy : static_cast<T>(0);
+  }
+};
+
+template <>
+struct CPUReduceTraits<MaxFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = MaxReducer<T>;
+};
+
+template <>
+struct CPUReduceTraits<MinFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = MinReducer<T>;
+};
+
+template <>
+struct CPUReduceTraits<MaxOrMinGradFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = MaxOrMinGradReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
@@ -21,6 +21,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/operators/cast_op.h"
+#include "paddle/fluid/operators/reduce_ops/cpu_reduce.h"
 #include "paddle/fluid/operators/reduce_ops/reduce_op_function.h"
 
 namespace paddle {
@@ -57,6 +58,10 @@ struct ReduceKernelFunctor {
   template <typename OutT>
   void apply() const {
     output->mutable_data<OutT>(context.GetPlace());
+    if (CPUReduceDispatch<DeviceContext, Functor, OutT>::Forward(
+            *input, output, dims, reduce_all)) {
+      return;
+    }
     if (reduce_all) {
       // Flatten and reduce 1-D tensor
       auto x = EigenVector<OutT>::Flatten(*input);
@@ -234,6 +239,10 @@ class ReduceGradKernel : public framework::OpKernel<T> {
     // not be set as Input in grad Maker, use Out_grad to replace here
     if (!input1) input1 = input2;
 
+    if (CPUReduceDispatch<DeviceContext, Functor, T>::Backward(
+            *input0, *input1, *input2, output, dims, reduce_all)) {
+      return;
+    }
     if (reduce_all) {
       auto x = EigenVector<T>::Flatten(*input0);
       auto x_reduce = EigenVector<T>::Flatten(*input1);
@@ -35,5 +35,37 @@ struct ProdGradFunctor {
   }
 };
 
+template <typename T>
+struct ProdReducer {
+  void Pass(const T* x, T* y, int64_t outer, int64_t n, int64_t inner,
+            bool first) const {
+    ReduceAxisCPU(x, y, outer, n, inner, static_cast<T>(1),
+                  ReduceIdentityMap<T>(), ReduceMulOp<T>());
+  }
+
+  void Finalize(T* y, int64_t numel, int64_t reduce_numel) const {}
+};
+
+template <typename T>
+struct ProdGradReducer {
+  T operator()(T x, T y, T dy, int64_t size) const {
+    return dy * y * (static_cast<T>(1) / x);
+  }
+};
+
+template <>
+struct CPUReduceTraits<ProdFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = ProdReducer<T>;
+};
+
+template <>
+struct CPUReduceTraits<ProdGradFunctor> {
+  static constexpr bool kSupported = true;
+  template <typename T>
+  using Reducer = ProdGradReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
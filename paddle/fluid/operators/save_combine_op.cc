@@ -15,6 +15,7 @@ limitations under the License. */
 #include <string>
 
 #include "paddle/fluid/operators/save_combine_op.h"
+#include "paddle/fluid/framework/op_version_registry.h"
 
 namespace paddle {
 namespace operators {
@@ -75,6 +76,13 @@ to a file on disk.
                   "(boolean, default false)"
                   "If true, the variables will be saved to binary strings.")
         .SetDefault(false);
+    AddAttr<bool>("align_data",
+                  "(boolean, default false)"
+                  "If true, the data of each tensor is padded to start at a "
+                  "multiple of 64 bytes in the file, so that load_combine "
+                  "with use_mmap uses it in place. The files can not be "
+                  "loaded by the versions without the padding.")
+        .SetDefault(false);
     AddOutput("Y",
               "(RAW, default empty)."
               "This output is used when saving variables to binary strings.")
@@ -98,6 +106,14 @@ namespace ops = paddle::operators;
 REGISTER_OPERATOR(save_combine, ops::SaveCombineOp,
                   ops::SaveCombineOpProtoMaker, ops::SaveCombineOpInferVarType);
 
+REGISTER_OP_VERSION(save_combine)
+    .AddCheckpoint(
+        R"ROC(Add the attribute `align_data` to pad the tensor data.)ROC",
+        paddle::framework::compatible::OpVersionDesc().NewAttr(
+            "align_data",
+            "Pad the data of each tensor to start at a multiple of 64 bytes.",
+            false));
+
 REGISTER_OP_CPU_KERNEL(
     save_combine,
     ops::SaveCombineOpKernel<paddle::platform::CPUDeviceContext, float>,
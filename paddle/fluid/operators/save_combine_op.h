@@ -19,6 +19,7 @@ limitations under the License. */
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
@@ -30,6 +31,12 @@ limitations under the License. */
 
 namespace paddle {
 namespace operators {
+
+constexpr size_t kSaveCombineStreamBufferSize = 8 << 20;
+// The alignment of the tensor data in the file with align_data, which is a
+// cache line, and the widest alignment the SIMD loads need
+constexpr size_t kSaveCombineDataAlignment = 64;
+
 template <typename DeviceContext, typename T>
 class SaveCombineOpKernel : public framework::OpKernel<T> {
  public:
@@ -39,6 +46,8 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto data_alignment =
+        ctx.Attr<bool>("align_data") ? kSaveCombineDataAlignment : 0;
     auto output = ctx.Output<std::string>("Y");
 
     bool is_present = FileExists(filename);
@@ -49,7 +58,6 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
           filename, overwrite));
     }
 
-    std::ostringstream ss;
     auto inp_var_names = ctx.InputNames("X");
     auto &inp_vars = ctx.MultiInputVar("X");
     PADDLE_ENFORCE_GT(inp_var_names.size(), 0UL,
@@ -79,6 +87,27 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
           platform::errors::InvalidArgument(
               "The Tensor of Variable(%s) to be saved is not initialized.",
               inp_var_names[i]));
+    }
+
+    // Serialize the tensors straight into the file through a large buffer,
+    // rather than into a string that is copied to the file afterwards.
+    std::ostringstream ss;
+    std::vector<char> stream_buffer;
+    std::ofstream fout;
+    std::ostream *out_stream = &ss;
+    if (!save_to_memory) {
+      MkDirRecursively(DirName(filename).c_str());
+      stream_buffer.resize(kSaveCombineStreamBufferSize);
+      fout.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+      fout.open(filename, std::ios::binary);
+      PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                        platform::errors::Unavailable(
+                            "Cannot open %s to save variables.", filename));
+      out_stream = &fout;
+    }
+
+    for (size_t i = 0; i < inp_var_names.size(); i++) {
+      auto &tensor = inp_vars[i]->Get<framework::LoDTensor>();
       // Serialize tensors one by one
       // Check types to see if a fp16 transformation is required
       auto in_dtype = tensor.type();
@@ -92,9 +121,11 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
         // copy LoD info to the new tensor
         out.set_lod(tensor.lod());
         framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
-        framework::SerializeToStream(ss, out, dev_ctx);
+        framework::SerializeToStream(*out_stream, out, dev_ctx,
+                                     data_alignment);
       } else {
-        framework::SerializeToStream(ss, tensor, dev_ctx);
+        framework::SerializeToStream(*out_stream, tensor, dev_ctx,
+                                     data_alignment);
       }
     }
     if (save_to_memory) {
@@ -103,13 +134,10 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
                             "Cannot find variable Y for save_combine_op"));
       *output = ss.str();
     } else {
-      MkDirRecursively(DirName(filename).c_str());
-      std::ofstream fout(filename, std::ios::binary);
+      fout.close();
       PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
                         platform::errors::Unavailable(
-                            "Cannot open %s to save variables.", filename));
-      fout << ss.str();
-      fout.close();
+                            "Failed to write variables to %s.", filename));
     }
   }
 };
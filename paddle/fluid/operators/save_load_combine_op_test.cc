@@ -17,6 +17,9 @@ limitations under the License. */
 #include <vector>
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_registry.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
 #include "paddle/fluid/platform/float16.h"
 
 USE_CPU_ONLY_OP(save_combine);
@@ -139,6 +142,138 @@ TEST(SaveLoadCombineOp, CPU) {
   CheckValues<int, int>(expect4, actual4, expect_lod4, actual_lod4, numel4);
 }
 
+#ifndef _WIN32
+// Load the combined file through a memory mapping. The odd sized int8 tensor
+// makes the following float tensors misaligned in the file, which should be
+// copied instead of being adopted from the mapping.
+TEST(SaveLoadCombineOpWithMmap, CPU) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<int> lod1 = {0, 1, 2, 3, 10};
+  int numel1 = 100;
+  paddle::framework::LoD expect_lod1;
+  float* expect1 = CreateForSaveCombineOp<float, float>(
+      10, 10, lod1, "test_var1", place, &scope, &expect_lod1);
+
+  std::vector<int> lod2 = {0, 1, 3};
+  int numel2 = 9;
+  paddle::framework::LoD expect_lod2;
+  int8_t* expect2 = CreateForSaveCombineOp<int8_t, int8_t>(
+      3, 3, lod2, "test_var2", place, &scope, &expect_lod2);
+
+  std::vector<int> lod3 = {0, 2, 3, 20};
+  int numel3 = 4000;
+  paddle::framework::LoD expect_lod3;
+  float* expect3 = CreateForSaveCombineOp<float, float>(
+      20, 200, lod3, "test_var3", place, &scope, &expect_lod3);
+
+  std::string filename = "check_tensor_mmap.ls";
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string(filename)});
+
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2", "test_var3"}}}, {},
+      attrs);
+  save_combine_op->Run(scope, place);
+
+  auto target1 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+  auto target2 = GeneratePlaceholderBeforeLoad("out_var2", &scope);
+  auto target3 = GeneratePlaceholderBeforeLoad("out_var3", &scope);
+
+  attrs.insert({"use_mmap", true});
+  auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"out_var1", "out_var2", "out_var3"}}},
+      attrs);
+  load_combine_op->Run(scope, place);
+
+  paddle::framework::LoD actual_lod1, actual_lod2, actual_lod3;
+  float* actual1 =
+      GetValuesAfterLoadCombineOp<float>(target1, scope, &actual_lod1);
+  int8_t* actual2 =
+      GetValuesAfterLoadCombineOp<int8_t>(target2, scope, &actual_lod2);
+  float* actual3 =
+      GetValuesAfterLoadCombineOp<float>(target3, scope, &actual_lod3);
+
+  CheckValues<float, float>(expect1, actual1, expect_lod1, actual_lod1,
+                            numel1);
+  CheckValues<int8_t, int8_t>(expect2, actual2, expect_lod2, actual_lod2,
+                              numel2);
+  CheckValues<float, float>(expect3, actual3, expect_lod3, actual_lod3,
+                            numel3);
+
+  // writing a loaded tensor must not touch the file
+  target1->mutable_data<float>(place)[0] = -1.0f;
+  auto reload_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"test_var1", "test_var2", "test_var3"}}},
+      attrs);
+  reload_op->Run(scope, place);
+  auto* reloaded = scope.FindVar("test_var1")
+                       ->GetMutable<paddle::framework::LoDTensor>()
+                       ->data<float>();
+  EXPECT_EQ(reloaded[0], 0.0f);
+}
+
+// With align_data, the data of every tensor is padded to 64 bytes in the
+// file, so all of them are adopted from the mapping, even those behind the
+// odd sized int8 tensor. The padded file also loads without the mapping.
+TEST(SaveLoadCombineOpWithMmap, AlignData) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<int> lod1 = {0, 1, 3};
+  int numel1 = 9;
+  paddle::framework::LoD expect_lod1;
+  int8_t* expect1 = CreateForSaveCombineOp<int8_t, int8_t>(
+      3, 3, lod1, "test_var1", place, &scope, &expect_lod1);
+
+  std::vector<int> lod2 = {0, 2, 3, 20};
+  int numel2 = 4000;
+  paddle::framework::LoD expect_lod2;
+  float* expect2 = CreateForSaveCombineOp<float, float>(
+      20, 200, lod2, "test_var2", place, &scope, &expect_lod2);
+
+  std::string filename = "check_tensor_mmap_aligned.ls";
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string(filename)});
+  attrs.insert({"align_data", true});
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2"}}}, {}, attrs);
+  save_combine_op->Run(scope, place);
+
+  for (bool use_mmap : {true, false}) {
+    auto target1 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+    auto target2 = GeneratePlaceholderBeforeLoad("out_var2", &scope);
+    paddle::framework::AttributeMap load_attrs;
+    load_attrs.insert({"file_path", std::string(filename)});
+    load_attrs.insert({"use_mmap", use_mmap});
+    auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+        "load_combine", {}, {{"Out", {"out_var1", "out_var2"}}}, load_attrs);
+    load_combine_op->Run(scope, place);
+
+    for (auto* target : {target1, target2}) {
+      auto* slice = dynamic_cast<
+          paddle::memory::allocation::MemoryMapFileSliceAllocation*>(
+          target->Holder().get());
+      EXPECT_EQ(slice != nullptr, use_mmap);
+      if (use_mmap) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(target->data<void>()) % 64, 0UL);
+      }
+    }
+
+    paddle::framework::LoD actual_lod1, actual_lod2;
+    int8_t* actual1 =
+        GetValuesAfterLoadCombineOp<int8_t>(target1, scope, &actual_lod1);
+    float* actual2 =
+        GetValuesAfterLoadCombineOp<float>(target2, scope, &actual_lod2);
+    CheckValues<int8_t, int8_t>(expect1, actual1, expect_lod1, actual_lod1,
+                                numel1);
+    CheckValues<float, float>(expect2, actual2, expect_lod2, actual_lod2,
+                              numel2);
+  }
+}
+#endif
+
 // FP16 version of SaveLoadCombineOp Test, only altering the saving aspect
 // to save as FP16.
 TEST(SaveCombineFP16Op, CPU) {
@@ -0,0 +1,334 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+
+// Rows are split into chunks of at least this many elements, selected in
+// parallel and then merged, when there are too few rows to feed the threads
+constexpr int64_t kTopkChunkSize = 1 << 16;
+constexpr int64_t kMinParallelTopkTasks = 64;
+constexpr int64_t kMinParallelTopkSize = 1 << 15;
+// Up to this k the best elements are kept in a heap, above it the k-th key
+// is found by radix-select
+constexpr int64_t kTopkHeapMaxK = 256;
+// Elements are tested against the heap threshold a block at a time
+constexpr int kTopkFilterBlock = 16;
+
+// Maps a value to an unsigned key with the same order, so the top k are the
+// k largest keys. NaN is larger than any number, as top_k_v2 defines it.
+template <typename T, typename Enable = void>
+struct TopkKeyTraits;
+
+template <typename T>
+struct TopkKeyTraits<
+    T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  using Key =
+      typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+  static_assert(sizeof(T) == sizeof(Key), "Unsupported floating point type.");
+
+  static Key ToKey(T x) {
+    constexpr Key kSign = Key(1) << (sizeof(Key) * 8 - 1);
+    Key bits;
+    std::memcpy(&bits, &x, sizeof(T));
+    bits = (bits & kSign) ? ~bits : (bits | kSign);
+    return x != x ? ~Key(0) : bits;
+  }
+};
+
+template <typename T>
+struct TopkKeyTraits<
+    T, typename std::enable_if<std::is_integral<T>::value>::type> {
+  using Key = typename std::make_unsigned<T>::type;
+
+  static Key ToKey(T x) {
+    constexpr Key kSign = Key(1) << (sizeof(Key) * 8 - 1);
+    return static_cast<Key>(x) ^ kSign;
+  }
+};
+
+template <typename Key>
+struct TopkEntry {
+  Key key;
+  int64_t index;
+};
+
+// The larger key wins, the smaller index breaks ties
+template <typename Key>
+struct TopkBetter {
+  bool operator()(const TopkEntry<Key>& a, const TopkEntry<Key>& b) const {
+    return a.key > b.key || (a.key == b.key && a.index < b.index);
+  }
+};
+
+// Selects the best k of x[0, n) into top, best first. The smallest k are
+// selected by flipping all the key bits.
+template <typename T>
+void TopkHeapSelect(const T* x, int64_t n, int64_t base, int64_t k,
+                    typename TopkKeyTraits<T>::Key flip,
+                    TopkEntry<typename TopkKeyTraits<T>::Key>* top) {
+  using Traits = TopkKeyTraits<T>;
+  using Key = typename Traits::Key;
+  TopkBetter<Key> better;
+  for (int64_t j = 0; j < k; ++j) {
+    top[j] = {Traits::ToKey(x[j]) ^ flip, base + j};
+  }
+  // A max-heap under better keeps the worst selected entry at the front
+  std::make_heap(top, top + k, better);
+  Key threshold = top[0].key;
+  auto push = [&](Key key, int64_t j) {
+    // The elements come in index order, so an equal key never wins
+    if (key > threshold) {
+      std::pop_heap(top, top + k, better);
+      top[k - 1] = {key, base + j};
+      std::push_heap(top, top + k, better);
+      threshold = top[0].key;
+    }
+  };
+
+  int64_t j = k;
+  for (; j + kTopkFilterBlock <= n; j += kTopkFilterBlock) {
+    // Most blocks of a long row hold nothing above the threshold, this test
+    // is branch free and vectorized
+    Key keys[kTopkFilterBlock];
+    Key block_max = 0;
+    for (int t = 0; t < kTopkFilterBlock; ++t) {
+      keys[t] = Traits::ToKey(x[j + t]) ^ flip;
+      block_max = std::max(block_max, keys[t]);
+    }
+    if (block_max <= threshold) continue;
+    for (int t = 0; t < kTopkFilterBlock; ++t) {
+      push(keys[t], j + t);
+    }
+  }
+  for (; j < n; ++j) {
+    push(Traits::ToKey(x[j]) ^ flip, j);
+  }
+  std::sort_heap(top, top + k, better);
+}
+
+// One radix-select pass over m keys: returns the digit at shift that holds
+// the remaining-th largest key, and takes the keys of the larger digits off
+// remaining.
+template <typename Key, typename KeyAt>
+int TopkRadixDigit(KeyAt key_at, int64_t m, int shift, int64_t* remaining,
+                   int64_t* digit_count) {
+  // Four histograms so that runs of one digit do not serialize the counts
+  int64_t hist[4][256] = {{0}};
+  int64_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    ++hist[0][(key_at(i) >> shift) & 0xFF];
+    ++hist[1][(key_at(i + 1) >> shift) & 0xFF];
+    ++hist[2][(key_at(i + 2) >> shift) & 0xFF];
+    ++hist[3][(key_at(i + 3) >> shift) & 0xFF];
+  }
+  for (; i < m; ++i) {
+    ++hist[0][(key_at(i) >> shift) & 0xFF];
+  }
+  int digit = 255;
+  while (true) {
+    *digit_count =
+        hist[0][digit] + hist[1][digit] + hist[2][digit] + hist[3][digit];
+    if (*digit_count >= *remaining) break;
+    *remaining -= *digit_count;
+    --digit;
+  }
+  return digit;
+}
+
+// Keeps the keys with the digit at shift, without branches since about any
+// fraction of them may be kept. dst may be the source itself.
+template <typename Key, typename KeyAt>
+int64_t TopkRadixCompact(KeyAt key_at, int64_t m, int shift, int digit,
+                         Key* dst) {
+  int64_t kept = 0;
+  for (int64_t i = 0; i < m; ++i) {
+    Key key = key_at(i);
+    dst[kept] = key;
+    kept += static_cast<int>((key >> shift) & 0xFF) == digit;
+  }
+  return kept;
+}
+
+// Finds the k-th largest key a byte at a time from the top, keeping only the
+// keys of the selected bucket after each pass, then gathers the selection.
+// The first pass and the gather compute the keys from x again rather than
+// storing a key for every element.
+template <typename T>
+void TopkRadixSelect(const T* x, int64_t n, int64_t base, int64_t k,
+                     typename TopkKeyTraits<T>::Key flip,
+                     TopkEntry<typename TopkKeyTraits<T>::Key>* top) {
+  using Traits = TopkKeyTraits<T>;
+  using Key = typename Traits::Key;
+  auto x_key = [x, flip](int64_t i) { return Traits::ToKey(x[i]) ^ flip; };
+
+  // How many keys equal to the k-th one are selected
+  int64_t remaining = k;
+  int64_t count = 0;
+  int shift = sizeof(Key) * 8 - 8;
+  int digit = TopkRadixDigit<Key>(x_key, n, shift, &remaining, &count);
+  Key kth = static_cast<Key>(digit) << shift;
+  // Until a pass splits the keys they are all read from x
+  std::vector<Key> bucket;
+  int64_t m = n;
+  auto bucket_key = [&bucket](int64_t i) { return bucket[i]; };
+  while (true) {
+    if (shift > 0 && count < m) {
+      if (bucket.empty()) {
+        bucket.resize(count + 1);
+        m = TopkRadixCompact(x_key, m, shift, digit, bucket.data());
+      } else {
+        m = TopkRadixCompact(bucket_key, m, shift, digit, bucket.data());
+      }
+    }
+    shift -= 8;
+    if (shift < 0) break;
+    if (bucket.empty()) {
+      digit = TopkRadixDigit<Key>(x_key, m, shift, &remaining, &count);
+    } else {
+      digit = TopkRadixDigit<Key>(bucket_key, m, shift, &remaining, &count);
+    }
+    kth |= static_cast<Key>(digit) << shift;
+  }
+
+  count = 0;
+  for (int64_t j = 0; j < n; ++j) {
+    Key key = x_key(j);
+    if (key > kth) {
+      top[count++] = {key, base + j};
+    } else if (key == kth && remaining > 0) {
+      top[count++] = {key, base + j};
+      --remaining;
+    }
+  }
+  std::sort(top, top + k, TopkBetter<Key>());
+}
+
+// Selects min(k, n) entries, best first, and returns how many
+template <typename T>
+int64_t TopkSelect(const T* x, int64_t n, int64_t base, int64_t k,
+                   bool largest,
+                   TopkEntry<typename TopkKeyTraits<T>::Key>* top) {
+  using Key = typename TopkKeyTraits<T>::Key;
+  Key flip = largest ? Key(0) : ~Key(0);
+  k = std::min(k, n);
+  if (k == 0) return 0;
+  if (k <= kTopkHeapMaxK) {
+    TopkHeapSelect(x, n, base, k, flip, top);
+  } else {
+    TopkRadixSelect(x, n, base, k, flip, top);
+  }
+  return k;
+}
+
+// out[i, :] and indices[i, :] are the k largest (or smallest) elements of
+// x[i, :] and their column, best first, ties in index order. A few long rows
+// are split into chunks selected in parallel, whose sorted candidates are
+// merged.
+template <typename T>
+void TopkCPU(const T* x, T* out, int64_t* indices, int64_t rows, int64_t cols,
+             int64_t k, bool largest) {
+  using Key = typename TopkKeyTraits<T>::Key;
+  using Entry = TopkEntry<Key>;
+  if (rows == 0 || k == 0) return;
+  int64_t chunk_cols = cols;
+  if (rows < kMinParallelTopkTasks && cols > kTopkChunkSize) {
+    chunk_cols = std::max(kTopkChunkSize, 64 * k);
+  }
+  int64_t chunks = (cols + chunk_cols - 1) / chunk_cols;
+  int64_t chunk_k = std::min(k, chunk_cols);
+
+  std::vector<Entry> candidates;
+  std::vector<int64_t> counts;
+  if (chunks > 1) {
+    candidates.resize(rows * chunks * chunk_k);
+    counts.resize(rows * chunks);
+  }
+  int64_t tasks = rows * chunks;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (rows * cols >= kMinParallelTopkSize)
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    int64_t i = t / chunks;
+    int64_t col = t % chunks * chunk_cols;
+    const T* src = x + i * cols;
+    if (chunks > 1) {
+      counts[t] =
+          TopkSelect(src + col, std::min(chunk_cols, cols - col), col, chunk_k,
+                     largest, candidates.data() + t * chunk_k);
+      continue;
+    }
+    std::vector<Entry> top(k);
+    int64_t num = TopkSelect(src, cols, 0, k, largest, top.data());
+    for (int64_t j = 0; j < num; ++j) {
+      out[i * k + j] = src[top[j].index];
+      indices[i * k + j] = top[j].index;
+    }
+  }
+  if (chunks == 1) return;
+
+  // Merge the sorted candidates of every chunk
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < rows; ++i) {
+    const T* src = x + i * cols;
+    const Entry* row_candidates = candidates.data() + i * chunks * chunk_k;
+    const int64_t* row_counts = counts.data() + i * chunks;
+    std::vector<int64_t> heads(chunks, 0);
+    int64_t num = std::min(k, cols);
+    for (int64_t j = 0; j < num; ++j) {
+      int64_t best = -1;
+      for (int64_t c = 0; c < chunks; ++c) {
+        if (heads[c] == row_counts[c]) continue;
+        if (best < 0 ||
+            TopkBetter<Key>()(row_candidates[c * chunk_k + heads[c]],
+                       row_candidates[best * chunk_k + heads[best]])) {
+          best = c;
+        }
+      }
+      const Entry& entry = row_candidates[best * chunk_k + heads[best]++];
+      out[i * k + j] = src[entry.index];
+      indices[i * k + j] = entry.index;
+    }
+  }
+}
+
+// dx[i, indices[i, j]] = dout[i, j], and zero elsewhere
+template <typename T>
+void TopkGradCPU(const T* dout, const int64_t* indices, T* dx, int64_t rows,
+                 int64_t cols, int64_t k) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (rows * cols >= kMinParallelTopkSize)
+#endif
+  for (int64_t i = 0; i < rows; ++i) {
+    T* dst = dx + i * cols;
+    std::memset(dst, 0, cols * sizeof(T));
+    for (int64_t j = 0; j < k; ++j) {
+      dst[indices[i * k + j]] = dout[i * k + j];
+    }
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
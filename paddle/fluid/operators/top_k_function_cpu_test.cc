@@ -0,0 +1,113 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "paddle/fluid/operators/top_k_function_cpu.h"
+
+namespace paddle {
+namespace operators {
+
+// Compares with a stable sort of every row, NaN being the largest value.
+// range > 0 draws integers in [-range / 2, range / 2) to get many ties.
+template <typename T>
+static void TestTopk(int64_t rows, int64_t cols, int64_t k, bool largest,
+                     int range) {
+  std::mt19937 engine(rows * 131 + cols * 7 + k);
+  std::vector<T> x(rows * cols);
+  for (auto& v : x) {
+    if (range > 0) {
+      v = static_cast<T>(static_cast<int>(engine() % range) - range / 2);
+    } else {
+      v = static_cast<T>(
+          std::uniform_real_distribution<double>(-1., 1.)(engine));
+      if (engine() % 64 == 0) v = std::numeric_limits<T>::quiet_NaN();
+    }
+  }
+  std::vector<T> out(rows * k);
+  std::vector<int64_t> indices(rows * k);
+  TopkCPU(x.data(), out.data(), indices.data(), rows, cols, k, largest);
+
+  for (int64_t i = 0; i < rows; ++i) {
+    const T* row = x.data() + i * cols;
+    auto is_nan = [](T v) { return v != v; };
+    std::vector<int64_t> order(cols);
+    for (int64_t j = 0; j < cols; ++j) order[j] = j;
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+      if (is_nan(row[a]) || is_nan(row[b])) {
+        return largest ? is_nan(row[a]) && !is_nan(row[b])
+                       : !is_nan(row[a]) && is_nan(row[b]);
+      }
+      return largest ? row[a] > row[b] : row[a] < row[b];
+    });
+    for (int64_t j = 0; j < k; ++j) {
+      ASSERT_EQ(indices[i * k + j], order[j]);
+      if (!is_nan(row[order[j]])) {
+        ASSERT_EQ(out[i * k + j], row[order[j]]);
+      }
+    }
+  }
+
+  // The gradient puts dout back to the selected columns
+  std::vector<T> dx(rows * cols);
+  TopkGradCPU(out.data(), indices.data(), dx.data(), rows, cols, k);
+  for (int64_t i = 0; i < rows; ++i) {
+    int64_t selected = 0;
+    for (int64_t j = 0; j < cols; ++j) {
+      selected += dx[i * cols + j] != static_cast<T>(0);
+    }
+    for (int64_t j = 0; j < k; ++j) {
+      T dout = out[i * k + j];
+      T grad = dx[i * cols + indices[i * k + j]];
+      ASSERT_TRUE(grad == dout || (dout != dout && grad != grad));
+    }
+    ASSERT_LE(selected, k);
+  }
+}
+
+template <typename T>
+static void TestTopkAllSizes(int range) {
+  for (bool largest : {true, false}) {
+    // heap
+    TestTopk<T>(5, 100, 3, largest, range);
+    TestTopk<T>(70, 1000, 20, largest, range);
+    TestTopk<T>(3, 10, 10, largest, range);
+    // radix-select
+    TestTopk<T>(2, 1000, 300, largest, range);
+    TestTopk<T>(2, 20000, 5000, largest, range);
+    // chunks of one row selected in parallel and merged
+    TestTopk<T>(1, 300000, 5, largest, range);
+    TestTopk<T>(2, 200000, 1000, largest, range);
+  }
+}
+
+TEST(TopkCPU, Float) {
+  TestTopkAllSizes<float>(0);
+  TestTopkAllSizes<float>(7);
+  TestTopkAllSizes<float>(1);
+}
+
+TEST(TopkCPU, Double) { TestTopkAllSizes<double>(0); }
+
+TEST(TopkCPU, Int) {
+  TestTopkAllSizes<int>(1000);
+  TestTopkAllSizes<int64_t>(5);
+}
+
+}  // namespace operators
+}  // namespace paddle
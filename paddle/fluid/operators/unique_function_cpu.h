@@ -0,0 +1,428 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+#include "paddle/fluid/platform/enforce.h"
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+
+// Below this many elements unique runs on one hash table, on one thread
+constexpr int64_t kMinParallelUniqueSize = 1 << 16;
+// Above it the input is split in kUniqueBlocks blocks at most. When fewer
+// than one in kUniqueRepeatRatio elements of a sample are distinct, every
+// block has a table of its own, otherwise the elements are scattered into
+// 1 << kUniquePartitionBits hash partitions.
+constexpr int64_t kUniqueSampleSize = 1 << 14;
+constexpr int64_t kUniqueRepeatRatio = 8;
+constexpr int kUniquePartitionBits = 6;
+constexpr int64_t kUniqueBlocks = 64;
+constexpr int64_t kMinUniqueBlockSize = 1 << 14;
+// The high bit of the local id of an element marks its first occurrence
+constexpr uint32_t kUniqueFirstFlag = 1u << 31;
+constexpr uint32_t kUniqueEmptySlot = std::numeric_limits<uint32_t>::max();
+constexpr uint64_t kUniqueInitialSlots = 1 << 10;
+constexpr uint64_t kUniqueSparseSlots = 1 << 16;
+
+template <typename T>
+inline uint64_t UniqueHash(T x) {
+  uint64_t h = 0;
+  if (std::is_floating_point<T>::value) {
+    // 0.0 and -0.0 compare equal, so they must hash alike
+    if (x != static_cast<T>(0)) {
+      std::memcpy(&h, &x, sizeof(T));
+    }
+  } else {
+    h = static_cast<uint64_t>(x);
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb53fe1a85ec3ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// NaN after every number, so that the order is strict weak
+template <typename T>
+inline bool UniqueLess(T a, T b) {
+  if (std::isnan(a)) return false;
+  return std::isnan(b) || a < b;
+}
+
+// The distinct values met so far in the order they are met, with the
+// position of their first occurrence and their count. The open addressing
+// table over them grows with the distinct values rather than the input.
+template <typename T>
+class UniqueTable {
+ public:
+  UniqueTable()
+      : mask_(kUniqueInitialSlots - 1),
+        slots_(kUniqueInitialSlots, kUniqueEmptySlot) {}
+
+  // The id of value, met count times from position pos on. *inserted tells
+  // whether it is met for the first time.
+  uint32_t Insert(T value, int64_t pos, int64_t count, bool* inserted) {
+    uint64_t slot = UniqueHash(value) & mask_;
+    while (true) {
+      uint32_t id = slots_[slot];
+      if (id == kUniqueEmptySlot) break;
+      if (values[id] == value) {
+        counts[id] += count;
+        *inserted = false;
+        return id;
+      }
+      slot = (slot + 1) & mask_;
+    }
+    PADDLE_ENFORCE_LT(values.size(), static_cast<size_t>(kUniqueEmptySlot),
+                      platform::errors::InvalidArgument(
+                          "The number of distinct elements of unique should "
+                          "be less than %d.",
+                          static_cast<int64_t>(kUniqueEmptySlot)));
+    uint32_t id = static_cast<uint32_t>(values.size());
+    slots_[slot] = id;
+    values.push_back(value);
+    first.push_back(pos);
+    counts.push_back(count);
+    *inserted = true;
+    // A sparse table while it is small enough to stay in cache, where a
+    // mispredicted probe costs more than the memory
+    size_t load = mask_ < kUniqueSparseSlots ? 8 : 2;
+    if (values.size() * load > mask_) Grow();
+    return id;
+  }
+
+  std::vector<T> values;
+  std::vector<int64_t> first;
+  std::vector<int64_t> counts;
+  // The global order of every value, when the table holds a part of them
+  std::vector<int64_t> global;
+
+ private:
+  void Grow() {
+    mask_ = mask_ * 2 + 1;
+    slots_.assign(mask_ + 1, kUniqueEmptySlot);
+    for (size_t id = 0; id < values.size(); ++id) {
+      uint64_t slot = UniqueHash(values[id]) & mask_;
+      while (slots_[slot] != kUniqueEmptySlot) slot = (slot + 1) & mask_;
+      slots_[slot] = static_cast<uint32_t>(id);
+    }
+  }
+
+  uint64_t mask_;
+  std::vector<uint32_t> slots_;
+};
+
+// Deduplicates keys[0, n) into table. The local id of every key goes to
+// local[k], or'ed with first_flag where the key is met for the first time.
+template <typename T, typename LocalT>
+void UniqueTableRun(const T* keys, int64_t n, LocalT first_flag, LocalT* local,
+                    UniqueTable<T>* table) {
+  for (int64_t k = 0; k < n; ++k) {
+    bool inserted;
+    uint32_t id = table->Insert(keys[k], k, 1, &inserted);
+    local[k] = static_cast<LocalT>(id) | (inserted ? first_flag : 0);
+  }
+}
+
+// The number of distinct values in a strided sample of x
+template <typename T>
+int64_t UniqueSampleDistinct(const T* x, int64_t n) {
+  UniqueTable<T> table;
+  const int64_t stride = std::max<int64_t>(1, n / kUniqueSampleSize);
+  for (int64_t i = 0; i < n; i += stride) {
+    bool inserted;
+    table.Insert(x[i], i, 1, &inserted);
+  }
+  return static_cast<int64_t>(table.values.size());
+}
+
+// For few distinct values: a table per block of the input, merged in the
+// order of the blocks, which is the order of first occurrence. The local ids
+// are kept in inverse, and remapped in place.
+template <typename T, typename IndexT>
+void UniqueByBlocks(const T* x, int64_t n, int64_t num_blocks,
+                    int64_t block_size, UniqueTable<T>* merged,
+                    IndexT* inverse) {
+  std::vector<UniqueTable<T>> blocks(num_blocks);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t begin = b * block_size;
+    int64_t end = std::min(n, begin + block_size);
+    UniqueTableRun<T, IndexT>(x + begin, end - begin, 0, inverse + begin,
+                              &blocks[b]);
+  }
+
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    auto& block = blocks[b];
+    block.global.resize(block.values.size());
+    for (size_t u = 0; u < block.values.size(); ++u) {
+      bool inserted;
+      block.global[u] = merged->Insert(block.values[u],
+                                       b * block_size + block.first[u],
+                                       block.counts[u], &inserted);
+    }
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    const auto& global = blocks[b].global;
+    for (int64_t i = b * block_size; i < std::min(n, (b + 1) * block_size);
+         ++i) {
+      int64_t id = static_cast<int64_t>(inverse[i]);
+      inverse[i] = static_cast<IndexT>(global[id]);
+    }
+  }
+}
+
+// For many distinct values: the elements are scattered by hash into
+// partitions, contiguous in memory, which are deduplicated in parallel.
+// Every later pass walks the input by blocks and finds the local id of an
+// element by a cursor per partition, so all the memory accesses stream, and
+// a prefix count of the first occurrences gives the order.
+template <typename T, typename IndexT>
+void UniqueByPartitions(const T* x, int64_t n, int64_t num_blocks,
+                        int64_t block_size, std::vector<T>* unique,
+                        IndexT* inverse, std::vector<int64_t>* first,
+                        std::vector<int64_t>* counts) {
+  constexpr int64_t kParts = 1 << kUniquePartitionBits;
+
+  // The partition of every element, and how many of each every block has
+  std::vector<uint8_t> part(n);
+  std::vector<int64_t> offset(kParts * num_blocks, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t* hist = offset.data() + b * kParts;
+    for (int64_t i = b * block_size; i < std::min(n, (b + 1) * block_size);
+         ++i) {
+      part[i] = static_cast<uint8_t>(UniqueHash(x[i]) >>
+                                     (64 - kUniquePartitionBits));
+      ++hist[part[i]];
+    }
+  }
+
+  // The buckets are partition major with the blocks in order inside each,
+  // offset becomes where every block starts in every bucket
+  std::vector<int64_t> bucket(kParts + 1, 0);
+  int64_t start = 0;
+  for (int64_t p = 0; p < kParts; ++p) {
+    bucket[p] = start;
+    for (int64_t b = 0; b < num_blocks; ++b) {
+      int64_t count = offset[b * kParts + p];
+      offset[b * kParts + p] = start;
+      start += count;
+    }
+  }
+  bucket[kParts] = n;
+
+  std::vector<T> keys(n);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t next[kParts];
+    std::copy_n(offset.data() + b * kParts, kParts, next);
+    for (int64_t i = b * block_size; i < std::min(n, (b + 1) * block_size);
+         ++i) {
+      keys[next[part[i]]++] = x[i];
+    }
+  }
+
+  std::vector<uint32_t> local(n);
+  std::vector<UniqueTable<T>> parts(kParts);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t p = 0; p < kParts; ++p) {
+    UniqueTableRun<T, uint32_t>(keys.data() + bucket[p],
+                                bucket[p + 1] - bucket[p], kUniqueFirstFlag,
+                                local.data() + bucket[p], &parts[p]);
+    parts[p].global.resize(parts[p].values.size());
+  }
+
+  // The global order of a value is the number of first occurrences before
+  // its own: counted by block, then assigned by a scan of every block
+  std::vector<int64_t> block_firsts(num_blocks + 1, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t next[kParts];
+    std::copy_n(offset.data() + b * kParts, kParts, next);
+    int64_t count = 0;
+    for (int64_t i = b * block_size; i < std::min(n, (b + 1) * block_size);
+         ++i) {
+      count += local[next[part[i]]++] >> 31;
+    }
+    block_firsts[b + 1] = count;
+  }
+  std::partial_sum(block_firsts.begin(), block_firsts.end(),
+                   block_firsts.begin());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t next[kParts];
+    std::copy_n(offset.data() + b * kParts, kParts, next);
+    int64_t order = block_firsts[b];
+    for (int64_t i = b * block_size; i < std::min(n, (b + 1) * block_size);
+         ++i) {
+      uint32_t id = local[next[part[i]]++];
+      if (id & kUniqueFirstFlag) {
+        auto& partition = parts[part[i]];
+        partition.global[id & ~kUniqueFirstFlag] = order++;
+        partition.first[id & ~kUniqueFirstFlag] = i;
+      }
+    }
+  }
+
+  const int64_t num_unique = block_firsts[num_blocks];
+  unique->resize(num_unique);
+  if (first) first->resize(num_unique);
+  if (counts) counts->resize(num_unique);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t p = 0; p < kParts; ++p) {
+    const auto& partition = parts[p];
+    for (size_t u = 0; u < partition.values.size(); ++u) {
+      int64_t g = partition.global[u];
+      (*unique)[g] = partition.values[u];
+      if (first) (*first)[g] = partition.first[u];
+      if (counts) (*counts)[g] = partition.counts[u];
+    }
+  }
+
+  if (inverse == nullptr) return;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t next[kParts];
+    std::copy_n(offset.data() + b * kParts, kParts, next);
+    for (int64_t i = b * block_size; i < std::min(n, (b + 1) * block_size);
+         ++i) {
+      uint32_t id = local[next[part[i]]++] & ~kUniqueFirstFlag;
+      inverse[i] = static_cast<IndexT>(parts[part[i]].global[id]);
+    }
+  }
+}
+
+// The number of threads the omp loops of unique run on
+inline int UniqueNumThreads() {
+#ifdef PADDLE_WITH_MKLML
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// The distinct values of x[0, n) in the order of their first occurrence, as
+// a serial scan would give them. inverse[i] is the order of x[i] among them,
+// first and counts the first position and the count of each; any of the
+// three may be null. Large inputs are split by blocks or by hash partitions,
+// as a sample of them has few or many distinct values. The tables per block
+// only pay off with more than one thread, so one thread runs one table.
+template <typename T, typename IndexT>
+void UniqueCPU(const T* x, int64_t n, std::vector<T>* unique, IndexT* inverse,
+               std::vector<int64_t>* first, std::vector<int64_t>* counts) {
+  const int64_t num_blocks =
+      std::max<int64_t>(1, std::min(kUniqueBlocks, n / kMinUniqueBlockSize));
+  const int64_t block_size = (n + num_blocks - 1) / num_blocks;
+  const bool parallel = n >= kMinParallelUniqueSize;
+  const bool few_distinct =
+      !parallel ||
+      UniqueSampleDistinct(x, n) * kUniqueRepeatRatio <= kUniqueSampleSize;
+  // The partitions mark the first occurrences in the high bit of uint32
+  // local ids, which limits them to fewer than 2^31 elements
+  if (!few_distinct && n < static_cast<int64_t>(kUniqueFirstFlag)) {
+    UniqueByPartitions<T, IndexT>(x, n, num_blocks, block_size, unique,
+                                  inverse, first, counts);
+    return;
+  }
+
+  std::vector<IndexT> inverse_buf;
+  if (inverse == nullptr) {
+    inverse_buf.resize(n);
+    inverse = inverse_buf.data();
+  }
+  UniqueTable<T> table;
+  if (parallel && few_distinct && UniqueNumThreads() > 1) {
+    UniqueByBlocks<T, IndexT>(x, n, num_blocks, block_size, &table, inverse);
+  } else {
+    // One table, its order is the order of first occurrence
+    UniqueTableRun<T, IndexT>(x, n, 0, inverse, &table);
+  }
+  unique->swap(table.values);
+  if (first) first->swap(table.first);
+  if (counts) counts->swap(table.counts);
+}
+
+// Reorders the result of UniqueCPU ascending, as unique with is_sorted
+// gives it: only the distinct values are sorted, then inverse is remapped.
+template <typename T, typename IndexT>
+void SortUniqueCPU(int64_t n, std::vector<T>* unique, IndexT* inverse,
+                   std::vector<int64_t>* first, std::vector<int64_t>* counts) {
+  const int64_t num_unique = static_cast<int64_t>(unique->size());
+  std::vector<int64_t> perm(num_unique);
+  std::iota(perm.begin(), perm.end(), 0);
+  const T* values = unique->data();
+  std::sort(perm.begin(), perm.end(), [values](int64_t a, int64_t b) {
+    return UniqueLess(values[a], values[b]);
+  });
+
+  std::vector<int64_t> rank(num_unique);
+  std::vector<T> sorted(num_unique);
+  for (int64_t r = 0; r < num_unique; ++r) {
+    rank[perm[r]] = r;
+    sorted[r] = values[perm[r]];
+  }
+  unique->swap(sorted);
+  for (auto* stat : {first, counts}) {
+    if (stat == nullptr) continue;
+    std::vector<int64_t> reordered(num_unique);
+    for (int64_t r = 0; r < num_unique; ++r) {
+      reordered[r] = (*stat)[perm[r]];
+    }
+    stat->swap(reordered);
+  }
+  if (inverse) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (n >= kMinParallelUniqueSize)
+#endif
+    for (int64_t i = 0; i < n; ++i) {
+      inverse[i] = static_cast<IndexT>(rank[static_cast<int64_t>(inverse[i])]);
+    }
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,109 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/unique_function_cpu.h"
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+
+template <typename T>
+std::vector<T> RandomIds(int64_t n, int64_t range, unsigned seed) {
+  std::mt19937_64 engine(seed);
+  std::uniform_int_distribution<int64_t> dist(-range, range);
+  std::vector<T> x(n);
+  for (auto& v : x) {
+    v = static_cast<T>(dist(engine));
+  }
+  return x;
+}
+
+template <typename T, typename IndexT>
+void TestUnique(const std::vector<T>& x) {
+  const int64_t n = static_cast<int64_t>(x.size());
+  std::vector<T> unique;
+  std::vector<IndexT> inverse(n);
+  std::vector<int64_t> first, counts;
+  UniqueCPU<T, IndexT>(x.data(), n, &unique, inverse.data(), &first, &counts);
+
+  // A serial scan gives the order of first occurrence
+  std::unordered_map<T, int64_t> order;
+  std::vector<T> expect;
+  std::vector<int64_t> expect_first, expect_counts;
+  for (int64_t i = 0; i < n; ++i) {
+    auto it = order.find(x[i]);
+    if (it == order.end()) {
+      it = order.emplace(x[i], expect.size()).first;
+      expect.push_back(x[i]);
+      expect_first.push_back(i);
+      expect_counts.push_back(0);
+    }
+    ++expect_counts[it->second];
+    ASSERT_EQ(static_cast<int64_t>(inverse[i]), it->second);
+  }
+  ASSERT_EQ(unique, expect);
+  ASSERT_EQ(first, expect_first);
+  ASSERT_EQ(counts, expect_counts);
+
+  SortUniqueCPU<T, IndexT>(n, &unique, inverse.data(), &first, &counts);
+  std::map<T, int64_t> sorted;
+  for (int64_t i = 0; i < n; ++i) {
+    sorted.emplace(x[i], i);
+  }
+  ASSERT_EQ(unique.size(), sorted.size());
+  int64_t r = 0;
+  for (auto& item : sorted) {
+    ASSERT_EQ(unique[r], item.first);
+    ASSERT_EQ(first[r], item.second);
+    ++r;
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    ASSERT_EQ(unique[static_cast<int64_t>(inverse[i])], x[i]);
+  }
+}
+
+TEST(UniqueCPU, serial) {
+  TestUnique<int64_t, int64_t>({});
+  TestUnique<int64_t, int64_t>({3, 1, 3, 2, 1, 3});
+  TestUnique<int64_t, int32_t>(RandomIds<int64_t>(1000, 50, 1));
+  TestUnique<int32_t, int64_t>(RandomIds<int32_t>(5000, 1 << 20, 2));
+  TestUnique<float, int64_t>({0.5f, -0.f, 0.f, 2.f, 0.5f});
+}
+
+TEST(UniqueCPU, partitioned) {
+  // Few and many distinct ids, above the parallel threshold
+  TestUnique<int64_t, int64_t>(RandomIds<int64_t>(200000, 100, 3));
+  TestUnique<int64_t, int32_t>(RandomIds<int64_t>(300001, 1 << 30, 4));
+  TestUnique<double, int64_t>(RandomIds<double>(150000, 5000, 5));
+  std::vector<int64_t> same(100000, 7);
+  TestUnique<int64_t, int64_t>(same);
+}
+
+#ifdef PADDLE_WITH_MKLML
+TEST(UniqueCPU, one_thread) {
+  // Few distinct ids on one thread run one table instead of the blocks
+  int num_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  TestUnique<int64_t, int64_t>(RandomIds<int64_t>(200000, 100, 6));
+  TestUnique<int64_t, int32_t>(RandomIds<int64_t>(300001, 1 << 30, 7));
+  omp_set_num_threads(num_threads);
+}
+#endif
+
+}  // namespace operators
+}  // namespace paddle
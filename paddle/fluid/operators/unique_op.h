@@ -16,18 +16,46 @@ limitations under the License. */
 #include <algorithm>
 #include <cmath>
 #include <numeric>
-#include <set>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/math/concat_and_split.h"
 #include "paddle/fluid/operators/math/math_function.h"
 #include "paddle/fluid/operators/transpose_op.h"
+#include "paddle/fluid/operators/unique_function_cpu.h"
 
 namespace paddle {
 namespace operators {
 
+// Runs the unique engine for any index type: int32 and int64 inverse
+// indices are computed in place, the others are converted from int64 ones.
+template <typename InT, typename IndexT>
+static void UniqueWithInverse(const InT* in_data, int64_t numel, bool sorted,
+                              std::vector<InT>* uniq, IndexT* inverse,
+                              std::vector<int64_t>* first,
+                              std::vector<int64_t>* counts) {
+  constexpr bool kExact = std::is_same<IndexT, int32_t>::value ||
+                          std::is_same<IndexT, int64_t>::value;
+  using ComputeT = typename std::conditional<kExact, IndexT, int64_t>::type;
+  std::vector<ComputeT> inverse_buf;
+  ComputeT* compute_inverse = reinterpret_cast<ComputeT*>(inverse);
+  if (!kExact && inverse != nullptr) {
+    inverse_buf.resize(numel);
+    compute_inverse = inverse_buf.data();
+  }
+  UniqueCPU<InT, ComputeT>(in_data, numel, uniq, compute_inverse, first,
+                           counts);
+  if (sorted) {
+    SortUniqueCPU<InT, ComputeT>(numel, uniq, compute_inverse, first, counts);
+  }
+  if (!kExact && inverse != nullptr) {
+    for (int64_t i = 0; i < numel; ++i) {
+      inverse[i] = static_cast<IndexT>(inverse_buf[i]);
+    }
+  }
+}
+
 template <typename InT>
 struct UniqueOpFunctor {
   framework::Tensor* out_;
@@ -45,38 +73,19 @@ struct UniqueOpFunctor {
     auto* in_data = in_->data<InT>();
     auto* index_data = index_->mutable_data<IndexT>(platform::CPUPlace());
 
-    int64_t j = 0;
-
-    // TODO(fangzeyang): Should optimize performance here.
-    std::unordered_map<InT, int64_t> dict;
     std::vector<InT> uniq;
+    std::vector<int64_t> counts;
 
-    PADDLE_ENFORCE_LT(
-        in_->numel(), pow(2, 31),
-        platform::errors::InvalidArgument(
-            "The num of Input(X) elements should be less then INT_MAX, "
-            "but received num is %d.",
-            in_->numel()));
-
-    for (auto i = 0; i < in_->numel(); i++) {
-      auto it = dict.find(in_data[i]);
-      if (it == dict.end()) {
-        dict.emplace(std::make_pair(in_data[i], j));
-        uniq.emplace_back(in_data[i]);
-        index_data[i] = static_cast<IndexT>(j);
-        j++;
-      } else {
-        index_data[i] = static_cast<IndexT>(it->second);
-      }
+    if (std::is_same<IndexT, int32_t>::value) {
+      PADDLE_ENFORCE_LT(
+          in_->numel(), pow(2, 31),
+          platform::errors::InvalidArgument(
+              "The num of Input(X) elements should be less then INT_MAX, "
+              "but received num is %d. Please set `dtype` to int64.",
+              in_->numel()));
     }
 
     if (count_ != nullptr) {
-      // Resize the count tensor dims to allocate the memory
-      count_->Resize(framework::make_ddim({static_cast<int64_t>(uniq.size())}));
-      IndexT* count_data = count_->mutable_data<IndexT>(platform::CPUPlace());
-      // init count_data to 0
-      memset(count_data, 0, uniq.size() * sizeof(IndexT));
-
       const auto& index_type = index_->type();
       bool index_type_match = index_type == framework::proto::VarType::INT32 ||
                               index_type == framework::proto::VarType::INT64;
@@ -89,17 +98,18 @@ struct UniqueOpFunctor {
                                 framework::proto::VarType::INT32),
                             paddle::framework::DataTypeToString(
                                 framework::proto::VarType::INT64)));
+    }
+
+    UniqueWithInverse<InT, IndexT>(in_data, in_->numel(), false, &uniq,
+                                   index_data, nullptr,
+                                   count_ != nullptr ? &counts : nullptr);
 
-      if (index_type == framework::proto::VarType::INT32) {
-        for (auto i = 0; i < in_->numel(); ++i) {
-          const IndexT& index = index_data[i];
-          count_data[static_cast<int32_t>(index)] += static_cast<IndexT>(1);
-        }
-      } else {
-        for (auto i = 0; i < in_->numel(); ++i) {
-          const IndexT& index = index_data[i];
-          count_data[static_cast<int64_t>(index)] += static_cast<IndexT>(1);
-        }
+    if (count_ != nullptr) {
+      // Resize the count tensor dims to allocate the memory
+      count_->Resize(framework::make_ddim({static_cast<int64_t>(uniq.size())}));
+      IndexT* count_data = count_->mutable_data<IndexT>(platform::CPUPlace());
+      for (size_t i = 0; i < counts.size(); ++i) {
+        count_data[i] = static_cast<IndexT>(counts[i]);
       }
     }
 
@@ -137,7 +147,19 @@ static void UniqueFlattendTensor(const framework::ExecutionContext& context,
                                  framework::Tensor* out, bool return_index,
                                  bool return_inverse, bool return_counts) {
   const InT* in_data = in.data<InT>();
-  std::set<InT> unique(in_data, in_data + in.numel());
+  std::vector<InT> unique;
+  std::vector<int64_t> first;
+  std::vector<int64_t> counts;
+  IndexT* inverse_data = nullptr;
+  if (return_inverse) {
+    auto* inverse = context.Output<framework::Tensor>("Index");
+    inverse->Resize(framework::make_ddim({in.numel()}));
+    inverse_data = inverse->mutable_data<IndexT>(context.GetPlace());
+  }
+  UniqueWithInverse<InT, IndexT>(in_data, in.numel(), true, &unique,
+                                 inverse_data, return_index ? &first : nullptr,
+                                 return_counts ? &counts : nullptr);
+
   out->Resize(framework::make_ddim({static_cast<int64_t>(unique.size())}));
   auto out_data = out->mutable_data<InT>(context.GetPlace());
   std::copy(unique.begin(), unique.end(), out_data);
@@ -146,28 +168,8 @@ static void UniqueFlattendTensor(const framework::ExecutionContext& context,
     auto* indices = context.Output<framework::Tensor>("Indices");
     indices->Resize(framework::make_ddim({out->numel()}));
     auto indices_data = indices->mutable_data<IndexT>(context.GetPlace());
-    std::unordered_map<InT, IndexT> indices_map;
-    indices_map.reserve(out->numel());
-    for (int64_t i = 0; i < in.numel(); ++i) {
-      if (indices_map.find(in_data[i]) != indices_map.end()) continue;
-      indices_map[in_data[i]] = i;
-    }
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      indices_data[i] = indices_map[out_data[i]];
-    }
-  }
-
-  if (return_inverse) {
-    auto* inverse = context.Output<framework::Tensor>("Index");
-    inverse->Resize(framework::make_ddim({in.numel()}));
-    auto inverse_data = inverse->mutable_data<IndexT>(context.GetPlace());
-    std::unordered_map<InT, IndexT> inverse_map;
-    inverse_map.reserve(out->numel());
     for (int64_t i = 0; i < out->numel(); ++i) {
-      inverse_map[out_data[i]] = i;
-    }
-    for (int64_t i = 0; i < in.numel(); ++i) {
-      inverse_data[i] = inverse_map[in_data[i]];
+      indices_data[i] = static_cast<IndexT>(first[i]);
     }
   }
 
@@ -175,16 +177,8 @@ static void UniqueFlattendTensor(const framework::ExecutionContext& context,
     auto* count = context.Output<framework::Tensor>("Counts");
     count->Resize(framework::make_ddim({out->numel()}));
     auto count_data = count->mutable_data<IndexT>(context.GetPlace());
-    std::unordered_map<InT, IndexT> counts_map;
-    counts_map.reserve(out->numel());
     for (int64_t i = 0; i < out->numel(); ++i) {
-      counts_map[out_data[i]] = 0;
-    }
-    for (int64_t i = 0; i < in.numel(); i++) {
-      counts_map[in_data[i]] += 1;
-    }
-    for (int64_t i = 0; i < out->numel(); i++) {
-      count_data[i] = counts_map[out_data[i]];
+      count_data[i] = static_cast<IndexT>(counts[i]);
     }
   }
 }
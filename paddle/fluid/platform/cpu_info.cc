@@ -31,7 +31,20 @@ limitations under the License. */
 #include <unistd.h>
 #endif  // _WIN32
 
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include "gflags/gflags.h"
 
 DECLARE_double(fraction_of_cpu_memory_to_use);
@@ -173,5 +186,146 @@ bool MayIUse(const cpu_isa_t cpu_isa) {
 }
 #endif
 
+#ifdef __linux__
+// Parses a list of ids like 0-3,8-11 of /sys/devices/system
+static std::vector<int> ParseIdList(const std::string& list) {
+  std::vector<int> ids;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || !isdigit(range[0])) continue;
+    const size_t dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last =
+        dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int id = first; id <= last; ++id) ids.push_back(id);
+  }
+  return ids;
+}
+
+static std::vector<int> ReadIdList(const std::string& path) {
+  std::ifstream fin(path);
+  std::string list;
+  std::getline(fin, list);
+  return ParseIdList(list);
+}
+
+// The node mask of the mempolicy syscalls, with the number of its bits
+static std::vector<uint64_t> NodeMask(int node,
+                                      unsigned long* max_node) {  // NOLINT
+  std::vector<uint64_t> mask(node / 64 + 1, 0);
+  mask[node / 64] |= 1ULL << (node % 64);
+  // The kernel reads max_node - 1 bits
+  *max_node = mask.size() * 64 + 1;
+  return mask;
+}
+#endif
+
+std::vector<std::vector<int>> NumaNodeCores() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  for (int node : ReadIdList("/sys/devices/system/node/online")) {
+    if (static_cast<int>(nodes.size()) <= node) nodes.resize(node + 1);
+    nodes[node] = ReadIdList("/sys/devices/system/node/node" +
+                             std::to_string(node) + "/cpulist");
+  }
+#endif
+  if (nodes.empty()) {
+    nodes.resize(1);
+    for (unsigned core = 0; core < std::thread::hardware_concurrency();
+         ++core) {
+      nodes[0].push_back(core);
+    }
+  }
+  return nodes;
+}
+
+bool BindMemoryToNumaNode(const void* ptr, size_t size, int node) {
+#ifdef __linux__
+  if (ptr == nullptr || size == 0 || node < 0) return false;
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) & ~(page_size - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(ptr) + size;
+  unsigned long max_node;  // NOLINT
+  auto mask = NodeMask(node, &max_node);
+  return syscall(SYS_mbind, begin, end - begin, MPOL_BIND, mask.data(),
+                 max_node, MPOL_MF_MOVE) == 0;
+#else
+  return false;
+#endif
+}
+
+void* AllocateNumaMemory(size_t size, int node) {
+#ifdef __linux__
+  if (size == 0 || node < 0) return nullptr;
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) return nullptr;
+  // The pages are not touched yet, so they are allocated on the node
+  if (!BindMemoryToNumaNode(ptr, size, node)) {
+    munmap(ptr, size);
+    return nullptr;
+  }
+  return ptr;
+#else
+  return nullptr;
+#endif
+}
+
+void FreeNumaMemory(void* ptr, size_t size) {
+#ifdef __linux__
+  if (ptr != nullptr) munmap(ptr, size);
+#endif
+}
+
+bool SetThreadNumaNode(int node) {
+#ifdef __linux__
+  if (node < 0) {
+    return syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0) == 0;
+  }
+  unsigned long max_node;  // NOLINT
+  auto mask = NodeMask(node, &max_node);
+  return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), max_node) ==
+         0;
+#else
+  return false;
+#endif
+}
+
+#ifdef __linux__
+// The bits of the node masks of the saved memory policies, enough for the
+// nodes of any kernel
+static constexpr unsigned long kMaxNumaNodes = 1024;  // NOLINT
+#endif
+
+bool GetThreadNumaPolicy(NumaMemoryPolicy* policy) {
+#ifdef __linux__
+  std::vector<uint64_t> nodes(kMaxNumaNodes / 64, 0);
+  int mode = 0;
+  if (syscall(SYS_get_mempolicy, &mode, nodes.data(), kMaxNumaNodes, nullptr,
+              0) != 0) {
+    return false;
+  }
+  policy->mode = mode;
+  policy->nodes = std::move(nodes);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool SetThreadNumaPolicy(const NumaMemoryPolicy& policy) {
+#ifdef __linux__
+  if (policy.mode < 0) return false;
+  if (policy.mode == MPOL_DEFAULT || policy.nodes.empty()) {
+    return syscall(SYS_set_mempolicy, policy.mode, nullptr, 0) == 0;
+  }
+  return syscall(SYS_set_mempolicy, policy.mode, policy.nodes.data(),
+                 policy.nodes.size() * 64 + 1) == 0;
+#else
+  return false;
+#endif
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -15,6 +15,8 @@ limitations under the License. */
 #pragma once
 
 #include <stddef.h>
+#include <cstdint>
+#include <vector>
 
 #ifdef _WIN32
 #if defined(__AVX2__)
@@ -87,5 +89,37 @@ typedef enum {
 // May I use some instruction
 bool MayIUse(const cpu_isa_t cpu_isa);
 
+//! Get the cores of each NUMA node, by node id. A machine that is not NUMA,
+//! or whose topology is unknown, has all its cores on node 0.
+std::vector<std::vector<int>> NumaNodeCores();
+
+//! Move the pages of [ptr, ptr + size) to a NUMA node and keep them there.
+//! The pages shared with the memory around are moved too. Returns whether
+//! the pages are bound, which is only supported on Linux.
+bool BindMemoryToNumaNode(const void* ptr, size_t size, int node);
+
+//! Allocate whole pages bound to a NUMA node, shared with no other memory.
+//! Returns nullptr if it is not supported. The pages are freed by
+//! FreeNumaMemory with the same size.
+void* AllocateNumaMemory(size_t size, int node);
+void FreeNumaMemory(void* ptr, size_t size);
+
+//! Make the calling thread prefer a NUMA node for the pages it touches for
+//! the first time, or the node it runs on again if node is -1. Memory that
+//! was touched before, like the chunks the CPU allocator reuses, stays where
+//! it is. Returns whether it is supported.
+bool SetThreadNumaNode(int node);
+
+//! The memory policy of a thread, to restore it after SetThreadNumaNode.
+struct NumaMemoryPolicy {
+  int mode{-1};
+  std::vector<uint64_t> nodes;
+};
+
+//! Get and set the memory policy of the calling thread. Return whether it is
+//! supported.
+bool GetThreadNumaPolicy(NumaMemoryPolicy* policy);
+bool SetThreadNumaPolicy(const NumaMemoryPolicy& policy);
+
 }  // namespace platform
 }  // namespace paddle
@@ -47,54 +47,56 @@ extern void* mklml_dso_handle;
 
 #define DECLARE_DYNAMIC_LOAD_MKLML_WRAP(__name) DYNAMIC_LOAD_MKLML_WRAP(__name)
 
-#define MKLML_ROUTINE_EACH(__macro) \
-  __macro(cblas_sgemm);             \
-  __macro(cblas_dgemm);             \
-  __macro(cblas_saxpy);             \
-  __macro(cblas_daxpy);             \
-  __macro(cblas_scopy);             \
-  __macro(cblas_dcopy);             \
-  __macro(cblas_sgemv);             \
-  __macro(cblas_dgemv);             \
-  __macro(cblas_strsm);             \
-  __macro(cblas_dtrsm);             \
-  __macro(cblas_sgemm_alloc);       \
-  __macro(cblas_dgemm_alloc);       \
-  __macro(cblas_sgemm_pack);        \
-  __macro(cblas_dgemm_pack);        \
-  __macro(cblas_sgemm_compute);     \
-  __macro(cblas_dgemm_compute);     \
-  __macro(cblas_sgemm_free);        \
-  __macro(cblas_dgemm_free);        \
-  __macro(cblas_sgemm_batch);       \
-  __macro(cblas_dgemm_batch);       \
-  __macro(cblas_sdot);              \
-  __macro(cblas_ddot);              \
-  __macro(cblas_sasum);             \
-  __macro(cblas_dasum);             \
-  __macro(cblas_isamax);            \
-  __macro(cblas_idamax);            \
-  __macro(cblas_sscal);             \
-  __macro(cblas_dscal);             \
-  __macro(vsAdd);                   \
-  __macro(vdAdd);                   \
-  __macro(vsSub);                   \
-  __macro(vdSub);                   \
-  __macro(vsMul);                   \
-  __macro(vdMul);                   \
-  __macro(vsDiv);                   \
-  __macro(vdDiv);                   \
-  __macro(vsExp);                   \
-  __macro(vdExp);                   \
-  __macro(vsSqr);                   \
-  __macro(vdSqr);                   \
-  __macro(vsPowx);                  \
-  __macro(vdPowx);                  \
-  __macro(vsInv);                   \
-  __macro(vdInv);                   \
-  __macro(vmsErf);                  \
-  __macro(vmdErf);                  \
-  __macro(MKL_Free_Buffers);        \
+#define MKLML_ROUTINE_EACH(__macro)   \
+  __macro(cblas_sgemm);               \
+  __macro(cblas_dgemm);               \
+  __macro(cblas_saxpy);               \
+  __macro(cblas_daxpy);               \
+  __macro(cblas_scopy);               \
+  __macro(cblas_dcopy);               \
+  __macro(cblas_sgemv);               \
+  __macro(cblas_dgemv);               \
+  __macro(cblas_strsm);               \
+  __macro(cblas_dtrsm);               \
+  __macro(cblas_sgemm_alloc);         \
+  __macro(cblas_dgemm_alloc);         \
+  __macro(cblas_sgemm_pack);          \
+  __macro(cblas_dgemm_pack);          \
+  __macro(cblas_sgemm_pack_get_size); \
+  __macro(cblas_dgemm_pack_get_size); \
+  __macro(cblas_sgemm_compute);       \
+  __macro(cblas_dgemm_compute);       \
+  __macro(cblas_sgemm_free);          \
+  __macro(cblas_dgemm_free);          \
+  __macro(cblas_sgemm_batch);         \
+  __macro(cblas_dgemm_batch);         \
+  __macro(cblas_sdot);                \
+  __macro(cblas_ddot);                \
+  __macro(cblas_sasum);               \
+  __macro(cblas_dasum);               \
+  __macro(cblas_isamax);              \
+  __macro(cblas_idamax);              \
+  __macro(cblas_sscal);               \
+  __macro(cblas_dscal);               \
+  __macro(vsAdd);                     \
+  __macro(vdAdd);                     \
+  __macro(vsSub);                     \
+  __macro(vdSub);                     \
+  __macro(vsMul);                     \
+  __macro(vdMul);                     \
+  __macro(vsDiv);                     \
+  __macro(vdDiv);                     \
+  __macro(vsExp);                     \
+  __macro(vdExp);                     \
+  __macro(vsSqr);                     \
+  __macro(vdSqr);                     \
+  __macro(vsPowx);                    \
+  __macro(vdPowx);                    \
+  __macro(vsInv);                     \
+  __macro(vdInv);                     \
+  __macro(vmsErf);                    \
+  __macro(vmdErf);                    \
+  __macro(MKL_Free_Buffers);          \
   __macro(MKL_Set_Num_Threads)
 
 MKLML_ROUTINE_EACH(DECLARE_DYNAMIC_LOAD_MKLML_WRAP);
@@ -484,6 +484,21 @@ DEFINE_double(local_exe_sub_scope_limit, 256.0,  // MBytes
  */
 DEFINE_bool(use_mkldnn, false, "Use MKLDNN to run");
 
+/**
+ * Operator related FLAG
+ * Name: FLAGS_conv_winograd
+ * Since Version: 2.0.0
+ * Value Range: bool, default=true
+ * Example: FLAGS_conv_winograd=false computes every CPU conv2d that neither
+ * MKLDNN nor the direct convolution takes by im2col and GEMM.
+ * Note: Winograd F(4x4, 3x3) runs fp32 3x3 stride 1 convolutions with fewer
+ * multiplications, and rounds differently from GEMM. Only the conv2d ops
+ * with is_test set use it, the training ones always take GEMM.
+ */
+DEFINE_bool(conv_winograd, true,
+            "Whether to compute fp32 3x3 stride 1 conv2d by Winograd on CPU "
+            "in inference.");
+
 /**
  * Debug related FLAG
  * Name: FLAGS_call_stack_level
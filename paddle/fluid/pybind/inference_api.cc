@@ -406,6 +406,10 @@ void BindAnalysisConfig(py::module *m) {
            py::arg("x") = true)
       .def("ir_optim", &AnalysisConfig::ir_optim)
       .def("enable_memory_optim", &AnalysisConfig::EnableMemoryOptim)
+      .def("enable_memory_map_params", &AnalysisConfig::EnableMemoryMapParams,
+           py::arg("x") = true)
+      .def("memory_map_params_enabled",
+           &AnalysisConfig::memory_map_params_enabled)
       .def("enable_profile", &AnalysisConfig::EnableProfile)
       .def("disable_glog_info", &AnalysisConfig::DisableGlogInfo)
       .def("glog_info_disabled", &AnalysisConfig::glog_info_disabled)
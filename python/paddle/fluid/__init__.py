@@ -197,6 +197,9 @@ def __bootstrap__():
         'free_when_no_cache_hit',
         'call_stack_level',
         'sort_sum_gradient',
+        'save_load_file_num',
+        'save_load_verify_checksum',
+        'conv_winograd',
     ]
     if 'Darwin' not in sysstr:
         read_env_flags.append('use_pinned_memory')
@@ -216,6 +219,9 @@ def __bootstrap__():
         read_env_flags.append('rpc_send_thread_num')
         read_env_flags.append('rpc_get_thread_num')
         read_env_flags.append('rpc_prefetch_thread_num')
+        read_env_flags.append('rpc_server_optimize_thread_num')
+        read_env_flags.append('rpc_server_sparse_shard_rows')
+        read_env_flags.append('rpc_server_geo_dense_pull_threshold')
         read_env_flags.append('rpc_disable_reuse_port')
         read_env_flags.append('rpc_retry_bind_port')
 
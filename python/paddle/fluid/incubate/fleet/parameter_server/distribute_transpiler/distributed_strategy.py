@@ -45,6 +45,8 @@ class TrainerRuntimeConfig(object):
             "FLAGS_communicator_send_wait_times", "5")
         self.runtime_configs['communicator_is_sgd_optimizer'] = os.getenv(
             "FLAGS_communicator_is_sgd_optimizer", "1")
+        self.runtime_configs['communicator_geo_dense_threshold'] = os.getenv(
+            "FLAGS_communicator_geo_dense_threshold", "0")
 
         # not used 
         self.runtime_configs['rpc_deadline'] = os.getenv("FLAGS_rpc_deadline",
@@ -70,7 +72,8 @@ class TrainerRuntimeConfig(object):
             mode_str = "GEO"
             need_keys = [
                 'communicator_thread_pool_size', 'communicator_send_wait_times',
-                'communicator_max_merge_var_num', 'communicator_send_queue_size'
+                'communicator_max_merge_var_num', 'communicator_send_queue_size',
+                'communicator_geo_dense_threshold'
             ]
         else:
             raise ValueError("Unsupported Mode")
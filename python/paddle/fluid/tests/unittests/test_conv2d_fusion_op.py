@@ -125,6 +125,7 @@ class TestConv2dFusionOp(OpTest):
         if self.has_cuda():
             place = core.CUDAPlace(0)
             self.check_output_with_place(place, atol=1e-5)
+        self.check_output_with_place(core.CPUPlace(), atol=1e-5)
 
     def init_test_case(self):
         self.pad = [0, 0]
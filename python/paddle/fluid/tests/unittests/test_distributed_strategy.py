@@ -96,6 +96,7 @@ class TestStrategyFactor(unittest.TestCase):
         runtime_configs = trainer_runtime_config.get_communicator_flags()
         self.assertIn('communicator_thread_pool_size', runtime_configs)
         self.assertIn('communicator_send_wait_times', runtime_configs)
+        self.assertIn('communicator_geo_dense_threshold', runtime_configs)
         self.assertNotIn('communicator_independent_recv_thread',
                          runtime_configs)
 
@@ -0,0 +1,173 @@
+#   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import unittest
+import numpy as np
+from op_test import OpTest
+import paddle.fluid.core as core
+from paddle.fluid.op import Operator
+
+
+def embedding_bag(table, ids, lod, combiner, padding_idx):
+    out = np.zeros((len(lod[0]), table.shape[1])).astype(table.dtype)
+    scales = []
+    offset = 0
+    for i, length in enumerate(lod[0]):
+        bag = [
+            x for x in ids[offset:offset + length].flatten()
+            if x != padding_idx
+        ]
+        offset += length
+        scale = 1.0
+        if bag and combiner == 'mean':
+            scale = 1.0 / len(bag)
+        elif bag and combiner == 'sqrt':
+            scale = 1.0 / np.sqrt(len(bag))
+        for x in bag:
+            out[i] += table[x]
+        out[i] *= scale
+        scales.append((bag, scale))
+    return out, scales
+
+
+class TestFusedEmbeddingBagOp(OpTest):
+    def setUp(self):
+        self.op_type = "fused_embedding_bag"
+        self.dtype = "float64"
+        self.emb_size = 16
+        self.table_height = 23
+        self.padding_idx = -1
+        self.init_combiner()
+        self.init_lods()
+        self.table = np.random.random(
+            (self.table_height, self.emb_size)).astype(self.dtype)
+
+        ids, outs = [], []
+        for s, lod in enumerate(self.lods):
+            slot_ids = np.random.randint(
+                0, self.table_height, (sum(lod[0]), 1)).astype("int64")
+            out, _ = embedding_bag(self.table, slot_ids, lod, self.combiner,
+                                   self.padding_idx)
+            ids.append(('ids%d' % s, (slot_ids, lod)))
+            outs.append(('out%d' % s, out))
+        self.inputs = {'W': self.table, 'Ids': ids}
+        self.outputs = {'Out': outs}
+        self.attrs = {
+            'combiner': self.combiner,
+            'padding_idx': self.padding_idx,
+            'is_sparse': False
+        }
+
+    def init_combiner(self):
+        self.combiner = 'sum'
+
+    def init_lods(self):
+        self.lods = [[[3, 1, 4]], [[2, 2, 5]], [[1, 6, 1]]]
+
+    def test_check_output(self):
+        # TODO(wangzhongpu): support lod in dygraph mode
+        self.check_output(check_dygraph=False)
+
+    def test_check_grad(self):
+        # TODO(wangzhongpu): support lod in dygraph mode
+        self.check_grad(
+            ['W'], ['out%d' % s for s in range(len(self.lods))],
+            no_grad_set=set(['ids%d' % s for s in range(len(self.lods))]),
+            check_dygraph=False)
+
+
+class TestFusedEmbeddingBagOpMean(TestFusedEmbeddingBagOp):
+    def init_combiner(self):
+        self.combiner = 'mean'
+
+
+class TestFusedEmbeddingBagOpSqrt(TestFusedEmbeddingBagOp):
+    def init_combiner(self):
+        self.combiner = 'sqrt'
+
+
+class TestFusedEmbeddingBagOpEmptyBag(TestFusedEmbeddingBagOp):
+    def init_combiner(self):
+        self.combiner = 'mean'
+
+    def init_lods(self):
+        self.lods = [[[0, 3, 0, 2]], [[4, 0, 1, 0]]]
+
+
+class TestFusedEmbeddingBagOpPadding(TestFusedEmbeddingBagOp):
+    def setUp(self):
+        self.table_height = 5
+        super(TestFusedEmbeddingBagOpPadding, self).setUp()
+
+    def init_combiner(self):
+        self.combiner = 'sqrt'
+        self.padding_idx = 3
+
+
+class TestFusedEmbeddingBagSparseGrad(unittest.TestCase):
+    def check_with_place(self, place, combiner, padding_idx):
+        scope = core.Scope()
+        emb_size, table_height = 8, 13
+        lods = [[[2, 3, 1]], [[4, 0, 2]]]
+        table = np.random.random((table_height, emb_size)).astype("float32")
+        scope.var('W').get_tensor().set(table, place)
+
+        expected = np.zeros_like(table)
+        ids_names, d_out_names = [], []
+        for s, lod in enumerate(lods):
+            ids = np.random.randint(0, table_height,
+                                    (sum(lod[0]), 1)).astype("int64")
+            d_out = np.random.random((len(lod[0]), emb_size)).astype("float32")
+            ids_tensor = scope.var('ids%d' % s).get_tensor()
+            ids_tensor.set(ids, place)
+            ids_tensor.set_lod([[0] + list(np.cumsum(lod[0]))])
+            scope.var('out%d@GRAD' % s).get_tensor().set(d_out, place)
+            _, scales = embedding_bag(table, ids, lod, combiner, padding_idx)
+            for i, (bag, scale) in enumerate(scales):
+                for x in bag:
+                    expected[x] += scale * d_out[i]
+            ids_names.append('ids%d' % s)
+            d_out_names.append('out%d@GRAD' % s)
+
+        d_table = scope.var('W@GRAD').get_selected_rows()
+        op = Operator(
+            "fused_embedding_bag_grad",
+            W='W',
+            Ids=ids_names,
+            **{'Out@GRAD': d_out_names,
+               'W@GRAD': 'W@GRAD',
+               'combiner': combiner,
+               'padding_idx': padding_idx,
+               'is_sparse': True})
+        op.run(scope, place)
+
+        rows = d_table.rows()
+        self.assertEqual(rows, sorted(set(rows)))
+        self.assertEqual(d_table.height(), table_height)
+        value = np.array(d_table.get_tensor())
+        self.assertEqual(value.shape, (len(rows), emb_size))
+        result = np.zeros_like(table)
+        result[rows] = value
+        self.assertTrue(np.allclose(result, expected, atol=1e-5))
+
+    def test_sparse_grad(self):
+        for combiner in ['sum', 'mean', 'sqrt']:
+            for padding_idx in [-1, 3]:
+                self.check_with_place(core.CPUPlace(), combiner, padding_idx)
+
+
+if __name__ == "__main__":
+    unittest.main()
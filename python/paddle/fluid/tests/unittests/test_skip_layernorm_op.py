@@ -0,0 +1,59 @@
+#   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import unittest
+import numpy as np
+from op_test import OpTest
+from test_layer_norm_op import _reference_layer_norm_naive
+
+
+class TestSkipLayerNormOp(OpTest):
+    def config(self):
+        self.x_shape = [4, 6, 32]
+        self.begin_norm_axis = 2
+
+    def setUp(self):
+        self.op_type = "skip_layernorm"
+        self.config()
+        epsilon = 0.00001
+
+        x = np.random.random_sample(self.x_shape).astype(np.float32)
+        y = np.random.random_sample(self.x_shape).astype(np.float32)
+        norm_shape = [np.prod(self.x_shape[self.begin_norm_axis:])]
+        scale = np.random.random_sample(norm_shape).astype(np.float32)
+        bias = np.random.random_sample(norm_shape).astype(np.float32)
+        out, _, _ = _reference_layer_norm_naive(x + y, scale, bias, epsilon,
+                                                self.begin_norm_axis)
+
+        self.inputs = {"X": x, "Y": y, "Scale": scale, "Bias": bias}
+        self.attrs = {
+            "epsilon": epsilon,
+            "begin_norm_axis": self.begin_norm_axis
+        }
+        self.outputs = {"Out": out}
+
+    def test_check_output(self):
+        self.check_output(atol=1e-4)
+
+
+class TestSkipLayerNormOp2(TestSkipLayerNormOp):
+    def config(self):
+        self.x_shape = [3, 5, 7]
+        self.begin_norm_axis = 1
+
+
+if __name__ == '__main__':
+    unittest.main()